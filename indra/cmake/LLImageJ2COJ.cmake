@@ -2,4 +2,9 @@
 
 include(OpenJPEG)
 
+set(LLIMAGEJ2COJ_INCLUDE_DIRS
+    ${LIBS_OPEN_DIR}/llimagej2coj
+    ${OPENJPEG_INCLUDE_DIR}
+    )
+
 set(LLIMAGEJ2COJ_LIBRARIES llimagej2coj)
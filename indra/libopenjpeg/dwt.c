@@ -31,10 +31,6 @@
  * POSSIBILITY OF SUCH DAMAGE.
  */
 
-#ifdef __SSE__
-#include <xmmintrin.h>
-#endif
-
 #include "opj_includes.h"
 
 /** @defgroup DWT DWT - Implementation of a discrete wavelet transform */
@@ -64,6 +60,17 @@ typedef struct v4dwt_local {
 	int		cas ;
 } v4dwt_t ;
 
+typedef union {
+	float	f[8];
+} v8;
+
+typedef struct v8dwt_local {
+	v8*	wavelet ;
+	int		dn ;
+	int		sn ;
+	int		cas ;
+} v8dwt_t ;
+
 static const float dwt_alpha =  1.586134342f; /*  12994 */
 static const float dwt_beta  =  0.052980118f; /*    434 */
 static const float dwt_gamma = -0.882911075f; /*  -7233 */
@@ -80,6 +87,25 @@ Virtual function type for wavelet transform in 1-D
 */
 typedef void (*DWT1DFN)(dwt_t* v);
 
+/** One pass (rows or columns) of one level of the inverse DWT, split in jobs of step lines */
+typedef struct dwt_decode_job {
+	void* data;		/**< tile component samples */
+	int w;			/**< width of the tile component */
+	int bufsize;	/**< number of samples in data */
+	int rw;			/**< width of the resolution level computed */
+	int rh;			/**< height of the resolution level computed */
+	int count;		/**< rows or columns to transform */
+	int step;		/**< rows or columns per job */
+	dwt_t h;		/**< 5-3 row transform of the level, mem is per thread */
+	dwt_t v;		/**< 5-3 column transform of the level, mem is per thread */
+	v4dwt_t h97;	/**< 9-7 row transform of the level, wavelet is per thread */
+	v4dwt_t v97;	/**< 9-7 column transform of the level, wavelet is per thread */
+	void** mem;		/**< scratch buffer of each thread */
+	DWT1DFN dwt_1D;
+	int features;	/**< OPJ_CPU_* instruction sets the transform may use */
+	int lanes;		/**< 5-3 lines transformed together with SIMD, 1 for none */
+} dwt_decode_job_t;
+
 /** @name Local static functions */
 /*@{*/
 
@@ -118,7 +144,7 @@ static void dwt_encode_stepsize(int stepsize, int numbps, opj_stepsize_t *bandno
 /**
 Inverse wavelet transform in 2-D.
 */
-static void dwt_decode_tile(opj_tcd_tilecomp_t* tilec, int i, DWT1DFN fn);
+static void dwt_decode_tile(opj_tcd_tilecomp_t* tilec, int i, DWT1DFN fn, opj_thread_pool_t *tp);
 
 /*@}*/
 
@@ -268,6 +294,161 @@ static void dwt_decode_1(dwt_t *v) {
 	dwt_decode_1_(v->mem, v->dn, v->sn, v->cas);
 }
 
+#ifdef OPJ_HAVE_SSE2
+/* <summary>                                             */
+/* Inverse 5-3 wavelet transform in 1-D of 4 lines at    */
+/* once. Sample i of line l is at a[i*4 + l], the result */
+/* is the same as dwt_decode_1_ on each line.            */
+/* </summary>                                            */
+static void dwt_decode_1_sse2(int *a, int dn, int sn, int cas) {
+	const __m128i two = _mm_set1_epi32(2);
+	__m128i prev, cur;
+	int i;
+
+#define LD(i) _mm_loadu_si128((const __m128i*)(a + (i) * 4))
+#define ST(i, x) _mm_storeu_si128((__m128i*)(a + (i) * 4), (x))
+	if (!cas) {
+		if ((dn > 0) || (sn > 1)) {
+			/* S(i) -= (D_(i - 1) + D_(i) + 2) >> 2 */
+			prev = LD(1);
+			for (i = 0; i < sn; i++) {
+				cur = LD(2 * int_min(i, dn - 1) + 1);
+				ST(2 * i, _mm_sub_epi32(LD(2 * i), _mm_srai_epi32(_mm_add_epi32(_mm_add_epi32(prev, cur), two), 2)));
+				prev = cur;
+			}
+			/* D(i) += (S_(i) + S_(i + 1)) >> 1 */
+			prev = LD(0);
+			for (i = 0; i < dn; i++) {
+				cur = LD(2 * int_min(i + 1, sn - 1));
+				ST(2 * i + 1, _mm_add_epi32(LD(2 * i + 1), _mm_srai_epi32(_mm_add_epi32(prev, cur), 1)));
+				prev = cur;
+			}
+		}
+	} else {
+		if (!sn && dn == 1) {
+			for (i = 0; i < 4; i++) a[i] /= 2;
+		} else {
+			/* D(i) -= (SS_(i) + SS_(i + 1) + 2) >> 2 */
+			prev = LD(0);
+			for (i = 0; i < sn; i++) {
+				cur = LD(2 * int_min(i + 1, dn - 1));
+				ST(2 * i + 1, _mm_sub_epi32(LD(2 * i + 1), _mm_srai_epi32(_mm_add_epi32(_mm_add_epi32(prev, cur), two), 2)));
+				prev = cur;
+			}
+			/* S(i) += (DD_(i) + DD_(i - 1)) >> 1 */
+			prev = LD(1);
+			for (i = 0; i < dn; i++) {
+				cur = LD(2 * int_min(i, sn - 1) + 1);
+				ST(2 * i, _mm_add_epi32(LD(2 * i), _mm_srai_epi32(_mm_add_epi32(cur, prev), 1)));
+				prev = cur;
+			}
+		}
+	}
+#undef LD
+#undef ST
+}
+#endif
+
+#ifdef OPJ_HAVE_AVX2
+/* <summary>                                          */
+/* Inverse 5-3 wavelet transform in 1-D of 8 lines at */
+/* once. Sample i of line l is at a[i*8 + l].         */
+/* </summary>                                         */
+static OPJ_TARGET_AVX2 void dwt_decode_1_avx2(int *a, int dn, int sn, int cas) {
+	const __m256i two = _mm256_set1_epi32(2);
+	__m256i prev, cur;
+	int i;
+
+#define LD(i) _mm256_loadu_si256((const __m256i*)(a + (i) * 8))
+#define ST(i, x) _mm256_storeu_si256((__m256i*)(a + (i) * 8), (x))
+	if (!cas) {
+		if ((dn > 0) || (sn > 1)) {
+			prev = LD(1);
+			for (i = 0; i < sn; i++) {
+				cur = LD(2 * int_min(i, dn - 1) + 1);
+				ST(2 * i, _mm256_sub_epi32(LD(2 * i), _mm256_srai_epi32(_mm256_add_epi32(_mm256_add_epi32(prev, cur), two), 2)));
+				prev = cur;
+			}
+			prev = LD(0);
+			for (i = 0; i < dn; i++) {
+				cur = LD(2 * int_min(i + 1, sn - 1));
+				ST(2 * i + 1, _mm256_add_epi32(LD(2 * i + 1), _mm256_srai_epi32(_mm256_add_epi32(prev, cur), 1)));
+				prev = cur;
+			}
+		}
+	} else {
+		if (!sn && dn == 1) {
+			for (i = 0; i < 8; i++) a[i] /= 2;
+		} else {
+			prev = LD(0);
+			for (i = 0; i < sn; i++) {
+				cur = LD(2 * int_min(i + 1, dn - 1));
+				ST(2 * i + 1, _mm256_sub_epi32(LD(2 * i + 1), _mm256_srai_epi32(_mm256_add_epi32(_mm256_add_epi32(prev, cur), two), 2)));
+				prev = cur;
+			}
+			prev = LD(1);
+			for (i = 0; i < dn; i++) {
+				cur = LD(2 * int_min(i, sn - 1) + 1);
+				ST(2 * i, _mm256_add_epi32(LD(2 * i), _mm256_srai_epi32(_mm256_add_epi32(cur, prev), 1)));
+				prev = cur;
+			}
+		}
+	}
+#undef LD
+#undef ST
+}
+#endif
+
+#ifdef OPJ_HAVE_SSE2
+/* <summary>                                               */
+/* Inverse lazy transform (horizontal) of lanes rows into  */
+/* the interleaved layout of the SIMD 5-3 transform.        */
+/* </summary>                                              */
+static void dwt_interleave_h_lanes(dwt_t* h, int *a, int x, int lanes) {
+	int l, i;
+	for (l = 0; l < lanes; ++l) {
+		int *ai = a + l * x;
+		int *bi = h->mem + h->cas * lanes + l;
+		for (i = 0; i < h->sn; ++i) {
+			bi[2 * i * lanes] = ai[i];
+		}
+		ai += h->sn;
+		bi = h->mem + (1 - h->cas) * lanes + l;
+		for (i = 0; i < h->dn; ++i) {
+			bi[2 * i * lanes] = ai[i];
+		}
+	}
+}
+
+/* <summary>                                                  */
+/* Inverse lazy transform (vertical) of lanes adjacent columns */
+/* into the interleaved layout of the SIMD 5-3 transform.      */
+/* </summary>                                                 */
+static void dwt_interleave_v_lanes(dwt_t* v, int *a, int x, int lanes) {
+	int i;
+	for (i = 0; i < v->sn; ++i) {
+		memcpy(v->mem + (v->cas + 2 * i) * lanes, a + i * x, lanes * sizeof(int));
+	}
+	a += v->sn * x;
+	for (i = 0; i < v->dn; ++i) {
+		memcpy(v->mem + (1 - v->cas + 2 * i) * lanes, a + i * x, lanes * sizeof(int));
+	}
+}
+
+/* <summary>                                      */
+/* Inverse 5-3 wavelet transform of lanes lines.   */
+/* </summary>                                     */
+static void dwt_decode_1_lanes(dwt_t *v, int lanes) {
+#ifdef OPJ_HAVE_AVX2
+	if (lanes == 8) {
+		dwt_decode_1_avx2(v->mem, v->dn, v->sn, v->cas);
+		return;
+	}
+#endif
+	dwt_decode_1_sse2(v->mem, v->dn, v->sn, v->cas);
+}
+#endif
+
 /* <summary>                             */
 /* Forward 9-7 wavelet transform in 1-D. */
 /* </summary>                            */
@@ -379,8 +560,8 @@ void dwt_encode(opj_tcd_tilecomp_t * tilec) {
 /* <summary>                            */
 /* Inverse 5-3 wavelet transform in 2-D. */
 /* </summary>                           */
-void dwt_decode(opj_tcd_tilecomp_t* tilec, int numres) {
-	dwt_decode_tile(tilec, numres, &dwt_decode_1);
+void dwt_decode(opj_tcd_tilecomp_t* tilec, int numres, opj_thread_pool_t *tp) {
+	dwt_decode_tile(tilec, numres, &dwt_decode_1, tp);
 }
 
 
@@ -513,56 +694,177 @@ static int dwt_decode_max_resolution(opj_tcd_resolution_t* restrict r, int i) {
 }
 
 
+/* <summary>                                         */
+/* Splits count lines in jobs of a multiple of align. */
+/* </summary>                                        */
+static int dwt_split_jobs(dwt_decode_job_t* job, int count, int align, opj_thread_pool_t *tp) {
+	int num_threads = opj_thread_pool_size(tp);
+	/* a few jobs per thread so uneven threads even out */
+	int num_jobs = num_threads > 1 ? num_threads * 4 : 1;
+	int step = (count + num_jobs - 1) / num_jobs;
+	step = (step + align - 1) / align * align;
+	if (step < align) {
+		step = align;
+	}
+	job->count = count;
+	job->step = step;
+	return (count + step - 1) / step;
+}
+
+/* <summary>                                 */
+/* Allocates a scratch buffer per thread.    */
+/* </summary>                                */
+static void** dwt_alloc_thread_mem(opj_thread_pool_t *tp, size_t size) {
+	int num_threads = opj_thread_pool_size(tp);
+	void** mem = (void**) opj_calloc(num_threads, sizeof(void*));
+	int i;
+	if (!mem) {
+		return NULL;
+	}
+	for (i = 0; i < num_threads; i++) {
+		mem[i] = opj_aligned_malloc(size);
+		if (!mem[i]) {
+			while (i--) {
+				opj_aligned_free(mem[i]);
+			}
+			opj_free(mem);
+			return NULL;
+		}
+	}
+	return mem;
+}
+
+static void dwt_free_thread_mem(opj_thread_pool_t *tp, void** mem) {
+	int num_threads = opj_thread_pool_size(tp);
+	int i;
+	for (i = 0; i < num_threads; i++) {
+		opj_aligned_free(mem[i]);
+	}
+	opj_free(mem);
+}
+
+/* <summary>                                */
+/* Inverse 5-3 transform of a band of rows. */
+/* </summary>                               */
+static void dwt_decode_h_job(void *user_data, int jobno, int threadno) {
+	dwt_decode_job_t* job = (dwt_decode_job_t*) user_data;
+	int * restrict tiledp = (int*) job->data;
+	dwt_t h = job->h;
+	int j = jobno * job->step;
+	int end = int_min(j + job->step, job->count);
+
+	h.mem = (int*) job->mem[threadno];
+#ifdef OPJ_HAVE_SSE2
+	if (job->lanes > 1) {
+		int lanes = job->lanes;
+		for(; end - j >= lanes; j += lanes) {
+			int l, k;
+			dwt_interleave_h_lanes(&h, &tiledp[j*job->w], job->w, lanes);
+			dwt_decode_1_lanes(&h, lanes);
+			for(l = 0; l < lanes; ++l) {
+				int * restrict row = &tiledp[(j + l) * job->w];
+				for(k = 0; k < job->rw; ++k) {
+					row[k] = h.mem[k * lanes + l];
+				}
+			}
+		}
+	}
+#endif
+	for(; j < end; ++j) {
+		dwt_interleave_h(&h, &tiledp[j*job->w]);
+		(job->dwt_1D)(&h);
+		memcpy(&tiledp[j*job->w], h.mem, job->rw * sizeof(int));
+	}
+}
+
+/* <summary>                                   */
+/* Inverse 5-3 transform of a band of columns. */
+/* </summary>                                  */
+static void dwt_decode_v_job(void *user_data, int jobno, int threadno) {
+	dwt_decode_job_t* job = (dwt_decode_job_t*) user_data;
+	int * restrict tiledp = (int*) job->data;
+	dwt_t v = job->v;
+	int j = jobno * job->step;
+	int end = int_min(j + job->step, job->count);
+
+	v.mem = (int*) job->mem[threadno];
+#ifdef OPJ_HAVE_SSE2
+	if (job->lanes > 1) {
+		int lanes = job->lanes;
+		for(; end - j >= lanes; j += lanes) {
+			int k;
+			dwt_interleave_v_lanes(&v, &tiledp[j], job->w, lanes);
+			dwt_decode_1_lanes(&v, lanes);
+			for(k = 0; k < job->rh; ++k) {
+				memcpy(&tiledp[k * job->w + j], &v.mem[k * lanes], lanes * sizeof(int));
+			}
+		}
+	}
+#endif
+	for(; j < end; ++j) {
+		int k;
+		dwt_interleave_v(&v, &tiledp[j], job->w);
+		(job->dwt_1D)(&v);
+		for(k = 0; k < job->rh; ++k) {
+			tiledp[k * job->w + j] = v.mem[k];
+		}
+	}
+}
+
 /* <summary>                            */
 /* Inverse wavelet transform in 2-D.     */
 /* </summary>                           */
-static void dwt_decode_tile(opj_tcd_tilecomp_t* tilec, int numres, DWT1DFN dwt_1D) {
-	dwt_t h;
-	dwt_t v;
+static void dwt_decode_tile(opj_tcd_tilecomp_t* tilec, int numres, DWT1DFN dwt_1D, opj_thread_pool_t *tp) {
+	dwt_decode_job_t job;
 
 	opj_tcd_resolution_t* tr = tilec->resolutions;
 
 	int rw = tr->x1 - tr->x0;	/* width of the resolution level computed */
 	int rh = tr->y1 - tr->y0;	/* height of the resolution level computed */
 
-	int w = tilec->x1 - tilec->x0;
-
-	h.mem = (int*)opj_aligned_malloc(dwt_decode_max_resolution(tr, numres) * sizeof(int));
-	v.mem = h.mem;
+	memset(&job, 0, sizeof(job));
+	job.data = tilec->data;
+	job.w = tilec->x1 - tilec->x0;
+	job.dwt_1D = dwt_1D;
+	job.features = opj_get_cpu_features();
+	job.lanes = 1;
+	if (dwt_1D == dwt_decode_1) {
+		if (job.features & OPJ_CPU_AVX2) {
+			job.lanes = 8;
+		} else if (job.features & OPJ_CPU_SSE2) {
+			job.lanes = 4;
+		}
+	}
+	job.mem = dwt_alloc_thread_mem(tp, dwt_decode_max_resolution(tr, numres) * job.lanes * sizeof(int));
+	if (!job.mem) {
+		return;
+	}
 
 	while( --numres) {
-		int * restrict tiledp = tilec->data;
-		int j;
+		int num_jobs;
 
 		++tr;
-		h.sn = rw;
-		v.sn = rh;
+		job.h.sn = rw;
+		job.v.sn = rh;
 
 		rw = tr->x1 - tr->x0;
 		rh = tr->y1 - tr->y0;
+		job.rw = rw;
+		job.rh = rh;
 
-		h.dn = rw - h.sn;
-		h.cas = tr->x0 % 2;
+		job.h.dn = rw - job.h.sn;
+		job.h.cas = tr->x0 % 2;
 
-		for(j = 0; j < rh; ++j) {
-			dwt_interleave_h(&h, &tiledp[j*w]);
-			(dwt_1D)(&h);
-			memcpy(&tiledp[j*w], h.mem, rw * sizeof(int));
-		}
+		num_jobs = dwt_split_jobs(&job, rh, job.lanes, tp);
+		opj_thread_pool_run(tp, num_jobs, dwt_decode_h_job, &job);
 
-		v.dn = rh - v.sn;
-		v.cas = tr->y0 % 2;
+		job.v.dn = rh - job.v.sn;
+		job.v.cas = tr->y0 % 2;
 
-		for(j = 0; j < rw; ++j){
-			int k;
-			dwt_interleave_v(&v, &tiledp[j], w);
-			(dwt_1D)(&v);
-			for(k = 0; k < rh; ++k) {
-				tiledp[k * w + j] = v.mem[k];
-			}
-		}
+		num_jobs = dwt_split_jobs(&job, rw, job.lanes, tp);
+		opj_thread_pool_run(tp, num_jobs, dwt_decode_v_job, &job);
 	}
-	opj_aligned_free(h.mem);
+	dwt_free_thread_mem(tp, job.mem);
 }
 
 static void v4dwt_interleave_h(v4dwt_t* restrict w, float* restrict a, int x, int size){
@@ -618,7 +920,7 @@ static void v4dwt_interleave_v(v4dwt_t* restrict v , float* restrict a , int x){
 	}
 }
 
-#ifdef __SSE__
+#ifdef OPJ_HAVE_SSE2
 
 static void v4dwt_decode_step1_sse(v4* w, int count, const __m128 c){
 	__m128* restrict vw = (__m128*) w;
@@ -667,7 +969,7 @@ static void v4dwt_decode_step2_sse(v4* l, v4* w, int k, int m, __m128 c){
 	}
 }
 
-#else
+#endif
 
 static void v4dwt_decode_step1(v4* w, int count, const float c){
 	float* restrict fw = (float*) w;
@@ -732,12 +1034,10 @@ static void v4dwt_decode_step2(v4* l, v4* w, int k, int m, float c){
 	}
 }
 
-#endif
-
 /* <summary>                             */
 /* Inverse 9-7 wavelet transform in 1-D. */
 /* </summary>                            */
-static void v4dwt_decode(v4dwt_t* restrict dwt){
+static void v4dwt_decode(v4dwt_t* restrict dwt, int features){
 	int a, b;
 	if(dwt->cas == 0) {
 		if(!((dwt->dn > 0) || (dwt->sn > 1))){
@@ -752,107 +1052,286 @@ static void v4dwt_decode(v4dwt_t* restrict dwt){
 		a = 1;
 		b = 0;
 	}
-#ifdef __SSE__
-	v4dwt_decode_step1_sse(dwt->wavelet+a, dwt->sn, _mm_set1_ps(K));
-	v4dwt_decode_step1_sse(dwt->wavelet+b, dwt->dn, _mm_set1_ps(c13318));
-	v4dwt_decode_step2_sse(dwt->wavelet+b, dwt->wavelet+a+1, dwt->sn, int_min(dwt->sn, dwt->dn-a), _mm_set1_ps(dwt_delta));
-	v4dwt_decode_step2_sse(dwt->wavelet+a, dwt->wavelet+b+1, dwt->dn, int_min(dwt->dn, dwt->sn-b), _mm_set1_ps(dwt_gamma));
-	v4dwt_decode_step2_sse(dwt->wavelet+b, dwt->wavelet+a+1, dwt->sn, int_min(dwt->sn, dwt->dn-a), _mm_set1_ps(dwt_beta));
-	v4dwt_decode_step2_sse(dwt->wavelet+a, dwt->wavelet+b+1, dwt->dn, int_min(dwt->dn, dwt->sn-b), _mm_set1_ps(dwt_alpha));
-#else
+#ifdef OPJ_HAVE_SSE2
+	if (features & OPJ_CPU_SSE2) {
+		v4dwt_decode_step1_sse(dwt->wavelet+a, dwt->sn, _mm_set1_ps(K));
+		v4dwt_decode_step1_sse(dwt->wavelet+b, dwt->dn, _mm_set1_ps(c13318));
+		v4dwt_decode_step2_sse(dwt->wavelet+b, dwt->wavelet+a+1, dwt->sn, int_min(dwt->sn, dwt->dn-a), _mm_set1_ps(dwt_delta));
+		v4dwt_decode_step2_sse(dwt->wavelet+a, dwt->wavelet+b+1, dwt->dn, int_min(dwt->dn, dwt->sn-b), _mm_set1_ps(dwt_gamma));
+		v4dwt_decode_step2_sse(dwt->wavelet+b, dwt->wavelet+a+1, dwt->sn, int_min(dwt->sn, dwt->dn-a), _mm_set1_ps(dwt_beta));
+		v4dwt_decode_step2_sse(dwt->wavelet+a, dwt->wavelet+b+1, dwt->dn, int_min(dwt->dn, dwt->sn-b), _mm_set1_ps(dwt_alpha));
+		return;
+	}
+#endif
 	v4dwt_decode_step1(dwt->wavelet+a, dwt->sn, K);
 	v4dwt_decode_step1(dwt->wavelet+b, dwt->dn, c13318);
 	v4dwt_decode_step2(dwt->wavelet+b, dwt->wavelet+a+1, dwt->sn, int_min(dwt->sn, dwt->dn-a), dwt_delta);
 	v4dwt_decode_step2(dwt->wavelet+a, dwt->wavelet+b+1, dwt->dn, int_min(dwt->dn, dwt->sn-b), dwt_gamma);
 	v4dwt_decode_step2(dwt->wavelet+b, dwt->wavelet+a+1, dwt->sn, int_min(dwt->sn, dwt->dn-a), dwt_beta);
 	v4dwt_decode_step2(dwt->wavelet+a, dwt->wavelet+b+1, dwt->dn, int_min(dwt->dn, dwt->sn-b), dwt_alpha);
+	(void)features;
+}
+
+#ifdef OPJ_HAVE_AVX2
+
+/* <summary>                                                */
+/* Inverse lazy transform (horizontal) of 8 complete rows.  */
+/* </summary>                                               */
+static void v8dwt_interleave_h(v8dwt_t* restrict w, float* restrict a, int x){
+	float* restrict bi = (float*) (w->wavelet + w->cas);
+	int count = w->sn;
+	int i, k, l;
+	for(k = 0; k < 2; ++k){
+		for(i = 0; i < count; ++i){
+			for(l = 0; l < 8; ++l){
+				bi[i*16 + l] = a[i + l*x];
+			}
+		}
+		bi = (float*) (w->wavelet + 1 - w->cas);
+		a += w->sn;
+		count = w->dn;
+	}
+}
+
+/* <summary>                                                    */
+/* Inverse lazy transform (vertical) of 8 adjacent columns.     */
+/* </summary>                                                   */
+static void v8dwt_interleave_v(v8dwt_t* restrict v , float* restrict a , int x){
+	v8* restrict bi = v->wavelet + v->cas;
+	int i;
+	for(i = 0; i < v->sn; ++i){
+		memcpy(&bi[i*2], &a[i*x], 8 * sizeof(float));
+	}
+	a += v->sn * x;
+	bi = v->wavelet + 1 - v->cas;
+	for(i = 0; i < v->dn; ++i){
+		memcpy(&bi[i*2], &a[i*x], 8 * sizeof(float));
+	}
+}
+
+/* The AVX2 steps do the same operations in the same order as the SSE and */
+/* C ones, without FMA, so every path gives bit exact results.            */
+static OPJ_TARGET_AVX2 void v8dwt_decode_step1_avx2(v8* w, int count, const __m256 c){
+	float* restrict fw = (float*) w;
+	int i;
+	for(i = 0; i < count; ++i){
+		_mm256_storeu_ps(fw, _mm256_mul_ps(_mm256_loadu_ps(fw), c));
+		fw += 16;
+	}
+}
+
+static OPJ_TARGET_AVX2 void v8dwt_decode_step2_avx2(v8* l, v8* w, int k, int m, __m256 c){
+	float* restrict fw = (float*) w;
+	int i;
+	__m256 tmp1, tmp2, tmp3;
+	tmp1 = _mm256_loadu_ps((float*) l);
+	for(i = 0; i < m; ++i){
+		tmp2 = _mm256_loadu_ps(fw - 8);
+		tmp3 = _mm256_loadu_ps(fw);
+		_mm256_storeu_ps(fw - 8, _mm256_add_ps(tmp2, _mm256_mul_ps(_mm256_add_ps(tmp1, tmp3), c)));
+		tmp1 = tmp3;
+		fw += 16;
+	}
+	if(m >= k){
+		return;
+	}
+	c = _mm256_add_ps(c, c);
+	c = _mm256_mul_ps(c, _mm256_loadu_ps(fw - 16));
+	for(; m < k; ++m){
+		_mm256_storeu_ps(fw - 8, _mm256_add_ps(_mm256_loadu_ps(fw - 8), c));
+		fw += 16;
+	}
+}
+
+/* <summary>                                          */
+/* Inverse 9-7 wavelet transform in 1-D of 8 lines.   */
+/* </summary>                                         */
+static OPJ_TARGET_AVX2 void v8dwt_decode(v8dwt_t* restrict dwt){
+	int a, b;
+	if(dwt->cas == 0) {
+		if(!((dwt->dn > 0) || (dwt->sn > 1))){
+			return;
+		}
+		a = 0;
+		b = 1;
+	}else{
+		if(!((dwt->sn > 0) || (dwt->dn > 1))) {
+			return;
+		}
+		a = 1;
+		b = 0;
+	}
+	v8dwt_decode_step1_avx2(dwt->wavelet+a, dwt->sn, _mm256_set1_ps(K));
+	v8dwt_decode_step1_avx2(dwt->wavelet+b, dwt->dn, _mm256_set1_ps(c13318));
+	v8dwt_decode_step2_avx2(dwt->wavelet+b, dwt->wavelet+a+1, dwt->sn, int_min(dwt->sn, dwt->dn-a), _mm256_set1_ps(dwt_delta));
+	v8dwt_decode_step2_avx2(dwt->wavelet+a, dwt->wavelet+b+1, dwt->dn, int_min(dwt->dn, dwt->sn-b), _mm256_set1_ps(dwt_gamma));
+	v8dwt_decode_step2_avx2(dwt->wavelet+b, dwt->wavelet+a+1, dwt->sn, int_min(dwt->sn, dwt->dn-a), _mm256_set1_ps(dwt_beta));
+	v8dwt_decode_step2_avx2(dwt->wavelet+a, dwt->wavelet+b+1, dwt->dn, int_min(dwt->dn, dwt->sn-b), _mm256_set1_ps(dwt_alpha));
+}
+
+#endif
+
+/* <summary>                                               */
+/* Inverse 9-7 transform of a band of rows, 4 at a time.    */
+/* </summary>                                              */
+static void v4dwt_decode_h_job(void *user_data, int jobno, int threadno) {
+	dwt_decode_job_t* job = (dwt_decode_job_t*) user_data;
+	v4dwt_t h = job->h97;
+	int w = job->w;
+	int rw = job->rw;
+	int j = jobno * job->step;
+	int end = int_min(j + job->step, job->count);
+	float * restrict aj = (float*) job->data + j * w;
+	int bufsize = job->bufsize - j * w;
+
+	h.wavelet = (v4*) job->mem[threadno];
+#ifdef OPJ_HAVE_AVX2
+	if (job->features & OPJ_CPU_AVX2) {
+		v8dwt_t h8;
+		h8.wavelet = (v8*) job->mem[threadno];
+		h8.dn = h.dn;
+		h8.sn = h.sn;
+		h8.cas = h.cas;
+		for(; end - j > 7; j += 8){
+			int k, l;
+			v8dwt_interleave_h(&h8, aj, w);
+			v8dwt_decode(&h8);
+			for(l = 0; l < 8; ++l){
+				for(k = 0; k < rw; ++k){
+					aj[k + w*l] = h8.wavelet[k].f[l];
+				}
+			}
+			aj += w*8;
+			bufsize -= w*8;
+		}
+	}
+#endif
+	for(; end - j > 3; j += 4){
+		int k;
+		v4dwt_interleave_h(&h, aj, w, bufsize);
+		v4dwt_decode(&h, job->features);
+		for(k = rw; --k >= 0;){
+			aj[k    ] = h.wavelet[k].f[0];
+			aj[k+w  ] = h.wavelet[k].f[1];
+			aj[k+w*2] = h.wavelet[k].f[2];
+			aj[k+w*3] = h.wavelet[k].f[3];
+		}
+		aj += w*4;
+		bufsize -= w*4;
+	}
+	if (j < end) {
+		int k;
+		int left = end - j;
+		v4dwt_interleave_h(&h, aj, w, bufsize);
+		v4dwt_decode(&h, job->features);
+		for(k = rw; --k >= 0;){
+			switch(left) {
+				case 3: aj[k+w*2] = h.wavelet[k].f[2];
+				case 2: aj[k+w  ] = h.wavelet[k].f[1];
+				case 1: aj[k    ] = h.wavelet[k].f[0];
+			}
+		}
+	}
+}
+
+/* <summary>                                                 */
+/* Inverse 9-7 transform of a band of columns, 4 at a time.  */
+/* </summary>                                                */
+static void v4dwt_decode_v_job(void *user_data, int jobno, int threadno) {
+	dwt_decode_job_t* job = (dwt_decode_job_t*) user_data;
+	v4dwt_t v = job->v97;
+	int w = job->w;
+	int rh = job->rh;
+	int j = jobno * job->step;
+	int end = int_min(j + job->step, job->count);
+	float * restrict aj = (float*) job->data + j;
+
+	v.wavelet = (v4*) job->mem[threadno];
+#ifdef OPJ_HAVE_AVX2
+	if (job->features & OPJ_CPU_AVX2) {
+		v8dwt_t v8w;
+		v8w.wavelet = (v8*) job->mem[threadno];
+		v8w.dn = v.dn;
+		v8w.sn = v.sn;
+		v8w.cas = v.cas;
+		for(; end - j > 7; j += 8){
+			int k;
+			v8dwt_interleave_v(&v8w, aj, w);
+			v8dwt_decode(&v8w);
+			for(k = 0; k < rh; ++k){
+				memcpy(&aj[k*w], &v8w.wavelet[k], 8 * sizeof(float));
+			}
+			aj += 8;
+		}
+	}
 #endif
+	for(; end - j > 3; j += 4){
+		int k;
+		v4dwt_interleave_v(&v, aj, w);
+		v4dwt_decode(&v, job->features);
+		for(k = 0; k < rh; ++k){
+			memcpy(&aj[k*w], &v.wavelet[k], 4 * sizeof(float));
+		}
+		aj += 4;
+	}
+	if (j < end){
+		int k;
+		int left = end - j;
+		v4dwt_interleave_v(&v, aj, w);
+		v4dwt_decode(&v, job->features);
+		for(k = 0; k < rh; ++k){
+			memcpy(&aj[k*w], &v.wavelet[k], left * sizeof(float));
+		}
+	}
 }
 
 /* <summary>                             */
 /* Inverse 9-7 wavelet transform in 2-D. */
 /* </summary>                            */
-void dwt_decode_real(opj_tcd_tilecomp_t* restrict tilec, int numres){
-	v4dwt_t h;
-	v4dwt_t v;
+void dwt_decode_real(opj_tcd_tilecomp_t* restrict tilec, int numres, opj_thread_pool_t *tp){
+	dwt_decode_job_t job;
 
 	opj_tcd_resolution_t* res = tilec->resolutions;
 
 	int rw = res->x1 - res->x0;	/* width of the resolution level computed */
 	int rh = res->y1 - res->y0;	/* height of the resolution level computed */
 
-	int w = tilec->x1 - tilec->x0;
-
-	h.wavelet = (v4*) opj_aligned_malloc((dwt_decode_max_resolution(res, numres)+5) * sizeof(v4));
-	v.wavelet = h.wavelet;
+	memset(&job, 0, sizeof(job));
+	job.data = tilec->data;
+	job.w = tilec->x1 - tilec->x0;
+	job.bufsize = (tilec->x1 - tilec->x0) * (tilec->y1 - tilec->y0);
+	job.features = opj_get_cpu_features();
+	job.lanes = (job.features & OPJ_CPU_AVX2) ? 8 : 4;
+	job.mem = dwt_alloc_thread_mem(tp, (dwt_decode_max_resolution(res, numres)+5) * (job.lanes == 8 ? sizeof(v8) : sizeof(v4)));
+	if (!job.mem) {
+		return;
+	}
 
 	while( --numres) {
-		float * restrict aj = (float*) tilec->data;
-		int bufsize = (tilec->x1 - tilec->x0) * (tilec->y1 - tilec->y0);
-		int j;
+		int num_jobs;
 
-		h.sn = rw;
-		v.sn = rh;
+		job.h97.sn = rw;
+		job.v97.sn = rh;
 
 		++res;
 
 		rw = res->x1 - res->x0;	/* width of the resolution level computed */
 		rh = res->y1 - res->y0;	/* height of the resolution level computed */
+		job.rw = rw;
+		job.rh = rh;
 
-		h.dn = rw - h.sn;
-		h.cas = res->x0 % 2;
+		job.h97.dn = rw - job.h97.sn;
+		job.h97.cas = res->x0 % 2;
 
-		for(j = rh; j > 3; j -= 4){
-			int k;
-			v4dwt_interleave_h(&h, aj, w, bufsize);
-			v4dwt_decode(&h);
-				for(k = rw; --k >= 0;){
-					aj[k    ] = h.wavelet[k].f[0];
-					aj[k+w  ] = h.wavelet[k].f[1];
-					aj[k+w*2] = h.wavelet[k].f[2];
-					aj[k+w*3] = h.wavelet[k].f[3];
-				}
-			aj += w*4;
-			bufsize -= w*4;
-		}
-		if (rh & 0x03) {
-				int k;
-			j = rh & 0x03;
-			v4dwt_interleave_h(&h, aj, w, bufsize);
-			v4dwt_decode(&h);
-				for(k = rw; --k >= 0;){
-					switch(j) {
-						case 3: aj[k+w*2] = h.wavelet[k].f[2];
-						case 2: aj[k+w  ] = h.wavelet[k].f[1];
-						case 1: aj[k    ] = h.wavelet[k].f[0];
-					}
-				}
-			}
+		num_jobs = dwt_split_jobs(&job, rh, job.lanes, tp);
+		opj_thread_pool_run(tp, num_jobs, v4dwt_decode_h_job, &job);
 
-		v.dn = rh - v.sn;
-		v.cas = res->y0 % 2;
+		job.v97.dn = rh - job.v97.sn;
+		job.v97.cas = res->y0 % 2;
 
-		aj = (float*) tilec->data;
-		for(j = rw; j > 3; j -= 4){
-			int k;
-			v4dwt_interleave_v(&v, aj, w);
-			v4dwt_decode(&v);
-				for(k = 0; k < rh; ++k){
-					memcpy(&aj[k*w], &v.wavelet[k], 4 * sizeof(float));
-				}
-			aj += 4;
-		}
-		if (rw & 0x03){
-				int k;
-			j = rw & 0x03;
-			v4dwt_interleave_v(&v, aj, w);
-			v4dwt_decode(&v);
-				for(k = 0; k < rh; ++k){
-					memcpy(&aj[k*w], &v.wavelet[k], j * sizeof(float));
-				}
-			}
+		num_jobs = dwt_split_jobs(&job, rw, job.lanes, tp);
+		opj_thread_pool_run(tp, num_jobs, v4dwt_decode_v_job, &job);
 	}
 
-	opj_aligned_free(h.wavelet);
+	dwt_free_thread_mem(tp, job.mem);
 }
-
@@ -58,8 +58,9 @@ Inverse 5-3 wavelet tranform in 2-D.
 Apply a reversible inverse DWT transform to a component of an image.
 @param tilec Tile component information (current tile)
 @param numres Number of resolution levels to decode
+@param tp Thread pool the rows and columns of each level are spread over, may be NULL
 */
-void dwt_decode(opj_tcd_tilecomp_t* tilec, int numres);
+void dwt_decode(opj_tcd_tilecomp_t* tilec, int numres, opj_thread_pool_t *tp);
 /**
 Get the gain of a subband for the reversible 5-3 DWT.
 @param orient Number that identifies the subband (0->LL, 1->HL, 2->LH, 3->HH)
@@ -84,8 +85,9 @@ Inverse 9-7 wavelet transform in 2-D.
 Apply an irreversible inverse DWT transform to a component of an image.
 @param tilec Tile component information (current tile)
 @param numres Number of resolution levels to decode
+@param tp Thread pool the rows and columns of each level are spread over, may be NULL
 */
-void dwt_decode_real(opj_tcd_tilecomp_t* tilec, int numres);
+void dwt_decode_real(opj_tcd_tilecomp_t* tilec, int numres, opj_thread_pool_t *tp);
 /**
 Get the gain of a subband for the irreversible 9-7 DWT.
 @param orient Number that identifies the subband (0->LL, 1->HL, 2->LH, 3->HH)
@@ -228,6 +228,8 @@ typedef struct opj_cp {
 	int layer;
 	/** if == NO_LIMITATION, decode entire codestream; if == LIMIT_TO_MAIN_HEADER then only decode the main header */
 	OPJ_LIMIT_DECODING limit_decoding;
+	/** number of threads to decode a tile with, <= 1 decodes on the calling thread only */
+	int num_threads;
 	/** XTOsiz */
 	int tx0;
 	/** YTOsiz */
@@ -29,10 +29,6 @@
  * POSSIBILITY OF SUCH DAMAGE.
  */
 
-#ifdef __SSE__
-#include <xmmintrin.h>
-#endif
-
 #include "opj_includes.h"
 
 /* <summary> */
@@ -68,6 +64,56 @@ void mct_encode(
 	}
 }
 
+#ifdef OPJ_HAVE_SSE2
+/* <summary> */
+/* Inverse reversible MCT, 4 samples at a time. */
+/* Returns the number of samples done. */
+/* </summary> */
+static int mct_decode_sse2(
+		int* restrict c0,
+		int* restrict c1,
+		int* restrict c2,
+		int n)
+{
+	int i;
+	for (i = 0; i + 4 <= n; i += 4) {
+		__m128i y = _mm_loadu_si128((const __m128i*)(c0 + i));
+		__m128i u = _mm_loadu_si128((const __m128i*)(c1 + i));
+		__m128i v = _mm_loadu_si128((const __m128i*)(c2 + i));
+		__m128i g = _mm_sub_epi32(y, _mm_srai_epi32(_mm_add_epi32(u, v), 2));
+		_mm_storeu_si128((__m128i*)(c0 + i), _mm_add_epi32(v, g));
+		_mm_storeu_si128((__m128i*)(c1 + i), g);
+		_mm_storeu_si128((__m128i*)(c2 + i), _mm_add_epi32(u, g));
+	}
+	return i;
+}
+#endif
+
+#ifdef OPJ_HAVE_AVX2
+/* <summary> */
+/* Inverse reversible MCT, 8 samples at a time. */
+/* Returns the number of samples done. */
+/* </summary> */
+static OPJ_TARGET_AVX2 int mct_decode_avx2(
+		int* restrict c0,
+		int* restrict c1,
+		int* restrict c2,
+		int n)
+{
+	int i;
+	for (i = 0; i + 8 <= n; i += 8) {
+		__m256i y = _mm256_loadu_si256((const __m256i*)(c0 + i));
+		__m256i u = _mm256_loadu_si256((const __m256i*)(c1 + i));
+		__m256i v = _mm256_loadu_si256((const __m256i*)(c2 + i));
+		__m256i g = _mm256_sub_epi32(y, _mm256_srai_epi32(_mm256_add_epi32(u, v), 2));
+		_mm256_storeu_si256((__m256i*)(c0 + i), _mm256_add_epi32(v, g));
+		_mm256_storeu_si256((__m256i*)(c1 + i), g);
+		_mm256_storeu_si256((__m256i*)(c2 + i), _mm256_add_epi32(u, g));
+	}
+	return i;
+}
+#endif
+
 /* <summary> */
 /* Inverse reversible MCT. */
 /* </summary> */
@@ -77,8 +123,20 @@ void mct_decode(
 		int* restrict c2, 
 		int n)
 {
-	int i;
-	for (i = 0; i < n; ++i) {
+	int i = 0;
+	int features = opj_get_cpu_features();
+#ifdef OPJ_HAVE_AVX2
+	if (features & OPJ_CPU_AVX2) {
+		i = mct_decode_avx2(c0, c1, c2, n);
+	} else
+#endif
+#ifdef OPJ_HAVE_SSE2
+	if (features & OPJ_CPU_SSE2) {
+		i = mct_decode_sse2(c0, c1, c2, n);
+	}
+#endif
+	(void)features;
+	for (; i < n; ++i) {
 		int y = c0[i];
 		int u = c1[i];
 		int v = c2[i];
@@ -121,6 +179,38 @@ void mct_encode_real(
 	}
 }
 
+#ifdef OPJ_HAVE_AVX2
+/* <summary> */
+/* Inverse irreversible MCT, 8 samples at a time. */
+/* Returns the number of samples done. */
+/* </summary> */
+static OPJ_TARGET_AVX2 int mct_decode_real_avx2(
+		float* restrict c0,
+		float* restrict c1,
+		float* restrict c2,
+		int n)
+{
+	__m256 vrv = _mm256_set1_ps(1.402f);
+	__m256 vgu = _mm256_set1_ps(0.34413f);
+	__m256 vgv = _mm256_set1_ps(0.71414f);
+	__m256 vbu = _mm256_set1_ps(1.772f);
+	int i;
+	/* same operations in the same order as the scalar code, so results are bit exact */
+	for (i = 0; i + 8 <= n; i += 8) {
+		__m256 vy = _mm256_loadu_ps(c0 + i);
+		__m256 vu = _mm256_loadu_ps(c1 + i);
+		__m256 vv = _mm256_loadu_ps(c2 + i);
+		__m256 vr = _mm256_add_ps(vy, _mm256_mul_ps(vv, vrv));
+		__m256 vg = _mm256_sub_ps(_mm256_sub_ps(vy, _mm256_mul_ps(vu, vgu)), _mm256_mul_ps(vv, vgv));
+		__m256 vb = _mm256_add_ps(vy, _mm256_mul_ps(vu, vbu));
+		_mm256_storeu_ps(c0 + i, vr);
+		_mm256_storeu_ps(c1 + i, vg);
+		_mm256_storeu_ps(c2 + i, vb);
+	}
+	return i;
+}
+#endif
+
 /* <summary> */
 /* Inverse irreversible MCT. */
 /* </summary> */
@@ -131,44 +221,57 @@ void mct_decode_real(
 		int n)
 {
 	int i;
-#ifdef __SSE__
-	__m128 vrv, vgu, vgv, vbu;
-	vrv = _mm_set1_ps(1.402f);
-	vgu = _mm_set1_ps(0.34413f);
-	vgv = _mm_set1_ps(0.71414f);
-	vbu = _mm_set1_ps(1.772f);
-	for (i = 0; i < (n >> 3); ++i) {
-		__m128 vy, vu, vv;
-		__m128 vr, vg, vb;
+	int features = opj_get_cpu_features();
+#ifdef OPJ_HAVE_AVX2
+	if (features & OPJ_CPU_AVX2) {
+		i = mct_decode_real_avx2(c0, c1, c2, n);
+		c0 += i;
+		c1 += i;
+		c2 += i;
+		n -= i;
+	}
+#endif
+#ifdef OPJ_HAVE_SSE2
+	if (features & OPJ_CPU_SSE2) {
+		__m128 vrv, vgu, vgv, vbu;
+		vrv = _mm_set1_ps(1.402f);
+		vgu = _mm_set1_ps(0.34413f);
+		vgv = _mm_set1_ps(0.71414f);
+		vbu = _mm_set1_ps(1.772f);
+		for (i = 0; i < (n >> 3); ++i) {
+			__m128 vy, vu, vv;
+			__m128 vr, vg, vb;
 
-		vy = _mm_load_ps(c0);
-		vu = _mm_load_ps(c1);
-		vv = _mm_load_ps(c2);
-		vr = _mm_add_ps(vy, _mm_mul_ps(vv, vrv));
-		vg = _mm_sub_ps(_mm_sub_ps(vy, _mm_mul_ps(vu, vgu)), _mm_mul_ps(vv, vgv));
-		vb = _mm_add_ps(vy, _mm_mul_ps(vu, vbu));
-		_mm_store_ps(c0, vr);
-		_mm_store_ps(c1, vg);
-		_mm_store_ps(c2, vb);
-		c0 += 4;
-		c1 += 4;
-		c2 += 4;
+			vy = _mm_load_ps(c0);
+			vu = _mm_load_ps(c1);
+			vv = _mm_load_ps(c2);
+			vr = _mm_add_ps(vy, _mm_mul_ps(vv, vrv));
+			vg = _mm_sub_ps(_mm_sub_ps(vy, _mm_mul_ps(vu, vgu)), _mm_mul_ps(vv, vgv));
+			vb = _mm_add_ps(vy, _mm_mul_ps(vu, vbu));
+			_mm_store_ps(c0, vr);
+			_mm_store_ps(c1, vg);
+			_mm_store_ps(c2, vb);
+			c0 += 4;
+			c1 += 4;
+			c2 += 4;
 
-		vy = _mm_load_ps(c0);
-		vu = _mm_load_ps(c1);
-		vv = _mm_load_ps(c2);
-		vr = _mm_add_ps(vy, _mm_mul_ps(vv, vrv));
-		vg = _mm_sub_ps(_mm_sub_ps(vy, _mm_mul_ps(vu, vgu)), _mm_mul_ps(vv, vgv));
-		vb = _mm_add_ps(vy, _mm_mul_ps(vu, vbu));
-		_mm_store_ps(c0, vr);
-		_mm_store_ps(c1, vg);
-		_mm_store_ps(c2, vb);
-		c0 += 4;
-		c1 += 4;
-		c2 += 4;
+			vy = _mm_load_ps(c0);
+			vu = _mm_load_ps(c1);
+			vv = _mm_load_ps(c2);
+			vr = _mm_add_ps(vy, _mm_mul_ps(vv, vrv));
+			vg = _mm_sub_ps(_mm_sub_ps(vy, _mm_mul_ps(vu, vgu)), _mm_mul_ps(vv, vgv));
+			vb = _mm_add_ps(vy, _mm_mul_ps(vu, vbu));
+			_mm_store_ps(c0, vr);
+			_mm_store_ps(c1, vg);
+			_mm_store_ps(c2, vb);
+			c0 += 4;
+			c1 += 4;
+			c2 += 4;
+		}
+		n &= 7;
 	}
-	n &= 7;
 #endif
+	(void)features;
 	for(i = 0; i < n; ++i) {
 		float y = c0[i];
 		float u = c1[i];
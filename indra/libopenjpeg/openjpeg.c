@@ -62,6 +62,27 @@ const char* OPJ_CALLCONV opj_version(void) {
     return PACKAGE_VERSION;
 }
 
+/* -1 until the application sets them */
+static int opj_cpu_features = -1;
+
+void OPJ_CALLCONV opj_set_cpu_features(int features) {
+	opj_cpu_features = features;
+}
+
+int OPJ_CALLCONV opj_get_cpu_features(void) {
+	int supported = 0;
+#ifdef OPJ_HAVE_SSE2
+	supported |= OPJ_CPU_SSE2;
+#endif
+#ifdef OPJ_HAVE_AVX2
+	supported |= OPJ_CPU_AVX2;
+#endif
+	if (opj_cpu_features < 0) {
+		return supported & OPJ_CPU_SSE2;
+	}
+	return opj_cpu_features & supported;
+}
+
 opj_dinfo_t* OPJ_CALLCONV opj_create_decompress(OPJ_CODEC_FORMAT format) {
 	opj_dinfo_t *dinfo = (opj_dinfo_t*)opj_calloc(1, sizeof(opj_dinfo_t));
 	if(!dinfo) return NULL;
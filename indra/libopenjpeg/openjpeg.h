@@ -410,8 +410,18 @@ typedef struct opj_dparameters {
 	OPJ_LIMIT_DECODING cp_limit_decoding;
 
 	unsigned int flags;
+
+	/**
+	Number of threads the tier-1 code-block decoding and the inverse DWT of a large tile
+	are spread over, the calling thread included.
+	if <= 1, the tile is decoded on the calling thread only
+	*/
+	int cp_num_threads;
 } opj_dparameters_t;
 
+/** opj_dparameters_t has cp_num_threads */
+#define OPJ_HAVE_DECODE_THREADS 1
+
 /** Common fields between JPEG-2000 compression and decompression master structs. */
 
 #define opj_common_fields \
@@ -731,6 +741,30 @@ extern "C" {
 
 OPJ_API const char * OPJ_CALLCONV opj_version(void);
 
+/* 
+==========================================================
+   cpu features
+==========================================================
+*/
+
+/** SSE2 inverse DWT and MCT (x86) */
+#define OPJ_CPU_SSE2	0x0001
+/** AVX2 inverse DWT and MCT (x86), needs OS support for the YMM registers too */
+#define OPJ_CPU_AVX2	0x0002
+
+/**
+Set the instruction set extensions the decoder may use, the library does no detection itself.
+Extensions this build has no code for are ignored. Should be called before decoding starts.
+If never called, SSE2 is used when the compiler targets it and AVX2 is not used.
+@param features OR'ed OPJ_CPU_* flags, 0 for the plain C code
+*/
+OPJ_API void OPJ_CALLCONV opj_set_cpu_features(int features);
+/**
+Get the instruction set extensions the decoder uses
+@return Returns the OR'ed OPJ_CPU_* flags set with opj_set_cpu_features that this build supports
+*/
+OPJ_API int OPJ_CALLCONV opj_get_cpu_features(void);
+
 /* 
 ==========================================================
    image functions definitions
@@ -104,6 +104,26 @@ static INLINE long lrintf(float f){
 }
 #endif
 
+/*
+SIMD code paths, picked at run time with opj_set_cpu_features().
+SSE2 is part of every x86-64 target; AVX2 functions are compiled for it one by one
+so the rest of the library still runs on older CPUs.
+*/
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#define OPJ_HAVE_SSE2
+	#include <emmintrin.h>
+	#if defined(_MSC_VER) && _MSC_VER >= 1700
+		#define OPJ_HAVE_AVX2
+		#define OPJ_TARGET_AVX2
+	#elif defined(__clang__) || (defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9)))
+		#define OPJ_HAVE_AVX2
+		#define OPJ_TARGET_AVX2 __attribute__((target("avx2")))
+	#endif
+	#ifdef OPJ_HAVE_AVX2
+		#include <immintrin.h>
+	#endif
+#endif
+
 #include "j2k_lib.h"
 #include "opj_malloc.h"
 #include "event.h"
@@ -121,6 +141,7 @@ static INLINE long lrintf(float f){
 #include "tgt.h"
 #include "pi.h"
 #include "tcd.h"
+#include "thread.h"
 #include "t1.h"
 #include "dwt.h"
 #include "t2.h"
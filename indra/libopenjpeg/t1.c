@@ -1504,6 +1504,82 @@ void t1_encode_cblks(
 	} /* compno  */
 }
 
+/* Decodes one code-block and stores its coefficients in the tile component */
+static void t1_decode_cblk_to_tile(
+		opj_t1_t* t1,
+		opj_tcd_tilecomp_t* tilec,
+		opj_tccp_t* tccp,
+		int resno,
+		opj_tcd_band_t* band,
+		opj_tcd_cblk_dec_t* cblk)
+{
+	int tile_w = tilec->x1 - tilec->x0;
+	int* restrict datap;
+	int cblk_w, cblk_h;
+	int x, y;
+	int i, j;
+
+	t1_decode_cblk(
+			t1,
+			cblk,
+			band->bandno,
+			tccp->roishift,
+			tccp->cblksty);
+
+	x = cblk->x0 - band->x0;
+	y = cblk->y0 - band->y0;
+	if (band->bandno & 1) {
+		opj_tcd_resolution_t* pres = &tilec->resolutions[resno - 1];
+		x += pres->x1 - pres->x0;
+	}
+	if (band->bandno & 2) {
+		opj_tcd_resolution_t* pres = &tilec->resolutions[resno - 1];
+		y += pres->y1 - pres->y0;
+	}
+
+	datap=t1->data;
+	cblk_w = t1->w;
+	cblk_h = t1->h;
+
+	if (tccp->roishift) {
+		int thresh = 1 << tccp->roishift;
+		for (j = 0; j < cblk_h; ++j) {
+			for (i = 0; i < cblk_w; ++i) {
+				int val = datap[(j * cblk_w) + i];
+				int mag = abs(val);
+				if (mag >= thresh) {
+					mag >>= tccp->roishift;
+					datap[(j * cblk_w) + i] = val < 0 ? -mag : mag;
+				}
+			}
+		}
+	}
+
+	if (tccp->qmfbid == 1) {
+		int* restrict tiledp = &tilec->data[(y * tile_w) + x];
+		for (j = 0; j < cblk_h; ++j) {
+			for (i = 0; i < cblk_w; ++i) {
+				int tmp = datap[(j * cblk_w) + i];
+				((int*)tiledp)[(j * tile_w) + i] = tmp / 2;
+			}
+		}
+	} else {		/* if (tccp->qmfbid == 0) */
+		float* restrict tiledp = (float*) &tilec->data[(y * tile_w) + x];
+		for (j = 0; j < cblk_h; ++j) {
+			float* restrict tiledp2 = tiledp;
+			for (i = 0; i < cblk_w; ++i) {
+				float tmp = *datap * band->stepsize;
+				*tiledp2 = tmp;
+				datap++;
+				tiledp2++;
+			}
+			tiledp += tile_w;
+		}
+	}
+	opj_free(cblk->data);
+	opj_free(cblk->segs);
+}
+
 void t1_decode_cblks(
 		opj_t1_t* t1,
 		opj_tcd_tilecomp_t* tilec,
@@ -1511,8 +1587,6 @@ void t1_decode_cblks(
 {
 	int resno, bandno, precno, cblkno;
 
-	int tile_w = tilec->x1 - tilec->x0;
-
 	for (resno = 0; resno < tilec->numresolutions; ++resno) {
 		opj_tcd_resolution_t* res = &tilec->resolutions[resno];
 
@@ -1523,71 +1597,7 @@ void t1_decode_cblks(
 				opj_tcd_precinct_t* precinct = &band->precincts[precno];
 
 				for (cblkno = 0; cblkno < precinct->cw * precinct->ch; ++cblkno) {
-					opj_tcd_cblk_dec_t* cblk = &precinct->cblks.dec[cblkno];
-					int* restrict datap;
-					int cblk_w, cblk_h;
-					int x, y;
-					int i, j;
-
-					t1_decode_cblk(
-							t1,
-							cblk,
-							band->bandno,
-							tccp->roishift,
-							tccp->cblksty);
-
-					x = cblk->x0 - band->x0;
-					y = cblk->y0 - band->y0;
-					if (band->bandno & 1) {
-						opj_tcd_resolution_t* pres = &tilec->resolutions[resno - 1];
-						x += pres->x1 - pres->x0;
-					}
-					if (band->bandno & 2) {
-						opj_tcd_resolution_t* pres = &tilec->resolutions[resno - 1];
-						y += pres->y1 - pres->y0;
-					}
-
-					datap=t1->data;
-					cblk_w = t1->w;
-					cblk_h = t1->h;
-
-					if (tccp->roishift) {
-						int thresh = 1 << tccp->roishift;
-						for (j = 0; j < cblk_h; ++j) {
-							for (i = 0; i < cblk_w; ++i) {
-								int val = datap[(j * cblk_w) + i];
-								int mag = abs(val);
-								if (mag >= thresh) {
-									mag >>= tccp->roishift;
-									datap[(j * cblk_w) + i] = val < 0 ? -mag : mag;
-								}
-							}
-						}
-					}
-
-					if (tccp->qmfbid == 1) {
-						int* restrict tiledp = &tilec->data[(y * tile_w) + x];
-						for (j = 0; j < cblk_h; ++j) {
-							for (i = 0; i < cblk_w; ++i) {
-								int tmp = datap[(j * cblk_w) + i];
-								((int*)tiledp)[(j * tile_w) + i] = tmp / 2;
-							}
-						}
-					} else {		/* if (tccp->qmfbid == 0) */
-						float* restrict tiledp = (float*) &tilec->data[(y * tile_w) + x];
-						for (j = 0; j < cblk_h; ++j) {
-							float* restrict tiledp2 = tiledp;
-							for (i = 0; i < cblk_w; ++i) {
-								float tmp = *datap * band->stepsize;
-								*tiledp2 = tmp;
-								datap++;
-								tiledp2++;
-							}
-							tiledp += tile_w;
-						}
-					}
-					opj_free(cblk->data);
-					opj_free(cblk->segs);
+					t1_decode_cblk_to_tile(t1, tilec, tccp, resno, band, &precinct->cblks.dec[cblkno]);
 				} /* cblkno */
 				opj_free(precinct->cblks.dec);
                 precinct->cblks.dec = NULL;
@@ -1596,3 +1606,120 @@ void t1_decode_cblks(
 	} /* resno */
 }
 
+/** A code-block to decode, with what is needed to place it in its tile component */
+typedef struct opj_t1_cblk_job {
+	opj_tcd_tilecomp_t* tilec;
+	opj_tccp_t* tccp;
+	opj_tcd_band_t* band;
+	opj_tcd_cblk_dec_t* cblk;
+	int resno;
+} opj_t1_cblk_job_t;
+
+typedef struct opj_t1_decode_jobs {
+	opj_t1_t** t1s;				/**< T1 handle of each thread */
+	opj_t1_cblk_job_t* jobs;
+} opj_t1_decode_jobs_t;
+
+static void t1_decode_cblk_job(void *user_data, int jobno, int threadno) {
+	opj_t1_decode_jobs_t* d = (opj_t1_decode_jobs_t*) user_data;
+	opj_t1_cblk_job_t* job = &d->jobs[jobno];
+	t1_decode_cblk_to_tile(d->t1s[threadno], job->tilec, job->tccp, job->resno, job->band, job->cblk);
+}
+
+opj_bool t1_decode_tile_cblks(
+		opj_common_ptr cinfo,
+		opj_tcd_tile_t* tile,
+		opj_tcp_t* tcp,
+		opj_thread_pool_t* tp)
+{
+	opj_t1_decode_jobs_t d;
+	int num_threads = opj_thread_pool_size(tp);
+	int num_jobs = 0;
+	int compno, resno, bandno, precno, cblkno, i;
+	opj_bool res_ok = OPJ_TRUE;
+
+	/* Every code-block writes its own area of the tile component, so they can
+	   be decoded in any order as long as each thread has its own T1 buffers */
+	for (compno = 0; compno < tile->numcomps; ++compno) {
+		opj_tcd_tilecomp_t* tilec = &tile->comps[compno];
+		for (resno = 0; resno < tilec->numresolutions; ++resno) {
+			opj_tcd_resolution_t* res = &tilec->resolutions[resno];
+			for (bandno = 0; bandno < res->numbands; ++bandno) {
+				opj_tcd_band_t* band = &res->bands[bandno];
+				for (precno = 0; precno < res->pw * res->ph; ++precno) {
+					opj_tcd_precinct_t* precinct = &band->precincts[precno];
+					num_jobs += precinct->cw * precinct->ch;
+				}
+			}
+		}
+	}
+
+	d.t1s = (opj_t1_t**) opj_calloc(num_threads, sizeof(opj_t1_t*));
+	d.jobs = (opj_t1_cblk_job_t*) opj_malloc(int_max(num_jobs, 1) * sizeof(opj_t1_cblk_job_t));
+	if (!d.t1s || !d.jobs) {
+		opj_free(d.t1s);
+		opj_free(d.jobs);
+		return OPJ_FALSE;
+	}
+	for (i = 0; i < num_threads; ++i) {
+		d.t1s[i] = t1_create(cinfo);
+		if (!d.t1s[i]) {
+			res_ok = OPJ_FALSE;
+		}
+	}
+
+	num_jobs = 0;
+	for (compno = 0; compno < tile->numcomps; ++compno) {
+		opj_tcd_tilecomp_t* tilec = &tile->comps[compno];
+		for (resno = 0; resno < tilec->numresolutions; ++resno) {
+			opj_tcd_resolution_t* res = &tilec->resolutions[resno];
+			for (bandno = 0; bandno < res->numbands; ++bandno) {
+				opj_tcd_band_t* band = &res->bands[bandno];
+				for (precno = 0; precno < res->pw * res->ph; ++precno) {
+					opj_tcd_precinct_t* precinct = &band->precincts[precno];
+					for (cblkno = 0; cblkno < precinct->cw * precinct->ch; ++cblkno) {
+						opj_t1_cblk_job_t* job = &d.jobs[num_jobs++];
+						job->tilec = tilec;
+						job->tccp = &tcp->tccps[compno];
+						job->band = band;
+						job->cblk = &precinct->cblks.dec[cblkno];
+						job->resno = resno;
+					}
+				}
+			}
+		}
+	}
+
+	if (res_ok) {
+		opj_thread_pool_run(tp, num_jobs, t1_decode_cblk_job, &d);
+	}
+
+	for (compno = 0; compno < tile->numcomps; ++compno) {
+		opj_tcd_tilecomp_t* tilec = &tile->comps[compno];
+		for (resno = 0; resno < tilec->numresolutions; ++resno) {
+			opj_tcd_resolution_t* res = &tilec->resolutions[resno];
+			for (bandno = 0; bandno < res->numbands; ++bandno) {
+				opj_tcd_band_t* band = &res->bands[bandno];
+				for (precno = 0; precno < res->pw * res->ph; ++precno) {
+					opj_tcd_precinct_t* precinct = &band->precincts[precno];
+					if (!res_ok) {
+						/* not decoded, the jobs did not get to free these */
+						for (cblkno = 0; cblkno < precinct->cw * precinct->ch; ++cblkno) {
+							opj_free(precinct->cblks.dec[cblkno].data);
+							opj_free(precinct->cblks.dec[cblkno].segs);
+						}
+					}
+					opj_free(precinct->cblks.dec);
+					precinct->cblks.dec = NULL;
+				}
+			}
+		}
+	}
+
+	for (i = 0; i < num_threads; ++i) {
+		t1_destroy(d.t1s[i]);
+	}
+	opj_free(d.t1s);
+	opj_free(d.jobs);
+	return res_ok;
+}
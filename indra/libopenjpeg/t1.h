@@ -139,6 +139,15 @@ Decode the code-blocks of a tile
 @param tccp Tile coding parameters
 */
 void t1_decode_cblks(opj_t1_t* t1, opj_tcd_tilecomp_t* tilec, opj_tccp_t* tccp);
+/**
+Decode the code-blocks of all the components of a tile, spread over a thread pool
+@param cinfo Codec context
+@param tile The tile to decode, the component data must be allocated
+@param tcp Tile coding parameters
+@param tp Thread pool, may be NULL
+@return Returns OPJ_FALSE when out of memory
+*/
+opj_bool t1_decode_tile_cblks(opj_common_ptr cinfo, opj_tcd_tile_t* tile, opj_tcp_t* tcp, opj_thread_pool_t* tp);
 /* ----------------------------------------------------------------------- */
 /*@}*/
 
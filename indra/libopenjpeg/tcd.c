@@ -33,6 +33,9 @@
 #define _ISOC99_SOURCE /* lrintf is C99 */
 #include "opj_includes.h"
 
+/** Tiles smaller than this are decoded on the calling thread only, starting threads would cost more than it saves */
+#define TCD_MT_MIN_TILE_AREA (256 * 256)
+
 void tcd_dump(FILE *fd, opj_tcd_t *tcd, opj_tcd_image_t * img) {
 	int tileno, compno, resno, bandno, precno;/*, cblkno;*/
 
@@ -1336,6 +1339,7 @@ opj_bool tcd_decode_tile(opj_tcd_t *tcd, unsigned char *src, int len, int tileno
 
 	opj_t1_t *t1 = NULL;		/* T1 component */
 	opj_t2_t *t2 = NULL;		/* T2 component */
+	opj_thread_pool_t *tp = NULL;	/* spreads T1 and DWT of large tiles */
 	
 	tcd->tcd_tileno = tileno;
 	tcd->tcd_tile = &(tcd->tcd_image->tiles[tileno]);
@@ -1386,27 +1390,51 @@ opj_bool tcd_decode_tile(opj_tcd_t *tcd, unsigned char *src, int len, int tileno
 	/*------------------TIER1-----------------*/
 	
 	t1_time = opj_clock();	/* time needed to decode a tile */
-	t1 = t1_create(tcd->cinfo);
-    if (t1 == NULL)
-    {
-        opj_event_msg(tcd->cinfo, EVT_ERROR, "Out of memory\n");
-        t1_destroy(t1);
-        return OPJ_FALSE;
-    }
+	if (tcd->cp->num_threads > 1 && (tile->x1 - tile->x0) * (tile->y1 - tile->y0) >= TCD_MT_MIN_TILE_AREA) {
+		/* NULL when another decoder is using the pool, everything then runs here */
+		tp = opj_thread_pool_acquire(tcd->cp->num_threads);
+	}
 
-	for (compno = 0; compno < tile->numcomps; ++compno) {
-		opj_tcd_tilecomp_t* tilec = &tile->comps[compno];
-		/* The +3 is headroom required by the vectorized DWT */
-		tilec->data = (int*) opj_aligned_malloc((((tilec->x1 - tilec->x0) * (tilec->y1 - tilec->y0))+3) * sizeof(int));
-        if (tilec->data == NULL)
-        {
-            opj_event_msg(tcd->cinfo, EVT_ERROR, "Out of memory\n");
-            return OPJ_FALSE;
-        }
+	if (tp) {
+		for (compno = 0; compno < tile->numcomps; ++compno) {
+			opj_tcd_tilecomp_t* tilec = &tile->comps[compno];
+			/* The +3 is headroom required by the vectorized DWT */
+			tilec->data = (int*) opj_aligned_malloc((((tilec->x1 - tilec->x0) * (tilec->y1 - tilec->y0))+3) * sizeof(int));
+			if (tilec->data == NULL)
+			{
+				opj_event_msg(tcd->cinfo, EVT_ERROR, "Out of memory\n");
+				opj_thread_pool_release(tp);
+				return OPJ_FALSE;
+			}
+		}
+		if (!t1_decode_tile_cblks(tcd->cinfo, tile, tcd->tcp, tp)) {
+			opj_event_msg(tcd->cinfo, EVT_ERROR, "Out of memory\n");
+			opj_thread_pool_release(tp);
+			return OPJ_FALSE;
+		}
+	} else {
+		t1 = t1_create(tcd->cinfo);
+		if (t1 == NULL)
+		{
+			opj_event_msg(tcd->cinfo, EVT_ERROR, "Out of memory\n");
+			t1_destroy(t1);
+			return OPJ_FALSE;
+		}
+
+		for (compno = 0; compno < tile->numcomps; ++compno) {
+			opj_tcd_tilecomp_t* tilec = &tile->comps[compno];
+			/* The +3 is headroom required by the vectorized DWT */
+			tilec->data = (int*) opj_aligned_malloc((((tilec->x1 - tilec->x0) * (tilec->y1 - tilec->y0))+3) * sizeof(int));
+			if (tilec->data == NULL)
+			{
+				opj_event_msg(tcd->cinfo, EVT_ERROR, "Out of memory\n");
+				return OPJ_FALSE;
+			}
 
-		t1_decode_cblks(t1, tilec, &tcd->tcp->tccps[compno]);
+			t1_decode_cblks(t1, tilec, &tcd->tcp->tccps[compno]);
+		}
+		t1_destroy(t1);
 	}
-	t1_destroy(t1);
 	t1_time = opj_clock() - t1_time;
 	opj_event_msg(tcd->cinfo, EVT_INFO, "- tiers-1 took %f s\n", t1_time);
 	
@@ -1421,6 +1449,7 @@ opj_bool tcd_decode_tile(opj_tcd_t *tcd, unsigned char *src, int len, int tileno
 			if ( tile->comps[compno].numresolutions < ( tcd->cp->reduce - 1 ) ) {
 				opj_event_msg(tcd->cinfo, EVT_ERROR, "Error decoding tile. The number of resolutions to remove [%d+1] is higher than the number "
 							  " of resolutions in the original codestream [%d]\nModify the cp_reduce parameter.\n", tcd->cp->reduce, tile->comps[compno].numresolutions);
+				opj_thread_pool_release(tp);
 				return OPJ_FALSE;
 			}
 			else {
@@ -1431,18 +1460,21 @@ opj_bool tcd_decode_tile(opj_tcd_t *tcd, unsigned char *src, int len, int tileno
 
 		if(!tilec->data) {
 			opj_event_msg(tcd->cinfo, EVT_ERROR, "Error decoding tile. null data\n");
+			opj_thread_pool_release(tp);
 			return OPJ_FALSE;
 		}
 
 		numres2decode = tcd->image->comps[compno].resno_decoded + 1;
 		if(numres2decode > 0){
 			if (tcd->tcp->tccps[compno].qmfbid == 1) {
-				dwt_decode(tilec, numres2decode);
+				dwt_decode(tilec, numres2decode, tp);
 			} else {
-				dwt_decode_real(tilec, numres2decode);
+				dwt_decode_real(tilec, numres2decode, tp);
 			}
 		}
 	}
+	opj_thread_pool_release(tp);
+	tp = NULL;
 	dwt_time = opj_clock() - dwt_time;
 	opj_event_msg(tcd->cinfo, EVT_INFO, "- dwt took %f s\n", dwt_time);
 
@@ -0,0 +1,265 @@
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS `AS IS'
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif /* _WIN32 */
+#include "opj_includes.h"
+
+#ifdef _WIN32
+typedef HANDLE opj_thread_handle_t;
+typedef CRITICAL_SECTION opj_mutex_t;
+typedef CONDITION_VARIABLE opj_cond_t;
+#define opj_mutex_init(m)		InitializeCriticalSection(m)
+#define opj_mutex_destroy(m)	DeleteCriticalSection(m)
+#define opj_mutex_lock(m)		EnterCriticalSection(m)
+#define opj_mutex_unlock(m)		LeaveCriticalSection(m)
+#define opj_cond_init(c)		InitializeConditionVariable(c)
+#define opj_cond_destroy(c)
+#define opj_cond_wait(c, m)		SleepConditionVariableCS(c, m, INFINITE)
+#define opj_cond_signal(c)		WakeConditionVariable(c)
+#define opj_cond_broadcast(c)	WakeAllConditionVariable(c)
+typedef SRWLOCK opj_static_lock_t;
+#define OPJ_STATIC_LOCK_INIT	SRWLOCK_INIT
+#define opj_static_trylock(l)	(TryAcquireSRWLockExclusive(l) != 0)
+#define opj_static_unlock(l)	ReleaseSRWLockExclusive(l)
+#else
+typedef pthread_t opj_thread_handle_t;
+typedef pthread_mutex_t opj_mutex_t;
+typedef pthread_cond_t opj_cond_t;
+#define opj_mutex_init(m)		pthread_mutex_init(m, NULL)
+#define opj_mutex_destroy(m)	pthread_mutex_destroy(m)
+#define opj_mutex_lock(m)		pthread_mutex_lock(m)
+#define opj_mutex_unlock(m)		pthread_mutex_unlock(m)
+#define opj_cond_init(c)		pthread_cond_init(c, NULL)
+#define opj_cond_destroy(c)		pthread_cond_destroy(c)
+#define opj_cond_wait(c, m)		pthread_cond_wait(c, m)
+#define opj_cond_signal(c)		pthread_cond_signal(c)
+#define opj_cond_broadcast(c)	pthread_cond_broadcast(c)
+typedef pthread_mutex_t opj_static_lock_t;
+#define OPJ_STATIC_LOCK_INIT	PTHREAD_MUTEX_INITIALIZER
+#define opj_static_trylock(l)	(pthread_mutex_trylock(l) == 0)
+#define opj_static_unlock(l)	pthread_mutex_unlock(l)
+#endif /* _WIN32 */
+
+typedef struct opj_worker {
+	opj_thread_pool_t *tp;
+	int threadno;
+	opj_thread_handle_t handle;
+} opj_worker_t;
+
+struct opj_thread_pool {
+	int num_threads;
+	opj_worker_t *workers;	/**< num_threads-1 workers, the caller is thread 0 */
+	opj_mutex_t mutex;
+	opj_cond_t work_cond;	/**< signaled when jobs are posted or on quit */
+	opj_cond_t done_cond;	/**< signaled when the last job of a run completes */
+	opj_job_fn fn;
+	void *user_data;
+	int num_jobs;
+	int next_job;
+	int jobs_done;
+	opj_bool quit;
+};
+
+/* The pool shared by all decoders of the process, and the lock held by the one using it */
+static opj_static_lock_t opj_shared_pool_lock = OPJ_STATIC_LOCK_INIT;
+static opj_thread_pool_t *opj_shared_pool = NULL;
+static int opj_shared_pool_threads = 0;	/**< size asked for, the pool may have fewer threads */
+
+/* Takes jobs until none are left. Called and returns with tp->mutex locked. */
+static void opj_thread_pool_take_jobs(opj_thread_pool_t *tp, int threadno) {
+	while (tp->next_job < tp->num_jobs) {
+		int jobno = tp->next_job++;
+		opj_job_fn fn = tp->fn;
+		void *user_data = tp->user_data;
+		opj_mutex_unlock(&tp->mutex);
+		fn(user_data, jobno, threadno);
+		opj_mutex_lock(&tp->mutex);
+		if (++tp->jobs_done == tp->num_jobs) {
+			opj_cond_signal(&tp->done_cond);
+		}
+	}
+}
+
+#ifdef _WIN32
+static DWORD WINAPI opj_worker_main(LPVOID arg) {
+#else
+static void* opj_worker_main(void *arg) {
+#endif
+	opj_worker_t *worker = (opj_worker_t*) arg;
+	opj_thread_pool_t *tp = worker->tp;
+
+	opj_mutex_lock(&tp->mutex);
+	while (!tp->quit) {
+		opj_thread_pool_take_jobs(tp, worker->threadno);
+		if (!tp->quit) {
+			opj_cond_wait(&tp->work_cond, &tp->mutex);
+		}
+	}
+	opj_mutex_unlock(&tp->mutex);
+	return 0;
+}
+
+static opj_bool opj_worker_start(opj_worker_t *worker) {
+#ifdef _WIN32
+	worker->handle = CreateThread(NULL, 0, opj_worker_main, worker, 0, NULL);
+	return worker->handle != NULL;
+#else
+	return pthread_create(&worker->handle, NULL, opj_worker_main, worker) == 0;
+#endif
+}
+
+static void opj_worker_join(opj_worker_t *worker) {
+#ifdef _WIN32
+	WaitForSingleObject(worker->handle, INFINITE);
+	CloseHandle(worker->handle);
+#else
+	pthread_join(worker->handle, NULL);
+#endif
+}
+
+/* 
+==========================================================
+   Thread pool interface
+==========================================================
+*/
+
+opj_thread_pool_t* opj_thread_pool_create(int num_threads) {
+	opj_thread_pool_t *tp = NULL;
+	int i;
+
+	if (num_threads < 2) {
+		return NULL;
+	}
+	tp = (opj_thread_pool_t*) opj_calloc(1, sizeof(opj_thread_pool_t));
+	if (!tp) {
+		return NULL;
+	}
+	tp->workers = (opj_worker_t*) opj_calloc(num_threads - 1, sizeof(opj_worker_t));
+	if (!tp->workers) {
+		opj_free(tp);
+		return NULL;
+	}
+	opj_mutex_init(&tp->mutex);
+	opj_cond_init(&tp->work_cond);
+	opj_cond_init(&tp->done_cond);
+
+	/* count the caller, then add the workers that actually started */
+	tp->num_threads = 1;
+	for (i = 0; i < num_threads - 1; i++) {
+		opj_worker_t *worker = &tp->workers[tp->num_threads - 1];
+		worker->tp = tp;
+		worker->threadno = tp->num_threads;
+		if (!opj_worker_start(worker)) {
+			break;
+		}
+		tp->num_threads++;
+	}
+	if (tp->num_threads < 2) {
+		opj_thread_pool_destroy(tp);
+		return NULL;
+	}
+	return tp;
+}
+
+void opj_thread_pool_destroy(opj_thread_pool_t *tp) {
+	int i;
+
+	if (!tp) {
+		return;
+	}
+	opj_mutex_lock(&tp->mutex);
+	tp->quit = OPJ_TRUE;
+	opj_cond_broadcast(&tp->work_cond);
+	opj_mutex_unlock(&tp->mutex);
+
+	for (i = 0; i < tp->num_threads - 1; i++) {
+		opj_worker_join(&tp->workers[i]);
+	}
+	opj_cond_destroy(&tp->done_cond);
+	opj_cond_destroy(&tp->work_cond);
+	opj_mutex_destroy(&tp->mutex);
+	opj_free(tp->workers);
+	opj_free(tp);
+}
+
+opj_thread_pool_t* opj_thread_pool_acquire(int num_threads) {
+	if (num_threads < 2 || !opj_static_trylock(&opj_shared_pool_lock)) {
+		return NULL;
+	}
+	if (num_threads != opj_shared_pool_threads) {
+		/* first use, or the number of threads was changed */
+		opj_thread_pool_destroy(opj_shared_pool);
+		opj_shared_pool = opj_thread_pool_create(num_threads);
+		opj_shared_pool_threads = num_threads;
+	}
+	if (!opj_shared_pool) {
+		/* the workers couldn't be started, don't try again for every tile */
+		opj_static_unlock(&opj_shared_pool_lock);
+		return NULL;
+	}
+	return opj_shared_pool;
+}
+
+void opj_thread_pool_release(opj_thread_pool_t *tp) {
+	if (tp) {
+		opj_static_unlock(&opj_shared_pool_lock);
+	}
+}
+
+int opj_thread_pool_size(opj_thread_pool_t *tp) {
+	return tp ? tp->num_threads : 1;
+}
+
+void opj_thread_pool_run(opj_thread_pool_t *tp, int num_jobs, opj_job_fn fn, void *user_data) {
+	if (num_jobs <= 0) {
+		return;
+	}
+	if (!tp || num_jobs == 1) {
+		int jobno;
+		for (jobno = 0; jobno < num_jobs; jobno++) {
+			fn(user_data, jobno, 0);
+		}
+		return;
+	}
+
+	opj_mutex_lock(&tp->mutex);
+	tp->fn = fn;
+	tp->user_data = user_data;
+	tp->num_jobs = num_jobs;
+	tp->next_job = 0;
+	tp->jobs_done = 0;
+	opj_cond_broadcast(&tp->work_cond);
+
+	opj_thread_pool_take_jobs(tp, 0);
+	while (tp->jobs_done < tp->num_jobs) {
+		opj_cond_wait(&tp->done_cond, &tp->mutex);
+	}
+	/* park the workers until the next run */
+	tp->num_jobs = 0;
+	tp->next_job = 0;
+	opj_mutex_unlock(&tp->mutex);
+}
@@ -0,0 +1,95 @@
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS `AS IS'
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef __THREAD_H
+#define __THREAD_H
+/**
+@file thread.h
+@brief Small fork/join thread pool
+
+A pool of worker threads that runs a set of independent jobs and returns when all of
+them are done. The calling thread takes jobs too, so a pool of n threads starts n-1
+workers. Used to spread the tier-1 code-block decoding and the inverse DWT of a tile.
+*/
+
+/** @defgroup THREAD THREAD - Fork/join thread pool */
+/*@{*/
+
+typedef struct opj_thread_pool opj_thread_pool_t;
+
+/**
+Job callback
+@param user_data Data passed to opj_thread_pool_run
+@param jobno Index of the job to run, 0 <= jobno < number of jobs
+@param threadno Index of the running thread, 0 <= threadno < opj_thread_pool_size(), 0 is the caller
+*/
+typedef void (*opj_job_fn)(void *user_data, int jobno, int threadno);
+
+/** @name Exported functions */
+/*@{*/
+/* ----------------------------------------------------------------------- */
+/**
+Create a thread pool
+@param num_threads Number of threads, including the calling thread
+@return Returns a new pool, or NULL when num_threads < 2 or the workers can't be started
+*/
+opj_thread_pool_t* opj_thread_pool_create(int num_threads);
+/**
+Stop the workers and free the pool
+@param tp Pool to destroy, may be NULL
+*/
+void opj_thread_pool_destroy(opj_thread_pool_t *tp);
+/**
+Get the pool shared by all decoders of the process. The pool is started on first use
+and kept for the life of the process, so that decoding a tile doesn't start and stop
+threads. Only one caller can hold it at a time, the others get NULL and run their
+jobs on their own thread.
+@param num_threads Number of threads, including the calling thread
+@return Returns the shared pool, or NULL when num_threads < 2, another caller holds it or the workers can't be started
+*/
+opj_thread_pool_t* opj_thread_pool_acquire(int num_threads);
+/**
+Give back the pool returned by opj_thread_pool_acquire
+@param tp Pool to give back, may be NULL
+*/
+void opj_thread_pool_release(opj_thread_pool_t *tp);
+/**
+Get the number of threads of a pool
+@param tp Pool, may be NULL
+@return Returns the number of threads including the caller, 1 for a NULL pool
+*/
+int opj_thread_pool_size(opj_thread_pool_t *tp);
+/**
+Run jobs 0 to num_jobs-1 on the pool and wait for all of them to complete.
+Runs them on the calling thread when tp is NULL.
+@param tp Pool, may be NULL
+@param num_jobs Number of jobs
+@param fn Job callback
+@param user_data Passed to fn
+*/
+void opj_thread_pool_run(opj_thread_pool_t *tp, int num_jobs, opj_job_fn fn, void *user_data);
+/* ----------------------------------------------------------------------- */
+/*@}*/
+
+/*@}*/
+
+#endif /* __THREAD_H */
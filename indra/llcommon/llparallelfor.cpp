@@ -0,0 +1,138 @@
+/**
+ * @file llparallelfor.cpp
+ * @brief Worker threads behind ll_parallel_for()
+ *
+ * $LicenseInfo:firstyear=2026&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2026, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+#include "llparallelfor.h"
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
+namespace
+{
+	// One run() call.  It lives on the caller's stack, so a worker may only
+	// touch it between claiming an index and reporting that index done.
+	struct Batch
+	{
+		const std::function<void(size_t)>* mTask;
+		size_t mCount;
+		size_t mNext;		// next index to hand out
+		size_t mDone;		// indices finished
+	};
+
+	class Pool
+	{
+	public:
+		Pool()
+		{
+			const U32 workers = ll_parallel_for_threads() - 1;
+			for (U32 i = 0; i < workers; ++i)
+			{
+				// Never joined: the workers sleep in mWake between batches
+				// and go away with the process.
+				std::thread(&Pool::work, this).detach();
+			}
+		}
+
+		void run(size_t count, const std::function<void(size_t)>& task)
+		{
+			Batch batch = { &task, count, 0, 0 };
+			std::unique_lock<std::mutex> lock(mMutex);
+			mBatches.push_back(&batch);
+			mWake.notify_all();
+
+			// Help out with our own batch, then wait for the stragglers.
+			size_t index;
+			while (claim(&batch, index))
+			{
+				lock.unlock();
+				task(index);
+				lock.lock();
+				++batch.mDone;
+			}
+			while (batch.mDone < batch.mCount)
+			{
+				mFinished.wait(lock);
+			}
+		}
+
+	private:
+		// Hands out the next index of batch, taking the batch off the queue
+		// once all of its indices are out.  Called with mMutex held.
+		bool claim(Batch* batch, size_t& index)
+		{
+			if (batch->mNext < batch->mCount)
+			{
+				index = batch->mNext++;
+				if (batch->mNext == batch->mCount)
+				{
+					mBatches.erase(std::find(mBatches.begin(), mBatches.end(), batch));
+				}
+				return true;
+			}
+			return false;
+		}
+
+		void work()
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+			while (true)
+			{
+				while (mBatches.empty())
+				{
+					mWake.wait(lock);
+				}
+				Batch* batch = mBatches.front();
+				size_t index;
+				if (claim(batch, index))
+				{
+					const std::function<void(size_t)>& task = *batch->mTask;
+					lock.unlock();
+					task(index);
+					lock.lock();
+					if (++batch->mDone == batch->mCount)
+					{
+						mFinished.notify_all();
+					}
+				}
+			}
+		}
+
+		std::mutex mMutex;
+		std::condition_variable mWake;
+		std::condition_variable mFinished;
+		std::deque<Batch*> mBatches;
+	};
+}
+
+//static
+void LLParallelForPool::run(size_t count, const std::function<void(size_t)>& task)
+{
+	// Constructed on first use and never destroyed, as the workers keep
+	// using it until the process is gone.
+	static Pool* pool = new Pool;
+	pool->run(count, task);
+}
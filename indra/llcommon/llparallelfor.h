@@ -0,0 +1,89 @@
+/**
+ * @file llparallelfor.h
+ * @brief Splits a loop over an index range across short-lived threads
+ *
+ * $LicenseInfo:firstyear=2026&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2026, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLPARALLELFOR_H
+#define LL_LLPARALLELFOR_H
+
+#include <algorithm>
+#include <functional>
+#include <thread>
+
+// Number of threads ll_parallel_for() uses when not told otherwise.
+inline U32 ll_parallel_for_threads()
+{
+	U32 threads = std::thread::hardware_concurrency();
+	return std::max(1U, std::min(threads, 16U));
+}
+
+// Worker threads shared by every ll_parallel_for() call.  They are started
+// on first use and stay parked until the process exits, so a loop can be
+// split up every frame without paying for thread creation.
+class LL_COMMON_API LLParallelForPool
+{
+public:
+	// Calls task(i) for every i in [0, count), on the pool's workers and on
+	// the calling thread, and returns once every call has returned.  Calls
+	// made from inside a task are fine: a caller runs pending tasks itself
+	// rather than waiting for a free worker.
+	static void run(size_t count, const std::function<void(size_t)>& task);
+};
+
+// Calls func(begin, end) on contiguous slices covering [0, count), on up to
+// max_threads threads counting the calling one, and returns once every
+// slice is done.  Slices hold at least min_slice indices, so small ranges
+// run inline on the caller.
+//
+// func runs concurrently with itself, so it must only touch its own slice
+// of any shared output.  It must not record fast timers or use LLThread-local
+// state, and must not throw.  It should not log either: LLError only gives
+// each message a few tries at its global lock before dropping it, and a log
+// site caches its level unlocked on first use.  Note failures in the slice's
+// output and log them once ll_parallel_for() has returned.  Library code
+// called from func (volume generation, say) may still warn on rare error
+// paths; such messages can be lost, but nothing else breaks.
+template<class FUNC>
+void ll_parallel_for(size_t count, size_t min_slice, FUNC func, U32 max_threads = 0)
+{
+	if (!count)
+	{
+		return;
+	}
+	size_t threads = max_threads ? max_threads : ll_parallel_for_threads();
+	threads = std::min(threads, count / std::max<size_t>(min_slice, 1));
+	if (threads <= 1)
+	{
+		func((size_t)0, count);
+		return;
+	}
+
+	const size_t slice = (count + threads - 1) / threads;
+	LLParallelForPool::run((count + slice - 1) / slice, [&](size_t i)
+	{
+		func(i * slice, std::min((i + 1) * slice, count));
+	});
+}
+
+#endif // LL_LLPARALLELFOR_H
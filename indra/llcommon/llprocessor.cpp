@@ -130,7 +130,8 @@ namespace
 		eMONTIOR_MWAIT=33,
 		eCPLDebugStore=34,
 		eThermalMonitor2=35,
-		eAltivec=36
+		eAltivec=36,
+		eAVX2=37
 	};
 
 	const char* cpu_feature_names[] =
@@ -173,7 +174,8 @@ namespace
 		"CPL Qualified Debug Store",
 		"Thermal Monitor 2",
 
-		"Altivec"
+		"Altivec",
+		"AVX2"
 	};
 
 	std::string intel_CPUFamilyName(int composed_family) 
@@ -277,6 +279,11 @@ public:
 		return hasExtension("Altivec"); 
 	}
 
+	bool hasAVX2() const
+	{
+		return hasExtension(cpu_feature_names[eAVX2]);
+	}
+
 	std::string getCPUFamilyName() const { return getInfo(eFamilyName, "Unknown").asString(); }
 	std::string getCPUBrandName() const { return getInfo(eBrandName, "Unknown").asString(); }
 
@@ -495,6 +502,9 @@ private:
 		*((int*)(cpu_vendor+8)) = cpu_info[2];
 		setInfo(eVendor, cpu_vendor);
 
+		// AVX needs the OS to save the YMM registers as well as CPU support.
+		bool os_avx = false;
+
 		// Get the information associated with each valid Id
 		for(unsigned int i=0; i<=ids; ++i)
 		{
@@ -537,6 +547,12 @@ private:
 				{
 					setExtension(cpu_feature_names[eThermalMonitor2]);
 				}
+
+				// OSXSAVE and AVX, then XMM and YMM state enabled in XCR0
+				if((cpu_info[2] & 0x18000000) == 0x18000000)
+				{
+					os_avx = (_xgetbv(0) & 0x6) == 0x6;
+				}
 						
 				unsigned int feature_info = (unsigned int) cpu_info[3];
 				for(unsigned int index = 0, bit = 1; index < eSSE3_Features; ++index, bit <<= 1)
@@ -547,6 +563,14 @@ private:
 					}
 				}
 			}
+			else if (i == 7)
+			{
+				__cpuidex(cpu_info, 7, 0);
+				if(os_avx && (cpu_info[1] & 0x20))
+				{
+					setExtension(cpu_feature_names[eAVX2]);
+				}
+			}
 		}
 
 		// Calling __cpuid with 0x80000000 as the InfoType argument
@@ -708,6 +732,12 @@ private:
 		uint64_t ext_feature_info = getSysctlInt64("machdep.cpu.extfeature_bits");
 		S32 *ext_feature_infos = (S32*)(&ext_feature_info);
 		setConfig(eExtFeatureBits, ext_feature_infos[0]);
+
+		// cpuid leaf 7 EBX, AVX2 is bit 5
+		if(getSysctlInt64("machdep.cpu.leaf7_feature_bits") & 0x20)
+		{
+			setExtension(cpu_feature_names[eAVX2]);
+		}
 	}
 };
 
@@ -817,6 +847,12 @@ private:
 		{
 			setExtension(cpu_feature_names[eSSE2_Ext]);
 		}
+
+		// the kernel only lists avx2 when it saves the YMM registers
+		if( flags.find( " avx2 " ) != std::string::npos )
+		{
+			setExtension(cpu_feature_names[eAVX2]);
+		}
 	
 # endif // LL_X86
 	}
@@ -877,6 +913,7 @@ F64MegahertzImplicit LLProcessorInfo::getCPUFrequency() const { return mImpl->ge
 bool LLProcessorInfo::hasSSE() const { return mImpl->hasSSE(); }
 bool LLProcessorInfo::hasSSE2() const { return mImpl->hasSSE2(); }
 bool LLProcessorInfo::hasAltivec() const { return mImpl->hasAltivec(); }
+bool LLProcessorInfo::hasAVX2() const { return mImpl->hasAVX2(); }
 std::string LLProcessorInfo::getCPUFamilyName() const { return mImpl->getCPUFamilyName(); }
 std::string LLProcessorInfo::getCPUBrandName() const { return mImpl->getCPUBrandName(); }
 std::string LLProcessorInfo::getCPUFeatureDescription() const { return mImpl->getCPUFeatureDescription(); }
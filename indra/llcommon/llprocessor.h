@@ -47,6 +47,7 @@ public:
 	bool hasSSE() const;
 	bool hasSSE2() const;
 	bool hasAltivec() const;
+	bool hasAVX2() const;
 	std::string getCPUFamilyName() const;
 	std::string getCPUBrandName() const;
 	std::string getCPUFeatureDescription() const;
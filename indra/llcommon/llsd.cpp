@@ -73,10 +73,12 @@ class LLSD::Impl
 		
 	*/
 {
+public:
+	enum StaticAllocationMarker { STATIC_USAGE_COUNT = 0xFFFFFFFF };
+
 protected:
 	Impl();
 
-	enum StaticAllocationMarker { STATIC_USAGE_COUNT = 0xFFFFFFFF };
 	Impl(StaticAllocationMarker);
 		///< This constructor is used for static objects and causes the
 		//   suppresses adjusting the debugging counters when they are
@@ -154,6 +156,16 @@ public:
 		safe(llsd.impl).calcStats(type_counts, share_counts);
 	}
 
+	template<LLSD::Type T>
+	static Impl* inlineMarker();
+		///< the shared static Impl an LLSD points at while it holds a
+		//   scalar of type T inline
+
+	template<typename R>
+	static R inlineConvert(const LLSD& llsd, R (Impl::*conv)() const);
+		///< applies a conversion to an inline scalar through a stack Impl,
+		//   so inline and allocated values convert by the same rules
+
 	static const Impl& getImpl(const LLSD& llsd)	{ return safe(llsd.impl); }
 	static Impl& getImpl(LLSD& llsd)				{ return safe(llsd.impl); }
 
@@ -182,6 +194,7 @@ namespace
 
 	public:
 		ImplBase(DataRef value) : mValue(value) { }
+		ImplBase(DataRef value, StaticAllocationMarker m) : Impl(m), mValue(value) { }
 		
 		virtual LLSD::Type type() const { return T; }
 
@@ -204,6 +217,7 @@ namespace
 	{
 	public:
 		ImplBoolean(LLSD::Boolean v) : Base(v) { }
+		ImplBoolean(LLSD::Boolean v, StaticAllocationMarker m) : Base(v, m) { }
 		
 		virtual LLSD::Boolean	asBoolean() const	{ return mValue; }
 		virtual LLSD::Integer	asInteger() const	{ return mValue ? 1 : 0; }
@@ -225,6 +239,7 @@ namespace
 	{
 	public:
 		ImplInteger(LLSD::Integer v) : Base(v) { }
+		ImplInteger(LLSD::Integer v, StaticAllocationMarker m) : Base(v, m) { }
 		
 		virtual LLSD::Boolean	asBoolean() const	{ return mValue != 0; }
 		virtual LLSD::Integer	asInteger() const	{ return mValue; }
@@ -241,6 +256,7 @@ namespace
 	{
 	public:
 		ImplReal(LLSD::Real v) : Base(v) { }
+		ImplReal(LLSD::Real v, StaticAllocationMarker m) : Base(v, m) { }
 				
 		virtual LLSD::Boolean	asBoolean() const;
 		virtual LLSD::Integer	asInteger() const;
@@ -647,13 +663,67 @@ LLSD::Impl::Impl()
 }
 
 LLSD::Impl::Impl(StaticAllocationMarker)
-	: mUseCount(0)
+	: mUseCount(STATIC_USAGE_COUNT)
 {
 }
 
 LLSD::Impl::~Impl()
 {
-	--sOutstandingCount;
+	if (mUseCount != STATIC_USAGE_COUNT)
+	{
+		--sOutstandingCount;
+	}
+}
+
+#ifdef NAME_UNNAMED_NAMESPACE
+namespace LLSDUnnamedNamespace 
+#else
+namespace 
+#endif
+{
+	template<LLSD::Type T>
+	class ImplInline : public LLSD::Impl
+		///< Marks an LLSD whose scalar value is held inline.  Everything
+		//   but type() falls through to the Undefined defaults, which are
+		//   what the scalar Impls return for non-scalar queries anyway.
+	{
+	public:
+		ImplInline() : Impl(STATIC_USAGE_COUNT) { }
+
+		virtual LLSD::Type type() const { return T; }
+	};
+}
+
+template<LLSD::Type T>
+LLSD::Impl* LLSD::Impl::inlineMarker()
+{
+	static ImplInline<T> sMarker;
+	return &sMarker;
+}
+
+template<typename R>
+R LLSD::Impl::inlineConvert(const LLSD& llsd, R (Impl::*conv)() const)
+{
+	switch (safe(llsd.impl).type())
+	{
+	case LLSD::TypeBoolean:
+		{
+			ImplBoolean impl(llsd.mInlineBoolean, STATIC_USAGE_COUNT);
+			return (impl.*conv)();
+		}
+	case LLSD::TypeInteger:
+		{
+			ImplInteger impl(llsd.mInlineInteger, STATIC_USAGE_COUNT);
+			return (impl.*conv)();
+		}
+	case LLSD::TypeReal:
+		{
+			ImplReal impl(llsd.mInlineReal, STATIC_USAGE_COUNT);
+			return (impl.*conv)();
+		}
+	default:
+		return (safe(llsd.impl).*conv)();
+	}
 }
 
 void LLSD::Impl::reset(Impl*& var, Impl* impl)
@@ -817,7 +887,18 @@ LLSD::LLSD() : impl(0)					{ ALLOC_LLSD_OBJECT; }
 LLSD::~LLSD()							{ FREE_LLSD_OBJECT; Impl::reset(impl, 0); }
 
 LLSD::LLSD(const LLSD& other) : impl(0) { ALLOC_LLSD_OBJECT;  assign(other); }
-void LLSD::assign(const LLSD& other)	{ Impl::assign(impl, other.impl); }
+void LLSD::assign(const LLSD& other)
+{
+	Impl::assign(impl, other.impl);
+	// Copy only the member the type says is live.
+	switch (type())
+	{
+	case TypeBoolean:	mInlineBoolean = other.mInlineBoolean;	break;
+	case TypeInteger:	mInlineInteger = other.mInlineInteger;	break;
+	case TypeReal:		mInlineReal = other.mInlineReal;		break;
+	default:			break;
+	}
+}
 
 
 void LLSD::clear()						{ Impl::assignUndefined(impl); }
@@ -838,9 +919,9 @@ LLSD::LLSD(const Binary& v) : impl(0)	{ ALLOC_LLSD_OBJECT;	assign(v); }
 LLSD::LLSD(F32 v) : impl(0)				{ ALLOC_LLSD_OBJECT;	assign((Real)v); }
 
 // Scalar Assignment
-void LLSD::assign(Boolean v)			{ safe(impl).assign(impl, v); }
-void LLSD::assign(Integer v)			{ safe(impl).assign(impl, v); }
-void LLSD::assign(Real v)				{ safe(impl).assign(impl, v); }
+void LLSD::assign(Boolean v)			{ Impl::reset(impl, Impl::inlineMarker<TypeBoolean>()); mInlineBoolean = v; }
+void LLSD::assign(Integer v)			{ Impl::reset(impl, Impl::inlineMarker<TypeInteger>()); mInlineInteger = v; }
+void LLSD::assign(Real v)				{ Impl::reset(impl, Impl::inlineMarker<TypeReal>()); mInlineReal = v; }
 void LLSD::assign(const String& v)		{ safe(impl).assign(impl, v); }
 void LLSD::assign(const UUID& v)		{ safe(impl).assign(impl, v); }
 void LLSD::assign(const Date& v)		{ safe(impl).assign(impl, v); }
@@ -848,10 +929,10 @@ void LLSD::assign(const URI& v)			{ safe(impl).assign(impl, v); }
 void LLSD::assign(const Binary& v)		{ safe(impl).assign(impl, v); }
 
 // Scalar Accessors
-LLSD::Boolean	LLSD::asBoolean() const	{ return safe(impl).asBoolean(); }
-LLSD::Integer	LLSD::asInteger() const	{ return safe(impl).asInteger(); }
-LLSD::Real		LLSD::asReal() const	{ return safe(impl).asReal(); }
-LLSD::String	LLSD::asString() const	{ return safe(impl).asString(); }
+LLSD::Boolean	LLSD::asBoolean() const	{ return Impl::inlineConvert(*this, &Impl::asBoolean); }
+LLSD::Integer	LLSD::asInteger() const	{ return Impl::inlineConvert(*this, &Impl::asInteger); }
+LLSD::Real		LLSD::asReal() const	{ return Impl::inlineConvert(*this, &Impl::asReal); }
+LLSD::String	LLSD::asString() const	{ return Impl::inlineConvert(*this, &Impl::asString); }
 LLSD::UUID		LLSD::asUUID() const	{ return safe(impl).asUUID(); }
 LLSD::Date		LLSD::asDate() const	{ return safe(impl).asDate(); }
 LLSD::URI		LLSD::asURI() const		{ return safe(impl).asURI(); }
@@ -398,6 +398,15 @@ public:
 		class Impl;
 private:
 		Impl* impl;
+		// Boolean, Integer and Real values are held here rather than in an
+		// Impl of their own, so the commonest scalars never allocate.  impl
+		// then points at a shared static marker that only carries the type.
+		union
+		{
+			Boolean	mInlineBoolean;
+			Integer	mInlineInteger;
+			Real	mInlineReal;
+		};
 		friend class LLSD::Impl;
 	//@}
 
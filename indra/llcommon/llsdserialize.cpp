@@ -316,6 +316,81 @@ static const char BINARY_TRUE_SERIAL = '1';
 static const char BINARY_FALSE_SERIAL = '0';
 
 
+/**
+ * LLSDParseTreeBuilder
+ */
+LLSDParseTreeBuilder::LLSDParseTreeBuilder(LLSD& root, bool replace_duplicate_keys)
+	: mRoot(root), mReplaceDuplicateKeys(replace_duplicate_keys)
+{
+}
+
+void LLSDParseTreeBuilder::reset()
+{
+	mStack.clear();
+	mKey.clear();
+	mDiscarded.clear();
+}
+
+LLSD& LLSDParseTreeBuilder::nextSlot()
+{
+	if(mStack.empty())
+	{
+		return mRoot;
+	}
+	LLSD& container = *mStack.back();
+	if(container.isArray())
+	{
+		return container.append(LLSD());
+	}
+	if(!mReplaceDuplicateKeys && container.has(mKey))
+	{
+		mDiscarded.push_back(LLSD());
+		return mDiscarded.back();
+	}
+	return container[mKey];
+}
+
+bool LLSDParseTreeBuilder::beginMap()
+{
+	LLSD& map = nextSlot();
+	map = LLSD::emptyMap();
+	mStack.push_back(&map);
+	return true;
+}
+
+bool LLSDParseTreeBuilder::mapKey(const std::string& key)
+{
+	mKey = key;
+	return true;
+}
+
+bool LLSDParseTreeBuilder::endMap()
+{
+	mStack.pop_back();
+	return true;
+}
+
+bool LLSDParseTreeBuilder::beginArray()
+{
+	LLSD& array = nextSlot();
+	array = LLSD::emptyArray();
+	mStack.push_back(&array);
+	return true;
+}
+
+bool LLSDParseTreeBuilder::endArray()
+{
+	mStack.pop_back();
+	return true;
+}
+
+bool LLSDParseTreeBuilder::value(const LLSD& value)
+{
+	nextSlot() = value;
+	return true;
+}
+
+
 /**
  * LLSDParser
  */
@@ -344,6 +419,20 @@ S32 LLSDParser::parseLines(std::istream& istr, LLSD& data)
 	return doParse(istr, data);
 }
 
+S32 LLSDParser::parse(std::istream& istr, LLSDParseHandler& handler, S32 max_bytes)
+{
+	mCheckLimits = (LLSDSerialize::SIZE_UNLIMITED == max_bytes) ? false : true;
+	mMaxBytesLeft = max_bytes;
+	return doParse(istr, handler);
+}
+
+S32 LLSDParser::parseLines(std::istream& istr, LLSDParseHandler& handler)
+{
+	mCheckLimits = false;
+	mParseLines = true;
+	return doParse(istr, handler);
+}
+
 
 int LLSDParser::get(std::istream& istr) const
 {
@@ -415,6 +504,18 @@ LLSDNotationParser::~LLSDNotationParser()
 
 // virtual
 S32 LLSDNotationParser::doParse(std::istream& istr, LLSD& data) const
+{
+	LLSDParseTreeBuilder builder(data, false);
+	S32 parse_count = doParse(istr, builder);
+	if(PARSE_FAILURE == parse_count)
+	{
+		data.clear();
+	}
+	return parse_count;
+}
+
+// virtual
+S32 LLSDNotationParser::doParse(std::istream& istr, LLSDParseHandler& handler) const
 {
 	// map: { string:object, string:object }
 	// array: [ object, object, object ]
@@ -441,12 +542,15 @@ S32 LLSDNotationParser::doParse(std::istream& istr, LLSD& data) const
 		return 0;
 	}
 	S32 parse_count = 1;
+	bool is_container = false;
+	LLSD data;
 	switch(c)
 	{
 	case '{':
 	{
-		S32 child_count = parseMap(istr, data);
-		if((child_count == PARSE_FAILURE) || data.isUndefined())
+		is_container = true;
+		S32 child_count = parseMap(istr, handler);
+		if(child_count == PARSE_FAILURE)
 		{
 			parse_count = PARSE_FAILURE;
 		}
@@ -464,8 +568,9 @@ S32 LLSDNotationParser::doParse(std::istream& istr, LLSD& data) const
 
 	case '[':
 	{
-		S32 child_count = parseArray(istr, data);
-		if((child_count == PARSE_FAILURE) || data.isUndefined())
+		is_container = true;
+		S32 child_count = parseArray(istr, handler);
+		if(child_count == PARSE_FAILURE)
 		{
 			parse_count = PARSE_FAILURE;
 		}
@@ -662,17 +767,17 @@ S32 LLSDNotationParser::doParse(std::istream& istr, LLSD& data) const
 			<< ")" << LL_ENDL;
 		break;
 	}
-	if(PARSE_FAILURE == parse_count)
+	if((PARSE_FAILURE != parse_count) && !is_container && !handler.value(data))
 	{
-		data.clear();
+		parse_count = PARSE_FAILURE;
 	}
 	return parse_count;
 }
 
-S32 LLSDNotationParser::parseMap(std::istream& istr, LLSD& map) const
+S32 LLSDNotationParser::parseMap(std::istream& istr, LLSDParseHandler& handler) const
 {
 	// map: { string:object, string:object }
-	map = LLSD::emptyMap();
+	if(!handler.beginMap()) return PARSE_FAILURE;
 	S32 parse_count = 0;
 	char c = get(istr);
 	if(c == '{')
@@ -703,14 +808,13 @@ S32 LLSDNotationParser::parseMap(std::istream& istr, LLSD& map) const
 					continue;
 				}
 				putback(istr, c);
-				LLSD child;
-				S32 count = doParse(istr, child);
+				if(!handler.mapKey(name)) return PARSE_FAILURE;
+				S32 count = doParse(istr, handler);
 				if(count > 0)
 				{
 					// There must be a value for every key, thus
 					// child_count must be greater than 0.
 					parse_count += count;
-					map.insert(name, child);
 				}
 				else
 				{
@@ -722,17 +826,17 @@ S32 LLSDNotationParser::parseMap(std::istream& istr, LLSD& map) const
 		}
 		if(c != '}')
 		{
-			map.clear();
 			return PARSE_FAILURE;
 		}
 	}
+	if(!handler.endMap()) return PARSE_FAILURE;
 	return parse_count;
 }
 
-S32 LLSDNotationParser::parseArray(std::istream& istr, LLSD& array) const
+S32 LLSDNotationParser::parseArray(std::istream& istr, LLSDParseHandler& handler) const
 {
 	// array: [ object, object, object ]
-	array = LLSD::emptyArray();
+	if(!handler.beginArray()) return PARSE_FAILURE;
 	S32 parse_count = 0;
 	char c = get(istr);
 	if(c == '[')
@@ -741,14 +845,13 @@ S32 LLSDNotationParser::parseArray(std::istream& istr, LLSD& array) const
 		c = get(istr);
 		while((c != ']') && istr.good())
 		{
-			LLSD child;
 			if(isspace(c) || (c == ','))
 			{
 				c = get(istr);
 				continue;
 			}
 			putback(istr, c);
-			S32 count = doParse(istr, child);
+			S32 count = doParse(istr, handler);
 			if(PARSE_FAILURE == count)
 			{
 				return PARSE_FAILURE;
@@ -756,7 +859,6 @@ S32 LLSDNotationParser::parseArray(std::istream& istr, LLSD& array) const
 			else
 			{
 				parse_count += count;
-				array.append(child);
 			}
 			c = get(istr);
 		}
@@ -765,6 +867,7 @@ S32 LLSDNotationParser::parseArray(std::istream& istr, LLSD& array) const
 			return PARSE_FAILURE;
 		}
 	}
+	if(!handler.endArray()) return PARSE_FAILURE;
 	return parse_count;
 }
 
@@ -881,6 +984,18 @@ LLSDBinaryParser::~LLSDBinaryParser()
 
 // virtual
 S32 LLSDBinaryParser::doParse(std::istream& istr, LLSD& data) const
+{
+	LLSDParseTreeBuilder builder(data, false);
+	S32 parse_count = doParse(istr, builder);
+	if(PARSE_FAILURE == parse_count)
+	{
+		data.clear();
+	}
+	return parse_count;
+}
+
+// virtual
+S32 LLSDBinaryParser::doParse(std::istream& istr, LLSDParseHandler& handler) const
 {
 /**
  * Undefined: '!'<br>
@@ -905,12 +1020,15 @@ S32 LLSDBinaryParser::doParse(std::istream& istr, LLSD& data) const
 		return 0;
 	}
 	S32 parse_count = 1;
+	bool is_container = false;
+	LLSD data;
 	switch(c)
 	{
 	case '{':
 	{
-		S32 child_count = parseMap(istr, data);
-		if((child_count == PARSE_FAILURE) || data.isUndefined())
+		is_container = true;
+		S32 child_count = parseMap(istr, handler);
+		if(child_count == PARSE_FAILURE)
 		{
 			parse_count = PARSE_FAILURE;
 		}
@@ -928,8 +1046,9 @@ S32 LLSDBinaryParser::doParse(std::istream& istr, LLSD& data) const
 
 	case '[':
 	{
-		S32 child_count = parseArray(istr, data);
-		if((child_count == PARSE_FAILURE) || data.isUndefined())
+		is_container = true;
+		S32 child_count = parseArray(istr, handler);
+		if(child_count == PARSE_FAILURE)
 		{
 			parse_count = PARSE_FAILURE;
 		}
@@ -1102,16 +1221,16 @@ S32 LLSDBinaryParser::doParse(std::istream& istr, LLSD& data) const
 			<< ")" << LL_ENDL;
 		break;
 	}
-	if(PARSE_FAILURE == parse_count)
+	if((PARSE_FAILURE != parse_count) && !is_container && !handler.value(data))
 	{
-		data.clear();
+		parse_count = PARSE_FAILURE;
 	}
 	return parse_count;
 }
 
-S32 LLSDBinaryParser::parseMap(std::istream& istr, LLSD& map) const
+S32 LLSDBinaryParser::parseMap(std::istream& istr, LLSDParseHandler& handler) const
 {
-	map = LLSD::emptyMap();
+	if(!handler.beginMap()) return PARSE_FAILURE;
 	U32 value_nbo = 0;
 	read(istr, (char*)&value_nbo, sizeof(U32));		 /*Flawfinder: ignore*/
 	S32 size = (S32)ntohl(value_nbo);
@@ -1138,14 +1257,13 @@ S32 LLSDBinaryParser::parseMap(std::istream& istr, LLSD& map) const
 			break;
 		}
 		}
-		LLSD child;
-		S32 child_count = doParse(istr, child);
+		if(!handler.mapKey(name)) return PARSE_FAILURE;
+		S32 child_count = doParse(istr, handler);
 		if(child_count > 0)
 		{
 			// There must be a value for every key, thus child_count
 			// must be greater than 0.
 			parse_count += child_count;
-			map.insert(name, child);
 		}
 		else
 		{
@@ -1160,12 +1278,13 @@ S32 LLSDBinaryParser::parseMap(std::istream& istr, LLSD& map) const
 		// as were said to be there.
 		return PARSE_FAILURE;
 	}
+	if(!handler.endMap()) return PARSE_FAILURE;
 	return parse_count;
 }
 
-S32 LLSDBinaryParser::parseArray(std::istream& istr, LLSD& array) const
+S32 LLSDBinaryParser::parseArray(std::istream& istr, LLSDParseHandler& handler) const
 {
-	array = LLSD::emptyArray();
+	if(!handler.beginArray()) return PARSE_FAILURE;
 	U32 value_nbo = 0;
 	read(istr, (char*)&value_nbo, sizeof(U32));		 /*Flawfinder: ignore*/
 	S32 size = (S32)ntohl(value_nbo);
@@ -1178,8 +1297,7 @@ S32 LLSDBinaryParser::parseArray(std::istream& istr, LLSD& array) const
 	char c = istr.peek();
 	while((c != ']') && (count < size) && istr.good())
 	{
-		LLSD child;
-		S32 child_count = doParse(istr, child);
+		S32 child_count = doParse(istr, handler);
 		if(PARSE_FAILURE == child_count)
 		{
 			return PARSE_FAILURE;
@@ -1187,7 +1305,6 @@ S32 LLSDBinaryParser::parseArray(std::istream& istr, LLSD& array) const
 		if(child_count)
 		{
 			parse_count += child_count;
-			array.append(child);
 		}
 		++count;
 		c = istr.peek();
@@ -1199,6 +1316,7 @@ S32 LLSDBinaryParser::parseArray(std::istream& istr, LLSD& array) const
 		// as were said to be there.
 		return PARSE_FAILURE;
 	}
+	if(!handler.endArray()) return PARSE_FAILURE;
 	return parse_count;
 }
 
@@ -29,11 +29,78 @@
 #ifndef LL_LLSDSERIALIZE_H
 #define LL_LLSDSERIALIZE_H
 
+#include <deque>
 #include <iosfwd>
+#include <vector>
 #include "llpointer.h"
 #include "llrefcount.h"
 #include "llsd.h"
 
+/** 
+ * @class LLSDParseHandler
+ * @brief Receives the contents of an LLSD document as it is parsed.
+ *
+ * Handing one of these to LLSDParser::parse() walks the document in one
+ * pass without building an LLSD tree, so memory use is bounded by the
+ * nesting depth instead of the document size. Maps and arrays arrive as
+ * begin/end pairs, every map value is preceded by its key, and all other
+ * values arrive through value(). Returning false from any method stops
+ * the parse, which then reports PARSE_FAILURE.
+ */
+class LL_COMMON_API LLSDParseHandler
+{
+public:
+	virtual ~LLSDParseHandler() { }
+
+	virtual bool beginMap()							{ return true; }
+	virtual bool mapKey(const std::string& key)		{ return true; }
+	virtual bool endMap()							{ return true; }
+	virtual bool beginArray()						{ return true; }
+	virtual bool endArray()							{ return true; }
+	virtual bool value(const LLSD& value)			{ return true; }
+};
+
+/** 
+ * @class LLSDParseTreeBuilder
+ * @brief LLSDParseHandler which assembles the parsed document into an LLSD.
+ *
+ * This is what the tree returning LLSDParser::parse() uses. It is also
+ * handy inside a streaming handler to collect one small subtree at a time.
+ */
+class LL_COMMON_API LLSDParseTreeBuilder : public LLSDParseHandler
+{
+public:
+	/** 
+	 * @brief Constructor
+	 *
+	 * @param root The LLSD to assign the document to.
+	 * @param replace_duplicate_keys If true, the last of several values
+	 * for the same map key wins, otherwise the first one does.
+	 */
+	LLSDParseTreeBuilder(LLSD& root, bool replace_duplicate_keys);
+
+	/** 
+	 * @brief Forget any partially built containers.
+	 */
+	void reset();
+
+	/*virtual*/ bool beginMap();
+	/*virtual*/ bool mapKey(const std::string& key);
+	/*virtual*/ bool endMap();
+	/*virtual*/ bool beginArray();
+	/*virtual*/ bool endArray();
+	/*virtual*/ bool value(const LLSD& value);
+
+private:
+	LLSD& nextSlot();
+
+	LLSD& mRoot;
+	bool mReplaceDuplicateKeys;
+	std::vector<LLSD*> mStack;
+	std::string mKey;
+	std::deque<LLSD> mDiscarded;	// values for ignored duplicate keys
+};
+
 /** 
  * @class LLSDParser
  * @brief Abstract base class for LLSD parsers.
@@ -85,6 +152,25 @@ public:
 	 */
 	S32 parseLines(std::istream& istr, LLSD& data);
 
+	/** 
+	 * @brief Parse a stream, handing its contents to handler as they are read.
+	 *
+	 * Behaves like parse() above without building the LLSD tree.
+	 * @param istr The input stream.
+	 * @param handler The handler which receives the parsed data.
+	 * @param max_bytes The maximum number of bytes that will be in
+	 * the stream, or LLSDSerialize::SIZE_UNLIMITED.
+	 * @return Returns the number of LLSD objects parsed. Returns
+	 * PARSE_FAILURE (-1) on parse failure or when the handler stops
+	 * the parse.
+	 */
+	S32 parse(std::istream& istr, LLSDParseHandler& handler, S32 max_bytes);
+
+	/** 
+	 * @brief Like parseLines(), handing the contents to handler.
+	 */
+	S32 parseLines(std::istream& istr, LLSDParseHandler& handler);
+
 	/** 
 	 * @brief Resets the parser so parse() or parseLines() can be called again for another <llsd> chunk.
 	 */
@@ -108,6 +194,16 @@ protected:
 	 */
 	virtual S32 doParse(std::istream& istr, LLSD& data) const = 0;
 
+	/** 
+	 * @brief Pure virtual base for doing a streaming parse.
+	 *
+	 * @param istr The input stream.
+	 * @param handler The handler which receives the parsed data.
+	 * @return Returns the number of LLSD objects parsed. Returns
+	 * PARSE_FAILURE (-1) on parse failure.
+	 */
+	virtual S32 doParse(std::istream& istr, LLSDParseHandler& handler) const = 0;
+
 	/** 
 	 * @brief Virtual default function for resetting the parser
 	 */
@@ -246,24 +342,29 @@ protected:
 	 */
 	virtual S32 doParse(std::istream& istr, LLSD& data) const;
 
+	/** 
+	 * @brief Parse the stream, handing its contents to handler.
+	 */
+	virtual S32 doParse(std::istream& istr, LLSDParseHandler& handler) const;
+
 private:
 	/** 
 	 * @brief Parse a map from the istream
 	 *
 	 * @param istr The input stream.
-	 * @param map The map to add the parsed data.
+	 * @param handler The handler to receive the map.
 	 * @return Returns The number of LLSD objects parsed into data.
 	 */
-	S32 parseMap(std::istream& istr, LLSD& map) const;
+	S32 parseMap(std::istream& istr, LLSDParseHandler& handler) const;
 
 	/** 
 	 * @brief Parse an array from the istream.
 	 *
 	 * @param istr The input stream.
-	 * @param array The array to append the parsed data.
+	 * @param handler The handler to receive the array.
 	 * @return Returns The number of LLSD objects parsed into data.
 	 */
-	S32 parseArray(std::istream& istr, LLSD& array) const;
+	S32 parseArray(std::istream& istr, LLSDParseHandler& handler) const;
 
 	/** 
 	 * @brief Parse a string from the istream and assign it to data.
@@ -319,6 +420,11 @@ protected:
 	 */
 	virtual S32 doParse(std::istream& istr, LLSD& data) const;
 
+	/** 
+	 * @brief Parse the stream, handing its contents to handler.
+	 */
+	virtual S32 doParse(std::istream& istr, LLSDParseHandler& handler) const;
+
 	/** 
 	 * @brief Virtual default function for resetting the parser
 	 */
@@ -367,24 +473,29 @@ protected:
 	 */
 	virtual S32 doParse(std::istream& istr, LLSD& data) const;
 
+	/** 
+	 * @brief Parse the stream, handing its contents to handler.
+	 */
+	virtual S32 doParse(std::istream& istr, LLSDParseHandler& handler) const;
+
 private:
 	/** 
 	 * @brief Parse a map from the istream
 	 *
 	 * @param istr The input stream.
-	 * @param map The map to add the parsed data.
+	 * @param handler The handler to receive the map.
 	 * @return Returns The number of LLSD objects parsed into data.
 	 */
-	S32 parseMap(std::istream& istr, LLSD& map) const;
+	S32 parseMap(std::istream& istr, LLSDParseHandler& handler) const;
 
 	/** 
 	 * @brief Parse an array from the istream.
 	 *
 	 * @param istr The input stream.
-	 * @param array The array to append the parsed data.
+	 * @param handler The handler to receive the array.
 	 * @return Returns The number of LLSD objects parsed into data.
 	 */
-	S32 parseArray(std::istream& istr, LLSD& array) const;
+	S32 parseArray(std::istream& istr, LLSDParseHandler& handler) const;
 
 	/** 
 	 * @brief Parse a string from the istream and assign it to data.
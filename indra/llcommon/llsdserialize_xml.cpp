@@ -27,12 +27,11 @@
 #include "linden_common.h"
 #include "llsdserialize_xml.h"
 #include "llbase64.h"
+#include "llsdxmlscanner.h"
 
 #include <iostream>
 #include <deque>
 
-#include <boost/regex.hpp>
-
 extern "C"
 {
 #ifdef LL_STANDALONE
@@ -246,12 +245,23 @@ public:
 	
 	S32 parse(std::istream& input, LLSD& data);
 	S32 parseLines(std::istream& input, LLSD& data);
+	S32 parse(std::istream& input, LLSDParseHandler& handler);
+	S32 parseLines(std::istream& input, LLSDParseHandler& handler);
 
 	void parsePart(const char *buf, int len);
 	
 	void reset();
 
+	// LLSDXMLScanner::replay() callbacks, false once parsing should stop
+	bool startElement(const XML_Char* name, const XML_Char** attributes);
+	bool endElement(const XML_Char* name);
+	bool characterData(const XML_Char* data, size_t length);
+
 private:
+	bool canScan();
+	bool scanDocument(const std::string& document, bool at_end);
+	S32 finishScannedParse(std::istream& input, bool succeeded);
+
 	void startElementHandler(const XML_Char* name, const XML_Char** attributes);
 	void endElementHandler(const XML_Char* name);
 	void characterDataHandler(const XML_Char* data, int length);
@@ -264,6 +274,7 @@ private:
 		void* userData, const XML_Char* data, int length);
 
 	void startSkipping();
+	void stopForHandler();
 	
 	enum Element {
 		ELEMENT_LLSD,
@@ -289,14 +300,20 @@ private:
 
 	XML_Parser	mParser;
 
+	LLSDXMLScanner mScanner;
+	bool mScannerFinished;			// true if mScanner parsed the document instead of expat
+
 	LLSD mResult;
+	LLSDParseTreeBuilder mResultBuilder;
+	LLSDParseHandler* mHandler;		// mResultBuilder unless streaming
 	S32 mParseCount;
 	
 	bool mInLLSDElement;			// true if we're on LLSD
 	bool mGracefullStop;			// true if we found the </llsd
+	bool mHandlerStopped;			// true if mHandler asked us to stop
 	
-	typedef std::deque<LLSD*> LLSDRefStack;
-	LLSDRefStack mStack;
+	typedef std::deque<Element> ElementStack;
+	ElementStack mStack;			// value elements currently open
 	
 	int mDepth;
 	bool mSkipping;
@@ -308,7 +325,9 @@ private:
 
 
 LLSDXMLParser::Impl::Impl(bool emit_errors)
-	: mEmitErrors(emit_errors)
+	: mEmitErrors(emit_errors),
+	  mResultBuilder(mResult, true),
+	  mHandler(&mResultBuilder)
 {
 	mParser = XML_ParserCreate(NULL);
 	reset();
@@ -347,14 +366,114 @@ static unsigned get_till_eol(std::istream& input, char *buf, unsigned bufsize)
 	return count;
 }
 
+// Reads one line, keeping the \n that getline() absorbs
+static std::streamsize get_line(std::istream& input, char* buf, unsigned bufsize)
+{
+	input.getline(buf, bufsize);
+	std::streamsize num_read = input.gcount();
+	if ( num_read > 0 )
+	{
+		if (!input.good() )
+		{	// Clear state that's set when we run out of buffer
+			input.clear();
+		}
+	
+		// Re-insert with the \n that was absorbed by getline()
+		if ( buf[num_read - 1] == 0)
+		{
+			buf[num_read - 1] = '\n';
+		}
+	}
+	return num_read;
+}
+
+bool LLSDXMLParser::Impl::canScan()
+{
+	if (!LLSDXMLScanner::isEnabled())
+	{
+		return false;
+	}
+	// The scanner needs the whole document in memory plus a token list.
+	// That is no worse than the tree mResultBuilder builds anyway, but a
+	// caller's own LLSDParseHandler may be streaming to keep memory bounded,
+	// so those documents stay with expat's 1KB buffers.
+	if (mHandler != &mResultBuilder)
+	{
+		return false;
+	}
+	// Only whole documents; anything already fed to expat stays with it.
+	XML_ParsingStatus status;
+	XML_GetParsingStatus(mParser, &status);
+	return status.parsing == XML_INITIALIZED;
+}
+
+bool LLSDXMLParser::Impl::scanDocument(const std::string& document, bool at_end)
+{
+	if (!mScanner.scan(document.data(), document.size(), at_end))
+	{
+		return false;
+	}
+	mScannerFinished = true;
+	mScanner.replay(*this);
+	return true;
+}
+
+S32 LLSDXMLParser::Impl::finishScannedParse(std::istream& input, bool succeeded)
+{
+	mHandler = &mResultBuilder;
+	if (!succeeded || mHandlerStopped)
+	{
+		return LLSDParser::PARSE_FAILURE;
+	}
+	clear_eol(input);
+	return mParseCount;
+}
+
 S32 LLSDXMLParser::Impl::parse(std::istream& input, LLSD& data)
 {
-	XML_Status status;
+	S32 parse_count = parse(input, mResultBuilder);
+	data = (parse_count == LLSDParser::PARSE_FAILURE) ? LLSD() : mResult;
+	return parse_count;
+}
+
+S32 LLSDXMLParser::Impl::parse(std::istream& input, LLSDParseHandler& handler)
+{
+	XML_Status status = XML_STATUS_OK;
+	mHandler = &handler;
 	
 	static const int BUFFER_SIZE = 1024;
 	void* buffer = NULL;	
 	int count = 0;
-	while (input.good() && !input.eof())
+
+	if (mScannerFinished)
+	{
+		// Like a finished expat parser, only succeed again after </llsd>
+		return finishScannedParse(input, mGracefullStop);
+	}
+	if (canScan())
+	{
+		// Read just as far as the loop below would, then hand the whole
+		// document to the scanner, or to expat if the scanner declines it.
+		std::string document;
+		while (input.good() && !input.eof())
+		{
+			size_t offset = document.size();
+			document.resize(offset + BUFFER_SIZE);
+			count = get_till_eol(input, &document[offset], BUFFER_SIZE);
+			document.resize(offset + count);
+			if (!count || LLSDXMLScanner::containsLLSDEnd(document, offset))
+			{
+				break;
+			}
+		}
+		if (scanDocument(document, !input.good() || input.eof()))
+		{
+			return finishScannedParse(input, true);
+		}
+		status = XML_Parse(mParser, document.data(), (int)document.size(), false);
+	}
+
+	while (status != XML_STATUS_ERROR && input.good() && !input.eof())
 	{
 		buffer = XML_GetBuffer(mParser, BUFFER_SIZE);
 
@@ -386,6 +505,11 @@ S32 LLSDXMLParser::Impl::parse(std::istream& input, LLSD& data)
 	// preserved
 
 	status = XML_ParseBuffer(mParser, 0, true);
+	mHandler = &mResultBuilder;
+	if (mHandlerStopped)
+	{
+		return LLSDParser::PARSE_FAILURE;
+	}
 	if (status == XML_STATUS_ERROR && !mGracefullStop)
 	{
 		if (buffer)
@@ -394,23 +518,31 @@ S32 LLSDXMLParser::Impl::parse(std::istream& input, LLSD& data)
 		}
 		if (mEmitErrors)
 		{
-			LL_INFOS() << "LLSDXMLParser::Impl::parse: XML_STATUS_ERROR parsing:" << (char*) buffer << LL_ENDL;
+			LL_INFOS() << "LLSDXMLParser::Impl::parse: XML_STATUS_ERROR parsing:" << (buffer ? (char*) buffer : "") << LL_ENDL;
 		}
-		data = LLSD();
 		return LLSDParser::PARSE_FAILURE;
 	}
 
 	clear_eol(input);
-	data = mResult;
 	return mParseCount;
 }
 
 
 S32 LLSDXMLParser::Impl::parseLines(std::istream& input, LLSD& data)
 {
-	XML_Status status = XML_STATUS_OK;
-
 	data = LLSD();
+	S32 parse_count = parseLines(input, mResultBuilder);
+	if (parse_count != LLSDParser::PARSE_FAILURE)
+	{
+		data = mResult;
+	}
+	return parse_count;
+}
+
+S32 LLSDXMLParser::Impl::parseLines(std::istream& input, LLSDParseHandler& handler)
+{
+	XML_Status status = XML_STATUS_OK;
+	mHandler = &handler;
 
 	static const int BUFFER_SIZE = 1024;
 
@@ -420,7 +552,34 @@ S32 LLSDXMLParser::Impl::parseLines(std::istream& input, LLSD& data)
 	// Must get rid of any leading \n, otherwise the stream gets into an error/eof state
 	clear_eol(input);
 
+	if (mScannerFinished)
+	{
+		// Like a finished expat parser, only succeed again after </llsd>
+		return finishScannedParse(input, mGracefullStop);
+	}
+	if (canScan())
+	{
+		std::string document;
+		while (input.good() && !input.eof())
+		{
+			size_t offset = document.size();
+			document.resize(offset + BUFFER_SIZE);
+			std::streamsize num_read = get_line(input, &document[offset], BUFFER_SIZE);
+			document.resize(offset + num_read);
+			if (LLSDXMLScanner::containsLLSDEnd(document, offset))
+			{
+				break;
+			}
+		}
+		if (scanDocument(document, !input.good() || input.eof()))
+		{
+			return finishScannedParse(input, true);
+		}
+		status = XML_Parse(mParser, document.data(), (int)document.size(), false);
+	}
+
 	while( !mGracefullStop
+		&& status != XML_STATUS_ERROR
 		&& input.good() 
 		&& !input.eof())
 	{
@@ -436,26 +595,7 @@ S32 LLSDXMLParser::Impl::parseLines(std::istream& input, LLSD& data)
 		}
 		
 		// Get one line
-		input.getline((char*)buffer, BUFFER_SIZE);
-		std::streamsize num_read = input.gcount();
-
-		//memcpy( last_buffer, buffer, num_read );
-		//last_num_read = num_read;
-
-		if ( num_read > 0 )
-		{
-			if (!input.good() )
-			{	// Clear state that's set when we run out of buffer
-				input.clear();
-			}
-		
-			// Re-insert with the \n that was absorbed by getline()
-			char * text = (char *) buffer;
-			if ( text[num_read - 1] == 0)
-			{
-				text[num_read - 1] = '\n';
-			}
-		}
+		std::streamsize num_read = get_line(input, (char*)buffer, BUFFER_SIZE);
 
 		status = XML_ParseBuffer(mParser, (int)num_read, false);
 		if (status == XML_STATUS_ERROR)
@@ -469,6 +609,11 @@ S32 LLSDXMLParser::Impl::parseLines(std::istream& input, LLSD& data)
 	{	// Parse last bit
 		status = XML_ParseBuffer(mParser, 0, true);
 	}
+	mHandler = &mResultBuilder;
+	if (mHandlerStopped)
+	{
+		return LLSDParser::PARSE_FAILURE;
+	}
 	
 	if (status == XML_STATUS_ERROR  
 		&& !mGracefullStop)
@@ -481,7 +626,6 @@ S32 LLSDXMLParser::Impl::parseLines(std::istream& input, LLSD& data)
 	}
 
 	clear_eol(input);
-	data = mResult;
 	return mParseCount;
 }
 
@@ -489,12 +633,16 @@ S32 LLSDXMLParser::Impl::parseLines(std::istream& input, LLSD& data)
 void LLSDXMLParser::Impl::reset()
 {
 	mResult.clear();
+	mResultBuilder.reset();
+	mHandler = &mResultBuilder;
 	mParseCount = 0;
 
 	mInLLSDElement = false;
 	mDepth = 0;
 
 	mGracefullStop = false;
+	mHandlerStopped = false;
+	mScannerFinished = false;
 
 	mStack.clear();
 	
@@ -515,6 +663,12 @@ void LLSDXMLParser::Impl::startSkipping()
 	mSkipThrough = mDepth;
 }
 
+void LLSDXMLParser::Impl::stopForHandler()
+{
+	mHandlerStopped = true;
+	XML_StopParser(mParser, false);
+}
+
 const XML_Char*
 LLSDXMLParser::Impl::findAttribute(const XML_Char* name, const XML_Char** pairs)
 {
@@ -578,7 +732,7 @@ void LLSDXMLParser::Impl::startElementHandler(const XML_Char* name, const XML_Ch
 	#endif // XML_PARSER_PERFORMANCE_TESTS
 	
 	++mDepth;
-	if (mSkipping)
+	if (mSkipping || mHandlerStopped)
 	{
 		return;
 	}
@@ -595,7 +749,7 @@ void LLSDXMLParser::Impl::startElementHandler(const XML_Char* name, const XML_Ch
 			return;
 	
 		case ELEMENT_KEY:
-			if (mStack.empty()  ||  !(mStack.back()->isMap()))
+			if (mStack.empty()  ||  mStack.back() != ELEMENT_MAP)
 			{
 				return startSkipping();
 			}
@@ -618,43 +772,36 @@ void LLSDXMLParser::Impl::startElementHandler(const XML_Char* name, const XML_Ch
 	
 	if (mStack.empty())
 	{
-		mStack.push_back(&mResult);
+		// the top level value
 	}
-	else if (mStack.back()->isMap())
+	else if (mStack.back() == ELEMENT_MAP)
 	{
 		if (mCurrentKey.empty()) { return startSkipping(); }
 		
-		LLSD& map = *mStack.back();
-		LLSD& newElement = map[mCurrentKey];
-		mStack.push_back(&newElement);		
+		if (!mHandler->mapKey(mCurrentKey)) { return stopForHandler(); }
 
 		mCurrentKey.clear();
 	}
-	else if (mStack.back()->isArray())
+	else if (mStack.back() != ELEMENT_ARRAY)
 	{
-		LLSD& array = *mStack.back();
-		array.append(LLSD());
-		LLSD& newElement = array[array.size()-1];
-		mStack.push_back(&newElement);
-	}
-	else {
 		// improperly nested value in a non-structure
 		return startSkipping();
 	}
+	mStack.push_back(element);
 
 	++mParseCount;
 	switch (element)
 	{
 		case ELEMENT_MAP:
-			*mStack.back() = LLSD::emptyMap();
+			if (!mHandler->beginMap()) { return stopForHandler(); }
 			break;
 		
 		case ELEMENT_ARRAY:
-			*mStack.back() = LLSD::emptyArray();
+			if (!mHandler->beginArray()) { return stopForHandler(); }
 			break;
 			
 		default:
-			// all the other values will be set in the end element handler
+			// all the other values will be sent from the end element handler
 			;
 	}
 }
@@ -674,6 +821,10 @@ void LLSDXMLParser::Impl::endElementHandler(const XML_Char* name)
 		}
 		return;
 	}
+	if (mHandlerStopped)
+	{
+		return;
+	}
 	
 	Element element = readElement(name);
 	
@@ -699,13 +850,22 @@ void LLSDXMLParser::Impl::endElementHandler(const XML_Char* name)
 	
 	if (!mInLLSDElement) { return; }
 
-	LLSD& value = *mStack.back();
+	LLSD value;
 	mStack.pop_back();
 	
 	switch (element)
 	{
+		case ELEMENT_MAP:
+			mCurrentContent.clear();
+			if (!mHandler->endMap()) { stopForHandler(); }
+			return;
+
+		case ELEMENT_ARRAY:
+			mCurrentContent.clear();
+			if (!mHandler->endArray()) { stopForHandler(); }
+			return;
+
 		case ELEMENT_UNDEF:
-			value.clear();
 			break;
 		
 		case ELEMENT_BOOL:
@@ -763,13 +923,17 @@ void LLSDXMLParser::Impl::endElementHandler(const XML_Char* name)
 		
 		case ELEMENT_BINARY:
 		{
-			// Regex is expensive, but only fix for whitespace in base64,
-			// created by python and other non-linden systems - DEV-39358
-			// Fortunately we have very little binary passing now,
-			// so performance impact shold be negligible. + poppy 2009-09-04
-			boost::regex r;
-			r.assign("\\s");
-			std::string stripped = boost::regex_replace(mCurrentContent, r, "");
+			// Strip whitespace in base64, created by python and other
+			// non-linden systems - DEV-39358
+			std::string stripped;
+			stripped.reserve(mCurrentContent.size());
+			for (std::string::const_iterator it = mCurrentContent.begin(); it != mCurrentContent.end(); ++it)
+			{
+				if (!isspace((unsigned char)*it))
+				{
+					stripped.push_back(*it);
+				}
+			}
 			size_t len = LLBase64::requiredDecryptionSpace(stripped);
 			std::vector<U8> data;
 			data.resize(len);
@@ -780,15 +944,15 @@ void LLSDXMLParser::Impl::endElementHandler(const XML_Char* name)
 		}
 		
 		case ELEMENT_UNKNOWN:
-			value.clear();
-			break;
-			
 		default:
-			// other values, map and array, have already been set
 			break;
 	}
 
 	mCurrentContent.clear();
+	if (!mHandler->value(value))
+	{
+		stopForHandler();
+	}
 }
 
 void LLSDXMLParser::Impl::characterDataHandler(const XML_Char* data, int length)
@@ -801,6 +965,24 @@ void LLSDXMLParser::Impl::characterDataHandler(const XML_Char* data, int length)
 }
 
 
+bool LLSDXMLParser::Impl::startElement(const XML_Char* name, const XML_Char** attributes)
+{
+	startElementHandler(name, attributes);
+	return !(mGracefullStop || mHandlerStopped);
+}
+
+bool LLSDXMLParser::Impl::endElement(const XML_Char* name)
+{
+	endElementHandler(name);
+	return !(mGracefullStop || mHandlerStopped);
+}
+
+bool LLSDXMLParser::Impl::characterData(const XML_Char* data, size_t length)
+{
+	characterDataHandler(data, (int)length);
+	return true;
+}
+
 void LLSDXMLParser::Impl::sStartElementHandler(
 	void* userData, const XML_Char* name, const XML_Char** attributes)
 {
@@ -923,6 +1105,17 @@ S32 LLSDXMLParser::doParse(std::istream& input, LLSD& data) const
 	return impl.parse(input, data);
 }
 
+// virtual
+S32 LLSDXMLParser::doParse(std::istream& input, LLSDParseHandler& handler) const
+{
+	if (mParseLines)
+	{
+		return impl.parseLines(input, handler);
+	}
+
+	return impl.parse(input, handler);
+}
+
 //	virtual 
 void LLSDXMLParser::doReset()
 {
@@ -0,0 +1,807 @@
+/**
+ * @file llsdxmlscanner.cpp
+ * @brief Vectorized tokenizer for the XML subset that LLSD documents use
+ *
+ * $LicenseInfo:firstyear=2026&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2026, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+#include "llsdxmlscanner.h"
+#include "llprocessor.h"
+
+#include <string.h>
+
+#if defined(_M_X64) || defined(__x86_64__) || defined(__amd64__)
+#	include <emmintrin.h>
+#	define LL_SDXML_SSE2 1
+#	if defined(__GNUC__) || defined(__clang__)
+#		include <immintrin.h>
+#		define LL_SDXML_AVX2 1
+#		define LL_SDXML_TARGET_AVX2 __attribute__((target("avx2")))
+#	elif defined(_MSC_VER)
+#		include <immintrin.h>
+#		define LL_SDXML_AVX2 1
+#		define LL_SDXML_TARGET_AVX2
+#	endif
+#endif
+
+bool LLSDXMLScanner::sEnabled = true;
+
+namespace
+{
+	// The element names the LLSD formatter writes.  Element and attribute
+	// names matching one of these share a single copy in mStrings.
+	const char* const KNOWN_NAMES[] =
+	{
+		"llsd", "map", "key", "array", "string", "integer", "real", "boolean",
+		"uuid", "date", "uri", "binary", "undef", "encoding"
+	};
+	const size_t KNOWN_NAME_COUNT = sizeof(KNOWN_NAMES) / sizeof(KNOWN_NAMES[0]);
+
+	inline bool is_space(char c)
+	{
+		return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+	}
+
+	inline bool is_name_start(char c)
+	{
+		return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_' || c == ':';
+	}
+
+	inline bool is_name_char(char c)
+	{
+		return is_name_start(c) || (c >= '0' && c <= '9') || c == '-' || c == '.';
+	}
+
+	inline const char* skip_space(const char* p, const char* end)
+	{
+		while (p < end && is_space(*p))
+		{
+			++p;
+		}
+		return p;
+	}
+
+	// True if c is a character that needs a closer look in character data:
+	// markup, entities, a possible "]]>", a carriage return, a control
+	// character or the start of a multi-byte UTF-8 sequence.
+	inline bool is_special(unsigned char c)
+	{
+		return c == '<' || c == '&' || c == ']' || c >= 0x80
+			|| (c < 0x20 && c != '\t' && c != '\n');
+	}
+
+	const char* find_special_scalar(const char* p, const char* end)
+	{
+		while (p < end && !is_special((unsigned char)*p))
+		{
+			++p;
+		}
+		return p;
+	}
+
+#if LL_SDXML_SSE2
+	inline U32 count_trailing_zeros(U32 mask)
+	{
+#if defined(_MSC_VER)
+		unsigned long index;
+		_BitScanForward(&index, mask);
+		return index;
+#else
+		return __builtin_ctz(mask);
+#endif
+	}
+
+	// 16 bytes at a time.  A signed compare against 0x20 catches both the
+	// control characters and every byte with the high bit set.
+	const char* find_special_sse2(const char* p, const char* end)
+	{
+		const __m128i lt = _mm_set1_epi8('<');
+		const __m128i amp = _mm_set1_epi8('&');
+		const __m128i bracket = _mm_set1_epi8(']');
+		const __m128i space = _mm_set1_epi8(0x20);
+		const __m128i tab = _mm_set1_epi8('\t');
+		const __m128i newline = _mm_set1_epi8('\n');
+		while (end - p >= 16)
+		{
+			__m128i v = _mm_loadu_si128((const __m128i*)p);
+			__m128i hits = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, lt), _mm_cmpeq_epi8(v, amp)),
+										_mm_cmpeq_epi8(v, bracket));
+			__m128i allowed = _mm_or_si128(_mm_cmpeq_epi8(v, tab), _mm_cmpeq_epi8(v, newline));
+			hits = _mm_or_si128(hits, _mm_andnot_si128(allowed, _mm_cmplt_epi8(v, space)));
+			U32 mask = (U32)_mm_movemask_epi8(hits);
+			if (mask)
+			{
+				return p + count_trailing_zeros(mask);
+			}
+			p += 16;
+		}
+		return find_special_scalar(p, end);
+	}
+#endif
+
+#if LL_SDXML_AVX2
+	LL_SDXML_TARGET_AVX2
+	const char* find_special_avx2(const char* p, const char* end)
+	{
+		const __m256i lt = _mm256_set1_epi8('<');
+		const __m256i amp = _mm256_set1_epi8('&');
+		const __m256i bracket = _mm256_set1_epi8(']');
+		const __m256i space = _mm256_set1_epi8(0x20);
+		const __m256i tab = _mm256_set1_epi8('\t');
+		const __m256i newline = _mm256_set1_epi8('\n');
+		while (end - p >= 32)
+		{
+			__m256i v = _mm256_loadu_si256((const __m256i*)p);
+			__m256i hits = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, lt), _mm256_cmpeq_epi8(v, amp)),
+										   _mm256_cmpeq_epi8(v, bracket));
+			__m256i allowed = _mm256_or_si256(_mm256_cmpeq_epi8(v, tab), _mm256_cmpeq_epi8(v, newline));
+			hits = _mm256_or_si256(hits, _mm256_andnot_si256(allowed, _mm256_cmpgt_epi8(space, v)));
+			U32 mask = (U32)_mm256_movemask_epi8(hits);
+			if (mask)
+			{
+				return p + count_trailing_zeros(mask);
+			}
+			p += 32;
+		}
+		return find_special_sse2(p, end);
+	}
+#endif
+
+	typedef const char* (*find_special_func)(const char* p, const char* end);
+
+	find_special_func select_find_special()
+	{
+#if LL_SDXML_AVX2
+		if (LLProcessorInfo().hasAVX2())
+		{
+			return find_special_avx2;
+		}
+#endif
+#if LL_SDXML_SSE2
+		return find_special_sse2;
+#else
+		return find_special_scalar;
+#endif
+	}
+
+	// Returns the first byte at or after p that is_special(), or end.
+	inline const char* find_special(const char* p, const char* end)
+	{
+		static const find_special_func sFindSpecial = select_find_special();
+		return sFindSpecial(p, end);
+	}
+
+	// Length of the well formed UTF-8 sequence starting at p that expat
+	// accepts as a character, or 0.
+	size_t utf8_sequence_length(const char* p, const char* end)
+	{
+		const unsigned char* s = (const unsigned char*)p;
+		size_t left = end - p;
+		unsigned char c = s[0];
+		if (c >= 0xC2 && c <= 0xDF)
+		{
+			return (left >= 2 && (s[1] & 0xC0) == 0x80) ? 2 : 0;
+		}
+		if (c >= 0xE0 && c <= 0xEF)
+		{
+			if (left < 3 || (s[1] & 0xC0) != 0x80 || (s[2] & 0xC0) != 0x80)
+			{
+				return 0;
+			}
+			if ((c == 0xE0 && s[1] < 0xA0)					// overlong
+				|| (c == 0xED && s[1] > 0x9F)				// surrogate
+				|| (c == 0xEF && s[1] == 0xBF && s[2] >= 0xBE))	// U+FFFE, U+FFFF
+			{
+				return 0;
+			}
+			return 3;
+		}
+		if (c >= 0xF0 && c <= 0xF4)
+		{
+			if (left < 4 || (s[1] & 0xC0) != 0x80 || (s[2] & 0xC0) != 0x80 || (s[3] & 0xC0) != 0x80)
+			{
+				return 0;
+			}
+			if ((c == 0xF0 && s[1] < 0x90) || (c == 0xF4 && s[1] > 0x8F))
+			{
+				return 0;
+			}
+			return 4;
+		}
+		return 0;
+	}
+
+	void append_utf8(U32 code, std::string& out)
+	{
+		if (code < 0x80)
+		{
+			out.push_back((char)code);
+		}
+		else if (code < 0x800)
+		{
+			out.push_back((char)(0xC0 | (code >> 6)));
+			out.push_back((char)(0x80 | (code & 0x3F)));
+		}
+		else if (code < 0x10000)
+		{
+			out.push_back((char)(0xE0 | (code >> 12)));
+			out.push_back((char)(0x80 | ((code >> 6) & 0x3F)));
+			out.push_back((char)(0x80 | (code & 0x3F)));
+		}
+		else
+		{
+			out.push_back((char)(0xF0 | (code >> 18)));
+			out.push_back((char)(0x80 | ((code >> 12) & 0x3F)));
+			out.push_back((char)(0x80 | ((code >> 6) & 0x3F)));
+			out.push_back((char)(0x80 | (code & 0x3F)));
+		}
+	}
+}
+
+LLSDXMLScanner::LLSDXMLScanner()
+	: mDocument(NULL)
+{
+}
+
+// static
+bool LLSDXMLScanner::containsLLSDEnd(const std::string& document, size_t offset)
+{
+	// A tag straddling the previous piece starts at its last '<'.
+	size_t pos = offset;
+	if (offset > 0)
+	{
+		size_t last = document.rfind('<', offset - 1);
+		if (last != std::string::npos)
+		{
+			pos = last;
+		}
+	}
+
+	// Looks for "</llsd>" or "<llsd/>", with optional white space before
+	// the closing '>' or "/>".
+	const size_t size = document.size();
+	while ((pos = document.find('<', pos)) != std::string::npos)
+	{
+		++pos;
+		bool end_tag = (pos < size && document[pos] == '/');
+		if (end_tag)
+		{
+			++pos;
+		}
+		if (document.compare(pos, 4, "llsd") != 0)
+		{
+			continue;
+		}
+		size_t p = pos + 4;
+		while (p < size && is_space(document[p]))
+		{
+			++p;
+		}
+		if (!end_tag && p < size && document[p] == '/')
+		{
+			++p;
+			end_tag = true;
+		}
+		if (end_tag && p < size && document[p] == '>')
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+bool LLSDXMLScanner::scan(const char* data, size_t length, bool at_end)
+{
+	mDocument = data;
+	mTokens.clear();
+	mAttributeOffsets.clear();
+	mDecoded.clear();
+	mStrings.clear();
+	for (size_t i = 0; i < KNOWN_NAME_COUNT; ++i)
+	{
+		mStrings.append(KNOWN_NAMES[i]);
+		mStrings.push_back('\0');
+	}
+
+	const char* p = data;
+	const char* end = data + length;
+
+	// An XML declaration may only come first.
+	if (end - p > 5 && memcmp(p, "<?xml", 5) == 0 && is_space(p[5]))
+	{
+		if (!scanDeclaration(p, end))
+		{
+			return false;
+		}
+	}
+
+	// Comments, processing instructions and DOCTYPE are left to expat.
+	p = skip_space(p, end);
+	if (p == end || *p != '<')
+	{
+		return false;
+	}
+
+	std::vector<U32> open_names;
+	U32 root_name = 0;
+	while (true)
+	{
+		if (p >= end)
+		{
+			// The root element is not finished.
+			return false;
+		}
+		if (*p != '<')
+		{
+			if (!scanText(p, end))
+			{
+				return false;
+			}
+			continue;
+		}
+		if (end - p < 2)
+		{
+			return false;
+		}
+		if (p[1] == '/')
+		{
+			if (open_names.empty() || !scanEndTag(p, end, open_names.back()))
+			{
+				return false;
+			}
+			open_names.pop_back();
+			if (open_names.empty())
+			{
+				break;
+			}
+		}
+		else if (p[1] == '!' || p[1] == '?')
+		{
+			return false;
+		}
+		else
+		{
+			bool empty_element = false;
+			if (!scanStartTag(p, end, empty_element))
+			{
+				return false;
+			}
+			U32 name = mTokens.back().mName;
+			if (mTokens.size() == 1)
+			{
+				root_name = name;
+			}
+			if (empty_element)
+			{
+				Token token = { TOKEN_END, name, 0, 0, 0 };
+				mTokens.push_back(token);
+				if (open_names.empty())
+				{
+					break;
+				}
+			}
+			else
+			{
+				open_names.push_back(name);
+			}
+		}
+	}
+
+	if (strcmp(mStrings.data() + root_name, "llsd") == 0)
+	{
+		// The LLSD parser stops reading here.
+		return true;
+	}
+	return at_end && skip_space(p, end) == end;
+}
+
+bool LLSDXMLScanner::scanDeclaration(const char*& p, const char* end)
+{
+	p = skip_space(p + 5, end);
+
+	// Each pseudo attribute must be preceded by white space, in this order.
+	static const char* const PSEUDO_ATTRIBUTES[] = { "version", "encoding", "standalone" };
+	bool had_space = true;
+	for (size_t i = 0; i < 3; ++i)
+	{
+		size_t name_length = strlen(PSEUDO_ATTRIBUTES[i]);
+		if (!had_space || (size_t)(end - p) < name_length
+			|| memcmp(p, PSEUDO_ATTRIBUTES[i], name_length) != 0)
+		{
+			if (i == 0)
+			{
+				return false;	// version is required
+			}
+			continue;
+		}
+		p = skip_space(p + name_length, end);
+		if (p >= end || *p != '=')
+		{
+			return false;
+		}
+		p = skip_space(p + 1, end);
+		if (p >= end || (*p != '"' && *p != '\''))
+		{
+			return false;
+		}
+		const char quote = *p++;
+		const char* value = p;
+		while (p < end && *p != quote)
+		{
+			++p;
+		}
+		if (p >= end)
+		{
+			return false;
+		}
+		std::string text(value, p - value);
+		++p;
+		if ((i == 0 && text != "1.0")
+			|| (i == 1 && text != "UTF-8" && text != "utf-8")
+			|| (i == 2 && text != "yes" && text != "no"))
+		{
+			return false;
+		}
+		const char* before = p;
+		p = skip_space(p, end);
+		had_space = (p != before);
+	}
+
+	if (end - p < 2 || p[0] != '?' || p[1] != '>')
+	{
+		return false;
+	}
+	p += 2;
+	return true;
+}
+
+bool LLSDXMLScanner::scanName(const char*& p, const char* end, U32& name)
+{
+	const char* start = p;
+	if (p >= end || !is_name_start(*p))
+	{
+		return false;
+	}
+	++p;
+	while (p < end && is_name_char(*p))
+	{
+		++p;
+	}
+	if (p >= end)
+	{
+		return false;
+	}
+	// Names with anything beyond ASCII are left to expat.
+	if ((unsigned char)*p >= 0x80)
+	{
+		return false;
+	}
+
+	size_t length = p - start;
+	size_t offset = 0;
+	for (size_t i = 0; i < KNOWN_NAME_COUNT; ++i)
+	{
+		size_t known_length = strlen(KNOWN_NAMES[i]);
+		if (known_length == length && memcmp(KNOWN_NAMES[i], start, length) == 0)
+		{
+			name = (U32)offset;
+			return true;
+		}
+		offset += known_length + 1;
+	}
+	name = (U32)mStrings.size();
+	mStrings.append(start, length);
+	mStrings.push_back('\0');
+	return true;
+}
+
+bool LLSDXMLScanner::scanStartTag(const char*& p, const char* end, bool& empty_element)
+{
+	++p;	// '<'
+	Token token = { TOKEN_START, 0, (U32)mAttributeOffsets.size(), 0, 0 };
+	if (!scanName(p, end, token.mName))
+	{
+		return false;
+	}
+
+	while (true)
+	{
+		const char* before = p;
+		p = skip_space(p, end);
+		if (p >= end)
+		{
+			return false;
+		}
+		if (*p == '>')
+		{
+			++p;
+			empty_element = false;
+			break;
+		}
+		if (*p == '/')
+		{
+			if (end - p < 2 || p[1] != '>')
+			{
+				return false;
+			}
+			p += 2;
+			empty_element = true;
+			break;
+		}
+		if (p == before)
+		{
+			return false;	// attributes must be separated by white space
+		}
+
+		U32 attribute_name = 0;
+		if (!scanName(p, end, attribute_name))
+		{
+			return false;
+		}
+		p = skip_space(p, end);
+		if (p >= end || *p != '=')
+		{
+			return false;
+		}
+		p = skip_space(p + 1, end);
+		if (p >= end || (*p != '"' && *p != '\''))
+		{
+			return false;
+		}
+		const char quote = *p++;
+		const char* value = p;
+		// expat normalizes white space and expands references in attribute
+		// values; leave any of that to it.
+		while (p < end && *p != quote)
+		{
+			unsigned char c = (unsigned char)*p;
+			if (c == '<' || c == '&' || c < 0x20 || c >= 0x80)
+			{
+				return false;
+			}
+			++p;
+		}
+		if (p >= end)
+		{
+			return false;
+		}
+		for (size_t i = token.mAttributes; i < mAttributeOffsets.size(); i += 2)
+		{
+			if (strcmp(mStrings.data() + mAttributeOffsets[i], mStrings.data() + attribute_name) == 0)
+			{
+				return false;	// duplicate attribute
+			}
+		}
+		mAttributeOffsets.push_back(attribute_name);
+		mAttributeOffsets.push_back((U32)mStrings.size());
+		mStrings.append(value, p - value);
+		mStrings.push_back('\0');
+		++p;
+	}
+
+	mAttributeOffsets.push_back(U32_MAX);
+	mTokens.push_back(token);
+	return true;
+}
+
+bool LLSDXMLScanner::scanEndTag(const char*& p, const char* end, U32 expected_name)
+{
+	p += 2;	// "</"
+	const char* expected = mStrings.data() + expected_name;
+	size_t length = strlen(expected);
+	if ((size_t)(end - p) <= length || memcmp(p, expected, length) != 0
+		|| is_name_char(p[length]) || (unsigned char)p[length] >= 0x80)
+	{
+		return false;
+	}
+	p = skip_space(p + length, end);
+	if (p >= end || *p != '>')
+	{
+		return false;
+	}
+	++p;
+	Token token = { TOKEN_END, expected_name, 0, 0, 0 };
+	mTokens.push_back(token);
+	return true;
+}
+
+bool LLSDXMLScanner::appendEntity(const char*& p, const char* end, std::string& out)
+{
+	const char* semicolon = (const char*)memchr(p, ';', std::min<size_t>(end - p, 12));
+	if (!semicolon)
+	{
+		return false;
+	}
+	const char* name = p + 1;
+	size_t length = semicolon - name;
+	if (length >= 2 && name[0] == '#')
+	{
+		U32 code = 0;
+		bool hex = (name[1] == 'x');
+		const char* digit = name + (hex ? 2 : 1);
+		if (digit == semicolon)
+		{
+			return false;
+		}
+		for (; digit < semicolon; ++digit)
+		{
+			char c = *digit;
+			U32 value;
+			if (c >= '0' && c <= '9')
+			{
+				value = c - '0';
+			}
+			else if (hex && c >= 'a' && c <= 'f')
+			{
+				value = c - 'a' + 10;
+			}
+			else if (hex && c >= 'A' && c <= 'F')
+			{
+				value = c - 'A' + 10;
+			}
+			else
+			{
+				return false;
+			}
+			code = code * (hex ? 16 : 10) + value;
+			if (code > 0x10FFFF)
+			{
+				return false;
+			}
+		}
+		// Only the references expat would accept as XML characters.
+		if (!(code == 0x9 || code == 0xA || code == 0xD
+			  || (code >= 0x20 && code <= 0xD7FF)
+			  || (code >= 0xE000 && code <= 0xFFFD)
+			  || code >= 0x10000))
+		{
+			return false;
+		}
+		append_utf8(code, out);
+	}
+	else if (length == 2 && memcmp(name, "lt", 2) == 0)
+	{
+		out.push_back('<');
+	}
+	else if (length == 2 && memcmp(name, "gt", 2) == 0)
+	{
+		out.push_back('>');
+	}
+	else if (length == 3 && memcmp(name, "amp", 3) == 0)
+	{
+		out.push_back('&');
+	}
+	else if (length == 4 && memcmp(name, "quot", 4) == 0)
+	{
+		out.push_back('"');
+	}
+	else if (length == 4 && memcmp(name, "apos", 4) == 0)
+	{
+		out.push_back('\'');
+	}
+	else
+	{
+		return false;
+	}
+	p = semicolon + 1;
+	return true;
+}
+
+bool LLSDXMLScanner::scanText(const char*& p, const char* end)
+{
+	const char* start = p;
+	const char* run = p;			// first byte not yet copied to mDecoded
+	size_t decoded_start = 0;
+	bool decoded = false;
+
+	while (true)
+	{
+		const char* q = find_special(p, end);
+		if (q >= end)
+		{
+			// The caller fails the scan since the root element is open.
+			p = end;
+			return true;
+		}
+
+		unsigned char c = (unsigned char)*q;
+		if (c == '<')
+		{
+			p = q;
+			break;
+		}
+		if (c == ']')
+		{
+			if (end - q < 3)
+			{
+				return false;
+			}
+			if (q[1] == ']' && q[2] == '>')
+			{
+				return false;
+			}
+			p = q + 1;
+			continue;
+		}
+		if (c >= 0x80)
+		{
+			size_t length = utf8_sequence_length(q, end);
+			if (!length)
+			{
+				return false;
+			}
+			p = q + length;
+			continue;
+		}
+		if (c != '&' && c != '\r')
+		{
+			return false;	// control character
+		}
+
+		if (!decoded)
+		{
+			decoded = true;
+			decoded_start = mDecoded.size();
+		}
+		mDecoded.append(run, q - run);
+		p = q;
+		if (c == '&')
+		{
+			if (!appendEntity(p, end, mDecoded))
+			{
+				return false;
+			}
+		}
+		else
+		{
+			// Line ends are normalized to a single line feed.
+			mDecoded.push_back('\n');
+			++p;
+			if (p < end && *p == '\n')
+			{
+				++p;
+			}
+		}
+		run = p;
+	}
+
+	if (p == start)
+	{
+		return true;
+	}
+	Token token = { TOKEN_TEXT, 0, 0, 0, 0 };
+	if (decoded)
+	{
+		mDecoded.append(run, p - run);
+		token.mType = TOKEN_DECODED_TEXT;
+		token.mText = decoded_start;
+		token.mLength = mDecoded.size() - decoded_start;
+	}
+	else
+	{
+		token.mText = start - mDocument;
+		token.mLength = p - start;
+	}
+	mTokens.push_back(token);
+	return true;
+}
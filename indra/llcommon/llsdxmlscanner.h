@@ -0,0 +1,141 @@
+/**
+ * @file llsdxmlscanner.h
+ * @brief Vectorized tokenizer for the XML subset that LLSD documents use
+ *
+ * $LicenseInfo:firstyear=2026&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2026, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLSDXMLSCANNER_H
+#define LL_LLSDXMLSCANNER_H
+
+#include <string>
+#include <vector>
+
+// Splits an in-memory XML document into the same start tag, end tag and
+// character data callbacks expat would make, for the plain subset of XML
+// that LLSD formatters write: an optional <?xml?> declaration, elements
+// with simple attributes, the predefined and numeric character entities
+// and UTF-8 text.
+//
+// scan() checks the whole document before anything is reported, so when
+// it meets anything outside that subset (comments, CDATA, DOCTYPE, odd
+// attributes, malformed input, a document that is not finished yet) it
+// returns false having had no side effects, and the caller hands the very
+// same bytes to expat instead.  Whatever scan() accepts, expat accepts
+// with the same callbacks; only the places where character data is split
+// differ, which the LLSD parser does not care about.
+class LLSDXMLScanner
+{
+public:
+	LLSDXMLScanner();
+
+	// Tokenizes data.  Scanning ends at the end tag closing the root element
+	// when that element is <llsd>, as the LLSD parser stops expat there.
+	// Any other root must be followed by nothing but white space up to the
+	// end of data, and at_end must say that no more input will follow.
+	bool scan(const char* data, size_t length, bool at_end);
+
+	// After a successful scan(), calls handler.startElement(name, attributes),
+	// handler.endElement(name) and handler.characterData(text, length) in
+	// document order until one of them returns false.
+	template<class HANDLER>
+	void replay(HANDLER& handler) const;
+
+	// True if the document holds the end of an <llsd> element, so a caller
+	// reading a stream piece by piece knows when to stop and scan.
+	// Only the part from offset on needs checking.
+	static bool containsLLSDEnd(const std::string& document, size_t offset);
+
+	// Globally enables or disables the scanner, for testing against expat.
+	static void setEnabled(bool enabled)	{ sEnabled = enabled; }
+	static bool isEnabled()					{ return sEnabled; }
+
+private:
+	enum ETokenType
+	{
+		TOKEN_START,
+		TOKEN_END,
+		TOKEN_TEXT,			// mText points into the scanned document
+		TOKEN_DECODED_TEXT	// mText is an offset into mDecoded
+	};
+
+	struct Token
+	{
+		ETokenType	mType;
+		U32			mName;			// start/end: offset of the name in mStrings
+		U32			mAttributes;	// start: index into mAttributeOffsets
+		size_t		mText;
+		size_t		mLength;
+	};
+
+	bool scanDeclaration(const char*& p, const char* end);
+	bool scanStartTag(const char*& p, const char* end, bool& empty_element);
+	bool scanEndTag(const char*& p, const char* end, U32 expected_name);
+	bool scanText(const char*& p, const char* end);
+	bool scanName(const char*& p, const char* end, U32& name);
+	bool appendEntity(const char*& p, const char* end, std::string& out);
+
+	const char* mDocument;
+	std::vector<Token> mTokens;
+	std::string mStrings;				// NUL terminated names and attribute values
+	std::vector<U32> mAttributeOffsets;	// per tag: name, value, ..., ~0
+	std::string mDecoded;				// text that needed entity or newline decoding
+
+	static bool sEnabled;
+};
+
+template<class HANDLER>
+void LLSDXMLScanner::replay(HANDLER& handler) const
+{
+	std::vector<const char*> attributes;
+	for (std::vector<Token>::const_iterator it = mTokens.begin(); it != mTokens.end(); ++it)
+	{
+		bool keep_going = true;
+		switch (it->mType)
+		{
+		case TOKEN_START:
+			attributes.clear();
+			for (U32 i = it->mAttributes; mAttributeOffsets[i] != U32_MAX; ++i)
+			{
+				attributes.push_back(mStrings.data() + mAttributeOffsets[i]);
+			}
+			attributes.push_back(NULL);
+			keep_going = handler.startElement(mStrings.data() + it->mName, &attributes[0]);
+			break;
+		case TOKEN_END:
+			keep_going = handler.endElement(mStrings.data() + it->mName);
+			break;
+		case TOKEN_TEXT:
+			keep_going = handler.characterData(mDocument + it->mText, it->mLength);
+			break;
+		case TOKEN_DECODED_TEXT:
+			keep_going = handler.characterData(mDecoded.data() + it->mText, it->mLength);
+			break;
+		}
+		if (!keep_going)
+		{
+			break;
+		}
+	}
+}
+
+#endif // LL_LLSDXMLSCANNER_H
@@ -79,6 +79,7 @@ public:
 	bool hasAltivec() const;
 	bool hasSSE() const;
 	bool hasSSE2() const;
+	bool hasAVX2() const;
 	F64 getMHz() const;
 
 	// Family is "AMD Duron" or "Intel Pentium Pro"
@@ -87,6 +88,7 @@ public:
 private:
 	bool mHasSSE;
 	bool mHasSSE2;
+	bool mHasAVX2;
 	bool mHasAltivec;
 	F64 mCPUMHz;
 	std::string mFamily;
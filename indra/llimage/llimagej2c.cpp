@@ -542,6 +542,33 @@ BOOL LLImageJ2C::validate(U8 *data, U32 file_size)
 	return res;
 }
 
+LLImageJ2C* LLImageJ2C::createProgressiveImage(S32 discard_level)
+{
+	if (!getData() || !getWidth() || discard_level < 0 || discard_level > MAX_DISCARD_LEVEL)
+	{
+		return NULL;
+	}
+	if (calcDiscardLevelBytes(getDataSize()) > discard_level)
+	{
+		return NULL; // not loaded far enough yet
+	}
+	// Only the packets of the coarser resolution levels are needed, the rest of
+	// the codestream is skipped by the decoder anyway.
+	S32 size = llmin(getDataSize(), calcDataSize(discard_level));
+	U8* data = (U8*)ALLOCATE_MEM(LLImageBase::getPrivatePool(), size);
+	if (!data)
+	{
+		return NULL;
+	}
+	memcpy(data, getData(), size);
+
+	LLImageJ2C* image = new LLImageJ2C;
+	image->setRate(mRate);
+	image->setData(data, size);
+	image->setDiscardLevel(discard_level);
+	return image;
+}
+
 void LLImageJ2C::decodeFailed()
 {
 	mDecoding = FALSE;
@@ -60,6 +60,11 @@ public:
 	BOOL validate(U8 *data, U32 file_size);
 	BOOL loadAndValidate(const std::string &filename);
 
+	// Progressive decoding: returns a new image holding a copy of the part of the
+	// codestream needed for discard_level, or NULL when not enough data is loaded.
+	// The copy can be decoded while more data is appended to this image.
+	LLImageJ2C* createProgressiveImage(S32 discard_level);
+
 	// Encode accessors
 	void setReversible(const BOOL reversible); // Use non-lossy?
 	void setRate(F32 rate);
@@ -28,22 +28,91 @@
 
 #include "llimageworker.h"
 #include "llimagedxt.h"
+#include "lltimer.h"
+
+// Statistics of the decode thread the current thread is, NULL for other threads.
+static LL_THREAD_LOCAL LLImageDecodeThread::WorkerStats* sCurrentWorkerStats = NULL;
 
 //----------------------------------------------------------------------------
 
 // MAIN THREAD
-LLImageDecodeThread::LLImageDecodeThread(bool threaded)
+LLImageDecodeThread::LLImageDecodeThread(bool threaded, S32 num_threads)
 	: LLQueuedThread("imagedecode", threaded)
 {
 	mCreationMutex = new LLMutex();
+
+	// The additional threads only make sense when this one runs threaded too.
+	num_threads = threaded ? llmax(num_threads, 1) : 1;
+	mWorkerStats.resize(num_threads);
+	for (S32 i = 1; i < num_threads; ++i)
+	{
+		mWorkers.push_back(new DecodeWorker(this, i));
+	}
+	LL_INFOS() << "Image decode threads: " << num_threads << LL_ENDL;
 }
 
 //virtual 
 LLImageDecodeThread::~LLImageDecodeThread()
 {
+	shutdownWorkers();
 	delete mCreationMutex ;
 }
 
+// MAIN THREAD
+//virtual
+void LLImageDecodeThread::shutdown()
+{
+	shutdownWorkers();
+	dumpWorkerStats();
+	LLQueuedThread::shutdown();
+}
+
+// MAIN THREAD
+// The workers must be gone before LLQueuedThread::shutdown() deletes the remaining requests.
+void LLImageDecodeThread::shutdownWorkers()
+{
+	if (mWorkers.empty())
+	{
+		return;
+	}
+	for (std::vector<DecodeWorker*>::iterator iter = mWorkers.begin(); iter != mWorkers.end(); ++iter)
+	{
+		// Wakes the worker if it is sleeping in checkPause().
+		(*iter)->setQuitting();
+	}
+	for (std::vector<DecodeWorker*>::iterator iter = mWorkers.begin(); iter != mWorkers.end(); ++iter)
+	{
+		DecodeWorker* worker = *iter;
+		// The threads are detached; wait for run() to return (after at most the
+		// decode in progress) before deleting.
+		while (!worker->isStopped())
+		{
+			ms_sleep(1);
+		}
+		delete worker;
+	}
+	mWorkers.clear();
+}
+
+void LLImageDecodeThread::dumpWorkerStats()
+{
+	for (S32 i = 0; i < getNumThreads(); ++i)
+	{
+		const WorkerStats& stats = mWorkerStats[i];
+		U32 decodes = stats.mDecodes;
+		U32 time_ms = stats.mDecodeTimeMs;
+		LL_INFOS() << "Image decode thread " << i << ": " << decodes << " decodes in " << time_ms << " ms ("
+				<< (time_ms ? (F32)decodes * 1000.f / (F32)time_ms : 0.f) << " decodes/s busy)" << LL_ENDL;
+	}
+}
+
+// virtual
+// Called from our own thread (or from update() when not threaded)
+void LLImageDecodeThread::startThread()
+{
+	sCurrentWorkerStats = &mWorkerStats[0];
+}
+
 // MAIN THREAD
 // virtual
 S32 LLImageDecodeThread::update(F32 max_time_ms)
@@ -63,7 +132,15 @@ S32 LLImageDecodeThread::update(F32 max_time_ms)
 			LL_ERRS() << "request added after LLLFSThread::cleanupClass()" << LL_ENDL;
 		}
 	}
+	bool added = !mCreationList.empty();
 	mCreationList.clear();
+	if (added)
+	{
+		for (std::vector<DecodeWorker*>::iterator iter = mWorkers.begin(); iter != mWorkers.end(); ++iter)
+		{
+			(*iter)->wake();
+		}
+	}
 	S32 res = LLQueuedThread::update(max_time_ms);
 	return res;
 }
@@ -86,6 +163,41 @@ S32 LLImageDecodeThread::tut_size()
 	return res;
 }
 
+//----------------------------------------------------------------------------
+
+LLImageDecodeThread::DecodeWorker::DecodeWorker(LLImageDecodeThread* pool, S32 index)
+	: LLThread(llformat("imagedecode%d", index)),
+	  mPool(pool),
+	  mIndex(index)
+{
+	start();
+}
+
+// virtual
+// mRunCondition is locked here
+bool LLImageDecodeThread::DecodeWorker::runCondition()
+{
+	return mPool->getPending() > 0;
+}
+
+// virtual
+void LLImageDecodeThread::DecodeWorker::run()
+{
+	sCurrentWorkerStats = &mPool->mWorkerStats[mIndex];
+	while (1)
+	{
+		// Sleeps until update() wakes us up with new requests in the queue.
+		checkPause();
+
+		if (isQuitting() || mPool->isQuitting())
+		{
+			break;
+		}
+
+		mPool->processNextRequest();
+	}
+}
+
 LLImageDecodeThread::Responder::~Responder()
 {
 }
@@ -120,6 +232,7 @@ bool LLImageDecodeThread::ImageRequest::processRequest()
 {
 	const F32 decode_time_slice = .1f;
 	bool done = true;
+	LLTimer decode_timer;
 	if (!mDecodedRaw && mFormattedImage.notNull())
 	{
 		// Decode primary channels
@@ -158,6 +271,14 @@ bool LLImageDecodeThread::ImageRequest::processRequest()
 		mDecodedAux = done;
 	}
 
+	if (sCurrentWorkerStats)
+	{
+		sCurrentWorkerStats->mDecodeTimeMs += (U32)(decode_timer.getElapsedTimeF32() * 1000.f);
+		if (done)
+		{
+			sCurrentWorkerStats->mDecodes++;
+		}
+	}
 	return done;
 }
 
@@ -71,19 +71,59 @@ public:
 		LLPointer<LLImageDecodeThread::Responder> mResponder;
 	};
 	
+	// Decode statistics of one thread of the pool
+	struct WorkerStats
+	{
+		WorkerStats() : mDecodes(0), mDecodeTimeMs(0) {}
+		LLAtomicU32 mDecodes;		// completed requests
+		LLAtomicU32 mDecodeTimeMs;	// time spent in processRequest()
+	};
+
+private:
+	// Additional decode thread. All threads of the pool take requests from the
+	// single priority queue of the LLImageDecodeThread, so an idle thread always
+	// picks up the most important pending request.
+	class DecodeWorker : public LLThread
+	{
+	public:
+		DecodeWorker(LLImageDecodeThread* pool, S32 index);
+
+	protected:
+		/*virtual*/ void run();
+		/*virtual*/ bool runCondition();
+
+	private:
+		LLImageDecodeThread* mPool;
+		S32 mIndex;
+	};
+
 public:
-	LLImageDecodeThread(bool threaded = true);
+	// num_threads is the total number of decode threads, including this one.
+	LLImageDecodeThread(bool threaded = true, S32 num_threads = 1);
 	virtual ~LLImageDecodeThread();
+	/*virtual*/ void shutdown();
 
 	handle_t decodeImage(LLImageFormatted* image,
 						 U32 priority, S32 discard, BOOL needs_aux,
 						 Responder* responder);
 	S32 update(F32 max_time_ms);
 
+	S32 getNumThreads() const { return (S32)mWorkerStats.size(); }
+	const WorkerStats& getWorkerStats(S32 index) const { return mWorkerStats[index]; }
+	void dumpWorkerStats();
+
 	// Used by unit tests to check the consistency of the thread instance
 	S32 tut_size();
-	
+
+protected:
+	/*virtual*/ void startThread();
+
 private:
+	void shutdownWorkers();
+
+	std::vector<DecodeWorker*> mWorkers;
+	std::vector<WorkerStats> mWorkerStats;	// index 0 is this thread
+	
 	struct creation_info
 	{
 		handle_t handle;
@@ -239,6 +239,38 @@ namespace tut
 		ensure("LLImageDecodeThread: threaded work unit not processed", done == true);
 	}
 
+	template<> template<>
+	void imagedecodethread_object_t::test<3>()
+	{
+		// Test a *threaded* instance with a pool of decode threads
+		mThread = new LLImageDecodeThread(true, 4);
+		ensure("LLImageDecodeThread: pool constructor failed", mThread != NULL);
+		ensure("LLImageDecodeThread: pool size incorrect", mThread->getNumThreads() == 4);
+		// Queue more work orders than there are threads
+		const S32 NUM_REQUESTS = 16;
+		bool done[NUM_REQUESTS];
+		for (S32 i = 0; i < NUM_REQUESTS; ++i)
+		{
+			LLImageDecodeThread::handle_t decodeHandle = mThread->decodeImage(NULL, LLQueuedThread::PRIORITY_NORMAL + i, 0, FALSE, new responder_test(&done[i]));
+			ensure("LLImageDecodeThread: pool decodeImage(), returned handle is null", decodeHandle != 0);
+		}
+		// Hand the work orders to the threads
+		mThread->update(1);
+		// Wait till all of them are handled
+		const U32 INCREMENT_TIME = 500;				// 500 milliseconds
+		const U32 MAX_TIME = 20 * INCREMENT_TIME;	// Do the loop 20 times max, i.e. wait 10 seconds but no more
+		U32 total_time = 0;
+		S32 num_done = 0;
+		while ((num_done < NUM_REQUESTS) && (total_time < MAX_TIME))
+		{
+			ms_sleep(INCREMENT_TIME);
+			total_time += INCREMENT_TIME;
+			num_done = std::count(done, done + NUM_REQUESTS, true);
+		}
+		// Verifies that every responder has now been called
+		ensure_equals("LLImageDecodeThread: pool work units not processed", num_done, NUM_REQUESTS);
+	}
+
 	// ---------------------------------------------------------------------------------------
 	// Test the LLImageDecodeThread::ImageRequest interface
 	// ---------------------------------------------------------------------------------------
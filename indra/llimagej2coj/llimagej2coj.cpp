@@ -97,11 +97,39 @@ int ceildivpow2(int a, int b)
 }
 
 
+S32 LLImageJ2COJ::sDecodeThreads = 1;
+
 LLImageJ2COJ::LLImageJ2COJ()
 	: LLImageJ2CImpl()
 {
 }
 
+//static
+void LLImageJ2COJ::setDecodeThreads(S32 num_threads)
+{
+	sDecodeThreads = llclamp(num_threads, 1, 16);
+}
+
+//static
+void LLImageJ2COJ::setCPUFeatures(bool sse2, bool avx2)
+{
+#ifdef OPJ_CPU_SSE2
+	int features = 0;
+	if (sse2)
+	{
+		features |= OPJ_CPU_SSE2;
+		if (avx2)
+		{
+			features |= OPJ_CPU_AVX2;
+		}
+	}
+	opj_set_cpu_features(features);
+	features = opj_get_cpu_features();
+	LL_INFOS("Texture") << "OpenJPEG SIMD: SSE2 " << ((features & OPJ_CPU_SSE2) ? "on" : "off")
+						<< ", AVX2 " << ((features & OPJ_CPU_AVX2) ? "on" : "off") << LL_ENDL;
+#endif
+}
+
 
 LLImageJ2COJ::~LLImageJ2COJ()
 {
@@ -169,6 +197,9 @@ BOOL LLImageJ2COJ::decodeImpl(LLImageJ2C &base, LLImageRaw &raw_image, F32 decod
 	opj_set_default_decoder_parameters(&parameters);
 
 	parameters.cp_reduce = base.getRawDiscardLevel();
+#ifdef OPJ_HAVE_DECODE_THREADS
+	parameters.cp_num_threads = sDecodeThreads;
+#endif
 
 	if(parameters.cp_reduce == 0 && *(U16*)(base.getData() + base.getDataSize() - 2) != 0xD9FF)
 	{
@@ -41,6 +41,15 @@ public:
 	LLImageJ2COJ();
 	virtual ~LLImageJ2COJ();
 
+	// Number of threads the code-blocks and the inverse DWT of one large image are
+	// decoded with, the decoding thread included. 1 (default) decodes on that thread only.
+	static void setDecodeThreads(S32 num_threads);
+	static S32 getDecodeThreads() { return sDecodeThreads; }
+
+	// Lets OpenJPEG use its SSE2/AVX2 inverse DWT and color transform. The CPU
+	// (and for AVX2 the OS) support must have been checked by the caller.
+	static void setCPUFeatures(bool sse2, bool avx2);
+
 protected:
 	/*virtual*/ BOOL getMetadata(LLImageJ2C &base);
 	/*virtual*/ BOOL decodeImpl(LLImageJ2C &base, LLImageRaw &raw_image, F32 decode_time, S32 first_channel, S32 max_channel_count);
@@ -52,6 +61,8 @@ protected:
 		return (a + (1 << b) - 1) >> b;
 	}
 
+private:
+	static S32 sDecodeThreads;
 };
 
 #endif
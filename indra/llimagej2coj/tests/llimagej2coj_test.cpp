@@ -0,0 +1,194 @@
+/** 
+ * @file llimagej2coj_test.cpp
+ * @brief Checks the SIMD inverse DWT and color transforms of OpenJPEG against the C code.
+ *
+ * $LicenseInfo:firstyear=2006&license=viewergpl$
+ * 
+ * Copyright (c) 2006-2009, Linden Research, Inc.
+ * 
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlifegrid.net/programs/open_source/licensing/gplv2
+ * 
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlifegrid.net/programs/open_source/licensing/flossexception
+ * 
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ * 
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ */
+
+#include "../llcommon/linden_common.h"
+#include <cmath>
+#include <vector>
+// Class to test
+#include "../llimagej2coj.h"
+#include "openjpeg.h"
+#include "../llcommon/llprocessor.h"
+// Tut header
+#include "../test/lltut.h"
+
+// -------------------------------------------------------------------------------------------
+// TUT
+// -------------------------------------------------------------------------------------------
+
+namespace tut
+{
+	// Test wrapper declaration: encodes a synthetic 3 component image in memory, decodes it
+	// back with each instruction set and keeps the samples for comparison.
+	struct opjsimd_test
+	{
+		std::vector<unsigned char> mStream;
+
+		~opjsimd_test()
+		{
+			// Back to what the library does when nobody sets anything
+			LLImageJ2COJ::setCPUFeatures(true, false);
+		}
+
+		void encode(int width, int height, int x0, int y0, bool irreversible)
+		{
+			opj_cparameters_t parameters;
+			opj_set_default_encoder_parameters(&parameters);
+			parameters.tcp_numlayers = 1;
+			parameters.tcp_rates[0] = irreversible ? 8.f : 0.f;
+			parameters.cp_disto_alloc = 1;
+			parameters.irreversible = irreversible;
+			parameters.tcp_mct = 1;
+			parameters.numresolution = 5;
+			parameters.image_offset_x0 = x0;
+			parameters.image_offset_y0 = y0;
+
+			opj_image_cmptparm_t cmptparm[3];
+			memset(cmptparm, 0, sizeof(cmptparm));
+			for (int i = 0; i < 3; ++i)
+			{
+				cmptparm[i].dx = cmptparm[i].dy = 1;
+				cmptparm[i].w = width;
+				cmptparm[i].h = height;
+				cmptparm[i].prec = cmptparm[i].bpp = 8;
+			}
+			opj_image_t* image = opj_image_create(3, cmptparm, CLRSPC_SRGB);
+			image->x0 = x0;
+			image->y0 = y0;
+			image->x1 = x0 + width;
+			image->y1 = y0 + height;
+			U32 seed = 1;
+			for (int i = 0; i < 3; ++i)
+			{
+				for (int k = 0; k < width * height; ++k)
+				{
+					seed = seed * 1103515245 + 12345;
+					int x = k % width;
+					int y = k / width;
+					image->comps[i].data[k] = llclamp((int)(127.f + 100.f * sinf(x * 0.05f * (i + 1)) * cosf(y * 0.03f)) + (int)((seed >> 16) & 15), 0, 255);
+				}
+			}
+
+			opj_cinfo_t* cinfo = opj_create_compress(CODEC_J2K);
+			opj_setup_encoder(cinfo, &parameters, image);
+			opj_cio_t* cio = opj_cio_open((opj_common_ptr)cinfo, NULL, 0);
+			bool success = opj_encode(cinfo, cio, image, NULL);
+			if (success)
+			{
+				mStream.assign(cio->buffer, cio->buffer + cio_tell(cio));
+			}
+			opj_cio_close(cio);
+			opj_destroy_compress(cinfo);
+			opj_image_destroy(image);
+			ensure("encoding the test image failed", success);
+		}
+
+		std::vector<int> decode(int features)
+		{
+			opj_set_cpu_features(features);
+
+			opj_dparameters_t parameters;
+			opj_set_default_decoder_parameters(&parameters);
+			opj_dinfo_t* dinfo = opj_create_decompress(CODEC_J2K);
+			opj_setup_decoder(dinfo, &parameters);
+			opj_cio_t* cio = opj_cio_open((opj_common_ptr)dinfo, &mStream[0], mStream.size());
+			opj_image_t* image = opj_decode(dinfo, cio);
+			opj_cio_close(cio);
+			opj_destroy_decompress(dinfo);
+
+			std::vector<int> samples;
+			ensure("decoding the test image failed", image != NULL);
+			for (int i = 0; i < image->numcomps; ++i)
+			{
+				samples.insert(samples.end(), image->comps[i].data, image->comps[i].data + image->comps[i].w * image->comps[i].h);
+			}
+			opj_image_destroy(image);
+			return samples;
+		}
+
+		// Every instruction set this build and CPU have must give the C results exactly
+		void check(const char* what)
+		{
+			std::vector<int> reference = decode(0);
+			LLProcessorInfo proc;
+			if (proc.hasSSE2())
+			{
+				std::vector<int> sse2 = decode(OPJ_CPU_SSE2);
+				ensure(std::string(what) + ": SSE2 differs from C", sse2 == reference);
+				if (proc.hasAVX2())
+				{
+					std::vector<int> avx2 = decode(OPJ_CPU_SSE2 | OPJ_CPU_AVX2);
+					ensure(std::string(what) + ": AVX2 differs from C", avx2 == reference);
+				}
+			}
+		}
+	};
+
+	typedef test_group<opjsimd_test> opjsimd_t;
+	typedef opjsimd_t::object opjsimd_object_t;
+	tut::opjsimd_t tut_opjsimd("opjsimd");
+
+	template<> template<>
+	void opjsimd_object_t::test<1>()
+	{
+		// 5-3 wavelet and RCT, sizes that leave partial groups of lines everywhere
+		encode(333, 157, 0, 0, false);
+		check("reversible");
+	}
+
+	template<> template<>
+	void opjsimd_object_t::test<2>()
+	{
+		// 9-7 wavelet and ICT
+		encode(333, 157, 0, 0, true);
+		check("irreversible");
+	}
+
+	template<> template<>
+	void opjsimd_object_t::test<3>()
+	{
+		// Odd image offsets start the resolutions on odd samples (the other lifting case)
+		encode(131, 67, 3, 5, false);
+		check("reversible with offset");
+		encode(131, 67, 3, 5, true);
+		check("irreversible with offset");
+	}
+
+	template<> template<>
+	void opjsimd_object_t::test<4>()
+	{
+		// Thin images: fewer lines than one SIMD group
+		encode(7, 300, 0, 0, false);
+		check("reversible thin");
+		encode(300, 3, 0, 0, true);
+		check("irreversible thin");
+	}
+}
@@ -296,6 +296,74 @@ S32 LLCamera::AABBInRegionFrustumNoFarClip(const LLVector4a& center, const LLVec
 	return AABBInFrustumNoFarClip(center, radius, mRegionPlanes);
 }
 
+void LLCamera::AABBsInFrustum(const LLAABBBatch& boxes, S32* results, const LLPlane* planes)
+{
+	AABBsInFrustum(boxes, results, planes, AGENT_PLANE_USER_CLIP_NUM);
+}
+
+void LLCamera::AABBsInFrustumNoFarClip(const LLAABBBatch& boxes, S32* results, const LLPlane* planes)
+{
+	AABBsInFrustum(boxes, results, planes, AGENT_PLANE_FAR);
+}
+
+// The box by box tests above, four boxes per lane. The arithmetic is done
+// in the same order, so the results match them exactly.
+void LLCamera::AABBsInFrustum(const LLAABBBatch& boxes, S32* results, const LLPlane* planes, U32 skip_plane)
+{
+	if(!planes)
+	{
+		//use agent space
+		planes = mAgentPlanes;
+	}
+
+	U32 max_planes = llmin(mPlaneCount, (U32) AGENT_PLANE_USER_CLIP_NUM);
+	for (U32 first = 0; first < boxes.mCount; first += 4)
+	{
+		const LLQuad center_x = _mm_load_ps(boxes.mCenter[0] + first);
+		const LLQuad center_y = _mm_load_ps(boxes.mCenter[1] + first);
+		const LLQuad center_z = _mm_load_ps(boxes.mCenter[2] + first);
+		const LLQuad radius_x = _mm_load_ps(boxes.mRadius[0] + first);
+		const LLQuad radius_y = _mm_load_ps(boxes.mRadius[1] + first);
+		const LLQuad radius_z = _mm_load_ps(boxes.mRadius[2] + first);
+		LLQuad outside = _mm_setzero_ps();
+		LLQuad partial = _mm_setzero_ps();
+		for (U32 i = 0; i < max_planes; i++)
+		{
+			U8 mask = mPlaneMask[i];
+			if ((i != skip_plane) && (mask < PLANE_MASK_NUM))
+			{
+				const LLPlane& p(planes[i]);
+				const LLVector4a& scaler = sFrustumScaler[mask];
+				const LLQuad rscale_x = _mm_mul_ps(radius_x, _mm_set1_ps(scaler[0]));
+				const LLQuad rscale_y = _mm_mul_ps(radius_y, _mm_set1_ps(scaler[1]));
+				const LLQuad rscale_z = _mm_mul_ps(radius_z, _mm_set1_ps(scaler[2]));
+				const LLQuad p_x = _mm_set1_ps(p[0]);
+				const LLQuad p_y = _mm_set1_ps(p[1]);
+				const LLQuad p_z = _mm_set1_ps(p[2]);
+				const LLQuad d = _mm_set1_ps(-p[3]);
+
+				LLQuad dot = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_sub_ps(center_x, rscale_x), p_x),
+												   _mm_mul_ps(_mm_sub_ps(center_y, rscale_y), p_y)),
+										_mm_mul_ps(_mm_sub_ps(center_z, rscale_z), p_z));
+				outside = _mm_or_ps(outside, _mm_cmpgt_ps(dot, d));
+
+				dot = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_add_ps(center_x, rscale_x), p_x),
+											_mm_mul_ps(_mm_add_ps(center_y, rscale_y), p_y)),
+								 _mm_mul_ps(_mm_add_ps(center_z, rscale_z), p_z));
+				partial = _mm_or_ps(partial, _mm_cmpgt_ps(dot, d));
+			}
+		}
+
+		const S32 outside_bits = _mm_movemask_ps(outside);
+		const S32 partial_bits = _mm_movemask_ps(partial);
+		for (U32 box = first; box < llmin(first + 4, boxes.mCount); ++box)
+		{
+			const S32 bit = 1 << (box - first);
+			results[box] = (outside_bits & bit) ? 0 : ((partial_bits & bit) ? 1 : 2);
+		}
+	}
+}
+
 int LLCamera::sphereInFrustumQuick(const LLVector3 &sphere_center, const F32 radius) 
 {
 	LLVector3 dist = sphere_center-mFrustCenter;
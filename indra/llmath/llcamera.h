@@ -51,6 +51,36 @@ const F32 MIN_FAR_PLANE 	= 0.2f;
 static const F32 MIN_FIELD_OF_VIEW = 5.0f * DEG_TO_RAD;
 static const F32 MAX_FIELD_OF_VIEW = 320.f * DEG_TO_RAD;
 
+// Up to eight boxes (center, radius) stored one axis after another, so that
+// LLCamera::AABBsInFrustum() can test a plane against four of them at once.
+LL_ALIGN_PREFIX(16)
+struct LLAABBBatch
+{
+	enum { MAX_BOXES = 8 };
+
+	LLAABBBatch() : mCount(0)
+	{
+		// Unused lanes are still loaded; keep them harmless.
+		memset(mCenter, 0, sizeof(mCenter));
+		memset(mRadius, 0, sizeof(mRadius));
+	}
+
+	void add(const LLVector4a& center, const LLVector4a& radius)
+	{
+		llassert(mCount < MAX_BOXES);
+		for (U32 axis = 0; axis < 3; ++axis)
+		{
+			mCenter[axis][mCount] = center[axis];
+			mRadius[axis][mCount] = radius[axis];
+		}
+		++mCount;
+	}
+
+	LL_ALIGN_16(F32 mCenter[3][MAX_BOXES]);
+	LL_ALIGN_16(F32 mRadius[3][MAX_BOXES]);
+	U32 mCount;
+} LL_ALIGN_POSTFIX(16);
+
 // An LLCamera is an LLCoorFrame with a view frustum.
 // This means that it has several methods for moving it around 
 // that are inherited from the LLCoordFrame() class :
@@ -208,6 +238,10 @@ public:
 	S32 AABBInRegionFrustum(const LLVector4a& center, const LLVector4a& radius);
 	S32 AABBInFrustumNoFarClip(const LLVector4a& center, const LLVector4a& radius, const LLPlane* planes = NULL);
 	S32 AABBInRegionFrustumNoFarClip(const LLVector4a& center, const LLVector4a& radius);
+	// Same as AABBInFrustum() and AABBInFrustumNoFarClip() for every box in
+	// boxes, with the result for box i stored in results[i].
+	void AABBsInFrustum(const LLAABBBatch& boxes, S32* results, const LLPlane* planes = NULL);
+	void AABBsInFrustumNoFarClip(const LLAABBBatch& boxes, S32* results, const LLPlane* planes = NULL);
 
 	//does a quick 'n dirty sphere-sphere check
 	S32 sphereInFrustumQuick(const LLVector3 &sphere_center, const F32 radius); 
@@ -228,6 +262,7 @@ protected:
 	void calculateFrustumPlanes(F32 left, F32 right, F32 top, F32 bottom);
 	void calculateFrustumPlanesFromWindow(F32 x1, F32 y1, F32 x2, F32 y2);
 	void calculateWorldFrustumPlanes();
+	void AABBsInFrustum(const LLAABBBatch& boxes, S32* results, const LLPlane* planes, U32 skip_plane);
 } LL_ALIGN_POSTFIX(16);
 
 
@@ -56,7 +56,13 @@ extern U32 gOctreeReserveCapacity;
 
 template <class T> class LLOctreeNode;
 
+// Each element type has its own node pool, which is only locked for types whose
+// octrees are built or destroyed off the main thread. Specialize this next to the
+// element type to turn locking on.
+template <class T> struct LLOctreeSharedPool { enum { value = false }; };
+
 #include "lltimer.h"
+#include "llthread.h"
 
 //#define LL_OCTREE_STATS
 #define LL_OCTREE_POOLS
@@ -205,7 +211,8 @@ struct OctreeGuard
 	}
 	static std::vector<OctreeGuard*>& getNodes()
 	{
-		static std::vector<OctreeGuard*> gNodes;
+		// per thread, mesh decode threads build octrees too
+		static thread_local std::vector<OctreeGuard*> gNodes;
 		return gNodes;
 	}
 	void* mNode;
@@ -257,12 +264,26 @@ public:
 		llassert_always((std::size_t)LL_NEXT_ALIGNED_ADDRESS((char*)size) == sPool.get_requested_size());
 		return sPool;
 	}
+	// NULL (no locking) unless LLOctreeSharedPool<T> says threads other than the main
+	// thread build octrees of T. Created before the pool is first used, so it outlives
+	// the pool at exit.
+	static LLMutex* getPoolMutex()
+	{
+		if (!LLOctreeSharedPool<T>::value)
+		{
+			return NULL;
+		}
+		static LLMutex sPoolMutex;
+		return &sPoolMutex;
+	}
 	void* operator new(size_t size)
 	{
+		LLMutexLock lock(getPoolMutex());
 		return getPool(size).malloc();
 	}
 	void operator delete(void* ptr)
 	{
+		LLMutexLock lock(getPoolMutex());
 		getPool(sizeof(LLOctreeNode<T>)).free(ptr);
 	}
 #else
@@ -961,10 +982,12 @@ public:
 #ifdef LL_OCTREE_POOLS
 	void* operator new(size_t size)
 	{
+		LLMutexLock lock(LLOctreeNode<T>::getPoolMutex());
 		return LLOctreeNode<T>::getPool(size).malloc();
 	}
 	void operator delete(void* ptr)
 	{
+		LLMutexLock lock(LLOctreeNode<T>::getPoolMutex());
 		LLOctreeNode<T>::getPool(sizeof(LLOctreeNode<T>)).free(ptr);
 	}
 #else
@@ -46,6 +46,7 @@
 #include "lloctree.h"
 #include "llvolume.h"
 #include "llvolumeoctree.h"
+#include "llvolumefacecache.h"
 #include "llstl.h"
 #include "llsdserialize.h"
 #include "llvector4a.h"
@@ -680,7 +681,7 @@ LLProfile::Face* LLProfile::addHole(const LLProfileParams& params, BOOL flat, F3
 
 	Face *face = addFace(mTotalOut, mTotal-mTotalOut,0,LL_FACE_INNER_SIDE, flat);
 
-	static LLAlignedArray<LLVector4a,64> pt;
+	static thread_local LLAlignedArray<LLVector4a,64> pt;
 	pt.resize(mTotal) ;
 
 	for (S32 i=mTotalOut;i<mTotal;i++)
@@ -2040,7 +2041,7 @@ LLProfile::~LLProfile()
 }
 
 
-S32 LLVolume::sNumMeshPoints = 0;
+LLAtomicS32 LLVolume::sNumMeshPoints(0);
 
 LLVolume::LLVolume(const LLVolumeParams &params, const F32 detail, const BOOL generate_single_face, const BOOL is_unique)
 	: mParams(params)
@@ -2718,6 +2719,13 @@ void LLVolume::copyVolumeFaces(const LLVolume* volume)
 	mSculptLevel = 0;
 }
 
+void LLVolume::swapVolumeFaces(LLVolume* volume)
+{
+	//the faces stay where they are, so their octrees remain valid
+	mVolumeFaces.swap(volume->mVolumeFaces);
+	mSculptLevel = 0;
+}
+
 void LLVolume::cacheOptimize()
 {
 	for (S32 i = 0; i < (S32)mVolumeFaces.size(); ++i)
@@ -2861,6 +2869,28 @@ inline LLVector4a sculpt_index_to_vector(U32 index, const U8* sculpt_data)
 	return v;
 }
 
+// Converts count pixels of a sculpt map row, at the given byte offsets, to
+// mesh points as sculpt_rgb_to_vector() does, negating x if mirror is set.
+static void sculpt_row_to_vectors(const U8* row, const U32* offsets, S32 count, BOOL mirror, LLVector4a* out)
+{
+	LLVector4a scale;
+	scale.splat(1.f/255.f);
+	const LLVector4a sub(0.5f, 0.5f, 0.5f);
+	const LLVector4a flip(mirror ? -1.f : 1.f, 1.f, 1.f, 1.f);
+
+	for (S32 i = 0; i < count; i++)
+	{
+		const U8* rgb = row + offsets[i];
+		LLVector4a value = _mm_cvtepi32_ps(_mm_setr_epi32(rgb[0], rgb[1], rgb[2], 0));
+		value.mul(scale);
+		value.sub(sub);
+		value.mul(flip);
+
+		llassert(value.isFinite3());
+		out[i] = value;
+	}
+}
+
 inline LLVector4a sculpt_st_to_vector(S32 s, S32 t, S32 size_s, S32 size_t, U16 sculpt_width, U16 sculpt_height, S8 sculpt_components, const U8* sculpt_data)
 {
 	U32 index = sculpt_st_to_index(s, t, size_s, size_t, sculpt_width, sculpt_height, sculpt_components);
@@ -2987,82 +3017,84 @@ void LLVolume::sculptGenerateMapVertices(U16 sculpt_width, U16 sculpt_height, S8
 
 	S32 sizeS = mPathp->mPath.size();
 	S32 sizeT = mProfilep->mProfile.size();
-	
-	S32 line = 0;
-	for (S32 s = 0; s < sizeS; s++)
+
+	// The map column each profile point samples is the same on every row,
+	// so work out the byte offsets once, side stitching included.
+	static thread_local std::vector<U32> column_offsets;
+	column_offsets.resize(sizeT);
+	for (S32 t = 0; t < sizeT; t++)
 	{
-		// Run along the profile.
-		for (S32 t = 0; t < sizeT; t++)
+		S32 reversed_t = t;
+
+		if (reverse_horizontal)
 		{
-			S32 i = t + line;
-			LLVector4a& pt = mMesh[i];
+			reversed_t = sizeT - t - 1;
+		}
 
-			S32 reversed_t = t;
+		U32 x = (U32) ((F32)reversed_t/(sizeT-1) * (F32) sculpt_width);
 
-			if (reverse_horizontal)
+		if (x == sculpt_width)   // side stitching
+		{
+			// wrap?
+			if ((sculpt_stitching == LL_SCULPT_TYPE_SPHERE) ||
+				(sculpt_stitching == LL_SCULPT_TYPE_TORUS) ||
+				(sculpt_stitching == LL_SCULPT_TYPE_CYLINDER))
 			{
-				reversed_t = sizeT - t - 1;
+				x = 0;
 			}
-			
-			U32 x = (U32) ((F32)reversed_t/(sizeT-1) * (F32) sculpt_width);
-			U32 y = (U32) ((F32)s/(sizeS-1) * (F32) sculpt_height);
-
-			
-			if (y == 0)  // top row stitching
+			else
 			{
-				// pinch?
-				if (sculpt_stitching == LL_SCULPT_TYPE_SPHERE)
-				{
-					x = sculpt_width / 2;
-				}
+				x = sculpt_width - 1;
 			}
+		}
 
-			if (y == sculpt_height)  // bottom row stitching
-			{
-				// wrap?
-				if (sculpt_stitching == LL_SCULPT_TYPE_TORUS)
-				{
-					y = 0;
-				}
-				else
-				{
-					y = sculpt_height - 1;
-				}
+		column_offsets[t] = sculpt_xy_to_index(x, 0, sculpt_width, sculpt_height, sculpt_components);
+	}
 
-				// pinch?
-				if (sculpt_stitching == LL_SCULPT_TYPE_SPHERE)
-				{
-					x = sculpt_width / 2;
-				}
-			}
+	const U32 pinch_offset = sculpt_xy_to_index(sculpt_width / 2, 0, sculpt_width, sculpt_height, sculpt_components);
 
-			if (x == sculpt_width)   // side stitching
-			{
-				// wrap?
-				if ((sculpt_stitching == LL_SCULPT_TYPE_SPHERE) ||
-					(sculpt_stitching == LL_SCULPT_TYPE_TORUS) ||
-					(sculpt_stitching == LL_SCULPT_TYPE_CYLINDER))
-				{
-					x = 0;
-				}
-					
-				else
-				{
-					x = sculpt_width - 1;
-				}
-			}
+	S32 line = 0;
+	for (S32 s = 0; s < sizeS; s++)
+	{
+		U32 y = (U32) ((F32)s/(sizeS-1) * (F32) sculpt_height);
+		bool pinch = false;
 
-			pt = sculpt_xy_to_vector(x, y, sculpt_width, sculpt_height, sculpt_components, sculpt_data);
+		if (y == 0)  // top row stitching
+		{
+			// pinch?
+			pinch = sculpt_stitching == LL_SCULPT_TYPE_SPHERE;
+		}
 
-			if (sculpt_mirror)
+		if (y == sculpt_height)  // bottom row stitching
+		{
+			// wrap?
+			if (sculpt_stitching == LL_SCULPT_TYPE_TORUS)
+			{
+				y = 0;
+			}
+			else
 			{
-				LLVector4a scale(-1.f,1,1,1);
-				pt.mul(scale);
+				y = sculpt_height - 1;
 			}
 
-			llassert(pt.isFinite3());
+			// pinch?
+			pinch = sculpt_stitching == LL_SCULPT_TYPE_SPHERE;
 		}
-		
+
+		const U8* row = sculpt_data + sculpt_xy_to_index(0, y, sculpt_width, sculpt_height, sculpt_components);
+		LLVector4a* pt = mMesh.mArray + line;
+
+		if (pinch)
+		{
+			// Every point of a pinched row is the same pixel.
+			sculpt_row_to_vectors(row, &pinch_offset, 1, sculpt_mirror, pt);
+			std::fill(pt + 1, pt + sizeT, pt[0]);
+		}
+		else
+		{
+			sculpt_row_to_vectors(row, &column_offsets[0], sizeT, sculpt_mirror, pt);
+		}
+
 		line += sizeT;
 	}
 }
@@ -4797,6 +4829,19 @@ LLVolumeFace::~LLVolumeFace()
 
 void LLVolumeFace::freeData()
 {
+	if (mShared.notNull())
+	{ //the buffers belong to the shared face, just let go of them
+		mPositions = NULL;
+		mNormals = NULL;
+		mTexCoords = NULL;
+		mTangents = NULL;
+		mIndices = NULL;
+		mOctree = NULL;
+		mNumAllocatedVertices = 0;
+		mNumIndices = 0;
+		mShared = NULL;
+	}
+
 	allocateVertices(0);
 	allocateTangents(0);
 	allocateWeights(0);
@@ -4806,8 +4851,68 @@ void LLVolumeFace::freeData()
 	mOctree = NULL;
 }
 
+void LLVolumeFace::shareData(LLSharedVolumeFace* shared)
+{
+	freeData();
+
+	const LLVolumeFace& src = shared->mFace;
+	mShared = shared;
+	mPositions = src.mPositions;
+	mNormals = src.mNormals;
+	mTexCoords = src.mTexCoords;
+	mTangents = src.mTangents;
+	mIndices = src.mIndices;
+	mOctree = NULL; //may be under construction, createOctree() hands it out
+	mNumVertices = src.mNumVertices;
+	mNumAllocatedVertices = src.mNumAllocatedVertices;
+	mNumIndices = src.mNumIndices;
+	mOptimized = src.mOptimized;
+}
+
+void LLVolumeFace::makeUnique()
+{
+	if (mShared.isNull())
+	{
+		return;
+	}
+
+	//operator= copies the buffers, but also what describes the face
+	LLPointer<LLSharedVolumeFace> shared = mShared;
+	const S32 id = mID;
+	const U32 type_mask = mTypeMask;
+	const S32 begin_s = mBeginS;
+	const S32 begin_t = mBeginT;
+	const S32 num_s = mNumS;
+	const S32 num_t = mNumT;
+	const LLVector4a extents[3] = { mExtents[0], mExtents[1], *mCenter };
+	const LLVector2 tc_extents[2] = { mTexCoordExtents[0], mTexCoordExtents[1] };
+
+	*this = shared->mFace;
+
+	mID = id;
+	mTypeMask = type_mask;
+	mBeginS = begin_s;
+	mBeginT = begin_t;
+	mNumS = num_s;
+	mNumT = num_t;
+	mExtents[0] = extents[0];
+	mExtents[1] = extents[1];
+	*mCenter = extents[2];
+	mTexCoordExtents[0] = tc_extents[0];
+	mTexCoordExtents[1] = tc_extents[1];
+}
+
 BOOL LLVolumeFace::create(LLVolume* volume, BOOL partial_build)
 {
+	if (partial_build)
+	{ //keeps the indices
+		makeUnique();
+	}
+	else if (mShared.notNull())
+	{ //everything gets rebuilt
+		freeData();
+	}
+
 	//tree for this face is no longer valid
 	delete mOctree;
 	mOctree = NULL;
@@ -5237,6 +5342,7 @@ void LLVolumeFace::cacheOptimize()
   // http://home.comcast.net/~tom_forsyth/papers/fast_vert_cache_opt.html
 
 	llassert(!mOptimized);
+	makeUnique();
 	mOptimized = TRUE;
 
 	LLVCacheLRU cache;
@@ -5437,6 +5543,12 @@ void LLVolumeFace::createOctree(F32 scaler, const LLVector4a& center, const LLVe
 		return;
 	}
 
+	if (mShared.notNull())
+	{ //one octree serves every face borrowing the same data
+		LLVolumeFaceCache::createOctree(*this, scaler, center, size);
+		return;
+	}
+
 	mOctree = new LLOctreeRoot<LLVolumeTriangle>(center, size, NULL);
 	new LLVolumeOctreeListener(mOctree);
 
@@ -5502,6 +5614,9 @@ void LLVolumeFace::createOctree(F32 scaler, const LLVector4a& center, const LLVe
 
 void LLVolumeFace::swapData(LLVolumeFace& rhs)
 {
+	makeUnique();
+	rhs.makeUnique();
+
 	llswap(rhs.mPositions, mPositions);
 	llswap(rhs.mNormals, mNormals);
 	llswap(rhs.mTangents, mTangents);
@@ -5760,6 +5875,58 @@ BOOL LLVolumeFace::createUnCutCubeCap(LLVolume* volume, BOOL partial_build)
 }
 
 
+// Writes the texture coordinates of a cap, (x + 0.5, y + 0.5) for each
+// profile point, or (x + 0.5, 0.5 - y) when mirror_v is set, into tc and
+// returns their range. Works on two points per vector.
+static void create_cap_tex_coords(const LLVector4a* profile, S32 count, bool mirror_v,
+								  LLVector2* tc, LLVector2& min_uv, LLVector2& max_uv)
+{
+	const F32 v_sign = mirror_v ? -1.f : 1.f;
+	LLVector4a sign(1.f, v_sign, 1.f, v_sign);
+	LLVector4a half;
+	half.splat(0.5f);
+
+	LLVector4a uv_min, uv_max;
+	S32 i = 0;
+	for (; i + 1 < count; i += 2)
+	{
+		LLVector4a uv = _mm_shuffle_ps(profile[i], profile[i+1], _MM_SHUFFLE(1, 0, 1, 0));
+		uv.mul(sign);
+		uv.add(half);
+		_mm_storeu_ps(tc[i].mV, uv);
+
+		if (i)
+		{
+			uv_min.setMin(uv_min, uv);
+			uv_max.setMax(uv_max, uv);
+		}
+		else
+		{
+			uv_min = uv_max = uv;
+		}
+	}
+
+	if (i)
+	{
+		min_uv.set(llmin(uv_min[0], uv_min[2]), llmin(uv_min[1], uv_min[3]));
+		max_uv.set(llmax(uv_max[0], uv_max[2]), llmax(uv_max[1], uv_max[3]));
+	}
+
+	if (i < count)
+	{
+		tc[i].set(profile[i][0]+0.5f,
+				  mirror_v ? 0.5f - profile[i][1] : profile[i][1]+0.5f);
+		if (i)
+		{
+			update_min_max(min_uv, max_uv, tc[i]);
+		}
+		else
+		{
+			min_uv = max_uv = tc[i];
+		}
+	}
+}
+
 BOOL LLVolumeFace::createCap(LLVolume* volume, BOOL partial_build)
 {
 	if (!(mTypeMask & HOLLOW_MASK) && 
@@ -5836,62 +6003,21 @@ BOOL LLVolumeFace::createCap(LLVolume* volume, BOOL partial_build)
 	max = min;
 	
 	
-	const LLVector4a* p = profile.mArray;
-
-	if (mTypeMask & TOP_MASK)
+	while(src < end)
 	{
-		min_uv.set((*p)[0]+0.5f,
-					(*p)[1]+0.5f);
-
-		max_uv = min_uv;
+		llassert(src->isFinite3());
+		update_min_max(min,max,*src);
 
-		while(src < end)
-		{
-			tc->mV[0] = (*p)[0]+0.5f;
-			tc->mV[1] = (*p)[1]+0.5f;
+		*pos = *src;
 
-			llassert(src->isFinite3());
-			update_min_max(min,max,*src);
-			update_min_max(min_uv, max_uv, *tc);
-		
-			*pos = *src;
-		
-			llassert(pos->isFinite3());
-
-			++p;
-			++tc;
-			++src;
-			++pos;
-		}
-		}
-		else
-		{
-
-		min_uv.set((*p)[0]+0.5f,
-				   0.5f - (*p)[1]);
-		max_uv = min_uv;
-
-		while(src < end)
-		{
-			// Mirror for underside.
-			tc->mV[0] = (*p)[0]+0.5f;
-			tc->mV[1] = 0.5f - (*p)[1];
-		
-			llassert(src->isFinite3());
-			update_min_max(min,max,*src);
-			update_min_max(min_uv, max_uv, *tc);
-
-			*pos = *src;
-		
-			llassert(pos->isFinite3());
-		
-			++p;
-			++tc;
-			++src;
-			++pos;
-		}
+		++src;
+		++pos;
 	}
 
+	// Mirror for underside.
+	create_cap_tex_coords(profile.mArray, num_vertices, !(mTypeMask & TOP_MASK), tc, min_uv, max_uv);
+	tc += num_vertices;
+
 	mCenter->setAdd(min, max);
 	mCenter->mul(0.5f); 
 
@@ -6241,6 +6367,8 @@ void LLVolumeFace::pushVertex(const LLVolumeFace::VertexData& cv)
 
 void LLVolumeFace::pushVertex(const LLVector4a& pos, const LLVector4a& norm, const LLVector2& tc)
 {
+	makeUnique();
+
 	S32 new_verts = mNumVertices+1;
 
 	if (new_verts > mNumAllocatedVertices)
@@ -6261,6 +6389,8 @@ void LLVolumeFace::pushVertex(const LLVector4a& pos, const LLVector4a& norm, con
 
 void LLVolumeFace::allocateTangents(S32 num_verts)
 {
+	makeUnique();
+
 	ll_aligned_free_16(mTangents);
 	mTangents = NULL;
 	if (num_verts)
@@ -6271,6 +6401,8 @@ void LLVolumeFace::allocateTangents(S32 num_verts)
 
 void LLVolumeFace::allocateWeights(S32 num_verts)
 {
+	makeUnique();
+
 	ll_aligned_free_16(mWeights);
 	mWeights = NULL;
 	if (num_verts)
@@ -6281,6 +6413,8 @@ void LLVolumeFace::allocateWeights(S32 num_verts)
 
 void LLVolumeFace::allocateVertices(S32 num_verts, bool copy)
 {
+	makeUnique();
+
 	if (!copy || !num_verts)
 	{
 		ll_aligned_free<64>(mPositions);
@@ -6323,6 +6457,8 @@ void LLVolumeFace::allocateVertices(S32 num_verts, bool copy)
 
 void LLVolumeFace::allocateIndices(S32 num_indices, bool copy)
 {
+	makeUnique();
+
 	if (num_indices == mNumIndices)
 	{
 		return;
@@ -6356,6 +6492,8 @@ void LLVolumeFace::resizeIndices(S32 num_indices)
 
 void LLVolumeFace::pushIndex(const U16& idx)
 {
+	makeUnique();
+
 	allocateIndices(mNumIndices + 1, true);
 
 	mIndices[mNumIndices-1] = idx;
@@ -6422,89 +6560,109 @@ BOOL LLVolumeFace::createSide(LLVolume* volume, BOOL partial_build)
 	F32 begin_stex = floorf(profile[mBeginS][2]);
 	S32 num_s = ((mTypeMask & INNER_MASK) && (mTypeMask & FLAT_MASK) && mNumS > 2) ? mNumS/2 : mNumS;
 
-	S32 cur_vertex = 0;
-	S32 end_t = mBeginT+mNumT;
 	bool test = (mTypeMask & INNER_MASK) && (mTypeMask & FLAT_MASK) && mNumS > 2;
 
-	// Copy the vertices into the array
-	for (t = mBeginT; t < end_t; t++)
+	// Every row of the face takes the same profile columns, so work out once
+	// which mesh column and texture s each vertex of a row gets. Columns past
+	// the end of the profile wrap around into the previous row of the mesh.
+	static thread_local std::vector<S32> row_cols;
+	static thread_local std::vector<F32> row_s;
+	row_cols.clear();
+	row_s.clear();
+
+	for (s = 0; s < num_s; s++)
 	{
-		tt = path_data[t].mTexT;
-		for (s = 0; s < num_s; s++)
+		if (mTypeMask & END_MASK)
 		{
-			if (mTypeMask & END_MASK)
+			if (s)
 			{
-				if (s)
-				{
-					ss = 1.f;
-				}
-				else
-				{
-					ss = 0.f;
-				}
+				ss = 1.f;
 			}
 			else
 			{
-				// Get s value for tex-coord.
-				if (!flat)
-				{
-					ss = profile[mBeginS + s][2];
-				}
-				else
-				{
-					ss = profile[mBeginS + s][2] - begin_stex;
-				}
+				ss = 0.f;
 			}
-
-			if (sculpt_reverse_horizontal)
-			{
-				ss = 1.f - ss;
-			}
-			
-			// Check to see if this triangle wraps around the array.
-			if (mBeginS + s >= max_s)
+		}
+		else
+		{
+			// Get s value for tex-coord.
+			if (!flat)
 			{
-				// We're wrapping
-				i = mBeginS + s + max_s*(t-1);
+				ss = profile[mBeginS + s][2];
 			}
 			else
 			{
-				i = mBeginS + s + max_s*t;
+				ss = profile[mBeginS + s][2] - begin_stex;
 			}
+		}
 
-			mesh[i].store4a((F32*)(pos+cur_vertex));
-			tc[cur_vertex].set(ss,tt);
-		
-			cur_vertex++;
+		if (sculpt_reverse_horizontal)
+		{
+			ss = 1.f - ss;
+		}
 
-			if (test && s > 0)
-			{
-				mesh[i].store4a((F32*)(pos+cur_vertex));
-				tc[cur_vertex].set(ss,tt);
-				cur_vertex++;
-			}
+		// Check to see if this triangle wraps around the array.
+		if (mBeginS + s >= max_s)
+		{
+			// We're wrapping
+			i = mBeginS + s - max_s;
 		}
-		
-		if ((mTypeMask & INNER_MASK) && (mTypeMask & FLAT_MASK) && mNumS > 2)
+		else
 		{
-			if (mTypeMask & OPEN_MASK)
-			{
-				s = num_s-1;
-			}
-			else
-			{
-				s = 0;
-			}
+			i = mBeginS + s;
+		}
 
-			i = mBeginS + s + max_s*t;
-			ss = profile[mBeginS + s][2] - begin_stex;
+		row_cols.push_back(i);
+		row_s.push_back(ss);
 
-			mesh[i].store4a((F32*)(pos+cur_vertex));
-			tc[cur_vertex].set(ss,tt);
-			
-			cur_vertex++;
+		if (test && s > 0)
+		{
+			row_cols.push_back(i);
+			row_s.push_back(ss);
 		}
 	}
+
+	if (test)
+	{
+		if (mTypeMask & OPEN_MASK)
+		{
+			s = num_s-1;
+		}
+		else
+		{
+			s = 0;
+		}
+
+		row_cols.push_back(mBeginS + s);
+		row_s.push_back(profile[mBeginS + s][2] - begin_stex);
+	}
+
+	// Copy the vertices into the array, a row at a time
+	const S32 row_size = row_cols.size();
+	const S32* cols = &row_cols[0];
+	const F32* col_s = &row_s[0];
+	const S32 end_t = mBeginT+mNumT;
+	LLVector4a* dst_pos = pos;
+	LLVector2* dst_tc = tc;
+
+	for (t = mBeginT; t < end_t; t++)
+	{
+		tt = path_data[t].mTexT;
+		const LLVector4a* row = mesh.mArray + max_s*t;
+
+		for (S32 k = 0; k < row_size; k++)
+		{
+			dst_pos[k] = row[cols[k]];
+		}
+
+		for (S32 k = 0; k < row_size; k++)
+		{
+			dst_tc[k].set(col_s[k], tt);
+		}
+
+		dst_pos += row_size;
+		dst_tc += row_size;
+	}
 	
 	mCenter->clear();
 
@@ -6629,19 +6787,14 @@ BOOL LLVolumeFace::createSide(LLVolume* volume, BOOL partial_build)
 		dst += 4;
 	}
 
-	//generate normals 
+	//generate normals, adding each triangle's to its corners as we go
 	U32 count = mNumIndices/3;
 
 	LLVector4a* norm = mNormals;
 
-	static LLAlignedArray<LLVector4a, 64> triangle_normals;
-	triangle_normals.resize(count);
-	LLVector4a* output = triangle_normals.mArray;
-	LLVector4a* end_output = output+count;
-
 	U16* idx = mIndices;
 
-	while (output < end_output)
+	for (U32 i = 0; i < count; i++) //for each triangle
 	{
 		LLVector4a b,v1,v2;
 		b.load4a((F32*) (pos+idx[0]));
@@ -6677,23 +6830,8 @@ BOOL LLVolumeFace::createSide(LLVolume* volume, BOOL partial_build)
 		// mQ = { 0, a[X]*b[Y] - a[Y]*b[X], a[Z]*b[X] - a[X]*b[Z], a[Y]*b[Z] - a[Z]*b[Y] }
 		vector1 = _mm_sub_ps( vector2, _mm_mul_ps( amQ, bmQ ));
 
-		llassert(v1.isFinite3());
-
-		v1.store4a((F32*) output);
-		
-		
-		output++;
-		idx += 3;
-	}
-
-	idx = mIndices;
-
-	LLVector4a* src = triangle_normals.mArray;
-	
-	for (U32 i = 0; i < count; i++) //for each triangle
-	{
-		LLVector4a c;
-		c.load4a((F32*) (src++));
+		const LLVector4a& c = v1;
+		llassert(c.isFinite3());
 
 		LLVector4a* n0p = norm+idx[0];
 		LLVector4a* n1p = norm+idx[1];
@@ -6710,8 +6848,6 @@ BOOL LLVolumeFace::createSide(LLVolume* volume, BOOL partial_build)
 		n1.add(c);
 		n2.add(c);
 
-		llassert(c.isFinite3());
-
 		//even out quad contributions
 		switch (i%2+1)
 		{
@@ -43,6 +43,7 @@ template <class T> class LLOctreeNode;
 class LLVolumeFace;
 class LLVolume;
 class LLVolumeTriangle;
+class LLSharedVolumeFace;
 
 #include "lluuid.h"
 #include "v4color.h"
@@ -57,6 +58,7 @@ class LLVolumeTriangle;
 #include "llstrider.h"
 #include "v4coloru.h"
 #include "llrefcount.h"
+#include "llatomic.h"
 #include "llpointer.h"
 #include "llfile.h"
 #include "llalignedarray.h"
@@ -867,8 +869,17 @@ public:
 	~LLVolumeFace();
 private:
 	void freeData();
+	void shareData(LLSharedVolumeFace* shared);
 public:
 
+	// True while this face borrows its buffers and octree from an identical
+	// face in LLVolumeFaceCache.  They must not be written to; everything
+	// here that edits the face calls makeUnique() first.
+	bool isShared() const							{ return mShared.notNull(); }
+
+	// Gives a shared face its own copy of the buffers, minus the octree.
+	void makeUnique();
+
 	BOOL create(LLVolume* volume, BOOL partial_build = FALSE);
 	void createTangents();
 
@@ -970,6 +981,9 @@ public:
 	BOOL mOptimized;
 
 private:
+	friend class LLVolumeFaceCache;
+	LLPointer<LLSharedVolumeFace> mShared;
+
 	BOOL createUnCutCubeCap(LLVolume* volume, BOOL partial_build = FALSE);
 	BOOL createCap(LLVolume* volume, BOOL partial_build = FALSE);
 	BOOL createSide(LLVolume* volume, BOOL partial_build = FALSE);
@@ -1049,7 +1063,7 @@ public:
 	LLFaceID generateFaceMask();
 
 	BOOL isFaceMaskValid(LLFaceID face_mask);
-	static S32 sNumMeshPoints;
+	static LLAtomicS32 sNumMeshPoints;
 
 	friend std::ostream& operator<<(std::ostream &s, const LLVolume &volume);
 	friend std::ostream& operator<<(std::ostream &s, const LLVolume *volumep);		// HACK to bypass Windoze confusion over 
@@ -1064,6 +1078,7 @@ public:
 	
 	void sculpt(U16 sculpt_width, U16 sculpt_height, S8 sculpt_components, const U8* sculpt_data, S32 sculpt_level, bool visible_placeholder);
 	void copyVolumeFaces(const LLVolume* volume);
+	void swapVolumeFaces(LLVolume* volume); // takes the faces of volume without copying, volume gets ours
 	void copyFacesTo(std::vector<LLVolumeFace> &faces) const;
 	void copyFacesFrom(const std::vector<LLVolumeFace> &faces);
 	void cacheOptimize();
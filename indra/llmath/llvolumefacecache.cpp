@@ -0,0 +1,243 @@
+/**
+ * @file llvolumefacecache.cpp
+ * @brief Content addressed store of volume faces shared between volumes
+ *
+ * $LicenseInfo:firstyear=2026&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2026, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "llvolumefacecache.h"
+#include "llvolumeoctree.h"
+
+// Don't bother purging unused faces before there are this many.
+static const size_t MIN_PURGE_SIZE = 1024;
+
+LLVolumeFaceCache::face_map_t* LLVolumeFaceCache::sFaces = NULL;
+size_t LLVolumeFaceCache::sPurgeSize = MIN_PURGE_SIZE;
+LLGlobalMutex LLVolumeFaceCache::sMutex;
+LLGlobalMutex LLVolumeFaceCache::sOctreeMutex;
+
+static U64 hash_words(U64 hash, const void* data, size_t bytes)
+{
+	// FNV-1a over 32 bit words; collisions only cost a compare
+	const U64 FNV_PRIME = 0x100000001b3ULL;
+
+	const U32* words = (const U32*) data;
+	const size_t count = bytes / sizeof(U32);
+	for (size_t i = 0; i < count; ++i)
+	{
+		hash = (hash ^ words[i]) * FNV_PRIME;
+	}
+
+	const U8* tail = (const U8*) (words + count);
+	for (size_t i = 0; i < bytes % sizeof(U32); ++i)
+	{
+		hash = (hash ^ tail[i]) * FNV_PRIME;
+	}
+	return hash;
+}
+
+//static
+U64 LLVolumeFaceCache::hashFace(const LLVolumeFace& face)
+{
+	const size_t verts = face.mNumVertices;
+
+	U64 hash = 0xcbf29ce484222325ULL;
+	hash = hash_words(hash, &face.mNumVertices, sizeof(S32));
+	hash = hash_words(hash, &face.mNumIndices, sizeof(S32));
+	hash = hash_words(hash, face.mPositions, verts * sizeof(LLVector4a));
+	hash = hash_words(hash, face.mNormals, verts * sizeof(LLVector4a));
+	hash = hash_words(hash, face.mTexCoords, verts * sizeof(LLVector2));
+	hash = hash_words(hash, face.mIndices, face.mNumIndices * sizeof(U16));
+
+	// the multiply only carries upwards, so fold the high bits back down
+	// before the map takes the low ones
+	return hash ^ (hash >> 29);
+}
+
+//static
+bool LLVolumeFaceCache::sameData(const LLVolumeFace& a, const LLVolumeFace& b)
+{
+	if (a.mNumVertices != b.mNumVertices || a.mNumIndices != b.mNumIndices ||
+		!a.mTangents != !b.mTangents || a.mOptimized != b.mOptimized)
+	{
+		return false;
+	}
+
+	const size_t verts = a.mNumVertices;
+	return !memcmp(a.mPositions, b.mPositions, verts * sizeof(LLVector4a)) &&
+		   !memcmp(a.mNormals, b.mNormals, verts * sizeof(LLVector4a)) &&
+		   !memcmp(a.mTexCoords, b.mTexCoords, verts * sizeof(LLVector2)) &&
+		   !memcmp(a.mIndices, b.mIndices, a.mNumIndices * sizeof(U16)) &&
+		   (!a.mTangents || !memcmp(a.mTangents, b.mTangents, verts * sizeof(LLVector4a)));
+}
+
+//static
+LLSharedVolumeFace* LLVolumeFaceCache::find(U64 hash, const LLVolumeFace& face)
+{
+	if (!sFaces)
+	{
+		return NULL;
+	}
+
+	std::pair<face_map_t::iterator, face_map_t::iterator> range = sFaces->equal_range(hash);
+	for (face_map_t::iterator iter = range.first; iter != range.second; ++iter)
+	{
+		if (sameData(iter->second->mFace, face))
+		{
+			return iter->second;
+		}
+	}
+	return NULL;
+}
+
+//static
+void LLVolumeFaceCache::purge()
+{
+	// Only this map holds a face nothing borrows, and new borrowers only
+	// come through here with the mutex held, so such a face stays unused.
+	for (face_map_t::iterator iter = sFaces->begin(); iter != sFaces->end(); )
+	{
+		if (iter->second->getNumRefs() == 1)
+		{
+			iter = sFaces->erase(iter);
+		}
+		else
+		{
+			++iter;
+		}
+	}
+}
+
+//static
+bool LLVolumeFaceCache::share(LLVolumeFace& face)
+{
+	if (face.isShared())
+	{
+		return true;
+	}
+
+	if (face.mWeights || !face.mNumVertices || !face.mNumIndices ||
+		!face.mPositions || !face.mNormals || !face.mTexCoords || !face.mIndices)
+	{
+		return false;
+	}
+
+	// Building tangents normalizes the normals, so do it before hashing.
+	face.createTangents();
+	const U64 hash = hashFace(face);
+
+	{
+		LLMutexLock lock(sMutex);
+		if (LLSharedVolumeFace* shared = find(hash, face))
+		{
+			face.shareData(shared);
+			return true;
+		}
+	}
+
+	// First of its kind: hand its buffers over to a new cached face.
+	LLPointer<LLSharedVolumeFace> shared = new LLSharedVolumeFace(hash);
+	LLVolumeFace& dst = shared->mFace;
+	llswap(dst.mPositions, face.mPositions);
+	llswap(dst.mNormals, face.mNormals);
+	llswap(dst.mTexCoords, face.mTexCoords);
+	llswap(dst.mTangents, face.mTangents);
+	llswap(dst.mIndices, face.mIndices);
+	llswap(dst.mOctree, face.mOctree);
+	llswap(dst.mNumVertices, face.mNumVertices);
+	llswap(dst.mNumAllocatedVertices, face.mNumAllocatedVertices);
+	llswap(dst.mNumIndices, face.mNumIndices);
+	dst.mOptimized = face.mOptimized;
+	dst.mExtents[0] = face.mExtents[0];
+	dst.mExtents[1] = face.mExtents[1];
+	*dst.mCenter = *face.mCenter;
+
+	const size_t verts = dst.mNumVertices;
+	shared->mBytes = verts * (3 * sizeof(LLVector4a) + sizeof(LLVector2)) +
+					 dst.mNumIndices * sizeof(U16) +
+					 dst.mNumIndices / 3 * sizeof(LLVolumeTriangle);
+
+	LLMutexLock lock(sMutex);
+	// another thread may have published the same face in the meantime
+	LLSharedVolumeFace* cached = find(hash, dst);
+	if (!cached)
+	{
+		if (!sFaces)
+		{
+			sFaces = new face_map_t;
+		}
+		else if (sFaces->size() >= sPurgeSize)
+		{
+			purge();
+			sPurgeSize = llmax(MIN_PURGE_SIZE, sFaces->size() * 2);
+		}
+		sFaces->insert(std::make_pair(hash, shared));
+		cached = shared;
+	}
+	face.shareData(cached);
+	return true;
+}
+
+//static
+void LLVolumeFaceCache::createOctree(LLVolumeFace& face, F32 scaler, const LLVector4a& center, const LLVector4a& size)
+{
+	// Apart from its octree, a cached face is never written to, so this
+	// doesn't need to hold up share().
+	LLMutexLock lock(sOctreeMutex);
+	LLVolumeFace& src = face.mShared->mFace;
+	src.createOctree(scaler, center, size);
+	face.mOctree = src.mOctree;
+}
+
+//static
+void LLVolumeFaceCache::getStats(S32& faces, U64& bytes_saved)
+{
+	faces = 0;
+	bytes_saved = 0;
+
+	LLMutexLock lock(sMutex);
+	if (!sFaces)
+	{
+		return;
+	}
+
+	for (face_map_t::const_iterator iter = sFaces->begin(); iter != sFaces->end(); ++iter)
+	{
+		const S32 borrowers = iter->second->getNumRefs() - 1;
+		if (borrowers > 0)
+		{
+			++faces;
+			bytes_saved += (U64) iter->second->mBytes * (borrowers - 1);
+		}
+	}
+}
+
+//static
+void LLVolumeFaceCache::cleanup()
+{
+	LLMutexLock lock(sMutex);
+	delete sFaces;
+	sFaces = NULL;
+	sPurgeSize = MIN_PURGE_SIZE;
+}
@@ -0,0 +1,95 @@
+/**
+ * @file llvolumefacecache.h
+ * @brief Content addressed store of volume faces shared between volumes
+ *
+ * $LicenseInfo:firstyear=2026&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2026, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLVOLUMEFACECACHE_H
+#define LL_LLVOLUMEFACECACHE_H
+
+#include <unordered_map>
+
+#include "llvolume.h"
+#include "llthread.h"
+
+// A finished face whose buffers and octree any number of LLVolumeFaces
+// borrow.  Nothing writes to it once it is in the cache.
+class LLSharedVolumeFace : public LLThreadSafeRefCount
+{
+protected:
+	~LLSharedVolumeFace() {}
+
+public:
+	LLSharedVolumeFace(U64 hash) : mHash(hash), mBytes(0) {}
+
+	LLVolumeFace mFace;
+	const U64 mHash;
+	size_t mBytes;		// memory one copy of the face takes
+};
+
+// Volumes with different LLVolumeParams often end up with the same faces,
+// for instance copies of a mesh or sculpt whose prim parameters differ, or
+// the placeholder of every sculpt whose map is missing.  Faces handed to
+// share() are looked up by a hash of their vertices and indices, compared
+// in full, and made to borrow the buffers of an identical face found there
+// rather than keep their own.  The first face of its kind gets its tangents
+// built and becomes the cached copy.  Its octree is only built once a
+// borrower needs one, and then serves all of them.
+//
+// Borrowing faces are copy on write: anything that edits a face first gives
+// it a private copy through LLVolumeFace::makeUnique().  Copying a face with
+// operator= copies the data as it always did.
+class LLVolumeFaceCache
+{
+public:
+	// Makes face borrow from the cache, and returns true if it does.  Faces
+	// with skin weights are left alone, as their weights get scrubbed for
+	// whichever skin they are drawn with, and so are empty faces.
+	static bool share(LLVolumeFace& face);
+
+	// Gives a face that borrows from the cache the octree of the cached face,
+	// building it first if no borrower has needed it yet.
+	static void createOctree(LLVolumeFace& face, F32 scaler, const LLVector4a& center, const LLVector4a& size);
+
+	// Number of cached faces in use, and the memory their borrowers would
+	// take on top of that if each had its own copy.
+	static void getStats(S32& faces, U64& bytes_saved);
+
+	// Lets go of every cached face at shutdown.  The cache is never torn
+	// down by static destructors, as faces need the octree allocator.
+	static void cleanup();
+
+private:
+	static U64 hashFace(const LLVolumeFace& face);
+	static bool sameData(const LLVolumeFace& a, const LLVolumeFace& b);
+	static LLSharedVolumeFace* find(U64 hash, const LLVolumeFace& face);
+	static void purge();
+
+	typedef std::unordered_multimap<U64, LLPointer<LLSharedVolumeFace> > face_map_t;
+	static face_map_t* sFaces;
+	static size_t sPurgeSize;
+	static LLGlobalMutex sMutex;
+	static LLGlobalMutex sOctreeMutex;
+};
+
+#endif // LL_LLVOLUMEFACECACHE_H
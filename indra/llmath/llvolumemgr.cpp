@@ -25,9 +25,12 @@
 
 #include "linden_common.h"
 
+#include <set>
+
 #include "llvolumemgr.h"
 #include "llvolume.h"
 #include "llthread.h"
+#include "llparallelfor.h"
 
 
 const F32 BASE_THRESHOLD = 0.03f;
@@ -106,11 +109,72 @@ LLVolume* LLVolumeMgr::refVolume(const LLVolumeParams &volume_params, const S32
 	{
 		volgroupp = iter->second;
 	}
+	LLVolume* volumep = volgroupp->refLOD(detail);
+	if (mDataMutex)
+	{
+		mDataMutex->unlock();
+	}
+	return volumep;
+}
+
+void LLVolumeMgr::refVolumes(const std::vector<volume_request_t>& requests, std::vector<LLVolume*>& volumes)
+{
+	if (mDataMutex)
+	{
+		mDataMutex->lock();
+	}
+
+	std::vector<LLVolumeLODGroup*> groups;
+	groups.reserve(requests.size());
+	std::vector<std::pair<LLVolumeLODGroup*, S32> > missing;
+	std::set<std::pair<LLVolumeLODGroup*, S32> > queued;
+	for (std::vector<volume_request_t>::const_iterator it = requests.begin(); it != requests.end(); ++it)
+	{
+		LLVolumeLODGroup* volgroupp;
+		volume_lod_group_map_t::iterator iter = mVolumeLODGroups.find(&it->first);
+		if (iter == mVolumeLODGroups.end())
+		{
+			volgroupp = createNewGroup(it->first);
+		}
+		else
+		{
+			volgroupp = iter->second;
+		}
+		groups.push_back(volgroupp);
+
+		std::pair<LLVolumeLODGroup*, S32> lod(volgroupp, it->second);
+		if (!volgroupp->hasLOD(it->second) && queued.insert(lod).second)
+		{
+			missing.push_back(lod);
+		}
+	}
+
+	// Building only reads the groups, which nothing else can change while
+	// we hold the lock.
+	std::vector<LLVolume*> built(missing.size());
+	ll_parallel_for(missing.size(), 1, [&](size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; ++i)
+		{
+			built[i] = missing[i].first->buildLOD(missing[i].second);
+		}
+	});
+	for (size_t i = 0; i < missing.size(); ++i)
+	{
+		missing[i].first->setLOD(missing[i].second, built[i]);
+	}
+
+	volumes.clear();
+	volumes.reserve(requests.size());
+	for (size_t i = 0; i < requests.size(); ++i)
+	{
+		volumes.push_back(groups[i]->refLOD(requests[i].second));
+	}
+
 	if (mDataMutex)
 	{
 		mDataMutex->unlock();
 	}
-	return volgroupp->refLOD(detail);
 }
 
 // virtual
@@ -296,12 +360,24 @@ LLVolume* LLVolumeLODGroup::refLOD(const S32 detail)
 	mRefs++;
 	if (mVolumeLODs[detail].isNull())
 	{
-		mVolumeLODs[detail] = new LLVolume(mVolumeParams, mDetailScales[detail]);
+		setLOD(detail, buildLOD(detail));
 	}
 	mLODRefs[detail]++;
 	return mVolumeLODs[detail];
 }
 
+LLVolume* LLVolumeLODGroup::buildLOD(const S32 detail) const
+{
+	llassert(detail >=0 && detail < NUM_LODS);
+	return new LLVolume(mVolumeParams, mDetailScales[detail]);
+}
+
+void LLVolumeLODGroup::setLOD(const S32 detail, LLVolume* volumep)
+{
+	llassert(mVolumeLODs[detail].isNull());
+	mVolumeLODs[detail] = volumep;
+}
+
 BOOL LLVolumeLODGroup::derefLOD(LLVolume *volumep)
 {
 	llassert_always(mRefs > 0);
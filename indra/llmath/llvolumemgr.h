@@ -28,6 +28,7 @@
 #define LL_LLVOLUMEMGR_H
 
 #include <map>
+#include <vector>
 
 #include "llvolume.h"
 #include "llpointer.h"
@@ -56,6 +57,12 @@ public:
 
 	LLVolume* refLOD(const S32 detail);
 	BOOL derefLOD(LLVolume *volumep);
+
+	// Split refLOD() for LLVolumeMgr::refVolumes(): buildLOD() only reads
+	// the group, so several threads may call it at once.
+	bool hasLOD(const S32 detail) const { return mVolumeLODs[detail].notNull(); }
+	LLVolume* buildLOD(const S32 detail) const;
+	void setLOD(const S32 detail, LLVolume* volumep);
 	S32 getNumRefs() const { return mRefs; }
 	
 	const LLVolumeParams* getVolumeParams() const { return &mVolumeParams; };
@@ -89,6 +96,11 @@ public:
 	virtual LLVolume *refVolume(const LLVolumeParams &volume_params, const S32 detail);
 	virtual void unrefVolume(LLVolume *volumep);
 
+	// Same as calling refVolume() for every request, in order, but the
+	// volumes that are not built yet are built on several threads at once.
+	typedef std::pair<LLVolumeParams, S32> volume_request_t;
+	void refVolumes(const std::vector<volume_request_t>& requests, std::vector<LLVolume*>& volumes);
+
 	void dump();
 
 	// manually call this for mutex magic
@@ -83,6 +83,9 @@ public:
 	void setBinIndex(S32 idx) const { mBinIndex = idx; }
 };
 
+// Mesh decode threads build face octrees, and the main thread frees them.
+template <> struct LLOctreeSharedPool<LLVolumeTriangle> { enum { value = true }; };
+
 class LLVolumeOctreeListener : public LLOctreeListener<LLVolumeTriangle>
 {
 public:
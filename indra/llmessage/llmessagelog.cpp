@@ -1,5 +1,15 @@
 // <edit>
 #include "llmessagelog.h"
+#include "llerror.h"
+#include "lltimer.h"
+
+// Capture file layout, host byte order:
+//   header: 8 byte magic, U32 version
+//   record: U64 usec since start, U8 direction, U8 trusted,
+//           U32 from ip, U16 from port, U32 to ip, U16 to port,
+//           U16 size, size bytes of raw packet
+static const char CAPTURE_MAGIC[8] = { 'L', 'L', 'M', 'S', 'G', 'C', 'A', 'P' };
+static const U32 CAPTURE_VERSION = 1;
 
 LLMessageLogEntry::LLMessageLogEntry(EType type, LLHost from_host, LLHost to_host, U8* data, S32 data_size)
 :	mType(type),
@@ -27,6 +37,8 @@ LLMessageLogEntry::~LLMessageLogEntry()
 U32 LLMessageLog::sMaxSize = 4096; // testzone fixme todo boom
 std::deque<LLMessageLogEntry> LLMessageLog::sDeque;
 void (*(LLMessageLog::sCallback))(LLMessageLogEntry);
+LLFILE* LLMessageLog::sCaptureFile = NULL;
+U64 LLMessageLog::sCaptureStart = 0;
 void LLMessageLog::setMaxSize(U32 size)
 {
 	sMaxSize = size;
@@ -39,6 +51,7 @@ void LLMessageLog::setCallback(void (*callback)(LLMessageLogEntry))
 }
 void LLMessageLog::log(LLHost from_host, LLHost to_host, U8* data, S32 data_size)
 {
+	if(sCaptureFile) capture(CAPTURE_OUT, from_host, to_host, data, data_size, FALSE);
 	LLMessageLogEntry entry = LLMessageLogEntry(LLMessageLogEntry::TEMPLATE, from_host, to_host, data, data_size);
 	if(!entry.mDataSize || !entry.mData.size()) return;
 	if(sCallback) sCallback(entry);
@@ -51,4 +64,104 @@ std::deque<LLMessageLogEntry> LLMessageLog::getDeque()
 {
 	return sDeque;
 }
+bool LLMessageLog::startCapture(const std::string& filename)
+{
+	stopCapture();
+	sCaptureFile = LLFile::fopen(filename, "wb");
+	if(!sCaptureFile)
+	{
+		LL_WARNS("Messaging") << "Unable to open message capture file " << filename << LL_ENDL;
+		return false;
+	}
+	fwrite(CAPTURE_MAGIC, sizeof(CAPTURE_MAGIC), 1, sCaptureFile);
+	fwrite(&CAPTURE_VERSION, sizeof(CAPTURE_VERSION), 1, sCaptureFile);
+	sCaptureStart = totalTime();
+	LL_INFOS("Messaging") << "Capturing messages to " << filename << LL_ENDL;
+	return true;
+}
+void LLMessageLog::stopCapture()
+{
+	if(!sCaptureFile) return;
+	fclose(sCaptureFile);
+	sCaptureFile = NULL;
+}
+void LLMessageLog::capture(ECaptureDirection direction, const LLHost& from_host, const LLHost& to_host,
+						   const U8* data, S32 data_size, BOOL trusted)
+{
+	if(!sCaptureFile || !data || data_size <= 0 || data_size > 0xFFFF) return;
+	U64 usec = totalTime() - sCaptureStart;
+	U8 dir = (U8)direction;
+	U8 trust = trusted ? 1 : 0;
+	U32 from_ip = from_host.getAddress();
+	U16 from_port = (U16)from_host.getPort();
+	U32 to_ip = to_host.getAddress();
+	U16 to_port = (U16)to_host.getPort();
+	U16 size = (U16)data_size;
+	fwrite(&usec, sizeof(usec), 1, sCaptureFile);
+	fwrite(&dir, sizeof(dir), 1, sCaptureFile);
+	fwrite(&trust, sizeof(trust), 1, sCaptureFile);
+	fwrite(&from_ip, sizeof(from_ip), 1, sCaptureFile);
+	fwrite(&from_port, sizeof(from_port), 1, sCaptureFile);
+	fwrite(&to_ip, sizeof(to_ip), 1, sCaptureFile);
+	fwrite(&to_port, sizeof(to_port), 1, sCaptureFile);
+	fwrite(&size, sizeof(size), 1, sCaptureFile);
+	if(fwrite(data, 1, size, sCaptureFile) != size)
+	{
+		LL_WARNS("Messaging") << "Message capture write failed, stopping capture" << LL_ENDL;
+		stopCapture();
+	}
+}
+bool LLMessageLog::readCapture(const std::string& filename, std::vector<LLMessageCaptureRecord>& records)
+{
+	LLFILE* fp = LLFile::fopen(filename, "rb");
+	if(!fp)
+	{
+		LL_WARNS("Messaging") << "Unable to open message capture file " << filename << LL_ENDL;
+		return false;
+	}
+	char magic[sizeof(CAPTURE_MAGIC)];
+	U32 version = 0;
+	if(fread(magic, sizeof(magic), 1, fp) != 1
+	   || memcmp(magic, CAPTURE_MAGIC, sizeof(magic))
+	   || fread(&version, sizeof(version), 1, fp) != 1
+	   || version != CAPTURE_VERSION)
+	{
+		LL_WARNS("Messaging") << filename << " is not a version " << CAPTURE_VERSION
+							  << " message capture" << LL_ENDL;
+		fclose(fp);
+		return false;
+	}
+	records.clear();
+	while(true)
+	{
+		LLMessageCaptureRecord record;
+		U8 trust;
+		U32 from_ip, to_ip;
+		U16 from_port, to_port, size;
+		if(fread(&record.mTimeUsec, sizeof(record.mTimeUsec), 1, fp) != 1) break;
+		if(fread(&record.mDirection, sizeof(record.mDirection), 1, fp) != 1
+		   || fread(&trust, sizeof(trust), 1, fp) != 1
+		   || fread(&from_ip, sizeof(from_ip), 1, fp) != 1
+		   || fread(&from_port, sizeof(from_port), 1, fp) != 1
+		   || fread(&to_ip, sizeof(to_ip), 1, fp) != 1
+		   || fread(&to_port, sizeof(to_port), 1, fp) != 1
+		   || fread(&size, sizeof(size), 1, fp) != 1)
+		{
+			LL_WARNS("Messaging") << "Truncated record in message capture " << filename << LL_ENDL;
+			break;
+		}
+		record.mTrusted = trust ? TRUE : FALSE;
+		record.mFromHost = LLHost(from_ip, from_port);
+		record.mToHost = LLHost(to_ip, to_port);
+		record.mData.resize(size);
+		if(size && fread(&record.mData[0], 1, size, fp) != size)
+		{
+			LL_WARNS("Messaging") << "Truncated record in message capture " << filename << LL_ENDL;
+			break;
+		}
+		records.push_back(record);
+	}
+	fclose(fp);
+	return true;
+}
 // </edit>
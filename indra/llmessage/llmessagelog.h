@@ -3,8 +3,10 @@
 #define LL_LLMESSAGELOG_H
 #include "stdtypes.h"
 #include "llhost.h"
+#include "llfile.h"
 #include <queue>
 #include <string.h>
+#include <vector>
 
 class LLMessageSystem;
 class LLMessageLogEntry
@@ -25,14 +27,40 @@ public:
 	S32 mDataSize;
 	std::vector<U8> mData;
 };
+// One packet read back from a binary capture file.
+struct LLMessageCaptureRecord
+{
+	U64 mTimeUsec;			// since the capture started
+	U8 mDirection;			// LLMessageLog::ECaptureDirection
+	BOOL mTrusted;			// circuit was trusted when the packet was seen
+	LLHost mFromHost;
+	LLHost mToHost;
+	std::vector<U8> mData;	// raw packet, acks and zerocoding intact
+};
 class LLMessageLog
 {
 public:
+	enum ECaptureDirection
+	{
+		CAPTURE_IN = 0,
+		CAPTURE_OUT = 1
+	};
 	static void setMaxSize(U32 size);
 	static void setCallback(void (*callback)(LLMessageLogEntry));
 	static void log(LLHost from_host, LLHost to_host, U8* data, S32 data_size);
 	static std::deque<LLMessageLogEntry> getDeque();
+
+	// Binary packet capture. Outgoing packets are captured from log(),
+	// incoming ones by LLMessageSystem::checkMessages().
+	static bool startCapture(const std::string& filename);
+	static void stopCapture();
+	static bool isCapturing() { return sCaptureFile != NULL; }
+	static void capture(ECaptureDirection direction, const LLHost& from_host, const LLHost& to_host,
+						const U8* data, S32 data_size, BOOL trusted);
+	static bool readCapture(const std::string& filename, std::vector<LLMessageCaptureRecord>& records);
 private:
+	static LLFILE* sCaptureFile;
+	static U64 sCaptureStart;
 	static U32 sMaxSize;
 	static void (*sCallback)(LLMessageLogEntry);
 	static std::deque<LLMessageLogEntry> sDeque;
@@ -0,0 +1,211 @@
+/** 
+ * @file llmessagereplay.cpp
+ * @brief Replays a binary message capture through LLMessageSystem
+ *
+ * $LicenseInfo:firstyear=2026&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2026, Linden Research, Inc.
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ * 
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "llmessagereplay.h"
+
+#include <algorithm>
+#include <iomanip>
+
+#include "llerror.h"
+#include "message.h"
+
+// Most packets left waiting in the inject queue at maximum speed; keeps a
+// huge capture from being copied into the queue at once.
+static const S32 MAX_SPEED_BATCH = 1024;
+
+LLMessageReplay::LLMessageReplay()
+:	mNext(0),
+	mMaxSpeed(false),
+	mRunning(false),
+	mPrevCallback(NULL),
+	mPrevCallbackData(NULL)
+{
+}
+
+LLMessageReplay::~LLMessageReplay()
+{
+	stop();
+}
+
+bool LLMessageReplay::load(const std::string& filename)
+{
+	stop();
+	mNext = 0;
+	mStats.clear();
+
+	std::vector<LLMessageCaptureRecord> records;
+	if (!LLMessageLog::readCapture(filename, records))
+	{
+		return false;
+	}
+
+	// Only what the viewer received is replayed.
+	mRecords.clear();
+	for (size_t i = 0; i < records.size(); ++i)
+	{
+		if (records[i].mDirection == LLMessageLog::CAPTURE_IN)
+		{
+			mRecords.push_back(records[i]);
+		}
+	}
+	LL_INFOS("Messaging") << "Loaded " << mRecords.size() << " incoming packets from "
+						  << filename << LL_ENDL;
+	return true;
+}
+
+void LLMessageReplay::start()
+{
+	if (mRunning || !gMessageSystem)
+	{
+		return;
+	}
+	mPrevCallback = gMessageSystem->getTimingCallback();
+	mPrevCallbackData = gMessageSystem->getTimingCallbackData();
+	gMessageSystem->setTimingFunc(timingCallback, this);
+	mTimer.reset();
+	mRunning = true;
+}
+
+void LLMessageReplay::stop()
+{
+	if (!mRunning)
+	{
+		return;
+	}
+	if (gMessageSystem)
+	{
+		gMessageSystem->setTimingFunc(mPrevCallback, mPrevCallbackData);
+	}
+	mPrevCallback = NULL;
+	mPrevCallbackData = NULL;
+	mRunning = false;
+}
+
+void LLMessageReplay::update()
+{
+	if (!mRunning || !gMessageSystem)
+	{
+		return;
+	}
+
+	if (mMaxSpeed)
+	{
+		S32 room = MAX_SPEED_BATCH - gMessageSystem->getPendingInjectedCount();
+		while (room-- > 0 && mNext < mRecords.size())
+		{
+			inject(mRecords[mNext++]);
+		}
+	}
+	else
+	{
+		U64 now_usec = (U64)(mTimer.getElapsedTimeF64() * 1000000.0);
+		while (mNext < mRecords.size() && mRecords[mNext].mTimeUsec <= now_usec)
+		{
+			inject(mRecords[mNext++]);
+		}
+	}
+}
+
+bool LLMessageReplay::isDone() const
+{
+	return mNext >= mRecords.size()
+		&& (!gMessageSystem || !gMessageSystem->getPendingInjectedCount());
+}
+
+void LLMessageReplay::inject(const LLMessageCaptureRecord& record)
+{
+	S32 size = (S32)record.mData.size();
+	if (size < (S32)LL_MINIMUM_VALID_PACKET_SIZE)
+	{
+		return;
+	}
+	std::vector<U8> data(record.mData);
+
+	// Appended acks refer to packets of the recorded session.
+	if (data[0] & LL_ACK_FLAG)
+	{
+		S32 acks = data[size - 1];
+		size -= 1 + acks * (S32)sizeof(TPACKETID);
+		if (size < (S32)LL_MINIMUM_VALID_PACKET_SIZE)
+		{
+			return;
+		}
+	}
+	data[0] &= ~(LL_ACK_FLAG | LL_RELIABLE_FLAG | LL_RESENT_FLAG);
+
+	gMessageSystem->injectPacket(mRemapHost.isOk() ? mRemapHost : record.mFromHost,
+								 &data[0], size);
+}
+
+// static
+void LLMessageReplay::timingCallback(const char* name, F32 time, void* data)
+{
+	LLMessageReplay* self = (LLMessageReplay*)data;
+	if (gMessageSystem->isLastPacketInjected())
+	{
+		HandlerStat& stat = self->mStats[name];
+		stat.mCount++;
+		stat.mTotal += time;
+		stat.mMax = llmax(stat.mMax, time);
+	}
+	if (self->mPrevCallback)
+	{
+		self->mPrevCallback(name, time, self->mPrevCallbackData);
+	}
+}
+
+static bool stat_total_greater(const std::pair<const char*, F64>& a, const std::pair<const char*, F64>& b)
+{
+	return a.second > b.second;
+}
+
+void LLMessageReplay::dumpStats(std::ostream& str) const
+{
+	std::vector<std::pair<const char*, F64> > order;
+	for (stat_map_t::const_iterator it = mStats.begin(); it != mStats.end(); ++it)
+	{
+		order.push_back(std::make_pair(it->first, it->second.mTotal));
+	}
+	std::sort(order.begin(), order.end(), stat_total_greater);
+
+	str << "Replayed " << mNext << " of " << mRecords.size() << " packets" << std::endl;
+	str << std::setw(32) << std::left << "Message"
+		<< std::setw(10) << std::right << "Count"
+		<< std::setw(12) << "Total ms"
+		<< std::setw(10) << "Avg us"
+		<< std::setw(10) << "Max us" << std::endl;
+	for (size_t i = 0; i < order.size(); ++i)
+	{
+		const HandlerStat& stat = mStats.find(order[i].first)->second;
+		str << std::setw(32) << std::left << order[i].first
+			<< std::setw(10) << std::right << stat.mCount
+			<< std::setw(12) << std::fixed << std::setprecision(2) << stat.mTotal * 1000.0
+			<< std::setw(10) << std::setprecision(1) << stat.mTotal * 1000000.0 / stat.mCount
+			<< std::setw(10) << stat.mMax * 1000000.f << std::endl;
+	}
+}
@@ -0,0 +1,102 @@
+/** 
+ * @file llmessagereplay.h
+ * @brief Replays a binary message capture through LLMessageSystem
+ *
+ * $LicenseInfo:firstyear=2026&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2026, Linden Research, Inc.
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ * 
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLMESSAGEREPLAY_H
+#define LL_LLMESSAGEREPLAY_H
+
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "llhost.h"
+#include "llmessagelog.h"
+#include "lltimer.h"
+
+// Feeds the incoming packets of an LLMessageLog capture back through
+// gMessageSystem, so they reach the registered handlers exactly as live
+// traffic would, and records how long each message's handler took.
+//
+// Packets are injected ahead of the network by update(), which the owner
+// calls once per frame before pumping checkMessages().  Reliable, resent
+// and appended-ack bits are stripped so the replay never acks, or is acked
+// against, the live circuit.
+class LLMessageReplay
+{
+public:
+	LLMessageReplay();
+	~LLMessageReplay();
+
+	bool load(const std::string& filename);
+
+	// Deliver every packet as if it came from host rather than the recorded
+	// sender.  The handlers usually need a circuit and region for the
+	// sender, which only the live session has.
+	void setRemapHost(const LLHost& host)	{ mRemapHost = host; }
+	// Ignore recorded timestamps and inject as fast as the frame allows.
+	void setMaxSpeed(bool max_speed)		{ mMaxSpeed = max_speed; }
+
+	void start();
+	void stop();
+	void update();
+	bool isRunning() const					{ return mRunning; }
+	// All packets injected and consumed by checkMessages().
+	bool isDone() const;
+
+	S32 getPacketCount() const				{ return (S32)mRecords.size(); }
+	S32 getPacketsInjected() const			{ return (S32)mNext; }
+
+	// Per-message handler latency, slowest total first.
+	void dumpStats(std::ostream& str) const;
+
+private:
+	static void timingCallback(const char* name, F32 time, void* data);
+	void inject(const LLMessageCaptureRecord& record);
+
+	struct HandlerStat
+	{
+		HandlerStat() : mCount(0), mTotal(0.0), mMax(0.f) {}
+		U32 mCount;
+		F64 mTotal;
+		F32 mMax;
+	};
+	// Keyed by prehashed message name.
+	typedef std::map<const char*, HandlerStat> stat_map_t;
+	stat_map_t mStats;
+
+	std::vector<LLMessageCaptureRecord> mRecords;
+	size_t mNext;
+	LLHost mRemapHost;
+	bool mMaxSpeed;
+	bool mRunning;
+	LLTimer mTimer;
+
+	// The timing callback this replay displaced, restored by stop().
+	void (*mPrevCallback)(const char*, F32, void*);
+	void* mPrevCallbackData;
+};
+
+#endif // LL_LLMESSAGEREPLAY_H
@@ -74,3 +74,10 @@ void LLPacketBuffer::init (S32 hSocket)
 	mReceivingIF = ::get_receiving_interface();
 }
 
+void LLPacketBuffer::setContents(S32 size, const LLHost &host, const LLHost &receiving_if)
+{
+	mSize = size;
+	mHost = host;
+	mReceivingIF = receiving_if;
+}
+
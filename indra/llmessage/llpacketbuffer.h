@@ -44,6 +44,10 @@ public:
 	LLHost		getReceivingInterface() const	{ return mReceivingIF; }
 	void init(S32 hSocket);
 
+	// Direct access for batched I/O into preallocated buffers.
+	char		*getWritableData()				{ return mData; }
+	void		setContents(S32 size, const LLHost &host, const LLHost &receiving_if = LLHost());
+
 protected:
 	char	mData[NET_BUFFER_SIZE];        // packet data		/* Flawfinder : ignore */
 	S32		mSize;          // size of buffer in bytes
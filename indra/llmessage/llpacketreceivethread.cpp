@@ -0,0 +1,134 @@
+/** 
+ * @file llpacketreceivethread.cpp
+ * @brief Thread that drains the UDP socket independently of the main loop
+ *
+ * $LicenseInfo:firstyear=2026&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2026, Linden Research, Inc.
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ * 
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "llpacketreceivethread.h"
+
+#include "llpacketbuffer.h"
+#include "lltimer.h"
+#include "net.h"
+
+// How long run() blocks on an idle socket before checking for shutdown.
+static const U32 RECEIVE_WAIT_MS = 50;
+// How long run() sleeps when the ring is full before looking again.
+static const U32 QUEUE_FULL_WAIT_MS = 1;
+
+LLPacketReceiveThread::LLPacketReceiveThread(S32 socket)
+:	LLThread("packetreceive"),
+	mSocket(socket),
+	mHead(0),
+	mTail(0)
+{
+	for (S32 i = 0; i < QUEUE_SIZE; ++i)
+	{
+		mSlots[i] = new LLPacketBuffer(LLHost(), NULL, 0);
+		mTimestamps[i] = 0;
+	}
+	start();
+}
+
+LLPacketReceiveThread::~LLPacketReceiveThread()
+{
+	shutdown();
+	for (S32 i = 0; i < QUEUE_SIZE; ++i)
+	{
+		delete mSlots[i];
+	}
+}
+
+void LLPacketReceiveThread::shutdown()
+{
+	setQuitting();
+	while (!isStopped())
+	{
+		ms_sleep(1);
+	}
+}
+
+// virtual
+void LLPacketReceiveThread::run()
+{
+	LLNetDatagram datagrams[QUEUE_SIZE];
+
+	while (!isQuitting())
+	{
+		U32 head = mHead;
+		U32 free_slots = QUEUE_SIZE - (head - (U32)mTail);
+		if (!free_slots)
+		{
+			// The main thread is far behind.  Leave what arrives queued in
+			// the kernel until popPacket() frees a slot, rather than
+			// throwing it away here.
+			ms_sleep(QUEUE_FULL_WAIT_MS);
+			continue;
+		}
+
+		if (!wait_for_packet(mSocket, RECEIVE_WAIT_MS))
+		{
+			continue;
+		}
+
+		// Fill as many free slots as one batched receive allows, without
+		// wrapping inside a single call.
+		U32 first = head & (QUEUE_SIZE - 1);
+		S32 count = (S32)llmin(free_slots, (U32)QUEUE_SIZE - first);
+		for (S32 i = 0; i < count; ++i)
+		{
+			datagrams[i].mData = mSlots[first + i]->getWritableData();
+		}
+		S32 received = receive_packets(mSocket, datagrams, count);
+		U64 now = totalTime();
+		for (S32 i = 0; i < received; ++i)
+		{
+			mSlots[first + i]->setContents(datagrams[i].mSize,
+										   LLHost(datagrams[i].mIP, datagrams[i].mPort),
+										   LLHost(datagrams[i].mReceivingIF, INVALID_PORT));
+			mTimestamps[first + i] = now;
+		}
+		// Publish only after the slots are written.
+		mHead = head + received;
+	}
+}
+
+S32 LLPacketReceiveThread::popPacket(char* datap, LLHost& sender, LLHost& receiving_if, U64& received_usec)
+{
+	U32 tail = mTail;
+	if (tail == (U32)mHead)
+	{
+		return 0;
+	}
+	U32 index = tail & (QUEUE_SIZE - 1);
+	LLPacketBuffer* packetp = mSlots[index];
+	S32 size = packetp->getSize();
+	memcpy(datap, packetp->getData(), size);
+	sender = packetp->getHost();
+	receiving_if = packetp->getReceivingInterface();
+	received_usec = mTimestamps[index];
+	// Hand the slot back only after it has been copied out.
+	mTail = tail + 1;
+	return size;
+}
@@ -0,0 +1,71 @@
+/** 
+ * @file llpacketreceivethread.h
+ * @brief Thread that drains the UDP socket independently of the main loop
+ *
+ * $LicenseInfo:firstyear=2026&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2026, Linden Research, Inc.
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ * 
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLPACKETRECEIVETHREAD_H
+#define LL_LLPACKETRECEIVETHREAD_H
+
+#include "llatomic.h"
+#include "llhost.h"
+#include "llthread.h"
+
+class LLPacketBuffer;
+
+// Keeps the socket drained while the main thread is busy with a long frame,
+// so the kernel buffer does not overflow into packet loss and resends.
+//
+// Datagrams are timestamped and handed to the main thread through a
+// single-producer/single-consumer ring: this thread only advances mHead,
+// popPacket() only advances mTail.  While the ring is full the thread stops
+// reading, so further datagrams wait in the kernel buffer as they did
+// before there was a receive thread.  Everything past the socket (acks,
+// circuits, decoding, handlers) stays on the main thread, since none of
+// the message system is thread-safe.
+class LLPacketReceiveThread : public LLThread
+{
+public:
+	LLPacketReceiveThread(S32 socket);
+	~LLPacketReceiveThread();
+
+	// Main thread only.  Copies the oldest queued datagram into datap and
+	// returns its size, or 0 if the queue is empty.
+	S32 popPacket(char* datap, LLHost& sender, LLHost& receiving_if, U64& received_usec);
+
+	void shutdown();
+
+protected:
+	/*virtual*/ void run();
+
+private:
+	enum { QUEUE_SIZE = 512 };	// power of two
+
+	S32 mSocket;
+	LLPacketBuffer* mSlots[QUEUE_SIZE];
+	U64 mTimestamps[QUEUE_SIZE];
+	LLAtomicU32 mHead;		// next slot the receive thread fills
+	LLAtomicU32 mTail;		// next slot popPacket() reads
+};
+
+#endif // LL_LLPACKETRECEIVETHREAD_H
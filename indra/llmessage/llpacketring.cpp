@@ -41,6 +41,7 @@
 #include "llproxy.h"
 #include "llrand.h"
 #include "message.h"
+#include "llpacketreceivethread.h"
 #include "u64.h"
 
 //<edit>
@@ -59,14 +60,34 @@ LLPacketRing::LLPacketRing () :
 	mInBufferLength(0),
 	mOutBufferLength(0),
 	mDropPercentage(0.0f),
-	mPacketsToDrop(0x0)
+	mPacketsToDrop(0x0),
+	mLastPacketInjected(FALSE),
+	mUseBatchedIO(FALSE),
+	mReceiveBatchCount(0),
+	mReceiveBatchNext(0),
+	mSendBatchCount(0),
+	mSendBatchDepth(0),
+	mSendBatchSocket(-1),
+	mSendBatchFailures(0),
+	mReceiveThread(NULL),
+	mMaxQueueDelay(0)
 {
 }
 
 ///////////////////////////////////////////////////////////
 LLPacketRing::~LLPacketRing ()
 {
+	stopReceiveThread();
 	cleanup();
+
+	for (size_t i = 0; i < mReceiveBatch.size(); ++i)
+	{
+		delete mReceiveBatch[i];
+	}
+	for (size_t i = 0; i < mSendBatch.size(); ++i)
+	{
+		delete mSendBatch[i];
+	}
 }
 	
 ///////////////////////////////////////////////////////////
@@ -87,6 +108,137 @@ void LLPacketRing::cleanup ()
 		delete packetp;
 		mSendQueue.pop();
 	}
+
+	while (!mInjectQueue.empty())
+	{
+		packetp = mInjectQueue.front();
+		delete packetp;
+		mInjectQueue.pop();
+	}
+
+	mReceiveBatchCount = 0;
+	mReceiveBatchNext = 0;
+	mSendBatchCount = 0;
+}
+
+///////////////////////////////////////////////////////////
+void LLPacketRing::setUseBatchedIO(const BOOL use_batched)
+{
+	mUseBatchedIO = use_batched && batched_net_io_supported();
+	if (mUseBatchedIO && mReceiveBatch.empty())
+	{
+		for (S32 i = 0; i < PACKET_BATCH_SIZE; ++i)
+		{
+			mReceiveBatch.push_back(new LLPacketBuffer(LLHost(), NULL, 0));
+			mSendBatch.push_back(new LLPacketBuffer(LLHost(), NULL, 0));
+		}
+	}
+	LL_INFOS() << "Batched UDP I/O " << (mUseBatchedIO ? "enabled" : "disabled") << LL_ENDL;
+}
+
+void LLPacketRing::beginSendBatch()
+{
+	mSendBatchDepth++;
+}
+
+S32 LLPacketRing::flushSendBatch()
+{
+	if (mSendBatchDepth > 0 && --mSendBatchDepth > 0)
+	{
+		return 0;
+	}
+	sendBatch();
+	S32 failures = mSendBatchFailures;
+	mSendBatchFailures = 0;
+	return failures;
+}
+
+void LLPacketRing::sendBatch()
+{
+	if (!mSendBatchCount)
+	{
+		return;
+	}
+
+	LLNetDatagram datagrams[PACKET_BATCH_SIZE];
+	for (S32 i = 0; i < mSendBatchCount; ++i)
+	{
+		LLPacketBuffer* packetp = mSendBatch[i];
+		datagrams[i].mData = packetp->getWritableData();
+		datagrams[i].mSize = packetp->getSize();
+		datagrams[i].mIP = packetp->getHost().getAddress();
+		datagrams[i].mPort = packetp->getHost().getPort();
+		datagrams[i].mReceivingIF = INVALID_HOST_IP_ADDRESS;
+	}
+	S32 sent = send_packets(mSendBatchSocket, datagrams, mSendBatchCount);
+	if (sent < mSendBatchCount)
+	{
+		LL_WARNS() << "Batched send dropped " << (mSendBatchCount - sent) << " of "
+				   << mSendBatchCount << " packets" << LL_ENDL;
+		mSendBatchFailures += mSendBatchCount - sent;
+	}
+	mSendBatchCount = 0;
+}
+
+///////////////////////////////////////////////////////////
+void LLPacketRing::startReceiveThread(S32 socket)
+{
+	if (mReceiveThread)
+	{
+		return;
+	}
+	if (mUseInThrottle || LLProxy::isSOCKSProxyEnabled())
+	{
+		LL_INFOS() << "Not starting packet receive thread with throttle or proxy enabled" << LL_ENDL;
+		return;
+	}
+	mReceiveThread = new LLPacketReceiveThread(socket);
+	LL_INFOS() << "Packet receive thread started" << LL_ENDL;
+}
+
+void LLPacketRing::stopReceiveThread()
+{
+	delete mReceiveThread;
+	mReceiveThread = NULL;
+}
+
+F32 LLPacketRing::getAndResetMaxQueueDelay()
+{
+	F32 delay = (F32)mMaxQueueDelay / 1000000.f;
+	mMaxQueueDelay = 0;
+	return delay;
+}
+
+
+///////////////////////////////////////////////////////////
+S32 LLPacketRing::receiveFromBatch(S32 socket, char *datap)
+{
+	if (mReceiveBatchNext >= mReceiveBatchCount)
+	{
+		LLNetDatagram datagrams[PACKET_BATCH_SIZE];
+		for (S32 i = 0; i < PACKET_BATCH_SIZE; ++i)
+		{
+			datagrams[i].mData = mReceiveBatch[i]->getWritableData();
+		}
+		mReceiveBatchCount = receive_packets(socket, datagrams, PACKET_BATCH_SIZE);
+		mReceiveBatchNext = 0;
+		for (S32 i = 0; i < mReceiveBatchCount; ++i)
+		{
+			mReceiveBatch[i]->setContents(datagrams[i].mSize,
+										  LLHost(datagrams[i].mIP, datagrams[i].mPort),
+										  LLHost(datagrams[i].mReceivingIF, INVALID_PORT));
+		}
+		if (!mReceiveBatchCount)
+		{
+			return 0;
+		}
+	}
+
+	LLPacketBuffer* packetp = mReceiveBatch[mReceiveBatchNext++];
+	memcpy(datap, packetp->getData(), packetp->getSize());
+	mLastSender = packetp->getHost();
+	mLastReceivingIF = packetp->getReceivingInterface();
+	return packetp->getSize();
 }
 
 ///////////////////////////////////////////////////////////
@@ -158,10 +310,65 @@ S32 LLPacketRing::receiveFromRing (S32 socket, char *datap)
 }
 
 ///////////////////////////////////////////////////////////
+void LLPacketRing::injectPacket(const LLHost& host, const char* datap, S32 size)
+{
+	if (size <= 0 || size > NET_BUFFER_SIZE)
+	{
+		LL_WARNS() << "Not injecting packet of invalid size " << size << LL_ENDL;
+		return;
+	}
+	mInjectQueue.push(new LLPacketBuffer(host, datap, size));
+}
+
 S32 LLPacketRing::receivePacket (S32 socket, char *datap)
 {
 	S32 packet_size = 0;
 
+	// Injected packets bypass the throttle and fake packet loss.
+	mLastPacketInjected = FALSE;
+	if (!mInjectQueue.empty())
+	{
+		LLPacketBuffer *packetp = mInjectQueue.front();
+		mInjectQueue.pop();
+		packet_size = packetp->getSize();
+		memcpy(datap, packetp->getData(), packet_size);
+		mLastSender = packetp->getHost();
+		mLastReceivingIF = packetp->getReceivingInterface();
+		delete packetp;
+		mLastPacketInjected = TRUE;
+		return packet_size;
+	}
+
+	if (mReceiveThread)
+	{
+		if (mUseInThrottle || LLProxy::isSOCKSProxyEnabled())
+		{
+			// Turned on after the thread started; go back to reading the
+			// socket here.
+			stopReceiveThread();
+		}
+		else
+		{
+			U64 received_usec = 0;
+			packet_size = mReceiveThread->popPacket(datap, mLastSender, mLastReceivingIF, received_usec);
+			if (packet_size)
+			{
+				U64 now = totalTime();
+				mMaxQueueDelay = llmax(mMaxQueueDelay, now - received_usec);
+				if (mDropPercentage && (ll_frand(100.f) < mDropPercentage))
+				{
+					mPacketsToDrop++;
+				}
+				if (mPacketsToDrop)
+				{
+					packet_size = 0;
+					mPacketsToDrop--;
+				}
+			}
+			return packet_size;
+		}
+	}
+
 	// If using the throttle, simulate a limited size input buffer.
 	if (mUseInThrottle)
 	{
@@ -247,15 +454,19 @@ S32 LLPacketRing::receivePacket (S32 socket, char *datap)
 			{
 				packet_size = 0;
 			}
+			mLastReceivingIF = ::get_receiving_interface();
+		}
+		else if (mUseBatchedIO)
+		{
+			packet_size = receiveFromBatch(socket, datap);
 		}
 		else
 		{
 			packet_size = receive_packet(socket, datap);
 			mLastSender = ::get_sender();
+			mLastReceivingIF = ::get_receiving_interface();
 		}
 
-		mLastReceivingIF = ::get_receiving_interface();
-
 		if (packet_size)  // did we actually get a packet?
 		{
 			if (mDropPercentage && (ll_frand(100.f) < mDropPercentage))
@@ -357,6 +568,24 @@ BOOL LLPacketRing::sendPacketImpl(int h_socket, const char * send_buffer, S32 bu
 	
 	if (!LLProxy::isSOCKSProxyEnabled())
 	{
+		if (mSendBatchDepth > 0 && mUseBatchedIO)
+		{
+			if (mSendBatchSocket != h_socket)
+			{
+				// Batches go out on a single socket.
+				sendBatch();
+			}
+			LLPacketBuffer* packetp = mSendBatch[mSendBatchCount++];
+			memcpy(packetp->getWritableData(), send_buffer, buf_size);
+			packetp->setContents(buf_size, host);
+			mSendBatchSocket = h_socket;
+			if (mSendBatchCount == PACKET_BATCH_SIZE)
+			{
+				sendBatch();
+			}
+			// Queued; failures are counted when the batch goes out.
+			return TRUE;
+		}
 		return send_packet(h_socket, send_buffer, buf_size, host.getAddress(), host.getPort());
 	}
 
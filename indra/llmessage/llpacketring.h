@@ -29,6 +29,7 @@
 #define LL_LLPACKETRING_H
 
 #include <queue>
+#include <vector>
 
 #include "llhost.h"
 #include "llpacketbuffer.h"
@@ -36,6 +37,8 @@
 #include "llthrottle.h"
 #include "net.h"
 
+class LLPacketReceiveThread;
+
 class LLPacketRing
 {
 public:
@@ -55,6 +58,33 @@ public:
 
 	BOOL sendPacket(int h_socket, char * send_buffer, S32 buf_size, LLHost host);
 
+	// Queue a packet to be handed out by receivePacket() ahead of the
+	// network, as if it had arrived from host.  Used by message replay.
+	void injectPacket(const LLHost& host, const char* datap, S32 size);
+
+	// Drain the socket with one recvmmsg() per PACKET_BATCH_SIZE datagrams
+	// instead of one recvfrom() each.  Only takes effect where the platform
+	// supports batched I/O, and not through a SOCKS proxy.
+	void setUseBatchedIO(const BOOL use_batched);
+	BOOL getUseBatchedIO() const				{ return mUseBatchedIO; }
+	// Sends between begin and flush are queued and go out together.
+	// sendPacket() returns TRUE for a queued packet, so the outermost
+	// flushSendBatch() returns how many of the batched packets failed to send.
+	void beginSendBatch();
+	S32  flushSendBatch();
+
+	// Read the socket on a dedicated thread, see LLPacketReceiveThread.
+	// Not used with the incoming throttle or a SOCKS proxy, which need the
+	// packets off the socket themselves.
+	void startReceiveThread(S32 socket);
+	void stopReceiveThread();
+	BOOL hasReceiveThread() const				{ return mReceiveThread != NULL; }
+	// Longest a packet sat in the receive thread's queue, in seconds, since
+	// the last call.
+	F32  getAndResetMaxQueueDelay();
+	BOOL getLastPacketInjected() const			{ return mLastPacketInjected; }
+	S32  getPendingInjectedCount() const		{ return (S32)mInjectQueue.size(); }
+
 	inline LLHost getLastSender();
 	inline LLHost getLastReceivingInterface();
 
@@ -79,12 +109,30 @@ protected:
 
 	std::queue<LLPacketBuffer *> mReceiveQueue;
 	std::queue<LLPacketBuffer *> mSendQueue;
+	std::queue<LLPacketBuffer *> mInjectQueue;
+	BOOL mLastPacketInjected;
+
+	enum { PACKET_BATCH_SIZE = 64 };
+	BOOL mUseBatchedIO;
+	std::vector<LLPacketBuffer *> mReceiveBatch;	// preallocated slots
+	S32 mReceiveBatchCount;
+	S32 mReceiveBatchNext;
+	std::vector<LLPacketBuffer *> mSendBatch;		// preallocated slots
+	S32 mSendBatchCount;
+	S32 mSendBatchDepth;
+	int mSendBatchSocket;
+	S32 mSendBatchFailures;	// since the outermost beginSendBatch()
+
+	LLPacketReceiveThread* mReceiveThread;
+	U64 mMaxQueueDelay;	// usec
 
 	LLHost mLastSender;
 	LLHost mLastReceivingIF;
 
 private:
 	BOOL sendPacketImpl(int h_socket, const char * send_buffer, S32 buf_size, LLHost host);
+	S32  receiveFromBatch(S32 socket, char *datap);
+	void sendBatch();
 };
 
 
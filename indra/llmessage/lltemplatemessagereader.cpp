@@ -38,12 +38,15 @@
 #include "v3math.h"
 #include "v4math.h"
 
+bool LLTemplateMessageReader::sZeroCopyDecode = true;
+
 LLTemplateMessageReader::LLTemplateMessageReader(message_template_number_map_t&
 												 number_template_map) :
 	mReceiveSize(0),
 	mCurrentRMessageTemplate(NULL),
 	mCurrentRMessageData(NULL),
-	mMessageNumbers(number_template_map)
+	mMessageNumbers(number_template_map),
+	mDecodeBuffer(NULL)
 {
 }
 
@@ -61,6 +64,36 @@ void LLTemplateMessageReader::clearMessage()
 	mCurrentRMessageTemplate = NULL;
 	delete mCurrentRMessageData;
 	mCurrentRMessageData = NULL;
+	mDecodeBuffer = NULL;
+	mBlockIndex.clear();
+	mVarIndex.clear();
+}
+
+S32 LLTemplateMessageReader::findBlock(const char* blockname) const
+{
+	for (S32 i = 0; i < (S32)mBlockIndex.size(); ++i)
+	{
+		if (mBlockIndex[i].mBlock->mName == blockname)
+		{
+			return i;
+		}
+	}
+	return -1;
+}
+
+//static
+S32 LLTemplateMessageReader::findVariable(const LLMessageBlock* block, const char* varname)
+{
+	S32 i = 0;
+	for (LLMessageBlock::message_variable_map_t::const_iterator iter = block->mMemberVariables.begin();
+		 iter != block->mMemberVariables.end(); ++iter, ++i)
+	{
+		if (block->mMemberVariables.toValue(iter)->getName() == varname)
+		{
+			return i;
+		}
+	}
+	return -1;
 }
 
 void LLTemplateMessageReader::getData(const char *blockname, const char *varname, void *datap, S32 size, S32 blocknum, S32 max_size)
@@ -74,7 +107,71 @@ void LLTemplateMessageReader::getData(const char *blockname, const char *varname
 
 	if (!mCurrentRMessageData)
 	{
-		LL_ERRS() << "Invalid mCurrentMessageData in getData!" << LL_ENDL;
+		if (!mDecodeBuffer)
+		{
+			LL_ERRS() << "Invalid mCurrentMessageData in getData!" << LL_ENDL;
+			return;
+		}
+
+		S32 block_index = findBlock(blockname);
+		if (block_index < 0 || blocknum >= mBlockIndex[block_index].mCount)
+		{
+			LL_ERRS() << "Block " << blockname << " #" << blocknum
+				<< " not in message " << mCurrentRMessageTemplate->mName << LL_ENDL;
+			return;
+		}
+
+		const BlockIndex& block = mBlockIndex[block_index];
+		S32 var_num = findVariable(block.mBlock, varname);
+		if (var_num < 0)
+		{
+			LL_ERRS() << "Variable "<< varname << " not in message "
+				<< mCurrentRMessageTemplate->mName << " block " << blockname << LL_ENDL;
+			return;
+		}
+
+		LLMessageBlock::message_variable_map_t::const_iterator var_iter = block.mBlock->mMemberVariables.begin() + var_num;
+		const LLMessageVariable* var = block.mBlock->mMemberVariables.toValue(var_iter);
+		const VarIndex& vardata = mVarIndex[block.mFirstVar + blocknum * block.mBlock->mMemberVariables.size() + var_num];
+
+		if (size && size != vardata.mSize)
+		{
+			LL_ERRS() << "Msg " << mCurrentRMessageTemplate->mName 
+				<< " variable " << varname
+				<< " is size " << vardata.mSize
+				<< " but copying into buffer of size " << size
+				<< LL_ENDL;
+			return;
+		}
+
+		if (max_size >= vardata.mSize)
+		{
+			if (vardata.mOffset < 0)
+			{
+				memset(datap, 0, vardata.mSize);
+			}
+			else
+			{
+				htonmemcpy(datap, mDecodeBuffer + vardata.mOffset, var->getType(), vardata.mSize);
+			}
+		}
+		else
+		{
+			LL_WARNS() << "Msg " << mCurrentRMessageTemplate->mName 
+				<< " variable " << varname
+				<< " is size " << vardata.mSize
+				<< " but truncated to max size of " << max_size
+				<< LL_ENDL;
+
+			if (vardata.mOffset < 0)
+			{
+				memset(datap, 0, max_size);
+			}
+			else
+			{
+				memcpy(datap, mDecodeBuffer + vardata.mOffset, max_size);
+			}
+		}
 		return;
 	}
 
@@ -159,8 +256,14 @@ S32 LLTemplateMessageReader::getNumberOfBlocks(const char *blockname)
 
 	if (!mCurrentRMessageData)
 	{
-		LL_ERRS() << "Invalid mCurrentRMessageData in getData!" << LL_ENDL;
-		return -1;
+		if (!mDecodeBuffer)
+		{
+			LL_ERRS() << "Invalid mCurrentRMessageData in getData!" << LL_ENDL;
+			return -1;
+		}
+
+		S32 block_index = findBlock(blockname);
+		return block_index < 0 ? 0 : mBlockIndex[block_index].mCount;
 	}
 
 	char *bnamep = (char *)blockname; 
@@ -184,6 +287,35 @@ S32 LLTemplateMessageReader::getSize(const char *blockname, const char *varname)
 		return LL_MESSAGE_ERROR;
 	}
 
+	if (!mCurrentRMessageData && mDecodeBuffer)
+	{
+		S32 block_index = findBlock(blockname);
+		if (block_index < 0 || !mBlockIndex[block_index].mCount)
+		{	// don't crash
+			LL_INFOS() << "Block " << blockname << " not in message "
+				<< mCurrentRMessageTemplate->mName << LL_ENDL;
+			return LL_BLOCK_NOT_IN_MESSAGE;
+		}
+
+		const BlockIndex& block = mBlockIndex[block_index];
+		S32 var_num = findVariable(block.mBlock, varname);
+		if (var_num < 0)
+		{	// don't crash
+			LL_INFOS() << "Variable " << varname << " not in message "
+				<< mCurrentRMessageTemplate->mName << " block " << blockname << LL_ENDL;
+			return LL_VARIABLE_NOT_IN_BLOCK;
+		}
+
+		if (block.mBlock->mType != MBT_SINGLE)
+		{	// This is a serious error - crash
+			LL_ERRS() << "Block " << blockname << " isn't type MBT_SINGLE,"
+				" use getSize with blocknum argument!" << LL_ENDL;
+			return LL_MESSAGE_ERROR;
+		}
+
+		return mVarIndex[block.mFirstVar + var_num].mSize;
+	}
+
 	if (!mCurrentRMessageData)
 	{	// This is a serious error - crash
 		LL_ERRS() << "Invalid mCurrentRMessageData in getData!" << LL_ENDL;
@@ -232,6 +364,28 @@ S32 LLTemplateMessageReader::getSize(const char *blockname, S32 blocknum, const
 		return LL_MESSAGE_ERROR;
 	}
 
+	if (!mCurrentRMessageData && mDecodeBuffer)
+	{
+		S32 block_index = findBlock(blockname);
+		if (block_index < 0 || blocknum >= mBlockIndex[block_index].mCount)
+		{	// don't crash
+			LL_INFOS() << "Block " << blockname << " not in message " 
+				<< mCurrentRMessageTemplate->mName << LL_ENDL;
+			return LL_BLOCK_NOT_IN_MESSAGE;
+		}
+
+		const BlockIndex& block = mBlockIndex[block_index];
+		S32 var_num = findVariable(block.mBlock, varname);
+		if (var_num < 0)
+		{	// don't crash
+			LL_INFOS() << "Variable " << varname << " not in message "
+				<< mCurrentRMessageTemplate->mName << " block " << blockname << LL_ENDL;
+			return LL_VARIABLE_NOT_IN_BLOCK;
+		}
+
+		return mVarIndex[block.mFirstVar + blocknum * block.mBlock->mMemberVariables.size() + var_num].mSize;
+	}
+
 	if (!mCurrentRMessageData)
 	{	// This is a serious error - crash
 		LL_ERRS() << "Invalid mCurrentRMessageData in getData!" << LL_ENDL;
@@ -546,10 +700,17 @@ BOOL LLTemplateMessageReader::decodeData(const U8* buffer, const LLHost& sender,
 	U8 offset = buffer[PHL_OFFSET];
 	S32 decode_pos = LL_PACKET_ID_SIZE + (S32)(mCurrentRMessageTemplate->mFrequency) + offset;
 
-	// create base working data set
-	mCurrentRMessageData = new LLMsgData(mCurrentRMessageTemplate->mName);
-	
-	// loop through the template building the data structure as we go
+	// keep our own copy of the packet, callers are free to reuse their buffer
+	// while the message is being read.  The copy keeps its capacity.
+	mPacketData.assign(buffer, buffer + mReceiveSize);
+	mDecodeBuffer = &mPacketData[0];
+
+	// index the variables of the message as we go, they are read from the copy later
+	mBlockIndex.clear();
+	mVarIndex.clear();
+	S32 num_blocks = 0;
+
+	// loop through the template building the index as we go
 	LLMessageTemplate::message_block_map_t::const_iterator iter;
 	for(iter = mCurrentRMessageTemplate->mMemberBlocks.begin();
 		iter != mCurrentRMessageTemplate->mMemberBlocks.end();
@@ -597,36 +758,20 @@ BOOL LLTemplateMessageReader::decodeData(const U8* buffer, const LLHost& sender,
 			return FALSE;
 		}
 
-		LLMsgBlkData* cur_data_block = NULL;
+		BlockIndex block_index = { mbci, repeat_number, (S32)mVarIndex.size() };
+		mBlockIndex.push_back(block_index);
+		num_blocks += repeat_number;
 
 		// now loop through the block
 		for (i = 0; i < repeat_number; i++)
 		{
-			if (i)
-			{
-				// build new name to prevent collisions
-				// TODO: This should really change to a vector
-				cur_data_block = new LLMsgBlkData(mbci->mName, repeat_number);
-				cur_data_block->mName = mbci->mName + i;
-			}
-			else
-			{
-				cur_data_block = new LLMsgBlkData(mbci->mName, repeat_number);
-			}
-
-			// add the block to the message
-			mCurrentRMessageData->addBlock(cur_data_block);
-
 			// now read the variables
 			for (LLMessageBlock::message_variable_map_t::const_iterator iter = 
 					 mbci->mMemberVariables.begin();
 				 iter != mbci->mMemberVariables.end(); iter++)
 			{
 				const LLMessageVariable* mvci = mbci->mMemberVariables.toValue(iter);
-
-				// ok, build out the variables
-				// add variable block
-				cur_data_block->addVariable(mvci->getName(), mvci->getType());
+				VarIndex var_index;
 
 				// what type of variable?
 				if (mvci->getType() == MVT_VARIABLE)
@@ -667,44 +812,47 @@ BOOL LLTemplateMessageReader::decodeData(const U8* buffer, const LLHost& sender,
 					}
 					decode_pos += data_size;
 
-					cur_data_block->addData(mvci->getName(), &buffer[decode_pos], tsize, mvci->getType());
+					var_index.mOffset = decode_pos;
+					var_index.mSize = tsize;
 					decode_pos += tsize;
 				}
 				else
 				{
 					// fixed!
-					// so, copy data pointer and set data size to fixed size
+					// so, point at the data and set data size to fixed size
 					if ((decode_pos + mvci->getSize()) > mReceiveSize)
 					{
 						if(!custom)
 							logRanOffEndOfPacket(sender, decode_pos, mvci->getSize());
 
 						// default to 0s.
-						U32 size = mvci->getSize();
-						std::vector<U8> data(size, 0);
-						cur_data_block->addData(mvci->getName(), &(data[0]),
-												size, mvci->getType());
+						var_index.mOffset = -1;
 					}
 					else
 					{
-						cur_data_block->addData(mvci->getName(),
-												&buffer[decode_pos], 
-												mvci->getSize(),
-												mvci->getType());
+						var_index.mOffset = decode_pos;
 					}
+					var_index.mSize = mvci->getSize();
 					decode_pos += mvci->getSize();
 				}
+				mVarIndex.push_back(var_index);
 			}
 		}
 	}
 
-	if (mCurrentRMessageData->mMemberBlocks.empty()
-		&& !mCurrentRMessageTemplate->mMemberBlocks.empty())
+	if (!num_blocks && !mCurrentRMessageTemplate->mMemberBlocks.empty())
 	{
 		LL_DEBUGS() << "Empty message '" << mCurrentRMessageTemplate->mName << "' (no blocks)" << LL_ENDL;
 		return FALSE;
 	}
 
+	if (!sZeroCopyDecode)
+	{
+		// create base working data set
+		mCurrentRMessageData = new LLMsgData(mCurrentRMessageTemplate->mName);
+		buildMessageData(*mCurrentRMessageData);
+	}
+
 	if(!custom)
 	{
 		static LLTimer decode_timer;
@@ -834,5 +982,50 @@ void LLTemplateMessageReader::copyToBuilder(LLMessageBuilder& builder) const
     {
         return;
     }
-	builder.copyFromMessageData(*mCurrentRMessageData);
+	if (mCurrentRMessageData)
+	{
+		builder.copyFromMessageData(*mCurrentRMessageData);
+		return;
+	}
+	LLMsgData data(mCurrentRMessageTemplate->mName);
+	buildMessageData(data);
+	builder.copyFromMessageData(data);
+}
+
+void LLTemplateMessageReader::buildMessageData(LLMsgData& data) const
+{
+	for (std::vector<BlockIndex>::const_iterator block_iter = mBlockIndex.begin(); block_iter != mBlockIndex.end(); ++block_iter)
+	{
+		const LLMessageBlock* mbci = block_iter->mBlock;
+		S32 var_num = block_iter->mFirstVar;
+		for (S32 i = 0; i < block_iter->mCount; i++)
+		{
+			// build new name to prevent collisions
+			// TODO: This should really change to a vector
+			LLMsgBlkData* cur_data_block = new LLMsgBlkData(mbci->mName, block_iter->mCount);
+			cur_data_block->mName = mbci->mName + i;
+
+			// add the block to the message
+			data.addBlock(cur_data_block);
+
+			for (LLMessageBlock::message_variable_map_t::const_iterator iter = 
+					 mbci->mMemberVariables.begin();
+				 iter != mbci->mMemberVariables.end(); iter++, var_num++)
+			{
+				const LLMessageVariable* mvci = mbci->mMemberVariables.toValue(iter);
+				const VarIndex& var_index = mVarIndex[var_num];
+
+				cur_data_block->addVariable(mvci->getName(), mvci->getType());
+				if (var_index.mOffset < 0)
+				{
+					std::vector<U8> zeros(var_index.mSize, 0);
+					cur_data_block->addData(mvci->getName(), &zeros[0], var_index.mSize, mvci->getType());
+				}
+				else
+				{
+					cur_data_block->addData(mvci->getName(), mDecodeBuffer + var_index.mOffset, var_index.mSize, mvci->getType());
+				}
+			}
+		}
+	}
 }
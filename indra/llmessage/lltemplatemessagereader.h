@@ -30,7 +30,9 @@
 #include "llmessagereader.h"
 
 #include <map>
+#include <vector>
 
+class LLMessageBlock;
 class LLMessageTemplate;
 class LLMsgData;
 
@@ -105,6 +107,12 @@ public:
 	bool isTrusted() const;
 	bool isBanned(bool trusted_source) const;
 	bool isUdpBanned() const;
+
+	// When on (the default), the get* methods read straight out of a copy of
+	// the packet passed to readMessage(), kept until the next message.
+	// When off, every variable is copied into an LLMsgData first, like it used to.
+	static void setZeroCopyDecode(bool zero_copy) { sZeroCopyDecode = zero_copy; }
+	static bool getZeroCopyDecode() { return sZeroCopyDecode; }
 	
 private:
 
@@ -119,10 +127,38 @@ private:
 
 	BOOL decodeData(const U8* buffer, const LLHost& sender, bool custom);
 
+	// Fills data with copies of all variables of the current message
+	void buildMessageData(LLMsgData& data) const;
+
+	// Index of the block named blockname in mBlockIndex, -1 if the template has none
+	S32 findBlock(const char* blockname) const;
+	// Index of the variable named varname in block, -1 if it has none
+	static S32 findVariable(const LLMessageBlock* block, const char* varname);
+
 	S32	mReceiveSize;
 	LLMessageTemplate* mCurrentRMessageTemplate;
-	LLMsgData* mCurrentRMessageData;
+	LLMsgData* mCurrentRMessageData;	// only when not decoding zero copy
 	message_template_number_map_t& mMessageNumbers;
+
+	// Where the variables of the current message are in the packet buffer.
+	// The vectors keep their capacity, so decoding a message allocates nothing.
+	struct BlockIndex
+	{
+		const LLMessageBlock* mBlock;
+		S32 mCount;			// number of blocks of this kind in the message
+		S32 mFirstVar;		// first variable of the first of these blocks in mVarIndex
+	};
+	struct VarIndex
+	{
+		S32 mOffset;		// in mDecodeBuffer, -1 if the packet ended before it (reads as zeros)
+		S32 mSize;
+	};
+	const U8* mDecodeBuffer;				// mPacketData while a message is decoded, else NULL
+	std::vector<U8> mPacketData;			// copy of the current packet
+	std::vector<BlockIndex> mBlockIndex;	// one per template block, in template order
+	std::vector<VarIndex> mVarIndex;		// each block's variables in template order
+
+	static bool sZeroCopyDecode;
 	friend class LLFloaterMessageLogItem;
 };
 
@@ -79,6 +79,7 @@
 #include "v4math.h"
 #include "lltransfertargetvfile.h"
 #include "llpacketring.h"
+#include "llmessagelog.h"
 
 class AIHTTPTimeoutPolicy;
 extern AIHTTPTimeoutPolicy fnPtrResponder_timeout;
@@ -365,6 +366,8 @@ LLMessageSystem::~LLMessageSystem()
 	for_each(mMessageNumbers.begin(), mMessageNumbers.end(), DeletePairedPointer());
 	mMessageNumbers.clear();
 	
+	// The receive thread reads mSocket, stop it before the socket goes.
+	mPacketRing->stopReceiveThread();
 	if (!mbError)
 	{
 		end_net(mSocket);
@@ -610,6 +613,13 @@ BOOL LLMessageSystem::checkMessages( S64 frame_count )
 			const bool resetPacketId = true;
 			cdp = findCircuit(host, resetPacketId);
 
+			if (LLMessageLog::isCapturing() && !mPacketRing->getLastPacketInjected())
+			{
+				LLMessageLog::capture(LLMessageLog::CAPTURE_IN, host, LLHost(16777343, mPort),
+									  mTrueReceiveBuffer, mTrueReceiveSize,
+									  cdp && cdp->getTrusted());
+			}
+
 			// At this point, cdp is now a pointer to the circuit that
 			// this message came in on if it's valid, and NULL if the
 			// circuit was bogus.
@@ -816,12 +826,20 @@ void LLMessageSystem::processAcks(F32 collect_time)
 		// Check the status of circuits
 		mCircuitInfo.updateWatchDogTimers(this);
 
+		// Resends and acks go out in as few system calls as the packet
+		// ring can manage.
+		mPacketRing->beginSendBatch();
+
 		//resend any necessary packets
 		mCircuitInfo.resendUnackedPackets(mUnackedListDepth, mUnackedListSize);
 
 		//cycle through ack list for each host we need to send acks to
 		mCircuitInfo.sendAcks(collect_time);
 
+		// sendMessage() counted the batched packets as sent; count the ones
+		// that did not make it now.
+		mSendPacketFailureCount += mPacketRing->flushSendBatch();
+
 		if (!mDenyTrustedCircuitSet.empty())
 		{
 			LL_INFOS("Messaging") << "Sending queued DenyTrustedCircuit messages." << LL_ENDL;
@@ -1461,8 +1479,12 @@ void LLMessageSystem::logValidMsg(LLCircuitData *cdp, const LLHost& host, BOOL r
 
 	if (cdp)
 	{
-		// update circuit packet ID tracking (missing/out of order packets)
-		cdp->checkPacketInID( mCurrentRecvPacketID, recv_resent );
+		// update circuit packet ID tracking (missing/out of order packets).
+		// Replayed packets carry IDs from another session, keep them out.
+		if (!mPacketRing->getLastPacketInjected())
+		{
+			cdp->checkPacketInID( mCurrentRecvPacketID, recv_resent );
+		}
 		cdp->addBytesIn( (S32Bytes)mTrueReceiveSize );
 	}
 
@@ -2684,6 +2706,7 @@ void LLMessageSystem::summarizeLogs(std::ostream& str)
 
 void end_messaging_system(bool print_summary)
 {
+	LLMessageLog::stopCapture();
 	gTransferManager.cleanup();
 	LLTransferTargetVFile::updateQueue(true); // shutdown LLTransferTargetVFile
 	if (gMessageSystem)
@@ -4009,6 +4032,32 @@ S32	LLMessageSystem::getSize(const char *blockname, S32 blocknum,
 					   LLMessageStringTable::getInstance()->getString(varname));
 }
 
+void LLMessageSystem::injectPacket(const LLHost& host, const U8* data, S32 size)
+{
+	mPacketRing->injectPacket(host, (const char*)data, size);
+}
+
+BOOL LLMessageSystem::isLastPacketInjected() const
+{
+	return mPacketRing->getLastPacketInjected();
+}
+
+S32 LLMessageSystem::getPendingInjectedCount() const
+{
+	return mPacketRing->getPendingInjectedCount();
+}
+
+void LLMessageSystem::setUseReceiveThread(BOOL use_thread)
+{
+	// Restart rather than keep a running thread, the proxy settings it was
+	// started under may have changed.
+	mPacketRing->stopReceiveThread();
+	if (use_thread && !mbError)
+	{
+		mPacketRing->startReceiveThread(mSocket);
+	}
+}
+
 S32 LLMessageSystem::getReceiveSize() const
 {
 	return mMessageReader->getMessageSize();
@@ -678,6 +678,15 @@ public:
 
 	S32		getUnackedListSize() const			{ return mUnackedListSize; }
 
+	// Feed a raw packet through the receive path as if it arrived from host.
+	// Injected packets skip circuit sequence tracking; see LLMessageReplay.
+	void	injectPacket(const LLHost& host, const U8* data, S32 size);
+	BOOL	isLastPacketInjected() const;
+	S32		getPendingInjectedCount() const;
+
+	// Drain the socket on a dedicated thread instead of in checkMessages().
+	void	setUseReceiveThread(BOOL use_thread);
+
 	//const char* getCurrentSMessageName() const { return mCurrentSMessageName; }
 	//const char* getCurrentSBlockName() const { return mCurrentSBlockName; }
 
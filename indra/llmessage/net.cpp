@@ -38,11 +38,13 @@
 	#include <sys/socket.h>
 	#include <netinet/in.h>
 	#include <arpa/inet.h>
+	#include <sys/select.h>
 	#include <fcntl.h>
 	#include <errno.h>
 #endif
 
 // linden library includes
+#include "llatomic.h"
 #include "llerror.h"
 #include "llhost.h"
 #include "lltimer.h"
@@ -73,6 +75,10 @@ typedef int socklen_t;
 
 static U32 gsnReceivingIFAddr = INVALID_HOST_IP_ADDRESS; // Address to which datagram was sent
 
+// Atomic, the packet receive thread makes calls too.
+static LLAtomicU32 gsnReceiveCalls(0);
+static LLAtomicU32 gsnSendCalls(0);
+
 const char* LOOPBACK_ADDRESS_STRING = "127.0.0.1";
 const char* BROADCAST_ADDRESS_STRING = "255.255.255.255";
 
@@ -102,6 +108,14 @@ U32 get_sender_port()
 	return ntohs(stSrcAddr.sin_port);
 }
 
+void get_and_reset_net_syscall_counts(U32& receive_calls, U32& send_calls)
+{
+	receive_calls = gsnReceiveCalls;
+	send_calls = gsnSendCalls;
+	gsnReceiveCalls -= receive_calls;
+	gsnSendCalls -= send_calls;
+}
+
 LLHost get_receiving_interface()
 {
 	return LLHost(gsnReceivingIFAddr, INVALID_PORT);
@@ -112,6 +126,17 @@ U32 get_receiving_interface_ip(void)
 	return gsnReceivingIFAddr;
 }
 
+BOOL wait_for_packet(int hSocket, U32 timeout_ms)
+{
+	fd_set read_fds;
+	FD_ZERO(&read_fds);
+	FD_SET(hSocket, &read_fds);
+	struct timeval timeout;
+	timeout.tv_sec = timeout_ms / 1000;
+	timeout.tv_usec = (timeout_ms % 1000) * 1000;
+	return select(hSocket + 1, &read_fds, NULL, NULL, &timeout) > 0;
+}
+
 const char* u32_to_ip_string(U32 ip)
 {
 	static char buffer[MAXADDRSTR];	 /* Flawfinder: ignore */ 
@@ -326,6 +351,7 @@ S32 receive_packet(int hSocket, char * receiveBuffer)
 	int addr_size = sizeof(struct sockaddr_in);
 
 	nRet = recvfrom(hSocket, receiveBuffer, NET_BUFFER_SIZE, 0, (struct sockaddr*)&stSrcAddr, &addr_size);
+	gsnReceiveCalls++;
 	if (nRet == SOCKET_ERROR ) 
 	{
 		if (WSAEWOULDBLOCK == WSAGetLastError())
@@ -351,6 +377,7 @@ BOOL send_packet(int hSocket, const char *sendBuffer, int size, U32 recipient, i
 	do
 	{
 		nRet = sendto(hSocket, sendBuffer, size, 0, (struct sockaddr*)&stDstAddr, sizeof(stDstAddr));					
+		gsnSendCalls++;
 
 		if (nRet == SOCKET_ERROR ) 
 		{
@@ -585,6 +612,7 @@ int receive_packet(int hSocket, char * receiveBuffer)
 	int recv_flags = 0;
 	nRet = recvfrom(hSocket, receiveBuffer, NET_BUFFER_SIZE, recv_flags, (struct sockaddr*)&stSrcAddr, &addr_size);
 #endif
+	gsnReceiveCalls++;
 
 	if (nRet == -1)
 	{
@@ -612,6 +640,7 @@ BOOL send_packet(int hSocket, const char * sendBuffer, int size, U32 recipient,
 	{
 		ret = sendto(hSocket, sendBuffer, size, 0,	(struct sockaddr*)&stDstAddr, sizeof(stDstAddr));
 		send_attempts++;
+		gsnSendCalls++;
 
 		if (ret >= 0)
 		{
@@ -660,4 +689,154 @@ BOOL send_packet(int hSocket, const char * sendBuffer, int size, U32 recipient,
 
 #endif
 
+#if LL_LINUX
+
+// Largest batch handed to one recvmmsg()/sendmmsg() call.
+static const S32 NET_MAX_BATCH = 64;
+
+BOOL batched_net_io_supported()
+{
+	return TRUE;
+}
+
+S32 receive_packets(int hSocket, LLNetDatagram* datagrams, S32 count)
+{
+	count = llmin(count, NET_MAX_BATCH);
+	if (count <= 0)
+	{
+		return 0;
+	}
+
+	struct mmsghdr msgs[NET_MAX_BATCH];
+	struct iovec iovs[NET_MAX_BATCH];
+	struct sockaddr_in addrs[NET_MAX_BATCH];
+	char cmsgs[NET_MAX_BATCH][CMSG_SPACE(sizeof(struct in_pktinfo))];
+
+	memset(msgs, 0, sizeof(msgs[0]) * count);
+	for (S32 i = 0; i < count; ++i)
+	{
+		iovs[i].iov_base = datagrams[i].mData;
+		iovs[i].iov_len = NET_BUFFER_SIZE;
+		msgs[i].msg_hdr.msg_name = &addrs[i];
+		msgs[i].msg_hdr.msg_namelen = sizeof(addrs[i]);
+		msgs[i].msg_hdr.msg_iov = &iovs[i];
+		msgs[i].msg_hdr.msg_iovlen = 1;
+		msgs[i].msg_hdr.msg_control = cmsgs[i];
+		msgs[i].msg_hdr.msg_controllen = sizeof(cmsgs[i]);
+	}
+
+	int received = recvmmsg(hSocket, msgs, count, MSG_DONTWAIT, NULL);
+	gsnReceiveCalls++;
+	if (received <= 0)
+	{
+		return 0;
+	}
+
+	for (S32 i = 0; i < received; ++i)
+	{
+		LLNetDatagram& datagram = datagrams[i];
+		datagram.mSize = msgs[i].msg_len;
+		datagram.mIP = addrs[i].sin_addr.s_addr;
+		datagram.mPort = ntohs(addrs[i].sin_port);
+		datagram.mReceivingIF = INVALID_HOST_IP_ADDRESS;
+		for (struct cmsghdr* cmsgptr = CMSG_FIRSTHDR(&msgs[i].msg_hdr); cmsgptr != NULL;
+			 cmsgptr = CMSG_NXTHDR(&msgs[i].msg_hdr, cmsgptr))
+		{
+			if (cmsgptr->cmsg_level == SOL_IP && cmsgptr->cmsg_type == IP_PKTINFO)
+			{
+				in_pktinfo* pktinfo = (in_pktinfo*)CMSG_DATA(cmsgptr);
+				datagram.mReceivingIF = pktinfo->ipi_spec_dst.s_addr;
+			}
+		}
+	}
+	return received;
+}
+
+S32 send_packets(int hSocket, const LLNetDatagram* datagrams, S32 count)
+{
+	S32 sent = 0;
+	while (sent < count)
+	{
+		S32 batch = llmin(count - sent, NET_MAX_BATCH);
+		struct mmsghdr msgs[NET_MAX_BATCH];
+		struct iovec iovs[NET_MAX_BATCH];
+		struct sockaddr_in addrs[NET_MAX_BATCH];
+
+		memset(msgs, 0, sizeof(msgs[0]) * batch);
+		for (S32 i = 0; i < batch; ++i)
+		{
+			const LLNetDatagram& datagram = datagrams[sent + i];
+			memset(&addrs[i], 0, sizeof(addrs[i]));
+			addrs[i].sin_family = AF_INET;
+			addrs[i].sin_addr.s_addr = datagram.mIP;
+			addrs[i].sin_port = htons(datagram.mPort);
+			iovs[i].iov_base = datagram.mData;
+			iovs[i].iov_len = datagram.mSize;
+			msgs[i].msg_hdr.msg_name = &addrs[i];
+			msgs[i].msg_hdr.msg_namelen = sizeof(addrs[i]);
+			msgs[i].msg_hdr.msg_iov = &iovs[i];
+			msgs[i].msg_hdr.msg_iovlen = 1;
+		}
+
+		int ret = sendmmsg(hSocket, msgs, batch, 0);
+		gsnSendCalls++;
+		if (ret > 0)
+		{
+			sent += ret;
+		}
+		else
+		{
+			// Let send_packet() retry and report the one that failed, then
+			// carry on batching after it.
+			const LLNetDatagram& datagram = datagrams[sent];
+			if (!send_packet(hSocket, datagram.mData, datagram.mSize, datagram.mIP, datagram.mPort))
+			{
+				return sent;
+			}
+			sent++;
+		}
+	}
+	return sent;
+}
+
+#else
+
+BOOL batched_net_io_supported()
+{
+	return FALSE;
+}
+
+S32 receive_packets(int hSocket, LLNetDatagram* datagrams, S32 count)
+{
+	S32 received = 0;
+	while (received < count)
+	{
+		LLNetDatagram& datagram = datagrams[received];
+		datagram.mSize = receive_packet(hSocket, datagram.mData);
+		if (datagram.mSize <= 0)
+		{
+			break;
+		}
+		datagram.mIP = get_sender_ip();
+		datagram.mPort = get_sender_port();
+		datagram.mReceivingIF = get_receiving_interface_ip();
+		received++;
+	}
+	return received;
+}
+
+S32 send_packets(int hSocket, const LLNetDatagram* datagrams, S32 count)
+{
+	for (S32 i = 0; i < count; ++i)
+	{
+		if (!send_packet(hSocket, datagrams[i].mData, datagrams[i].mSize, datagrams[i].mIP, datagrams[i].mPort))
+		{
+			return i;
+		}
+	}
+	return count;
+}
+
+#endif // LL_LINUX
+
 //EOF
@@ -45,6 +45,28 @@ S32		receive_packet(int hSocket, char * receiveBuffer);
 
 BOOL	send_packet(int hSocket, const char *sendBuffer, int size, U32 recipient, int nPort);	// Returns TRUE on success.
 
+// One datagram of a batched receive or send.
+struct LLNetDatagram
+{
+	char*	mData;			// NET_BUFFER_SIZE bytes on receive
+	S32		mSize;			// bytes received, or bytes to send
+	U32		mIP;			// sender on receive, recipient on send
+	U32		mPort;
+	U32		mReceivingIF;	// receive only
+};
+
+// Batched I/O: recvmmsg()/sendmmsg() on Linux, a loop over
+// receive_packet()/send_packet() elsewhere.
+S32		receive_packets(int hSocket, LLNetDatagram* datagrams, S32 count);	// returns number received
+S32		send_packets(int hSocket, const LLNetDatagram* datagrams, S32 count);	// returns number sent
+BOOL	batched_net_io_supported();
+
+// Block until a datagram is waiting on hSocket or timeout_ms passes.
+BOOL	wait_for_packet(int hSocket, U32 timeout_ms);
+
+// Number of receive and send system calls since the last call.
+void	get_and_reset_net_syscall_counts(U32& receive_calls, U32& send_calls);
+
 //void	get_sender(char * tmp);
 LLHost	get_sender();
 U32		get_sender_port();
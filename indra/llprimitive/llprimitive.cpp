@@ -34,6 +34,7 @@
 #include "legacy_object_types.h"
 #include "v4coloru.h"
 #include "llvolumemgr.h"
+#include "llvolumefacecache.h"
 #include "llstring.h"
 #include "lldatapacker.h"
 #include "llsdutil_math.h"
@@ -143,6 +144,7 @@ bool LLPrimitive::cleanupVolumeManager()
 		delete sVolumeManager;
 		sVolumeManager = NULL;
 	}
+	LLVolumeFaceCache::cleanup();
 	return res;
 }
 
@@ -33,12 +33,16 @@
 #include <map>
 #if LL_WINDOWS
 #include <share.h>
+#include <io.h>
+#include "llwin32headerslean.h"
 #elif LL_SOLARIS
 #include <sys/types.h>
 #include <unistd.h>
 #include <fcntl.h>
+#include <sys/mman.h>
 #else
 #include <sys/file.h>
+#include <sys/mman.h>
 #endif
     
 #include "llstl.h"
@@ -46,6 +50,8 @@
     
 const S32 FILE_BLOCK_MASK = 0x000003FF;	 // 1024-byte blocks
 const S32 VFS_CLEANUP_SIZE = 5242880;  // how much space we free up in a single stroke
+const S32 VFS_COMPACT_SIZE = 16777216;	// how much file data pokeFiles() moves around at most
+const U32 VFS_COMPACT_MIN_SCATTERED = 4;	// compact once 1/4 of the free space is outside the largest free block
 const S32 BLOCK_LENGTH_INVALID = -1;	// mLength for invalid LLVFSFileBlocks
 
 LLVFS *gVFS = NULL;
@@ -161,7 +167,8 @@ void LLVFSFileBlock::serialize(U8 *buffer)
 	buffer += 4;
 	swizzleCopy(buffer, &mLength, 4);
 	buffer +=4;
-	swizzleCopy(buffer, &mAccessTime, 4);
+	U32 access_time = mAccessTime;
+	swizzleCopy(buffer, &access_time, 4);
 	buffer +=4;
 	memcpy(buffer, &mFileID.mData, 16); /* Flawfinder: ignore */
 	buffer += 16;
@@ -179,7 +186,9 @@ void LLVFSFileBlock::deserialize(U8 *buffer, const S32 index_loc)
 	buffer += 4;
 	swizzleCopy(&mLength, buffer, 4);
 	buffer += 4;
-	swizzleCopy(&mAccessTime, buffer, 4);
+	U32 access_time;
+	swizzleCopy(&access_time, buffer, 4);
+	mAccessTime = access_time;
 	buffer += 4;
 	memcpy(&mFileID.mData, buffer, 16);
 	buffer += 16;
@@ -211,10 +220,22 @@ struct LLVFSFileBlock_less
 const S32 LLVFSFileBlock::SERIAL_SIZE = 34;
      
 
-LLVFS::LLVFS(const std::string& index_filename, const std::string& data_filename, const BOOL read_only, const U32 presize, const BOOL remove_after_crash)
+LLVFS::LLVFS(const std::string& index_filename, const std::string& data_filename, const BOOL read_only, const U32 presize, const BOOL remove_after_crash, const BOOL use_mmap)
 :	mRemoveAfterCrash(remove_after_crash),
 	mDataFP(NULL),
-	mIndexFP(NULL)
+	mIndexFP(NULL),
+	mMapLock(NULL),
+	mMappedData(NULL),
+	mMappedSize(0),
+	mMapFailed(FALSE),
+	mFreeBlockCount(0),
+	mFreeBytes(0),
+	mCompactedBytes(0),
+	mCompactedFiles(0),
+	mCompactCursor(0)
+#if LL_WINDOWS
+	, mMappingHandle(NULL)
+#endif
 {
 	mDataMutex = new LLMutex;
 
@@ -233,7 +254,7 @@ LLVFS::LLVFS(const std::string& index_filename, const std::string& data_filename
 	LL_INFOS("VFS") << "Attempting to open VFS index file " << mIndexFilename << LL_ENDL;
 	LL_INFOS("VFS") << "Attempting to open VFS data file " << mDataFilename << LL_ENDL;
 
-	mDataFP = openAndLock(mDataFilename, file_mode, mReadOnly);
+	mDataFP = openDataFile(file_mode, mReadOnly, use_mmap);
 	if (!mDataFP)
 	{
 		if (mReadOnly)
@@ -243,7 +264,7 @@ LLVFS::LLVFS(const std::string& index_filename, const std::string& data_filename
 			return;
 		}
 
-		mDataFP = openAndLock(mDataFilename, "w+b", FALSE);
+		mDataFP = openDataFile("w+b", FALSE, use_mmap);
 		if (mDataFP)
 		{
 			// Since we're creating this data file, assume any index file is bogus
@@ -281,7 +302,7 @@ LLVFS::LLVFS(const std::string& index_filename, const std::string& data_filename
 			LLFile::remove(mDataFilename);
 			LLFile::remove(marker);
 
-			mDataFP = openAndLock(mDataFilename, "w+b", FALSE);
+			mDataFP = openDataFile("w+b", FALSE, use_mmap);
 			if (!mDataFP)
 			{
 				LL_WARNS("VFS") << "Can't open VFS data file in crash recovery" << LL_ENDL;
@@ -493,6 +514,11 @@ LLVFS::LLVFS(const std::string& index_filename, const std::string& data_filename
 		{
 			addFreeBlock(new LLVFSBlock(0, data_size));
 		}
+
+		for (fileblock_map::iterator it = mFileBlocks.begin(); it != mFileBlocks.end(); ++it)
+		{
+			addFileLocation(it->second);
+		}
 	}
 	else	// Pre-existing index file wasn't opened
 	{
@@ -538,6 +564,12 @@ LLVFS::LLVFS(const std::string& index_filename, const std::string& data_filename
 	LL_INFOS("VFS") << "Using VFS data file " << mDataFilename << LL_ENDL;
 
 	mValid = VFSVALID_OK;
+
+	if (use_mmap)
+	{
+		mMapLock = new AIRWLock;
+		mapDataFile();
+	}
 }
     
 LLVFS::~LLVFS()
@@ -556,11 +588,21 @@ LLVFS::~LLVFS()
 		delete (*it).second;
 	}
 	mFileBlocks.clear();
+	mFileBlocksByLocation.clear();
 	
-	mFreeBlocksByLength.clear();
+	for (S32 i = 0; i < FREE_BIN_COUNT; ++i)
+	{
+		mFreeBlocksByLength[i].clear();
+	}
+	mFreeBlockCount = 0;
+	mFreeBytes = 0;
 
 	for_each(mFreeBlocksByLocation.begin(), mFreeBlocksByLocation.end(), DeletePairedPointer());
     
+	unmapDataFile();
+	delete mMapLock;
+	mMapLock = NULL;
+
 	unlockAndClose(mDataFP);
 	mDataFP = NULL;
     
@@ -582,9 +624,10 @@ LLVFS * LLVFS::createLLVFS(const std::string& index_filename,
 		const std::string& data_filename, 
 		const BOOL read_only, 
 		const U32 presize, 
-		const BOOL remove_after_crash)
+		const BOOL remove_after_crash,
+		const BOOL use_mmap)
 {
-	LLVFS * new_vfs = new LLVFS(index_filename, data_filename, read_only, presize, remove_after_crash);
+	LLVFS * new_vfs = new LLVFS(index_filename, data_filename, read_only, presize, remove_after_crash, use_mmap);
 
 	if( !new_vfs->isValid() )
 	{	// First name failed, retry with new names
@@ -598,7 +641,7 @@ LLVFS * LLVFS::createLLVFS(const std::string& index_filename,
 			retry_vfs_data_name = data_filename + llformat(".%u", count);
 
 			delete new_vfs;	// Delete bad VFS and try again
-			new_vfs = new LLVFS(retry_vfs_index_name, retry_vfs_data_name, read_only, presize, remove_after_crash);
+			new_vfs = new LLVFS(retry_vfs_index_name, retry_vfs_data_name, read_only, presize, remove_after_crash, use_mmap);
 
 			count++;
 		}
@@ -725,8 +768,7 @@ BOOL LLVFS::checkAvailable(S32 max_size)
 {
 	lockData();
 	
-	blocks_length_map_t::iterator iter = mFreeBlocksByLength.lower_bound(max_size); // first entry >= size
-	const BOOL res(iter == mFreeBlocksByLength.end() ? FALSE : TRUE);
+	const BOOL res(findFreeBlockLength(max_size) ? TRUE : FALSE);
 
 	unlockData();
 	
@@ -854,11 +896,9 @@ BOOL LLVFS::setMaxSize(const LLUUID &file_id, const LLAssetType::EType file_type
 					{
 						// move the file into the new block
 						std::vector<U8> buffer(block->mSize);
-						fseek(mDataFP, block->mLocation, SEEK_SET);
-						if (fread(&buffer[0], block->mSize, 1, mDataFP) == 1)
+						if (readDataFile(block->mLocation, &buffer[0], block->mSize) == (size_t)block->mSize)
 						{
-							fseek(mDataFP, new_data_location, SEEK_SET);
-							if (fwrite(&buffer[0], block->mSize, 1, mDataFP) != 1)
+							if (writeDataFile(new_data_location, &buffer[0], block->mSize) != (size_t)block->mSize)
 							{
 								LL_WARNS() << "Short write" << LL_ENDL;
 							}
@@ -868,9 +908,11 @@ BOOL LLVFS::setMaxSize(const LLUUID &file_id, const LLAssetType::EType file_type
 					}
 				}
     
+				eraseFileLocation(block);
 				block->mLocation = new_data_location;
     
 				block->mLength = max_size;
+				addFileLocation(block);
 
 
 				sync(block);
@@ -906,6 +948,7 @@ BOOL LLVFS::setMaxSize(const LLUUID &file_id, const LLAssetType::EType file_type
 				block = new LLVFSFileBlock(file_id, file_type, free_block->mLocation, max_size);
 				mFileBlocks.insert(fileblock_map::value_type(spec, block));
 			}
+			addFileLocation(block);
 
 			// Must call useFreeSpace before sync(), as sync()
 			// unlocks data structures.
@@ -1005,6 +1048,8 @@ void LLVFS::removeFileBlock(LLVFSFileBlock *fileblock)
 	
 	if (fileblock->mLength > 0)
 	{
+		eraseFileLocation(fileblock);
+
 		// turn this file into an empty block
 		LLVFSBlock *free_block = new LLVFSBlock(fileblock->mLocation, fileblock->mLength);
 		
@@ -1019,6 +1064,25 @@ void LLVFS::removeFileBlock(LLVFSFileBlock *fileblock)
 	//mergeFreeBlocks();
 }
 
+// mDataMutex must be LOCKED before calling this
+void LLVFS::addFileLocation(LLVFSFileBlock *fileblock)
+{
+	if (fileblock->mLength > 0)
+	{
+		mFileBlocksByLocation[fileblock->mLocation] = fileblock;
+	}
+}
+
+// mDataMutex must be LOCKED before calling this
+void LLVFS::eraseFileLocation(LLVFSFileBlock *fileblock)
+{
+	files_location_map_t::iterator it = mFileBlocksByLocation.find(fileblock->mLocation);
+	if (it != mFileBlocksByLocation.end() && it->second == fileblock)
+	{
+		mFileBlocksByLocation.erase(it);
+	}
+}
+
 void LLVFS::removeFile(const LLUUID &file_id, const LLAssetType::EType file_type)
 {
 	if (!isValid())
@@ -1059,6 +1123,16 @@ S32 LLVFS::getData(const LLUUID &file_id, const LLAssetType::EType file_type, U8
 	llassert(location >= 0);
 	llassert(length >= 0);
 
+	// Fast path: any number of threads can copy out of the mapping at the same time.
+	S32 view_length = length;
+	const U8* view = lockDataView(file_id, file_type, location, view_length);
+	if (view)
+	{
+		memcpy(buffer, view, view_length);	/* Flawfinder: ignore */
+		unlockDataView();
+		return view_length;
+	}
+
 	BOOL do_read = FALSE;
 	
     lockData();
@@ -1088,8 +1162,7 @@ S32 LLVFS::getData(const LLUUID &file_id, const LLAssetType::EType file_type, U8
 
 	if (do_read)
 	{
-		fseek(mDataFP, location, SEEK_SET);
-		bytesread = (S32)fread(buffer, 1, length, mDataFP);
+		bytesread = (S32)readDataFile(location, buffer, length);
 	}
 	
 	unlockData();
@@ -1158,8 +1231,7 @@ S32 LLVFS::storeData(const LLUUID &file_id, const LLAssetType::EType file_type,
 			}
 			U32 file_location = location + block->mLocation;
 			
-			fseek(mDataFP, file_location, SEEK_SET);
-			S32 write_len = (S32)fwrite(buffer, 1, length, mDataFP);
+			S32 write_len = (S32)writeDataFile(file_location, buffer, length);
 			if (write_len != length)
 			{
 				LL_WARNS() << llformat("VFS Write Error: %d != %d",write_len,length) << LL_ENDL;
@@ -1252,33 +1324,116 @@ BOOL LLVFS::isLocked(const LLUUID &file_id, const LLAssetType::EType file_type,
 	return res;
 }
 
+const U8* LLVFS::lockDataView(const LLUUID &file_id, const LLAssetType::EType file_type, S32 location, S32 &length)
+{
+	// mMapLock only exists when mapping was asked for. The mapping itself
+	// may be replaced while the data file grows, so check it under the lock.
+	if (!mMapLock)
+	{
+		return NULL;
+	}
+	llassert(location >= 0);
+	llassert(length >= 0);
+
+	mMapLock->rdlock();
+	if (!mMappedData)
+	{
+		mMapLock->rdunlock();
+		return NULL;
+	}
+
+	const U8* view = NULL;
+	LLVFSFileSpecifier spec(file_id, file_type);
+	fileblock_map::iterator it = mFileBlocks.find(spec);
+	if (it != mFileBlocks.end())
+	{
+		LLVFSFileBlock *block = (*it).second;
+
+		// Concurrent readers may store this at the same time; they all store
+		// (about) the same value and the LRU only needs it to be roughly right.
+		// The store is atomic, so that much is not a data race.
+		block->mAccessTime = (U32)time(NULL);
+
+		// Leave out of range reads to getData(), which warns about them.
+		if (location <= block->mSize)
+		{
+			length = llmin(length, block->mSize - location);
+			U32 file_location = block->mLocation + location;
+			if (file_location + (U32)length <= mMappedSize)
+			{
+				view = mMappedData + file_location;
+			}
+		}
+	}
+
+	if (!view)
+	{
+		mMapLock->rdunlock();
+	}
+	return view;
+}
+
+void LLVFS::unlockDataView()
+{
+	llassert(mMapLock);
+	mMapLock->rdunlock();
+}
+
 //============================================================================
 // protected
 //============================================================================
 
-void LLVFS::eraseBlockLength(LLVFSBlock *block)
+// static
+S32 LLVFS::getFreeBin(S32 length)
 {
-	// find the corresponding map entry in the length map and erase it
-	S32 length = block->mLength;
-	blocks_length_map_t::iterator iter = mFreeBlocksByLength.lower_bound(length);
-	blocks_length_map_t::iterator end = mFreeBlocksByLength.end();
-	bool found_block = false;
-	while(iter != end)
+	S32 bin = 0;
+	while ((length >>= 1) > 0)
 	{
-		LLVFSBlock *tblock = iter->second;
-		llassert(tblock->mLength == length); // there had -better- be an entry with our length!
-		if (tblock == block)
-		{
-			mFreeBlocksByLength.erase(iter);
-			found_block = true;
-			break;
-		}
-		++iter;
+		++bin;
 	}
-	if(!found_block)
+	return bin;
+}
+
+void LLVFS::insertBlockLength(LLVFSBlock *block)
+{
+	llassert(block->mLength > 0);
+	llverify(mFreeBlocksByLength[getFreeBin(block->mLength)].insert(block).second);
+	++mFreeBlockCount;
+	mFreeBytes += block->mLength;
+}
+
+void LLVFS::eraseBlockLength(LLVFSBlock *block)
+{
+	// find the corresponding entry in the size class bin and erase it
+	if (mFreeBlocksByLength[getFreeBin(block->mLength)].erase(block) != 1)
 	{
 		LL_ERRS() << "eraseBlock could not find block" << LL_ENDL;
 	}
+	--mFreeBlockCount;
+	mFreeBytes -= block->mLength;
+}
+
+LLVFSBlock *LLVFS::findFreeBlockLength(S32 size) const
+{
+	S32 bin = getFreeBin(size);
+
+	// The bin of size may contain blocks that are too small, find the first that isn't.
+	LLVFSBlock key(0, size);
+	blocks_length_set_t::const_iterator iter = mFreeBlocksByLength[bin].lower_bound(&key);
+	if (iter != mFreeBlocksByLength[bin].end())
+	{
+		return *iter;
+	}
+
+	// Every block in a larger bin is large enough, the first one fits best.
+	for (++bin; bin < FREE_BIN_COUNT; ++bin)
+	{
+		if (!mFreeBlocksByLength[bin].empty())
+		{
+			return *mFreeBlocksByLength[bin].begin();
+		}
+	}
+	return NULL;
 }
 
 
@@ -1335,7 +1490,7 @@ void LLVFS::addFreeBlock(LLVFSBlock *block)
 		eraseBlockLength(prev_block);
 		eraseBlock(next_block);
 		prev_block->mLength += block->mLength + next_block->mLength;
-		mFreeBlocksByLength.insert(blocks_length_map_t::value_type(prev_block->mLength, prev_block));
+		insertBlockLength(prev_block);
 		delete block;
 		block = NULL;
 		delete next_block;
@@ -1348,7 +1503,7 @@ void LLVFS::addFreeBlock(LLVFSBlock *block)
 		// therefore only need to update the length map. JC
 		eraseBlockLength(prev_block);
 		prev_block->mLength += block->mLength;
-		mFreeBlocksByLength.insert(blocks_length_map_t::value_type(prev_block->mLength, prev_block)); // multimap insert
+		insertBlockLength(prev_block);
 		delete block;
 		block = NULL;
 	}
@@ -1362,7 +1517,7 @@ void LLVFS::addFreeBlock(LLVFSBlock *block)
 		next_block->mLength += block->mLength;
 		// Don't hint here, next_free_it iterator may be invalid.
 		mFreeBlocksByLocation.insert(blocks_location_map_t::value_type(next_block->mLocation, next_block)); // multimap insert
-		mFreeBlocksByLength.insert(blocks_length_map_t::value_type(next_block->mLength, next_block)); // multimap insert			
+		insertBlockLength(next_block);
 		delete block;
 		block = NULL;
 	}
@@ -1371,7 +1526,7 @@ void LLVFS::addFreeBlock(LLVFSBlock *block)
 		// Can't merge with other free blocks.
 		// Hint that insert should go near next_free_it.
  		mFreeBlocksByLocation.insert(next_free_it, blocks_location_map_t::value_type(block->mLocation, block)); // multimap insert
- 		mFreeBlocksByLength.insert(blocks_length_map_t::value_type(block->mLength, block)); // multimap insert
+ 		insertBlockLength(block);
 	}
 }
 
@@ -1536,9 +1691,7 @@ LLVFSBlock *LLVFS::findFreeBlock(S32 size, LLVFSFileBlock *immune)
 	while (! block)
 	{
 		// look for a suitable free block
-		blocks_length_map_t::iterator iter = mFreeBlocksByLength.lower_bound(size); // first entry >= size
-		if (iter != mFreeBlocksByLength.end())
-			block = iter->second;
+		block = findFreeBlockLength(size);
     	
 		// no large enough free blocks, time to clean out some junk
 		if (! block)
@@ -1621,6 +1774,128 @@ LLVFSBlock *LLVFS::findFreeBlock(S32 size, LLVFSFileBlock *immune)
 	return block;
 }
 
+// mDataMutex must be LOCKED before calling this
+size_t LLVFS::readDataFile(U32 location, U8 *buffer, S32 length)
+{
+	if (mMappedData && location + (U32)length <= mMappedSize)
+	{
+		memcpy(buffer, mMappedData + location, length);	/* Flawfinder: ignore */
+		return length;
+	}
+	fseek(mDataFP, location, SEEK_SET);
+	return fread(buffer, 1, length, mDataFP);
+}
+
+// mDataMutex must be LOCKED before calling this
+size_t LLVFS::writeDataFile(U32 location, const U8 *buffer, S32 length)
+{
+	if (mMapLock && !mMapFailed && location + (U32)length > mMappedSize)
+	{
+		// The data file grows past the mapping, map more of it so that
+		// this data is available to the readers.
+		growMappedDataFile(location + (U32)length);
+	}
+	if (mMappedData && location + (U32)length <= mMappedSize)
+	{
+		memcpy(mMappedData + location, buffer, length);	/* Flawfinder: ignore */
+		return length;
+	}
+	fseek(mDataFP, location, SEEK_SET);
+	return fwrite(buffer, 1, length, mDataFP);
+}
+
+// Smallest step the mapped data file grows by.
+static const U32 MIN_MAP_GROWTH = 4 * 1024 * 1024;
+
+// mDataMutex must be LOCKED before calling this
+void LLVFS::growMappedDataFile(U32 min_size)
+{
+	// Double the mapping, so a file growing by small writes is only
+	// mapped again a logarithmic number of times.
+	U64 new_size = llmax((U64)min_size, (U64)mMappedSize * 2);
+	new_size = llmin(llmax(new_size, (U64)mMappedSize + MIN_MAP_GROWTH), (U64)U32_MAX);
+
+	unmapDataFile();
+
+	fseek(mDataFP, 0, SEEK_END);
+	if ((U64)ftell(mDataFP) < new_size)
+	{
+		// Extend the file with a byte at its new end, the rest reads as zeros.
+		U8 zero = 0;
+		fseek(mDataFP, (long)(new_size - 1), SEEK_SET);
+		fwrite(&zero, 1, 1, mDataFP);
+	}
+
+	mapDataFile();
+	if (!mMappedData)
+	{
+		// mapDataFile() said why, go on with file I/O only.
+		mMapFailed = TRUE;
+	}
+}
+
+// Maps the whole data file. mDataFP must be unbuffered and, unless called
+// from the constructor, mDataMutex must be LOCKED.
+void LLVFS::mapDataFile()
+{
+	llassert(!mMappedData);
+
+	fseek(mDataFP, 0, SEEK_END);
+	long file_size = ftell(mDataFP);
+	if (file_size <= 0)
+	{
+		// Nothing to map yet, everything goes through mDataFP until the file grows.
+		return;
+	}
+
+#if LL_WINDOWS
+	HANDLE file_handle = (HANDLE)_get_osfhandle(_fileno(mDataFP));
+	mMappingHandle = CreateFileMapping(file_handle, NULL, mReadOnly ? PAGE_READONLY : PAGE_READWRITE, 0, 0, NULL);
+	if (mMappingHandle)
+	{
+		mMappedData = (U8*)MapViewOfFile(mMappingHandle, mReadOnly ? FILE_MAP_READ : FILE_MAP_WRITE, 0, 0, 0);
+		if (!mMappedData)
+		{
+			CloseHandle(mMappingHandle);
+			mMappingHandle = NULL;
+		}
+	}
+#else
+	void* data = mmap(NULL, file_size, mReadOnly ? PROT_READ : (PROT_READ | PROT_WRITE), MAP_SHARED, fileno(mDataFP), 0);
+	if (data != MAP_FAILED)
+	{
+		mMappedData = (U8*)data;
+	}
+#endif
+
+	if (mMappedData)
+	{
+		mMappedSize = (U32)file_size;
+		LL_DEBUGS("VFS") << "Mapped " << mMappedSize << " bytes of VFS data file " << mDataFilename << LL_ENDL;
+	}
+	else
+	{
+		LL_WARNS("VFS") << "Failed to memory map VFS data file " << mDataFilename << ", using file I/O" << LL_ENDL;
+	}
+}
+
+void LLVFS::unmapDataFile()
+{
+	if (!mMappedData)
+	{
+		return;
+	}
+#if LL_WINDOWS
+	UnmapViewOfFile(mMappedData);
+	CloseHandle(mMappingHandle);
+	mMappingHandle = NULL;
+#else
+	munmap(mMappedData, mMappedSize);
+#endif
+	mMappedData = NULL;
+	mMappedSize = 0;
+}
+
 //============================================================================
 // public
 //============================================================================
@@ -1656,6 +1931,191 @@ void LLVFS::pokeFiles()
 		}
 		fflush(mIndexFP);
 	}
+
+	if (!mReadOnly)
+	{
+		compact(VFS_COMPACT_SIZE);
+	}
+}
+
+// mDataMutex must be LOCKED before calling this
+void LLVFS::syncMoved(LLVFSFileBlock *block)
+{
+	sync(block);
+	// The old place of the file is free space now and the next move may
+	// overwrite it, so the index must not keep pointing there.
+	fflush(mIndexFP);
+}
+
+// mDataMutex must be LOCKED before calling this
+BOOL LLVFS::isFragmented() const
+{
+	if (mFreeBlockCount <= 1)
+	{
+		// At most the trailing free space, nothing to coalesce.
+		return FALSE;
+	}
+	U32 largest = 0;
+	for (S32 bin = FREE_BIN_COUNT - 1; bin >= 0; --bin)
+	{
+		if (!mFreeBlocksByLength[bin].empty())
+		{
+			largest = (*mFreeBlocksByLength[bin].rbegin())->mLength;
+			break;
+		}
+	}
+	return (mFreeBytes - largest) * VFS_COMPACT_MIN_SCATTERED >= mFreeBytes;
+}
+
+BOOL LLVFS::needsCompaction()
+{
+	if (!isValid() || mReadOnly)
+	{
+		return FALSE;
+	}
+	LLMutexLock lock(mDataMutex);
+	return isFragmented();
+}
+
+S32 LLVFS::compact(S32 max_bytes)
+{
+	if (!isValid())
+	{
+		LL_ERRS() << "Attempting to use invalid VFS!" << LL_ENDL;
+	}
+	if (mReadOnly)
+	{
+		LL_WARNS() << "Attempt to compact read-only VFS" << LL_ENDL;
+		return 0;
+	}
+
+	LLTimer timer;
+
+	// Readers of the mapping are only locked out once there is work to do.
+	mDataMutex->lock();
+	if (!isFragmented())
+	{
+		mDataMutex->unlock();
+		return 0;
+	}
+	if (mMapLock)
+	{
+		mMapLock->wrlock();
+	}
+
+	S32 moved = 0;
+	S32 files_moved = 0;
+	std::vector<U8> buffer;
+	// Go on where the last call stopped, so that calls with a small budget
+	// eventually get around the whole file.
+	U32 cursor = mCompactCursor;
+	while (moved < max_bytes)
+	{
+		// Find the next hole and the file right behind it.
+		blocks_location_map_t::iterator hole_it = mFreeBlocksByLocation.lower_bound(cursor);
+		if (hole_it == mFreeBlocksByLocation.end())
+		{
+			cursor = 0;
+			break;
+		}
+		LLVFSBlock *hole = hole_it->second;
+		U32 hole_location = hole->mLocation;
+		U32 hole_end = hole_location + hole->mLength;
+		files_location_map_t::iterator file_it = mFileBlocksByLocation.find(hole_end);
+		if (file_it == mFileBlocksByLocation.end())
+		{
+			// Trailing free space (or garbage); nothing to slide down.
+			cursor = 0;
+			break;
+		}
+		LLVFSFileBlock *file_block = file_it->second;
+		if (file_block->mLocks[VFSLOCK_READ] ||
+			file_block->mLocks[VFSLOCK_APPEND] ||
+			file_block->mLocks[VFSLOCK_OPEN])
+		{
+			// Leave files that are in use alone, try the next hole.
+			cursor = hole_end + file_block->mLength;
+			continue;
+		}
+
+		// The index keeps pointing at the old copy until sync() below, so the
+		// new copy must not overwrite any of it or a crash in between loses
+		// the file.  Sliding the file down is only safe when its data fits
+		// in the hole.  Otherwise move it into the first free block in front
+		// of the hole that holds all of it, which empties its old place all
+		// the same.
+		LLVFSBlock *target = hole;
+		if (hole->mLength < file_block->mSize)
+		{
+			target = NULL;
+			for (blocks_location_map_t::iterator it = mFreeBlocksByLocation.begin(); it != hole_it; ++it)
+			{
+				if (it->second->mLength >= file_block->mLength)
+				{
+					target = it->second;
+					break;
+				}
+			}
+			if (!target)
+			{
+				cursor = hole_end + file_block->mLength;
+				continue;
+			}
+		}
+
+		if (file_block->mSize > 0)
+		{
+			buffer.resize(file_block->mSize);
+			if (readDataFile(file_block->mLocation, &buffer[0], file_block->mSize) != (size_t)file_block->mSize ||
+				writeDataFile(target->mLocation, &buffer[0], file_block->mSize) != (size_t)file_block->mSize)
+			{
+				LL_WARNS() << "VFS: Short read or write while compacting, stopping" << LL_ENDL;
+				break;
+			}
+			// The data must be in the file before the index points at it.
+			fflush(mDataFP);
+		}
+
+		mFileBlocksByLocation.erase(file_it);
+		if (target == hole)
+		{
+			// Swap the places of the hole and the file.
+			eraseBlock(hole);
+			file_block->mLocation = hole_location;
+			hole->mLocation = hole_location + file_block->mLength;
+			addFileLocation(file_block);
+			syncMoved(file_block);
+			addFreeBlock(hole);		// may merge with the next hole, which is fine
+			cursor = file_block->mLocation + file_block->mLength;
+		}
+		else
+		{
+			U32 old_location = file_block->mLocation;
+			file_block->mLocation = target->mLocation;
+			useFreeSpace(target, file_block->mLength);
+			addFileLocation(file_block);
+			syncMoved(file_block);
+			// Merges with the hole in front, look at the larger hole again.
+			addFreeBlock(new LLVFSBlock(old_location, file_block->mLength));
+			cursor = hole_location;
+		}
+
+		moved += file_block->mSize;
+		++files_moved;
+	}
+	mCompactCursor = cursor;
+
+	mCompactedBytes += moved;
+	mCompactedFiles += files_moved;
+
+	unlockData();
+
+	if (files_moved)
+	{
+		LL_INFOS("VFS") << "VFS: Compacted " << files_moved << " files (" << moved / 1024 << "K) in "
+						<< timer.getElapsedTimeF32() << " seconds" << LL_ENDL;
+	}
+	return moved;
 }
 
     
@@ -1946,10 +2406,21 @@ void LLVFS::dumpStatistics()
 		LL_INFOS() << "Free length " << it->first << " count " << it->second << LL_ENDL;
 	}
 
+	// Dump the size class bins
+	S32 length_list_count = 0;
+	for (S32 i = 0; i < FREE_BIN_COUNT; ++i)
+	{
+		length_list_count += (S32)mFreeBlocksByLength[i].size();
+		if (!mFreeBlocksByLength[i].empty())
+		{
+			LL_INFOS() << "Free size class " << (1 << i) << " bytes and up count " << mFreeBlocksByLength[i].size() << LL_ENDL;
+		}
+	}
+	llassert(length_list_count == mFreeBlockCount);
+
 	LL_INFOS() << "Invalid blocks: " << invalid_file_count << LL_ENDL;
 	LL_INFOS() << "File blocks:    " << mFileBlocks.size() << LL_ENDL;
 
-	S32 length_list_count = (S32)mFreeBlocksByLength.size();
 	S32 location_list_count = (S32)mFreeBlocksByLocation.size();
 	if (length_list_count == location_list_count)
 	{
@@ -1968,6 +2439,12 @@ void LLVFS::dumpStatistics()
 	LL_INFOS() << "Sum: " << (total_file_size + total_free_size) << " bytes" << LL_ENDL;
 	LL_INFOS() << llformat("%.0f%% full",((F32)(total_file_size)/(F32)(total_file_size+total_free_size))*100.f) << LL_ENDL;
 
+	// Fragmentation: how much of the free space can't be handed out in one piece.
+	F32 fragmentation = total_free_size ? (1.f - (F32)max_free_size / (F32)total_free_size) * 100.f : 0.f;
+	LL_INFOS() << llformat("Fragmentation: %.1f%% (%d free blocks, average %dK)", fragmentation, location_list_count,
+						   location_list_count ? total_free_size / location_list_count / 1024 : 0) << LL_ENDL;
+	LL_INFOS() << "Compacted: " << mCompactedFiles << " files, " << (mCompactedBytes >> 10) << "K" << LL_ENDL;
+
 	LL_INFOS() << " " << LL_ENDL;
 	for (std::map<LLAssetType::EType, std::pair<S32,S32> >::iterator iter = filetype_counts.begin();
 		 iter != filetype_counts.end(); ++iter)
@@ -2110,6 +2587,18 @@ void LLVFS::dumpFiles()
 //============================================================================
 
 // static
+LLFILE *LLVFS::openDataFile(const char* mode, BOOL read_lock, BOOL unbuffered)
+{
+	LLFILE* fp = openAndLock(mDataFilename, mode, read_lock);
+	if (fp && unbuffered)
+	{
+		// stdio must not buffer anything that might also be accessed through
+		// the mapping.  setvbuf() is only allowed before the first I/O.
+		setvbuf(fp, NULL, _IONBF, 0);
+	}
+	return fp;
+}
+
 LLFILE *LLVFS::openAndLock(const std::string& filename, const char* mode, BOOL read_lock)
 {
 #if LL_WINDOWS
@@ -28,9 +28,11 @@
 #define LL_LLVFS_H
 
 #include <deque>
+#include <set>
 #include "lluuid.h"
 #include "llassettype.h"
 #include "llthread.h"
+#include "llatomic.h"
 
 enum EVFSValid 
 {
@@ -65,6 +67,17 @@ public:
 		const LLVFSBlock* lhs,
 		const LLVFSBlock* rhs);
 
+	// Orders by length, then by location (best fit first).
+	struct length_less
+	{
+		bool operator()(const LLVFSBlock* lhs, const LLVFSBlock* rhs) const
+		{
+			return (lhs->mLength == rhs->mLength)
+				? lhs->mLocation < rhs->mLocation
+				: lhs->mLength < rhs->mLength;
+		}
+	};
+
 public:
 	U32 mLocation;
 	S32	mLength;		// allocated block size
@@ -102,7 +115,8 @@ public:
 						  LLVFSFileBlock* const& second);
 	S32  mSize;
 	S32  mIndexLocation; // location of index entry
-	U32  mAccessTime;
+	// Atomic, lockDataView() updates it holding only the shared map lock.
+	LLAtomicU32 mAccessTime;
 	BOOL mLocks[VFSLOCK_COUNT]; // number of outstanding locks of each type
 
 	static const S32 SERIAL_SIZE;
@@ -118,20 +132,25 @@ private:
 			const std::string& data_filename, 
 			const BOOL read_only, 
 			const U32 presize, 
-			const BOOL remove_after_crash);
+			const BOOL remove_after_crash,
+			const BOOL use_mmap);
 public:
 	~LLVFS();
 
 	// Use this function normally to create LLVFS files
 	// Pass 0 to not presize
+	// Pass use_mmap to memory map the data file, which lets getData() run
+	// concurrently from several threads.
 	static LLVFS * createLLVFS(const std::string& index_filename, 
 			const std::string& data_filename, 
 			const BOOL read_only, 
 			const U32 presize, 
-			const BOOL remove_after_crash);
+			const BOOL remove_after_crash,
+			const BOOL use_mmap = FALSE);
 
 	BOOL isValid() const			{ return (VFSVALID_OK == mValid); }
 	EVFSValid getValidState() const	{ return mValid; }
+	BOOL isMemoryMapped() const		{ return mMappedData != NULL; }
 
 	// ---------- The following fucntions lock/unlock mDataMutex ----------
 	BOOL getExists(const LLUUID &file_id, const LLAssetType::EType file_type);
@@ -154,9 +173,34 @@ public:
 	BOOL isLocked(const LLUUID &file_id, const LLAssetType::EType file_type, EVFSLock lock);
 	// ----------------------------------------------------------------
 
+	// ---------- The following functions take a shared (read) lock ----------
+	// Zero-copy access to the bytes of a file in the memory mapped data file.
+	// Clamps length to what is available. On success the VFS stays read locked
+	// (writers block, other readers don't) until unlockDataView() is called,
+	// so keep the view short lived. Returns NULL with nothing locked if the
+	// data file isn't mapped or the file isn't (entirely) inside the mapping.
+	const U8* lockDataView(const LLUUID &file_id, const LLAssetType::EType file_type, S32 location, S32 &length);
+	void unlockDataView();
+	// ----------------------------------------------------------------
+
 	// Used to trigger evil WinXP behavior of "preloading" entire file into memory.
+	// Also does a bounded amount of compaction, see compact().
 	void pokeFiles();
 
+	// Online defragmentation: slides unlocked files down into the free
+	// space in front of them so that free space coalesces into fewer and
+	// larger blocks. Moves at most max_bytes of file data and returns
+	// the number of bytes that were moved. Each call picks up where the
+	// previous one stopped. A file's data is never overwritten before the
+	// index points at its new copy, so a crash loses no files. Does
+	// nothing unless needsCompaction() holds.
+	S32 compact(S32 max_bytes);
+
+	// Whether enough of the free space is scattered over holes outside the
+	// largest free block for compact() to be worth calling.  Only takes
+	// mDataMutex, so readers of the mapping are not held up.
+	BOOL needsCompaction();
+
 	// Verify that the index file contents match the in-memory file structure
 	// Very slow, do not call routinely. JC
 	void audit();
@@ -171,15 +215,41 @@ public:
 
 protected:
 	void removeFileBlock(LLVFSFileBlock *fileblock);
+
+	// Keep mFileBlocksByLocation up to date: erase a file block before its
+	// location changes or it stops holding space, add it again after.
+	void addFileLocation(LLVFSFileBlock *fileblock);
+	void eraseFileLocation(LLVFSFileBlock *fileblock);
+	// mDataMutex must be LOCKED before calling this.
+	BOOL isFragmented() const;
 	
+	void insertBlockLength(LLVFSBlock *block);
 	void eraseBlockLength(LLVFSBlock *block);
 	void eraseBlock(LLVFSBlock *block);
 	void addFreeBlock(LLVFSBlock *block);
+	// Best fit: the smallest free block of at least size bytes, or NULL.
+	LLVFSBlock *findFreeBlockLength(S32 size) const;
 	//void mergeFreeBlocks();
 	void useFreeSpace(LLVFSBlock *free_block, S32 length);
 	void sync(LLVFSFileBlock *block, BOOL remove = FALSE);
+	// sync() for a file that compact() moved, flushed to the index file.
+	void syncMoved(LLVFSFileBlock *block);
 	void presizeDataFile(const U32 size);
 
+	// mDataMutex must be LOCKED before calling these.
+	// They go through the mapping when possible and through mDataFP otherwise.
+	size_t readDataFile(U32 location, U8 *buffer, S32 length);
+	size_t writeDataFile(U32 location, const U8 *buffer, S32 length);
+
+	void mapDataFile();
+	void unmapDataFile();
+	// Extends the data file to at least min_size bytes, growing it
+	// geometrically, and maps it again.
+	void growMappedDataFile(U32 min_size);
+
+	// Opens and locks the data file.  With unbuffered set, stdio buffering is
+	// turned off before any I/O, as the mapping must see every write at once.
+	LLFILE *openDataFile(const char* mode, BOOL read_lock, BOOL unbuffered);
 	static LLFILE *openAndLock(const std::string& filename, const char* mode, BOOL read_lock);
 	static void unlockAndClose(FILE *fp);
 	
@@ -188,11 +258,21 @@ protected:
 	LLVFSBlock *findFreeBlock(S32 size, LLVFSFileBlock *immune = NULL);
 
 	// lock/unlock data mutex (mDataMutex)
-	void lockData() { mDataMutex->lock(); }
-	void unlockData() { mDataMutex->unlock(); }	
+	// When memory mapped this also takes mMapLock for writing, to exclude
+	// the readers that only hold mMapLock for reading.
+	void lockData() { mDataMutex->lock(); if (mMapLock) mMapLock->wrlock(); }
+	void unlockData() { if (mMapLock) mMapLock->wrunlock(); mDataMutex->unlock(); }
 	
 protected:
 	LLMutex* mDataMutex;
+	AIRWLock* mMapLock;				// Only allocated when using a memory mapped data file.
+
+	U8* mMappedData;
+	U32 mMappedSize;
+	BOOL mMapFailed;				// Mapping the data file failed, stop trying.
+#if LL_WINDOWS
+	void* mMappingHandle;
+#endif
 
 //<edit>
 public:
@@ -201,9 +281,20 @@ public:
 //</edit>
 protected:
 	fileblock_map mFileBlocks;
-
-	typedef std::multimap<S32, LLVFSBlock*>	blocks_length_map_t;
-	blocks_length_map_t 	mFreeBlocksByLength;
+	// The file blocks that hold space in the data file, by location.
+	typedef std::map<U32, LLVFSFileBlock*> files_location_map_t;
+	files_location_map_t mFileBlocksByLocation;
+
+	// Free blocks are binned by size class (the position of the highest set
+	// bit of their length). Within a bin they are ordered by length and
+	// location, so that best fit lookups and removals are O(log n) no
+	// matter how many free blocks share the same length.
+	enum { FREE_BIN_COUNT = 32 };
+	typedef std::set<LLVFSBlock*, LLVFSBlock::length_less> blocks_length_set_t;
+	blocks_length_set_t		mFreeBlocksByLength[FREE_BIN_COUNT];
+	S32						mFreeBlockCount;
+	U32						mFreeBytes;
+	static S32 getFreeBin(S32 length);
 	typedef std::multimap<U32, LLVFSBlock*>	blocks_location_map_t;
 	blocks_location_map_t 	mFreeBlocksByLocation;
 
@@ -220,6 +311,12 @@ protected:
 
 	S32 mLockCounts[VFSLOCK_COUNT];
 	BOOL mRemoveAfterCrash;
+
+	// Compaction statistics.
+	U64 mCompactedBytes;
+	U32 mCompactedFiles;
+	// Where the next compact() call starts looking for holes.
+	U32 mCompactCursor;
 };
 
 extern LLVFS *gVFS;
@@ -52,6 +52,7 @@
 #include "llmarketplacefunctions.h"
 #include "llmarketplacenotifications.h"
 #include "llmeshrepository.h"
+#include "llmessagereplay.h"
 #include "llmodaldialog.h"
 #include "llpumpio.h"
 #include "llmimetypes.h"
@@ -96,6 +97,7 @@
 #include "llavatarnamecache.h"
 #include "lldiriterator.h"
 #include "llimagej2c.h"
+#include "llimagej2coj.h"
 #include "llmemory.h"
 #include "llprimitive.h"
 #include "llurlaction.h"
@@ -209,6 +211,7 @@
 #include "llviewernetwork.h"
 
 #include <random>
+#include <thread>
 
 #ifdef USE_CRASHPAD
 #pragma warning(disable:4265)
@@ -396,6 +399,10 @@ LLAppViewer::LLUpdaterInfo *LLAppViewer::sUpdaterInfo = NULL ;
 //----------------------------------------------------------------------------
 static const F32 METRICS_INTERVAL_DEFAULT = 600.0;
 static const F32 METRICS_INTERVAL_QA = 30.0;
+
+// Idle time VFS compaction: how often, and how much file data at most.
+static const F32 VFS_COMPACT_INTERVAL = 2.f;
+static const S32 VFS_COMPACT_IDLE_BYTES = 1024 * 1024;
 static F32 app_metrics_interval = METRICS_INTERVAL_DEFAULT;
 static bool app_metrics_qa_mode = false;
 
@@ -2045,7 +2052,17 @@ bool LLAppViewer::initThreads()
 	LLLFSThread::initClass(enable_threads && false);
 
 	// Image decoding
-	LLAppViewer::sImageDecodeThread = new LLImageDecodeThread(enable_threads && true);
+	S32 decode_threads = gSavedSettings.getS32("ImageDecodeThreads");
+	if (decode_threads <= 0)
+	{
+		// Leave a core for the main thread and one for everything else.
+		decode_threads = (S32)std::thread::hardware_concurrency() - 2;
+	}
+	decode_threads = llclamp(decode_threads, 1, 32);
+	LLAppViewer::sImageDecodeThread = new LLImageDecodeThread(enable_threads && true, decode_threads);
+	// Threads per image on top of the pool, worth it for large textures when cores are idle
+	LLImageJ2COJ::setDecodeThreads(gSavedSettings.getS32("ImageDecodeThreadsPerImage"));
+	LLImageJ2COJ::setCPUFeatures(gSysCPU.hasSSE2(), gSysCPU.hasAVX2());
 	LLAppViewer::sTextureCache = new LLTextureCache(enable_threads && true);
 	LLAppViewer::sTextureFetch = new LLTextureFetch(LLAppViewer::getTextureCache(),
 													sImageDecodeThread,
@@ -3495,7 +3512,7 @@ void dumpVFSCaches()
 U32 LLAppViewer::getTextureCacheVersion()
 {
 	//viewer texture cache version, change if the texture cache format changes.
-	static const U32 TEXTURE_CACHE_VERSION = 8;
+	static const U32 TEXTURE_CACHE_VERSION = 9;
 
 	return TEXTURE_CACHE_VERSION ;
 }
@@ -3605,6 +3622,9 @@ bool LLAppViewer::initCache()
 	U64Bytes extra(LLAppViewer::getTextureCache()->initCache(LL_PATH_CACHE, texture_cache_size, texture_cache_mismatch));
 	texture_cache_size -= extra;
 
+	// The decoded mip tier has its own budget on top of CacheSize
+	LLAppViewer::getTextureCache()->initDecodedCache((U64)gSavedSettings.getU32("DecodedTextureCacheSize") * 1024 * 1024);
+
 	LLVOCache::getInstance()->initCache(LL_PATH_CACHE, gSavedSettings.getU32("CacheNumberOfRegionsForObjects"), getObjectCacheVersion()) ;
 
 	LLSplashScreen::update(LLTrans::getString("StartupInitializingVFS"));
@@ -3727,14 +3747,16 @@ bool LLAppViewer::initCache()
 	// Startup the VFS...
 	gSavedSettings.setU32("VFSSalt", new_salt);
 
+	const bool vfs_use_mmap = gSavedSettings.getBOOL("VFSUseMemoryMap");
+
 	// Don't remove VFS after viewer crashes.  If user has corrupt data, they can reinstall. JC
-	gVFS = LLVFS::createLLVFS(new_vfs_index_file, new_vfs_data_file, false, U32Bytes(vfs_size), false);
+	gVFS = LLVFS::createLLVFS(new_vfs_index_file, new_vfs_data_file, false, U32Bytes(vfs_size), false, vfs_use_mmap);
 	if (!gVFS)
 	{
 		return false;
 	}
 
-	gStaticVFS = LLVFS::createLLVFS(static_vfs_index_file, static_vfs_data_file, true, 0, false);
+	gStaticVFS = LLVFS::createLLVFS(static_vfs_index_file, static_vfs_data_file, true, 0, false, vfs_use_mmap);
 	if (!gStaticVFS)
 	{
 		return false;
@@ -4220,6 +4242,19 @@ void LLAppViewer::idle()
 		}
 	}
 
+	// Coalesce the free space of the VFS a little at a time.
+	{
+		static LLFrameTimer vfs_compact_timer;
+		if (gVFS && vfs_compact_timer.getElapsedTimeF32() > VFS_COMPACT_INTERVAL)
+		{
+			vfs_compact_timer.reset();
+			if (gVFS->needsCompaction())
+			{
+				gVFS->compact(VFS_COMPACT_IDLE_BYTES);
+			}
+		}
+	}
+
 	if (gDisconnected)
 	{
 		return;
@@ -4631,6 +4666,52 @@ static LLTrace::BlockTimerStatHandle FTM_TIMEOUT_CHECK("Timeout Check");
 static LLTrace::BlockTimerStatHandle FTM_DYNAMIC_THROTTLE("Dynamic Throttle");
 static LLTrace::BlockTimerStatHandle FTM_CHECK_REGION_CIRCUIT("Check Region Circuit");
 
+// Drives a replay requested through the MessageReplayFile debug setting.
+// Packets are delivered as if the agent's region sent them, since the
+// object update handlers need a live circuit and region for the sender.
+static LLMessageReplay* sMessageReplay = NULL;
+
+static void update_message_replay()
+{
+	if (!sMessageReplay)
+	{
+		if (LLStartUp::getStartupState() != STATE_STARTED || !gAgent.getRegion())
+		{
+			return;
+		}
+		static const LLCachedControl<std::string> replay_file(gSavedSettings, "MessageReplayFile");
+		if (replay_file().empty())
+		{
+			return;
+		}
+		std::string filename = gDirUtilp->getExpandedFilename(LL_PATH_LOGS, replay_file());
+		gSavedSettings.setString("MessageReplayFile", std::string());
+
+		sMessageReplay = new LLMessageReplay();
+		if (!sMessageReplay->load(filename))
+		{
+			delete sMessageReplay;
+			sMessageReplay = NULL;
+			return;
+		}
+		sMessageReplay->setRemapHost(gAgent.getRegion()->getHost());
+		sMessageReplay->setMaxSpeed(gSavedSettings.getBOOL("MessageReplayMaxSpeed"));
+		sMessageReplay->start();
+	}
+
+	sMessageReplay->update();
+
+	if (sMessageReplay->isDone())
+	{
+		sMessageReplay->stop();
+		std::ostringstream str;
+		sMessageReplay->dumpStats(str);
+		LL_INFOS("Messaging") << "Message replay finished\n" << str.str() << LL_ENDL;
+		delete sMessageReplay;
+		sMessageReplay = NULL;
+	}
+}
+
 void LLAppViewer::idleNetwork()
 {
 	pingMainloopTimeout("idleNetwork");
@@ -4644,6 +4725,8 @@ void LLAppViewer::idleNetwork()
 		LL_RECORD_BLOCK_TIME(FTM_IDLE_NETWORK); // decode
 		
 		LL_PUSH_CALLSTACKS();
+		update_message_replay();
+
 		LLTimer check_message_timer;
 		//  Read all available packets from network 
 		const S64 frame_count = gFrameCount;  // U32->S64
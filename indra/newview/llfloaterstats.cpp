@@ -317,6 +317,32 @@ void LLFloaterStats::buildStats()
 		net_statviewp->addStat("UDP Packets Out", &(LLViewerStats::getInstance()->mPacketsOutStat), params, "DebugStatModePacketsOut");
 	}
 
+	{
+		LLStatBar::Parameters params;
+		params.mUnitLabel = "/frame";
+		params.mPerSec = FALSE;
+		net_statviewp->addStat("UDP Receive Calls", &(LLViewerStats::getInstance()->mNetReceiveCallsStat), params, "DebugStatModeNetReceiveCalls");
+	}
+
+	{
+		LLStatBar::Parameters params;
+		params.mUnitLabel = "/frame";
+		params.mPerSec = FALSE;
+		net_statviewp->addStat("UDP Send Calls", &(LLViewerStats::getInstance()->mNetSendCallsStat), params, "DebugStatModeNetSendCalls");
+	}
+
+	if (gSavedSettings.getBOOL("NetworkReceiveThread"))
+	{
+		LLStatBar::Parameters params;
+		params.mUnitLabel = " ms";
+		params.mPerSec = FALSE;
+		params.mMinBar = 0.f;
+		params.mMaxBar = 200.f;
+		params.mTickSpacing = 50.f;
+		params.mLabelSpacing = 100.f;
+		net_statviewp->addStat("UDP Queue Delay", &(LLViewerStats::getInstance()->mNetQueueDelayStat), params, "DebugStatModeNetQueueDelay");
+	}
+
 	{
 		LLStatBar::Parameters params;
 		params.mUnitLabel = " kbps";
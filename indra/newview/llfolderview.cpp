@@ -380,6 +380,34 @@ U32 LLFolderView::getSearchType() const
 	return mSearchType;
 }
 
+void LLFolderView::addLabelSuffix(const std::string& suffix)
+{
+	std::string upper_suffix(suffix);
+	LLStringUtil::toUpper(upper_suffix);
+	mLabelSuffixes.insert(upper_suffix);
+}
+
+bool LLFolderView::mayMatchLabelSuffix(const std::string& substring) const
+{
+	for (std::set<std::string>::const_iterator it = mLabelSuffixes.begin(); it != mLabelSuffixes.end(); ++it)
+	{
+		const std::string& suffix = *it;
+		if (suffix.find(substring) != std::string::npos)
+		{
+			return true;
+		}
+		// The end of the string starting the suffix.
+		for (size_t start = 1; start < substring.size(); ++start)
+		{
+			if (suffix.compare(0, substring.size() - start, substring, start, std::string::npos) == 0)
+			{
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
 BOOL LLFolderView::addFolder( LLFolderViewFolder* folder)
 {
 	// enforce sort order of My Inventory followed by Library
@@ -262,6 +262,13 @@ public:
 	virtual S32	notify(const LLSD& info) ;
 	
 	bool useLabelSuffix() { return mUseLabelSuffix; }
+	// Label suffixes shown in this view, which the filter searches along
+	// with the labels.
+	void addLabelSuffix(const std::string& suffix);
+	U32 getLabelSuffixCount() const { return (U32)mLabelSuffixes.size(); }
+	// Whether substring, in upper case, may match inside a label suffix or
+	// run from a label into one.
+	bool mayMatchLabelSuffix(const std::string& substring) const;
 	virtual void updateMenu();
 	void saveFolderState();
 	void restoreFolderState();
@@ -333,6 +340,7 @@ protected:
 	S32								mMinWidth;
 	S32								mRunningHeight;
 	boost::unordered_map<LLUUID, LLFolderViewItem*> mItemMap;
+	std::set<std::string>			mLabelSuffixes;	// upper case
 	LLUUID							mSelectThisID; // if non null, select this item
 	
 	LLHandle<LLPanel>				mParentPanel;
@@ -254,7 +254,15 @@ void LLFolderViewItem::refreshFromListener()
 		if (mRoot->useLabelSuffix())
 		{
 			mLabelStyle = mListener->getLabelStyle();
-			mLabelSuffix = mListener->getLabelSuffix();
+			std::string suffix = mListener->getLabelSuffix();
+			if (suffix != mLabelSuffix)
+			{
+				mLabelSuffix.swap(suffix);
+				if (!mLabelSuffix.empty())
+				{
+					mRoot->addLabelSuffix(mLabelSuffix);
+				}
+			}
 		}
 		
 		updateExtraSearchCriteria();
@@ -462,6 +470,16 @@ void LLFolderViewItem::filter( LLInventoryFilter& filter)
 	}
 }
 
+void LLFolderViewItem::filterOut( LLInventoryFilter& filter)
+{
+	if (mParentFolder && (getVisible() || mPassedFilter))
+	{
+		mParentFolder->requestArrange();
+	}
+	setFiltered(FALSE, filter.getCurrentGeneration());
+	mStringMatchOffset = std::string::npos;
+}
+
 void LLFolderViewItem::dirtyFilter()
 {
 	mLastFilterGeneration = -1;
@@ -1491,6 +1509,13 @@ void LLFolderViewFolder::filter( LLInventoryFilter& filter)
 			continue;
 		}
 
+		// the search index shows nothing in there can match
+		if (filter.canSkipFolder(folder))
+		{
+			folder->filterOut( filter );
+			continue;
+		}
+
 		// update this folders filter status (and children)
 		folder->filter( filter );
 
@@ -1534,6 +1559,12 @@ void LLFolderViewFolder::filter( LLInventoryFilter& filter)
 			continue;
 		}
 
+		if (filter.canSkipItem(item))
+		{
+			item->filterOut( filter );
+			continue;
+		}
+
 		item->filter( filter );
 
 		if (item->getFiltered(filter.getFirstSuccessGeneration()))
@@ -1553,6 +1584,13 @@ void LLFolderViewFolder::filter( LLInventoryFilter& filter)
 	}
 }
 
+void LLFolderViewFolder::filterOut( LLInventoryFilter& filter)
+{
+	// Nothing below can pass either.
+	LLFolderViewItem::filterOut(filter);
+	setCompletedFilterGeneration(filter.getCurrentGeneration(), FALSE);
+}
+
 void LLFolderViewFolder::filterFolder(LLInventoryFilter& filter)
 {
 	const BOOL previous_passed_filter = mPassedFolderFilter;
@@ -198,6 +198,8 @@ public:
 
 	// applies filters to control visibility of inventory items
 	virtual void filter( LLInventoryFilter& filter);
+	// fails the filter without checking, for what the filter can skip
+	virtual void filterOut( LLInventoryFilter& filter);
 
 	// updates filter serial number and optionally propagated value up to root
 	S32		getLastFilterGeneration() { return mLastFilterGeneration; }
@@ -264,6 +266,8 @@ public:
 	// method was primarily added to allow sorting on the folder
 	// contents possible before the entire view has been constructed.
 	const std::string& getLabel() const { return mLabel; }
+	// Status appended to the label, e.g. " (worn)"; searched with it.
+	const std::string& getLabelSuffix() const { return mLabelSuffix; }
 
 	// Used for sorting, like getLabel() above.
 	virtual time_t getCreationDate() const { return mCreationDate; }
@@ -433,6 +437,7 @@ public:
 
 	// applies filters to control visibility of inventory items
 	virtual void filter( LLInventoryFilter& filter);
+	virtual void filterOut( LLInventoryFilter& filter);
 	virtual void setFiltered(BOOL filtered, S32 filter_generation);
 	virtual BOOL getFiltered();
 	virtual BOOL getFiltered(S32 filter_generation);
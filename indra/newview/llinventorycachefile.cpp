@@ -0,0 +1,1122 @@
+/**
+ * @file llinventorycachefile.cpp
+ * @brief Binary, memory mappable inventory cache
+ *
+ * $LicenseInfo:firstyear=2026&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2026, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "llviewerprecompiledheaders.h"
+
+#include "llinventorycachefile.h"
+
+#include "llcrc.h"
+#include "llparallelfor.h"
+#include "llviewerinventory.h"
+
+#if LL_WINDOWS
+#include <io.h>
+#include "llwin32headerslean.h"
+#else
+#include <sys/mman.h>
+#endif
+
+static const char * const LOG_INV("Inventory");
+
+///----------------------------------------------------------------------------
+/// File layout
+///----------------------------------------------------------------------------
+//
+// CacheHeader, then the columns listed in CacheHeader::mColumns, each
+// starting on an 8 byte boundary, then any number of appended records:
+// a DeltaHeader followed by mSize bytes.  Category and item records hold
+// one row in the form write_row() produces; removals hold just the id.
+// Everything is stored in the byte order of the writing machine; any other
+// machine fails the magic check.
+
+namespace
+{
+	const char CACHE_MAGIC[8] = { 'L', 'L', 'I', 'N', 'V', 'B', 'I', 'N' };
+	// Increment this whenever the layout below changes.
+	const U32 CACHE_FORMAT_VERSION = 1;
+	const U32 DELTA_MAGIC = 0x44564e49;		// "INVD"
+
+	// Appended records may grow up to this fraction of the snapshot.
+	const U64 MAX_DELTA_FRACTION = 4;
+
+	enum EColumn
+	{
+		CAT_ID,
+		CAT_PARENT,
+		CAT_OWNER,
+		CAT_VERSION,
+		CAT_PREFERRED_TYPE,
+		CAT_NAME,				// U32 offset into STRING_POOL, U32 length
+		CAT_HASH,				// row_hash() of each row
+		ITEM_ID,
+		ITEM_PARENT,
+		ITEM_ASSET,
+		ITEM_CREATOR,
+		ITEM_OWNER,
+		ITEM_LAST_OWNER,
+		ITEM_GROUP,
+		ITEM_MASKS,				// base, owner, group, everyone, next owner
+		ITEM_FLAGS,
+		ITEM_CREATION_DATE,
+		ITEM_SALE_PRICE,
+		ITEM_TYPES,				// asset type, inventory type, sale type, 0
+		ITEM_NAME,
+		ITEM_DESCRIPTION,
+		ITEM_HASH,
+		STRING_POOL,
+		COLUMN_COUNT
+	};
+
+	// Bytes per row; the string pool has no rows.
+	const U64 COLUMN_ROW_SIZE[COLUMN_COUNT] =
+	{
+		UUID_BYTES, UUID_BYTES, UUID_BYTES, 4, 1, 8, 8,
+		UUID_BYTES, UUID_BYTES, UUID_BYTES, UUID_BYTES, UUID_BYTES, UUID_BYTES, UUID_BYTES,
+		20, 4, 4, 4, 4, 8, 8, 8,
+		0
+	};
+
+	struct ColumnInfo
+	{
+		U64 mOffset;
+		U64 mSize;
+		U32 mCRC;
+		U32 mReserved;
+	};
+
+	struct CacheHeader
+	{
+		char mMagic[8];
+		U32 mFormatVersion;
+		S32 mContentVersion;	// LLInventoryModel::sCurrentInvCacheVersion
+		U32 mColumnCount;
+		U32 mCategoryCount;
+		U32 mItemCount;
+		U32 mReserved;
+		U64 mSnapshotSize;		// header and columns; appended records follow
+		ColumnInfo mColumns[COLUMN_COUNT];
+	};
+
+	enum EDeltaKind
+	{
+		DELTA_CATEGORY = 1,
+		DELTA_ITEM = 2,
+		DELTA_REMOVE = 3
+	};
+
+	struct DeltaHeader
+	{
+		U32 mMagic;
+		U32 mKind;
+		U32 mSize;
+		U32 mCRC;
+	};
+
+	// One category or item, with the strings pointing into the object or the
+	// mapped file.
+	struct CategoryFields
+	{
+		LLUUID mID;
+		LLUUID mParentID;
+		LLUUID mOwnerID;
+		S32 mVersion;
+		S8 mPreferredType;
+		const char* mName;
+		U32 mNameLength;
+	};
+
+	struct ItemFields
+	{
+		LLUUID mID;
+		LLUUID mParentID;
+		LLUUID mAssetID;
+		LLUUID mCreatorID;
+		LLUUID mOwnerID;
+		LLUUID mLastOwnerID;
+		LLUUID mGroupID;
+		U32 mMasks[5];
+		U32 mFlags;
+		S32 mCreationDate;
+		S32 mSalePrice;
+		U8 mTypes[4];
+		const char* mName;
+		U32 mNameLength;
+		const char* mDescription;
+		U32 mDescriptionLength;
+	};
+
+	U32 compute_crc(const U8* data, size_t size)
+	{
+		LLCRC crc;
+		crc.update(data, size);
+		return crc.getCRC();
+	}
+
+	// 64 bit FNV-1a, to notice changed rows between saves.
+	U64 row_hash(const std::string& row)
+	{
+		U64 hash = 14695981039346656037ULL;
+		for (std::string::const_iterator it = row.begin(); it != row.end(); ++it)
+		{
+			hash ^= (U8)*it;
+			hash *= 1099511628211ULL;
+		}
+		return hash;
+	}
+
+	template<class T>
+	inline void append(std::string& out, const T& value)
+	{
+		out.append((const char*)&value, sizeof(T));
+	}
+
+	inline void append(std::string& out, const LLUUID& id)
+	{
+		out.append((const char*)id.mData, UUID_BYTES);
+	}
+
+	// Bounds checked reads from a record.
+	class RowReader
+	{
+	public:
+		RowReader(const U8* data, size_t size) : mPos(data), mEnd(data + size), mOK(true) {}
+
+		template<class T>
+		void read(T& value)
+		{
+			readBytes(&value, sizeof(T));
+		}
+
+		void read(LLUUID& id)
+		{
+			readBytes(id.mData, UUID_BYTES);
+		}
+
+		const char* readString(U32 length)
+		{
+			if (!mOK || (size_t)(mEnd - mPos) < length)
+			{
+				mOK = false;
+				return "";
+			}
+			const char* str = (const char*)mPos;
+			mPos += length;
+			return str;
+		}
+
+		bool done() const { return mOK && mPos == mEnd; }
+
+	private:
+		void readBytes(void* dest, size_t size)
+		{
+			if (!mOK || (size_t)(mEnd - mPos) < size)
+			{
+				mOK = false;
+				memset(dest, 0, size);
+				return;
+			}
+			memcpy(dest, mPos, size);
+			mPos += size;
+		}
+
+		const U8* mPos;
+		const U8* mEnd;
+		bool mOK;
+	};
+
+	void get_fields(const LLViewerInventoryCategory* cat, CategoryFields& fields)
+	{
+		fields.mID = cat->getUUID();
+		fields.mParentID = cat->getParentUUID();
+		fields.mOwnerID = cat->getOwnerID();
+		fields.mVersion = cat->getVersion();
+		fields.mPreferredType = (S8)cat->getPreferredType();
+		const std::string& name = cat->getName();
+		fields.mName = name.data();
+		fields.mNameLength = (U32)name.size();
+	}
+
+	// Like LLInventoryItem::exportFile(), this stores the item itself, not
+	// what a link resolves to, hence the qualified calls.
+	void get_fields(const LLViewerInventoryItem* item, ItemFields& fields)
+	{
+		const LLPermissions& perm = item->LLInventoryItem::getPermissions();
+		const LLSaleInfo& sale_info = item->LLInventoryItem::getSaleInfo();
+		fields.mID = item->getUUID();
+		fields.mParentID = item->getParentUUID();
+		fields.mAssetID = item->LLInventoryItem::getAssetUUID();
+		fields.mCreatorID = perm.getCreator();
+		fields.mOwnerID = perm.getOwner();
+		fields.mLastOwnerID = perm.getLastOwner();
+		fields.mGroupID = perm.getGroup();
+		fields.mMasks[0] = perm.getMaskBase();
+		fields.mMasks[1] = perm.getMaskOwner();
+		fields.mMasks[2] = perm.getMaskGroup();
+		fields.mMasks[3] = perm.getMaskEveryone();
+		fields.mMasks[4] = perm.getMaskNextOwner();
+		fields.mFlags = item->LLInventoryItem::getFlags();
+		fields.mCreationDate = (S32)item->LLInventoryItem::getCreationDate();
+		fields.mSalePrice = sale_info.getSalePrice();
+		fields.mTypes[0] = (U8)(S8)item->LLInventoryItem::getType();
+		fields.mTypes[1] = (U8)(S8)item->LLInventoryItem::getInventoryType();
+		fields.mTypes[2] = (U8)sale_info.getSaleType();
+		fields.mTypes[3] = 0;
+		const std::string& name = item->LLInventoryItem::getName();
+		fields.mName = name.data();
+		fields.mNameLength = (U32)name.size();
+		const std::string& desc = item->LLInventoryItem::getDescription();
+		fields.mDescription = desc.data();
+		fields.mDescriptionLength = (U32)desc.size();
+	}
+
+	void write_row(const CategoryFields& fields, std::string& out)
+	{
+		append(out, fields.mID);
+		append(out, fields.mParentID);
+		append(out, fields.mOwnerID);
+		append(out, fields.mVersion);
+		append(out, fields.mPreferredType);
+		append(out, fields.mNameLength);
+		out.append(fields.mName, fields.mNameLength);
+	}
+
+	void write_row(const ItemFields& fields, std::string& out)
+	{
+		append(out, fields.mID);
+		append(out, fields.mParentID);
+		append(out, fields.mAssetID);
+		append(out, fields.mCreatorID);
+		append(out, fields.mOwnerID);
+		append(out, fields.mLastOwnerID);
+		append(out, fields.mGroupID);
+		out.append((const char*)fields.mMasks, sizeof(fields.mMasks));
+		append(out, fields.mFlags);
+		append(out, fields.mCreationDate);
+		append(out, fields.mSalePrice);
+		out.append((const char*)fields.mTypes, sizeof(fields.mTypes));
+		append(out, fields.mNameLength);
+		append(out, fields.mDescriptionLength);
+		out.append(fields.mName, fields.mNameLength);
+		out.append(fields.mDescription, fields.mDescriptionLength);
+	}
+
+	bool read_row(const U8* data, size_t size, CategoryFields& fields)
+	{
+		RowReader reader(data, size);
+		reader.read(fields.mID);
+		reader.read(fields.mParentID);
+		reader.read(fields.mOwnerID);
+		reader.read(fields.mVersion);
+		reader.read(fields.mPreferredType);
+		reader.read(fields.mNameLength);
+		fields.mName = reader.readString(fields.mNameLength);
+		return reader.done();
+	}
+
+	bool read_row(const U8* data, size_t size, ItemFields& fields)
+	{
+		RowReader reader(data, size);
+		reader.read(fields.mID);
+		reader.read(fields.mParentID);
+		reader.read(fields.mAssetID);
+		reader.read(fields.mCreatorID);
+		reader.read(fields.mOwnerID);
+		reader.read(fields.mLastOwnerID);
+		reader.read(fields.mGroupID);
+		reader.read(fields.mMasks);
+		reader.read(fields.mFlags);
+		reader.read(fields.mCreationDate);
+		reader.read(fields.mSalePrice);
+		reader.read(fields.mTypes);
+		reader.read(fields.mNameLength);
+		reader.read(fields.mDescriptionLength);
+		fields.mName = reader.readString(fields.mNameLength);
+		fields.mDescription = reader.readString(fields.mDescriptionLength);
+		return reader.done();
+	}
+
+	LLViewerInventoryCategory* create_category(const CategoryFields& fields)
+	{
+		LLViewerInventoryCategory* cat = new LLViewerInventoryCategory(
+			fields.mID, fields.mParentID, (LLFolderType::EType)fields.mPreferredType,
+			std::string(fields.mName, fields.mNameLength), fields.mOwnerID);
+		cat->setVersion(fields.mVersion);
+		return cat;
+	}
+
+	LLViewerInventoryItem* create_item(const ItemFields& fields)
+	{
+		LLPermissions perm;
+		perm.init(fields.mCreatorID, fields.mOwnerID, fields.mLastOwnerID, fields.mGroupID);
+		perm.setMaskBase(fields.mMasks[0]);
+		perm.setMaskOwner(fields.mMasks[1]);
+		perm.setMaskGroup(fields.mMasks[2]);
+		perm.setMaskEveryone(fields.mMasks[3]);
+		perm.setMaskNext(fields.mMasks[4]);
+		perm.fix();
+		LLSaleInfo sale_info((LLSaleInfo::EForSale)fields.mTypes[2], fields.mSalePrice);
+		LLViewerInventoryItem* item = new LLViewerInventoryItem(
+			fields.mID, fields.mParentID, perm, fields.mAssetID,
+			(LLAssetType::EType)(S8)fields.mTypes[0], (LLInventoryType::EType)(S8)fields.mTypes[1],
+			std::string(fields.mName, fields.mNameLength),
+			std::string(fields.mDescription, fields.mDescriptionLength),
+			sale_info, fields.mFlags, (time_t)fields.mCreationDate);
+		// As with the text cache: usable in the UI, fetched before use.
+		item->setComplete(FALSE);
+		return item;
+	}
+
+	///------------------------------------------------------------------------
+	/// CacheView: a mapped, validated cache file
+	///------------------------------------------------------------------------
+
+	class CacheView
+	{
+	public:
+		struct Delta
+		{
+			U32 mKind;
+			const U8* mData;
+			U32 mSize;
+		};
+		typedef std::vector<Delta> delta_list_t;
+
+		CacheView();
+		~CacheView() { close(); }
+
+		// Maps filename and checks the snapshot and appended records.
+		bool open(const std::string& filename, S32 content_version);
+		void close();
+
+		const CacheHeader& header() const		{ return mHeader; }
+		const delta_list_t& deltas() const		{ return mDeltas; }
+		U64 deltaBytes() const					{ return mSize - mHeader.mSnapshotSize; }
+		// False if the file ends in a record that failed its checks, e.g.
+		// from an interrupted save; nothing can be appended after it.
+		bool endsCleanly() const				{ return mEndsCleanly; }
+
+		bool readCategory(U32 index, CategoryFields& fields) const;
+		bool readItem(U32 index, ItemFields& fields) const;
+		U64 categoryHash(U32 index) const		{ return readColumn<U64>(CAT_HASH, index); }
+		U64 itemHash(U32 index) const			{ return readColumn<U64>(ITEM_HASH, index); }
+
+	private:
+		bool validate(const std::string& filename, S32 content_version);
+		void readDeltas(const std::string& filename);
+
+		const U8* column(EColumn col) const		{ return mData + mHeader.mColumns[col].mOffset; }
+
+		template<class T>
+		T readColumn(EColumn col, U32 index) const
+		{
+			T value;
+			memcpy(&value, column(col) + (size_t)index * sizeof(T), sizeof(T));
+			return value;
+		}
+
+		LLUUID readUUID(EColumn col, U32 index) const
+		{
+			LLUUID id;
+			memcpy(id.mData, column(col) + (size_t)index * UUID_BYTES, UUID_BYTES);
+			return id;
+		}
+
+		const char* readString(EColumn col, U32 index, U32& length) const;
+
+		CacheHeader mHeader;
+		delta_list_t mDeltas;
+		bool mEndsCleanly;
+
+		const U8* mData;
+		U64 mSize;
+		LLFILE* mFile;
+		void* mMapped;
+#if LL_WINDOWS
+		HANDLE mMappingHandle;
+#endif
+		std::vector<U8> mBuffer;	// when the file cannot be mapped
+	};
+
+	CacheView::CacheView()
+		: mEndsCleanly(false),
+		  mData(NULL),
+		  mSize(0),
+		  mFile(NULL),
+		  mMapped(NULL)
+#if LL_WINDOWS
+		  , mMappingHandle(NULL)
+#endif
+	{
+		memset(&mHeader, 0, sizeof(mHeader));
+	}
+
+	bool CacheView::open(const std::string& filename, S32 content_version)
+	{
+		mFile = LLFile::fopen(filename, "rb");		/*Flawfinder: ignore*/
+		if (!mFile)
+		{
+			return false;
+		}
+		fseek(mFile, 0, SEEK_END);
+		long file_size = ftell(mFile);
+		if (file_size < (long)sizeof(CacheHeader))
+		{
+			LL_WARNS(LOG_INV) << "Inventory cache " << filename << " is truncated" << LL_ENDL;
+			close();
+			return false;
+		}
+		mSize = (U64)file_size;
+
+#if LL_WINDOWS
+		HANDLE file_handle = (HANDLE)_get_osfhandle(_fileno(mFile));
+		mMappingHandle = CreateFileMapping(file_handle, NULL, PAGE_READONLY, 0, 0, NULL);
+		if (mMappingHandle)
+		{
+			mMapped = MapViewOfFile(mMappingHandle, FILE_MAP_READ, 0, 0, 0);
+			if (!mMapped)
+			{
+				CloseHandle(mMappingHandle);
+				mMappingHandle = NULL;
+			}
+		}
+#else
+		void* data = mmap(NULL, (size_t)mSize, PROT_READ, MAP_SHARED, fileno(mFile), 0);
+		if (data != MAP_FAILED)
+		{
+			mMapped = data;
+		}
+#endif
+		if (mMapped)
+		{
+			mData = (const U8*)mMapped;
+		}
+		else
+		{
+			LL_DEBUGS(LOG_INV) << "Failed to map " << filename << ", reading it instead" << LL_ENDL;
+			mBuffer.resize((size_t)mSize);
+			fseek(mFile, 0, SEEK_SET);
+			if (fread(&mBuffer[0], 1, mBuffer.size(), mFile) != mBuffer.size())
+			{
+				LL_WARNS(LOG_INV) << "Unable to read inventory cache " << filename << LL_ENDL;
+				close();
+				return false;
+			}
+			mData = &mBuffer[0];
+		}
+
+		if (!validate(filename, content_version))
+		{
+			close();
+			return false;
+		}
+		readDeltas(filename);
+		return true;
+	}
+
+	void CacheView::close()
+	{
+		if (mMapped)
+		{
+#if LL_WINDOWS
+			UnmapViewOfFile(mMapped);
+			CloseHandle(mMappingHandle);
+			mMappingHandle = NULL;
+#else
+			munmap(mMapped, (size_t)mSize);
+#endif
+			mMapped = NULL;
+		}
+		if (mFile)
+		{
+			LLFile::close(mFile);
+			mFile = NULL;
+		}
+		std::vector<U8>().swap(mBuffer);
+		mData = NULL;
+		mSize = 0;
+		mDeltas.clear();
+	}
+
+	bool CacheView::validate(const std::string& filename, S32 content_version)
+	{
+		memcpy(&mHeader, mData, sizeof(mHeader));
+		if (memcmp(mHeader.mMagic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0
+			|| mHeader.mFormatVersion != CACHE_FORMAT_VERSION
+			|| mHeader.mColumnCount != COLUMN_COUNT)
+		{
+			LL_INFOS(LOG_INV) << "Inventory cache " << filename << " has an unknown format" << LL_ENDL;
+			return false;
+		}
+		if (mHeader.mContentVersion != content_version)
+		{
+			LL_INFOS(LOG_INV) << "Inventory cache " << filename << " is out of date" << LL_ENDL;
+			return false;
+		}
+		if (mHeader.mSnapshotSize < sizeof(CacheHeader) || mHeader.mSnapshotSize > mSize)
+		{
+			LL_WARNS(LOG_INV) << "Inventory cache " << filename << " is truncated" << LL_ENDL;
+			return false;
+		}
+
+		for (U32 col = 0; col < COLUMN_COUNT; ++col)
+		{
+			const ColumnInfo& info = mHeader.mColumns[col];
+			U64 rows = (col < ITEM_ID) ? mHeader.mCategoryCount : mHeader.mItemCount;
+			if (info.mOffset < sizeof(CacheHeader)
+				|| info.mOffset > mHeader.mSnapshotSize
+				|| info.mSize > mHeader.mSnapshotSize - info.mOffset
+				|| (col != STRING_POOL && info.mSize != rows * COLUMN_ROW_SIZE[col]))
+			{
+				LL_WARNS(LOG_INV) << "Inventory cache " << filename << " has a bad column " << col << LL_ENDL;
+				return false;
+			}
+		}
+
+		// The columns are checked side by side; the string pool and the ids
+		// are the big ones.
+		U32 crc_ok[COLUMN_COUNT];
+		ll_parallel_for(COLUMN_COUNT, 1, [&](size_t begin, size_t end)
+		{
+			for (size_t col = begin; col < end; ++col)
+			{
+				const ColumnInfo& info = mHeader.mColumns[col];
+				crc_ok[col] = (compute_crc(mData + info.mOffset, (size_t)info.mSize) == info.mCRC);
+			}
+		});
+		for (U32 col = 0; col < COLUMN_COUNT; ++col)
+		{
+			if (!crc_ok[col])
+			{
+				LL_WARNS(LOG_INV) << "Inventory cache " << filename << " failed the checksum of column " << col << LL_ENDL;
+				return false;
+			}
+		}
+		return true;
+	}
+
+	void CacheView::readDeltas(const std::string& filename)
+	{
+		mEndsCleanly = true;
+		U64 offset = mHeader.mSnapshotSize;
+		while (offset < mSize)
+		{
+			DeltaHeader delta_header;
+			if (mSize - offset < sizeof(DeltaHeader))
+			{
+				mEndsCleanly = false;
+				break;
+			}
+			memcpy(&delta_header, mData + offset, sizeof(DeltaHeader));
+			offset += sizeof(DeltaHeader);
+			if (delta_header.mMagic != DELTA_MAGIC
+				|| delta_header.mSize > mSize - offset
+				|| compute_crc(mData + offset, delta_header.mSize) != delta_header.mCRC)
+			{
+				mEndsCleanly = false;
+				break;
+			}
+			Delta delta = { delta_header.mKind, mData + offset, delta_header.mSize };
+			if (delta.mSize >= UUID_BYTES)
+			{
+				mDeltas.push_back(delta);
+			}
+			offset += delta_header.mSize;
+		}
+		if (!mEndsCleanly)
+		{
+			LL_WARNS(LOG_INV) << "Ignoring damaged records at the end of inventory cache " << filename << LL_ENDL;
+		}
+	}
+
+	const char* CacheView::readString(EColumn col, U32 index, U32& length) const
+	{
+		U32 ref[2];
+		memcpy(ref, column(col) + (size_t)index * sizeof(ref), sizeof(ref));
+		const ColumnInfo& pool = mHeader.mColumns[STRING_POOL];
+		if ((U64)ref[0] + ref[1] > pool.mSize)
+		{
+			length = 0;
+			return NULL;
+		}
+		length = ref[1];
+		return (const char*)column(STRING_POOL) + ref[0];
+	}
+
+	bool CacheView::readCategory(U32 index, CategoryFields& fields) const
+	{
+		fields.mID = readUUID(CAT_ID, index);
+		fields.mParentID = readUUID(CAT_PARENT, index);
+		fields.mOwnerID = readUUID(CAT_OWNER, index);
+		fields.mVersion = readColumn<S32>(CAT_VERSION, index);
+		fields.mPreferredType = readColumn<S8>(CAT_PREFERRED_TYPE, index);
+		fields.mName = readString(CAT_NAME, index, fields.mNameLength);
+		return fields.mName != NULL;
+	}
+
+	bool CacheView::readItem(U32 index, ItemFields& fields) const
+	{
+		fields.mID = readUUID(ITEM_ID, index);
+		fields.mParentID = readUUID(ITEM_PARENT, index);
+		fields.mAssetID = readUUID(ITEM_ASSET, index);
+		fields.mCreatorID = readUUID(ITEM_CREATOR, index);
+		fields.mOwnerID = readUUID(ITEM_OWNER, index);
+		fields.mLastOwnerID = readUUID(ITEM_LAST_OWNER, index);
+		fields.mGroupID = readUUID(ITEM_GROUP, index);
+		memcpy(fields.mMasks, column(ITEM_MASKS) + (size_t)index * sizeof(fields.mMasks), sizeof(fields.mMasks));
+		fields.mFlags = readColumn<U32>(ITEM_FLAGS, index);
+		fields.mCreationDate = readColumn<S32>(ITEM_CREATION_DATE, index);
+		fields.mSalePrice = readColumn<S32>(ITEM_SALE_PRICE, index);
+		memcpy(fields.mTypes, column(ITEM_TYPES) + (size_t)index * sizeof(fields.mTypes), sizeof(fields.mTypes));
+		fields.mName = readString(ITEM_NAME, index, fields.mNameLength);
+		fields.mDescription = readString(ITEM_DESCRIPTION, index, fields.mDescriptionLength);
+		return fields.mName != NULL && fields.mDescription != NULL;
+	}
+
+	LLUUID delta_id(const CacheView::Delta& delta)
+	{
+		LLUUID id;
+		memcpy(id.mData, delta.mData, UUID_BYTES);
+		return id;
+	}
+
+	// Appends a record to out.
+	void append_delta(std::string& out, U32 kind, const std::string& payload)
+	{
+		DeltaHeader delta_header;
+		delta_header.mMagic = DELTA_MAGIC;
+		delta_header.mKind = kind;
+		delta_header.mSize = (U32)payload.size();
+		delta_header.mCRC = compute_crc((const U8*)payload.data(), payload.size());
+		append(out, delta_header);
+		out.append(payload);
+	}
+
+	///------------------------------------------------------------------------
+	/// Writing
+	///------------------------------------------------------------------------
+
+	class SnapshotWriter
+	{
+	public:
+		SnapshotWriter(U32 category_count, U32 item_count);
+
+		void addCategory(U32 index, const CategoryFields& fields, U64 hash);
+		void addItem(U32 index, const ItemFields& fields, U64 hash);
+
+		bool write(const std::string& filename, S32 content_version);
+
+	private:
+		U8* row(EColumn col, U32 index)	{ return (U8*)&mColumns[col][(size_t)index * COLUMN_ROW_SIZE[col]]; }
+
+		void putUUID(EColumn col, U32 index, const LLUUID& id)
+		{
+			memcpy(row(col, index), id.mData, UUID_BYTES);
+		}
+
+		template<class T>
+		void put(EColumn col, U32 index, const T& value)
+		{
+			memcpy(row(col, index), &value, sizeof(T));
+		}
+
+		void putString(EColumn col, U32 index, const char* str, U32 length);
+
+		U32 mCategoryCount;
+		U32 mItemCount;
+		std::string mColumns[COLUMN_COUNT];
+	};
+
+	SnapshotWriter::SnapshotWriter(U32 category_count, U32 item_count)
+		: mCategoryCount(category_count),
+		  mItemCount(item_count)
+	{
+		for (U32 col = 0; col < STRING_POOL; ++col)
+		{
+			U32 rows = (col < ITEM_ID) ? category_count : item_count;
+			mColumns[col].resize((size_t)rows * COLUMN_ROW_SIZE[col]);
+		}
+	}
+
+	void SnapshotWriter::putString(EColumn col, U32 index, const char* str, U32 length)
+	{
+		U32 ref[2] = { (U32)mColumns[STRING_POOL].size(), length };
+		memcpy(row(col, index), ref, sizeof(ref));
+		mColumns[STRING_POOL].append(str, length);
+	}
+
+	void SnapshotWriter::addCategory(U32 index, const CategoryFields& fields, U64 hash)
+	{
+		putUUID(CAT_ID, index, fields.mID);
+		putUUID(CAT_PARENT, index, fields.mParentID);
+		putUUID(CAT_OWNER, index, fields.mOwnerID);
+		put(CAT_VERSION, index, fields.mVersion);
+		put(CAT_PREFERRED_TYPE, index, fields.mPreferredType);
+		putString(CAT_NAME, index, fields.mName, fields.mNameLength);
+		put(CAT_HASH, index, hash);
+	}
+
+	void SnapshotWriter::addItem(U32 index, const ItemFields& fields, U64 hash)
+	{
+		putUUID(ITEM_ID, index, fields.mID);
+		putUUID(ITEM_PARENT, index, fields.mParentID);
+		putUUID(ITEM_ASSET, index, fields.mAssetID);
+		putUUID(ITEM_CREATOR, index, fields.mCreatorID);
+		putUUID(ITEM_OWNER, index, fields.mOwnerID);
+		putUUID(ITEM_LAST_OWNER, index, fields.mLastOwnerID);
+		putUUID(ITEM_GROUP, index, fields.mGroupID);
+		put(ITEM_MASKS, index, fields.mMasks);
+		put(ITEM_FLAGS, index, fields.mFlags);
+		put(ITEM_CREATION_DATE, index, fields.mCreationDate);
+		put(ITEM_SALE_PRICE, index, fields.mSalePrice);
+		put(ITEM_TYPES, index, fields.mTypes);
+		putString(ITEM_NAME, index, fields.mName, fields.mNameLength);
+		putString(ITEM_DESCRIPTION, index, fields.mDescription, fields.mDescriptionLength);
+		put(ITEM_HASH, index, hash);
+	}
+
+	bool SnapshotWriter::write(const std::string& filename, S32 content_version)
+	{
+		CacheHeader header;
+		memset(&header, 0, sizeof(header));
+		memcpy(header.mMagic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+		header.mFormatVersion = CACHE_FORMAT_VERSION;
+		header.mContentVersion = content_version;
+		header.mColumnCount = COLUMN_COUNT;
+		header.mCategoryCount = mCategoryCount;
+		header.mItemCount = mItemCount;
+
+		U64 offset = (sizeof(CacheHeader) + 7) & ~7ULL;
+		for (U32 col = 0; col < COLUMN_COUNT; ++col)
+		{
+			ColumnInfo& info = header.mColumns[col];
+			info.mOffset = offset;
+			info.mSize = mColumns[col].size();
+			offset = (offset + info.mSize + 7) & ~7ULL;
+		}
+		header.mSnapshotSize = offset;
+		ll_parallel_for(COLUMN_COUNT, 1, [&](size_t begin, size_t end)
+		{
+			for (size_t col = begin; col < end; ++col)
+			{
+				header.mColumns[col].mCRC = compute_crc((const U8*)mColumns[col].data(), mColumns[col].size());
+			}
+		});
+
+		// Write next to the old file and swap it in at the end, so that an
+		// interrupted save leaves the previous cache in place.
+		std::string temp_filename = filename + ".tmp";
+		LLFILE* file = LLFile::fopen(temp_filename, "wb");		/*Flawfinder: ignore*/
+		if (!file)
+		{
+			LL_WARNS(LOG_INV) << "unable to save inventory to: " << temp_filename << LL_ENDL;
+			return false;
+		}
+		static const char PADDING[8] = { 0 };
+		bool ok = (fwrite(&header, sizeof(header), 1, file) == 1);
+		U64 written = sizeof(header);
+		for (U32 col = 0; ok && col < COLUMN_COUNT; ++col)
+		{
+			const ColumnInfo& info = header.mColumns[col];
+			ok = (fwrite(PADDING, 1, (size_t)(info.mOffset - written), file) == info.mOffset - written)
+				&& (fwrite(mColumns[col].data(), 1, mColumns[col].size(), file) == mColumns[col].size());
+			written = info.mOffset + info.mSize;
+		}
+		ok = ok && (fwrite(PADDING, 1, (size_t)(header.mSnapshotSize - written), file) == header.mSnapshotSize - written);
+		ok = (LLFile::close(file) == 0) && ok;
+		if (ok)
+		{
+			LLFile::remove(filename, ENOENT);
+			ok = (LLFile::rename(temp_filename, filename) == 0);
+		}
+		if (!ok)
+		{
+			LL_WARNS(LOG_INV) << "unable to save inventory to: " << filename << LL_ENDL;
+			LLFile::remove(temp_filename, ENOENT);
+		}
+		return ok;
+	}
+}
+
+///----------------------------------------------------------------------------
+/// LLInventoryCacheFile
+///----------------------------------------------------------------------------
+
+// static
+bool LLInventoryCacheFile::load(const std::string& filename, S32 content_version,
+								LLInventoryModel::cat_array_t& categories,
+								LLInventoryModel::item_array_t& items)
+{
+	categories.clear();
+	items.clear();
+	CacheView view;
+	if (!view.open(filename, content_version))
+	{
+		return false;
+	}
+	LL_INFOS(LOG_INV) << "LLInventoryCacheFile::load(" << filename << ")" << LL_ENDL;
+
+	// The last record for each id wins over the snapshot.
+	typedef boost::unordered_map<LLUUID, const CacheView::Delta*> latest_map_t;
+	latest_map_t latest;
+	const CacheView::delta_list_t& deltas = view.deltas();
+	for (CacheView::delta_list_t::const_iterator it = deltas.begin(); it != deltas.end(); ++it)
+	{
+		latest[delta_id(*it)] = &(*it);
+	}
+
+	// Objects are built side by side straight from the mapped columns.
+	const CacheHeader& header = view.header();
+	LLInventoryModel::cat_array_t loaded_categories(header.mCategoryCount);
+	ll_parallel_for(header.mCategoryCount, 1024, [&](size_t begin, size_t end)
+	{
+		CategoryFields fields;
+		for (size_t i = begin; i < end; ++i)
+		{
+			if (view.readCategory((U32)i, fields) && latest.find(fields.mID) == latest.end())
+			{
+				loaded_categories[i] = create_category(fields);
+			}
+		}
+	});
+	LLInventoryModel::item_array_t loaded_items(header.mItemCount);
+	ll_parallel_for(header.mItemCount, 1024, [&](size_t begin, size_t end)
+	{
+		ItemFields fields;
+		for (size_t i = begin; i < end; ++i)
+		{
+			if (view.readItem((U32)i, fields) && fields.mID.notNull()
+				&& latest.find(fields.mID) == latest.end())
+			{
+				loaded_items[i] = create_item(fields);
+			}
+		}
+	});
+
+	categories.reserve(loaded_categories.size() + latest.size());
+	for (LLInventoryModel::cat_array_t::iterator it = loaded_categories.begin(); it != loaded_categories.end(); ++it)
+	{
+		if (it->notNull())
+		{
+			categories.push_back(*it);
+		}
+	}
+	items.reserve(loaded_items.size() + latest.size());
+	for (LLInventoryModel::item_array_t::iterator it = loaded_items.begin(); it != loaded_items.end(); ++it)
+	{
+		if (it->notNull())
+		{
+			items.push_back(*it);
+		}
+	}
+
+	// Then whatever the appended records last said.
+	for (latest_map_t::const_iterator it = latest.begin(); it != latest.end(); ++it)
+	{
+		const CacheView::Delta& delta = *it->second;
+		if (delta.mKind == DELTA_CATEGORY)
+		{
+			CategoryFields fields;
+			if (read_row(delta.mData, delta.mSize, fields))
+			{
+				categories.push_back(create_category(fields));
+			}
+		}
+		else if (delta.mKind == DELTA_ITEM)
+		{
+			ItemFields fields;
+			if (read_row(delta.mData, delta.mSize, fields) && fields.mID.notNull())
+			{
+				items.push_back(create_item(fields));
+			}
+		}
+	}
+
+	LL_INFOS(LOG_INV) << "Read " << categories.size() << " categories and " << items.size()
+					  << " items from the inventory cache, " << deltas.size() << " of them updates" << LL_ENDL;
+	return true;
+}
+
+// static
+bool LLInventoryCacheFile::save(const std::string& filename, S32 content_version,
+								const LLInventoryModel::cat_array_t& categories,
+								const LLInventoryModel::item_array_t& items)
+{
+	if (filename.empty())
+	{
+		LL_ERRS(LOG_INV) << "Filename is Null!" << LL_ENDL;
+		return false;
+	}
+	LL_INFOS(LOG_INV) << "LLInventoryCacheFile::save(" << filename << ")" << LL_ENDL;
+
+	std::vector<const LLViewerInventoryCategory*> cached_categories;
+	cached_categories.reserve(categories.size());
+	for (LLInventoryModel::cat_array_t::const_iterator it = categories.begin(); it != categories.end(); ++it)
+	{
+		if ((*it)->getVersion() != LLViewerInventoryCategory::VERSION_UNKNOWN)
+		{
+			cached_categories.push_back(*it);
+		}
+	}
+
+	// Gather every row and its hash.
+	std::vector<CategoryFields> category_fields(cached_categories.size());
+	std::vector<U64> category_hashes(cached_categories.size());
+	ll_parallel_for(cached_categories.size(), 1024, [&](size_t begin, size_t end)
+	{
+		std::string row;
+		for (size_t i = begin; i < end; ++i)
+		{
+			get_fields(cached_categories[i], category_fields[i]);
+			row.clear();
+			write_row(category_fields[i], row);
+			category_hashes[i] = row_hash(row);
+		}
+	});
+	std::vector<ItemFields> item_fields(items.size());
+	std::vector<U64> item_hashes(items.size());
+	ll_parallel_for(items.size(), 1024, [&](size_t begin, size_t end)
+	{
+		std::string row;
+		for (size_t i = begin; i < end; ++i)
+		{
+			get_fields(items[i], item_fields[i]);
+			row.clear();
+			write_row(item_fields[i], row);
+			item_hashes[i] = row_hash(row);
+		}
+	});
+
+	// Compare against what the existing file holds and append the changes
+	// if they are small enough.
+	{
+		CacheView view;
+		if (view.open(filename, content_version) && view.endsCleanly())
+		{
+			const CacheHeader& header = view.header();
+			typedef boost::unordered_map<LLUUID, U64> hash_map_t;
+			hash_map_t stored;
+			stored.reserve(header.mCategoryCount + header.mItemCount);
+			CategoryFields category;
+			for (U32 i = 0; i < header.mCategoryCount; ++i)
+			{
+				view.readCategory(i, category);
+				stored[category.mID] = view.categoryHash(i);
+			}
+			ItemFields item;
+			for (U32 i = 0; i < header.mItemCount; ++i)
+			{
+				view.readItem(i, item);
+				stored[item.mID] = view.itemHash(i);
+			}
+			const CacheView::delta_list_t& deltas = view.deltas();
+			for (CacheView::delta_list_t::const_iterator it = deltas.begin(); it != deltas.end(); ++it)
+			{
+				if (it->mKind == DELTA_REMOVE)
+				{
+					stored.erase(delta_id(*it));
+				}
+				else
+				{
+					stored[delta_id(*it)] = row_hash(std::string((const char*)it->mData, it->mSize));
+				}
+			}
+
+			std::string appended;
+			std::string row;
+			U32 changed = 0;
+			for (size_t i = 0; i < category_fields.size(); ++i)
+			{
+				hash_map_t::iterator found = stored.find(category_fields[i].mID);
+				if (found == stored.end() || found->second != category_hashes[i])
+				{
+					row.clear();
+					write_row(category_fields[i], row);
+					append_delta(appended, DELTA_CATEGORY, row);
+					++changed;
+				}
+				if (found != stored.end())
+				{
+					stored.erase(found);
+				}
+			}
+			for (size_t i = 0; i < item_fields.size(); ++i)
+			{
+				hash_map_t::iterator found = stored.find(item_fields[i].mID);
+				if (found == stored.end() || found->second != item_hashes[i])
+				{
+					row.clear();
+					write_row(item_fields[i], row);
+					append_delta(appended, DELTA_ITEM, row);
+					++changed;
+				}
+				if (found != stored.end())
+				{
+					stored.erase(found);
+				}
+			}
+			for (hash_map_t::const_iterator it = stored.begin(); it != stored.end(); ++it)
+			{
+				append_delta(appended, DELTA_REMOVE, std::string((const char*)it->first.mData, UUID_BYTES));
+				++changed;
+			}
+
+			if (view.deltaBytes() + appended.size() <= header.mSnapshotSize / MAX_DELTA_FRACTION)
+			{
+				view.close();
+				if (appended.empty())
+				{
+					LL_DEBUGS(LOG_INV) << "Inventory cache " << filename << " is up to date" << LL_ENDL;
+					return true;
+				}
+				LLFILE* file = LLFile::fopen(filename, "ab");		/*Flawfinder: ignore*/
+				bool ok = file && fwrite(appended.data(), 1, appended.size(), file) == appended.size();
+				if (file)
+				{
+					ok = (LLFile::close(file) == 0) && ok;
+				}
+				if (ok)
+				{
+					LL_INFOS(LOG_INV) << "Appended " << changed << " changes to inventory cache " << filename << LL_ENDL;
+					return true;
+				}
+				// A partly written record is skipped when loading, but
+				// rewrite the whole file to be safe.
+				LL_WARNS(LOG_INV) << "Unable to append to inventory cache " << filename << ", rewriting it" << LL_ENDL;
+			}
+		}
+	}
+
+	SnapshotWriter writer((U32)category_fields.size(), (U32)item_fields.size());
+	for (size_t i = 0; i < category_fields.size(); ++i)
+	{
+		writer.addCategory((U32)i, category_fields[i], category_hashes[i]);
+	}
+	for (size_t i = 0; i < item_fields.size(); ++i)
+	{
+		writer.addItem((U32)i, item_fields[i], item_hashes[i]);
+	}
+	return writer.write(filename, content_version);
+}
@@ -0,0 +1,61 @@
+/**
+ * @file llinventorycachefile.h
+ * @brief Binary, memory mappable inventory cache
+ *
+ * $LicenseInfo:firstyear=2026&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2026, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLINVENTORYCACHEFILE_H
+#define LL_LLINVENTORYCACHEFILE_H
+
+#include "llinventorymodel.h"
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Class LLInventoryCacheFile
+//
+// The inventory cache kept between sessions.  A file starts with a snapshot
+// stored column by column (all ids, then all parent ids, ..., with names and
+// descriptions in one string pool), each column with its own checksum, so
+// it can be mapped and decoded by several threads at once.  Saves that find
+// a valid snapshot only append records for the categories and items that
+// changed or went away; loading replays those over the snapshot.  Once the
+// appended records outgrow a quarter of the snapshot, the next save writes
+// a fresh one.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+class LLInventoryCacheFile
+{
+public:
+	// Fills categories and items from filename.  Returns false, leaving both
+	// empty, when there is no usable cache: a missing or corrupt file, or one
+	// written for another content_version.
+	static bool load(const std::string& filename, S32 content_version,
+					 LLInventoryModel::cat_array_t& categories,
+					 LLInventoryModel::item_array_t& items);
+
+	// Stores the categories with a known version and all items.
+	static bool save(const std::string& filename, S32 content_version,
+					 const LLInventoryModel::cat_array_t& categories,
+					 const LLInventoryModel::item_array_t& items);
+};
+
+#endif // LL_LLINVENTORYCACHEFILE_H
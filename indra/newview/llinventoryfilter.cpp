@@ -36,6 +36,7 @@
 #include "llinventorymodel.h"
 #include "llinventorymodelbackgroundfetch.h"
 #include "llinventoryfunctions.h"
+#include "llinventorysearchindex.h"
 #include "llmarketplacefunctions.h"
 #include "llviewercontrol.h"
 #include "llfolderview.h"
@@ -77,7 +78,13 @@ LLInventoryFilter::LLInventoryFilter(const Params& p)
 	mEmptyLookupMessage("InventoryNoMatchingItems"),
 	mCurrentGeneration(0),
 	mFirstRequiredGeneration(0),
-	mFirstSuccessGeneration(0)
+	mFirstSuccessGeneration(0),
+	mIndexUsable(false),
+	mIndexSuffixMatch(false),
+	mIndexGeneration(0),
+	mIndexSearchType(0),
+	mIndexObjectTypes(0),
+	mIndexSuffixCount(0)
 {
 	mOrder = SO_FOLDERS_BY_NAME; // This gets overridden by a pref immediately
 
@@ -103,7 +110,8 @@ bool LLInventoryFilter::check(LLFolderViewItem* item)
 		return passed_clipboard;
 	}
 
-	mSubStringMatchOffset = mFilterSubString.size() ? item->getSearchableLabel().find(mFilterSubString) : std::string::npos;
+	mSubStringMatchOffset = mFilterSubString.size() && mayMatchSubString(item, item_id)
+		? item->getSearchableLabel().find(mFilterSubString) : std::string::npos;
 
 	const bool passed_filtertype = checkAgainstFilterType(item);
 	const bool passed_permissions = checkAgainstPermissions(item);
@@ -118,6 +126,75 @@ bool LLInventoryFilter::check(LLFolderViewItem* item)
 	return passed;
 }
 
+// Whether the searchable label of item needs to be searched for the filter
+// string, or the search index shows it cannot match.
+bool LLInventoryFilter::mayMatchSubString(LLFolderViewItem* item, const LLUUID& item_id)
+{
+	if (item_id.isNull())
+	{
+		return true;
+	}
+	updateIndexCandidates(item->getRoot());
+	return !mIndexUsable
+		|| !LLInventorySearchIndex::instance().hasItem(item_id)
+		|| (mIndexSuffixMatch && !item->getLabelSuffix().empty())
+		|| mIndexCandidates.find(item_id) != mIndexCandidates.end();
+}
+
+void LLInventoryFilter::updateIndexCandidates(LLFolderView* root)
+{
+	const U32 search_type = root->getSearchType();
+	const U64 object_types = (mFilterOps.mFilterTypes & FILTERTYPE_OBJECT) ? mFilterOps.mFilterObjectTypes : U64(-1);
+	const U32 suffix_count = root->getLabelSuffixCount();
+	LLInventorySearchIndex& index = LLInventorySearchIndex::instance();
+	if (mIndexSubString == mFilterSubString
+		&& mIndexSearchType == search_type
+		&& mIndexObjectTypes == object_types
+		&& mIndexSuffixCount == suffix_count
+		&& mIndexGeneration == index.getGeneration())
+	{
+		return;
+	}
+
+	mIndexSubString = mFilterSubString;
+	mIndexSearchType = search_type;
+	mIndexObjectTypes = object_types;
+	mIndexSuffixCount = suffix_count;
+	// When names, descriptions and creators are searched together, they
+	// are joined with spaces, and a string with a space could match
+	// across two of them.
+	const bool multiple_parts = (search_type & (search_type - 1)) != 0;
+	mIndexUsable = !(multiple_parts && mFilterSubString.find(' ') != std::string::npos)
+		&& index.findCandidates(mFilterSubString, search_type, object_types, mIndexCandidates, mIndexFolders);
+	mIndexSuffixMatch = (!search_type || (search_type & LLInventorySearchIndex::SEARCH_NAME))
+		&& root->mayMatchLabelSuffix(mFilterSubString);
+	mIndexGeneration = index.getGeneration();
+}
+
+bool LLInventoryFilter::canSkipItem(LLFolderViewItem* item)
+{
+	const LLFolderViewEventListener* listener = item->getListener();
+	return !mFilterSubString.empty() && listener && !mayMatchSubString(item, listener->getUUID());
+}
+
+bool LLInventoryFilter::canSkipFolder(LLFolderViewFolder* folder)
+{
+	// Folders pass regardless of the string when all are shown.
+	const LLFolderViewEventListener* listener = folder->getListener();
+	if (mFilterSubString.empty() || !listener || listener->getUUID().isNull()
+		|| mFilterOps.mShowFolderState == SHOW_ALL_FOLDERS)
+	{
+		return false;
+	}
+	const LLUUID& folder_id = listener->getUUID();
+	updateIndexCandidates(folder->getRoot());
+	return mIndexUsable
+		&& !mIndexSuffixMatch
+		&& LLInventorySearchIndex::instance().hasItem(folder_id)
+		&& mIndexCandidates.find(folder_id) == mIndexCandidates.end()
+		&& mIndexFolders.find(folder_id) == mIndexFolders.end();
+}
+
 bool LLInventoryFilter::checkFolder(const LLFolderViewFolder* folder) const
 {
 	if (!folder)
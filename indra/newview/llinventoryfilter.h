@@ -27,6 +27,7 @@
 #ifndef LLINVENTORYFILTER_H
 #define LLINVENTORYFILTER_H
 
+#include "llinventorysearchindex.h"
 #include "llinventorytype.h"
 #include "llpermissionsflags.h"
 
@@ -229,6 +230,10 @@ public:
 	bool				check(const LLInventoryItem* item);
 	bool				checkFolder(const LLFolderViewFolder* folder) const;
 	bool				checkFolder(const LLUUID& folder_id) const;
+	// True when the search index shows that the filter string is not in
+	// item, or anywhere in folder, so they fail without being checked.
+	bool				canSkipItem(LLFolderViewItem* item);
+	bool				canSkipFolder(LLFolderViewFolder* folder);
 
 	bool				showAllResults() const;
 
@@ -297,6 +302,8 @@ private:
 	bool 				checkAgainstPermissions(const LLInventoryItem* item) const;
 	bool 				checkAgainstFilterLinks(const LLFolderViewItem* item) const;
 	bool				checkAgainstClipboard(const LLUUID& object_id) const;
+	bool				mayMatchSubString(LLFolderViewItem* item, const LLUUID& item_id);
+	void				updateIndexCandidates(LLFolderView* root);
 
 	U32						mOrder;
 
@@ -306,6 +313,21 @@ private:
 	std::string::size_type	mSubStringMatchOffset;
 	std::string				mFilterSubString;
 	std::string				mFilterSubStringOrig;
+
+	// Items and folders that may match mFilterSubString according to the
+	// search index, and the folders holding them, for the index generation,
+	// search type, object types and label suffixes below.
+	LLInventorySearchIndex::uuid_hash_set_t mIndexCandidates;
+	LLInventorySearchIndex::uuid_hash_set_t mIndexFolders;
+	bool					mIndexUsable;
+	// Whether the string may match in a label suffix, which the index does
+	// not know about.
+	bool					mIndexSuffixMatch;
+	U32						mIndexGeneration;
+	U32						mIndexSearchType;
+	U64						mIndexObjectTypes;
+	U32						mIndexSuffixCount;
+	std::string				mIndexSubString;
 	const std::string		mName;
 
 	S32						mCurrentGeneration;
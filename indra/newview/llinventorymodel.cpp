@@ -37,6 +37,7 @@
 #include "llinventoryclipboard.h"
 #include "llinventorypanel.h"
 #include "llinventorybridge.h"
+#include "llinventorycachefile.h"
 #include "llinventoryfunctions.h"
 #include "llinventoryobserver.h"
 #include "llinventorypanel.h"
@@ -77,6 +78,7 @@ BOOL LLInventoryModel::sFirstTimeInViewer2 = TRUE;
 
 //BOOL decompress_file(const char* src_filename, const char* dst_filename);
 static const char CACHE_FORMAT_STRING[] = "%s.inv"; 
+static const char BINARY_CACHE_FORMAT_STRING[] = "%s.invbin";
 static const char * const LOG_INV("Inventory");
 
 struct InventoryIDPtrLess
@@ -1742,18 +1744,16 @@ void LLInventoryModel::cache(
 	std::string inventory_filename;
 	agent_id.toString(agent_id_str);
 	std::string path(gDirUtilp->getExpandedFilename(LL_PATH_CACHE, agent_id_str));
-	inventory_filename = llformat(CACHE_FORMAT_STRING, path.c_str());
-	saveToFile(inventory_filename, categories, items);
-	std::string gzip_filename(inventory_filename);
-	gzip_filename.append(".gz");
-	if(gzip_file(inventory_filename, gzip_filename))
+	inventory_filename = llformat(BINARY_CACHE_FORMAT_STRING, path.c_str());
+	if (LLInventoryCacheFile::save(inventory_filename, sCurrentInvCacheVersion, categories, items))
 	{
-		LL_DEBUGS(LOG_INV) << "Successfully compressed " << inventory_filename << LL_ENDL;
-		LLFile::remove(inventory_filename);
-	}
-	else
-	{
-		LL_WARNS(LOG_INV) << "Unable to compress " << inventory_filename << LL_ENDL;
+		// The gzipped text cache is only read once, to migrate it.
+		std::string gzip_filename(llformat(CACHE_FORMAT_STRING, path.c_str()));
+		gzip_filename.append(".gz");
+		if (LLFile::isfile(gzip_filename))
+		{
+			LLFile::remove(gzip_filename);
+		}
 	}
 }
 
@@ -2054,8 +2054,11 @@ bool LLInventoryModel::loadSkeleton(
 		const S32 NO_VERSION = LLViewerInventoryCategory::VERSION_UNKNOWN;
 		std::string gzip_filename(inventory_filename);
 		gzip_filename.append(".gz");
-		LLFILE* fp = LLFile::fopen(gzip_filename, "rb");
 		bool remove_inventory_file = false;
+		bool loaded = LLInventoryCacheFile::load(llformat(BINARY_CACHE_FORMAT_STRING, path.c_str()),
+												 sCurrentInvCacheVersion, categories, items);
+		// Fall back to a text cache left by an older viewer.
+		LLFILE* fp = loaded ? NULL : LLFile::fopen(gzip_filename, "rb");
 		if (fp)
 		{
 			fclose(fp);
@@ -2073,7 +2076,7 @@ bool LLInventoryModel::loadSkeleton(
 			}
 		}
 		bool is_cache_obsolete = false;
-		if(loadFromFile(inventory_filename, categories, items, is_cache_obsolete))
+		if(loaded || loadFromFile(inventory_filename, categories, items, is_cache_obsolete))
 		{
 			// We were able to find a cache of files. So, use what we
 			// found to generate a set of categories we should add. We
@@ -2400,24 +2403,13 @@ void LLInventoryModel::buildParentChildMap()
 
 	// Now the items. We allocated in the last step, so now all we
 	// have to do is iterate over the items and put them in the right
-	// place.
-	item_array_t items;
-	if(!mItemMap.empty())
-	{
-		LLPointer<LLViewerInventoryItem> item;
-		for(item_map_t::iterator iit = mItemMap.begin(); iit != mItemMap.end(); ++iit)
-		{
-			item = (*iit).second;
-			items.push_back(item);
-		}
-	}
-	count = items.size();
+	// place. The map holds a reference to every item for the duration.
 	lost = 0;
 	uuid_vec_t lost_item_ids;
-	for(i = 0; i < count; ++i)
+	LLUUID lnf;
+	for(item_map_t::iterator iit = mItemMap.begin(); iit != mItemMap.end(); ++iit)
 	{
-		LLPointer<LLViewerInventoryItem> item;
-		item = items.at(i);
+		LLViewerInventoryItem* item = iit->second;
 		itemsp = getUnlockedItemArray(item->getParentUUID());
 		if(itemsp)
 		{
@@ -2430,7 +2422,11 @@ void LLInventoryModel::buildParentChildMap()
 			++lost;
 			// plop it into the lost & found.
 			//
-			item->setParent(findCategoryUUIDForType(LLFolderType::FT_LOST_AND_FOUND));
+			if(lnf.isNull())
+			{
+				lnf = findCategoryUUIDForType(LLFolderType::FT_LOST_AND_FOUND);
+			}
+			item->setParent(lnf);
 			// move it later using a special message to move items. If
 			// we update server here, the client might crash.
 			//item->updateServer();
@@ -66,6 +66,7 @@ class LLInventoryModel
 	LOG_CLASS(LLInventoryModel);
 public:
 	friend class LLInventoryModelFetchDescendentsResponder;
+	friend class LLInventorySearchIndex;
 
 	enum EHasChildren
 	{
@@ -0,0 +1,460 @@
+/**
+ * @file llinventorysearchindex.cpp
+ * @brief Trigram index over inventory item names and descriptions
+ *
+ * $LicenseInfo:firstyear=2026&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2026, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "llviewerprecompiledheaders.h"
+
+#include "llinventorysearchindex.h"
+
+#include "llcachename.h"
+#include "llcallbacklist.h"
+#include "llinventorymodel.h"
+#include "llviewerinventory.h"
+
+static const char * const LOG_INV("Inventory");
+
+// Time spent adding entries per frame while the index is being built.
+static const F32 BUILD_TIME_PER_FRAME = 0.002f;
+
+namespace
+{
+	inline U32 trigram_at(const std::string& text, size_t pos)
+	{
+		return ((U32)(U8)text[pos] << 16) | ((U32)(U8)text[pos + 1] << 8) | (U32)(U8)text[pos + 2];
+	}
+
+	// The distinct trigrams of text, sorted.
+	void get_trigrams(const std::string& text, std::vector<U32>& trigrams)
+	{
+		trigrams.clear();
+		for (size_t pos = 0; pos + 3 <= text.size(); ++pos)
+		{
+			trigrams.push_back(trigram_at(text, pos));
+		}
+		std::sort(trigrams.begin(), trigrams.end());
+		trigrams.erase(std::unique(trigrams.begin(), trigrams.end()), trigrams.end());
+	}
+
+	void insert_sorted(std::vector<U32>& slots, U32 slot)
+	{
+		// Slots are mostly handed out in increasing order.
+		if (slots.empty() || slots.back() < slot)
+		{
+			slots.push_back(slot);
+		}
+		else
+		{
+			std::vector<U32>::iterator it = std::lower_bound(slots.begin(), slots.end(), slot);
+			if (it == slots.end() || *it != slot)
+			{
+				slots.insert(it, slot);
+			}
+		}
+	}
+
+	void erase_sorted(std::vector<U32>& slots, U32 slot)
+	{
+		std::vector<U32>::iterator it = std::lower_bound(slots.begin(), slots.end(), slot);
+		if (it != slots.end() && *it == slot)
+		{
+			slots.erase(it);
+		}
+	}
+}
+
+LLInventorySearchIndex::LLInventorySearchIndex()
+:	mBuilding(false),
+	mComplete(false),
+	mGeneration(0)
+{
+	gInventory.addObserver(this);
+}
+
+LLInventorySearchIndex::~LLInventorySearchIndex()
+{
+	if (mBuilding)
+	{
+		gIdleCallbacks.deleteFunction(&LLInventorySearchIndex::onIdle, this);
+	}
+	if (gInventory.containsObserver(this))
+	{
+		gInventory.removeObserver(this);
+	}
+}
+
+void LLInventorySearchIndex::changed(U32 mask)
+{
+	const U32 RELEVANT = LABEL | INTERNAL | ADD | REMOVE | REBUILD | DESCRIPTION | STRUCTURE;
+	if (!(mBuilding || mComplete) || !(mask & RELEVANT))
+	{
+		return;
+	}
+	const LLInventoryModel::changed_items_t& changed_ids = gInventory.getChangedIDs();
+	if (changed_ids.empty() || changed_ids.count(LLUUID::null))
+	{
+		// Some change not tied to particular items; start over.
+		startBuild();
+	}
+	else
+	{
+		// Also fine while building: entries added here are newer than the
+		// ones still pending, which are skipped.
+		for (LLInventoryModel::changed_items_t::const_iterator it = changed_ids.begin(); it != changed_ids.end(); ++it)
+		{
+			updateItem(*it);
+		}
+	}
+	++mGeneration;
+}
+
+bool LLInventorySearchIndex::findCandidates(const std::string& substring, U32 search_type, U64 object_types,
+											uuid_hash_set_t& candidates, uuid_hash_set_t& folders)
+{
+	candidates.clear();
+	folders.clear();
+	if (substring.size() < 3 || !gInventory.isInventoryUsable())
+	{
+		return false;
+	}
+	if (!mComplete)
+	{
+		// The filter checks every label until the index is ready.
+		if (!mBuilding)
+		{
+			startBuild();
+		}
+		return false;
+	}
+
+	slot_list_t slots;
+	slot_list_t part;
+	if (!search_type || (search_type & SEARCH_NAME))
+	{
+		findText(mNameTrigrams, substring, part);
+		for (slot_list_t::const_iterator it = part.begin(); it != part.end(); ++it)
+		{
+			if (mEntries[*it].mName.find(substring) != std::string::npos)
+			{
+				slots.push_back(*it);
+			}
+		}
+	}
+	if (search_type & SEARCH_DESCRIPTION)
+	{
+		findText(mDescriptionTrigrams, substring, part);
+		for (slot_list_t::const_iterator it = part.begin(); it != part.end(); ++it)
+		{
+			if (mEntries[*it].mDescription.find(substring) != std::string::npos)
+			{
+				slots.push_back(*it);
+			}
+		}
+	}
+	if (search_type & SEARCH_CREATOR)
+	{
+		// There are far fewer creators than items, so their names are simply
+		// checked one by one. Creators whose names are not known yet are kept,
+		// since their names may match once they arrive.
+		std::string creator_name;
+		for (boost::unordered_map<LLUUID, slot_list_t>::const_iterator it = mCreatorSlots.begin();
+			 it != mCreatorSlots.end(); ++it)
+		{
+			if (gCacheName && gCacheName->getFullName(it->first, creator_name))
+			{
+				LLStringUtil::toUpper(creator_name);
+				if (creator_name.find(substring) == std::string::npos)
+				{
+					continue;
+				}
+			}
+			slots.insert(slots.end(), it->second.begin(), it->second.end());
+		}
+	}
+
+	candidates.reserve(slots.size());
+	for (slot_list_t::const_iterator it = slots.begin(); it != slots.end(); ++it)
+	{
+		const Entry& entry = mEntries[*it];
+		if (entry.mInventoryType == LLInventoryType::IT_NONE
+			|| entry.mInventoryType == LLInventoryType::IT_CATEGORY
+			|| (1LL << entry.mInventoryType & object_types) != U64(0))
+		{
+			candidates.insert(entry.mID);
+		}
+	}
+
+	// The folders leading to them, so the filter can skip all the others.
+	for (uuid_hash_set_t::const_iterator it = candidates.begin(); it != candidates.end(); ++it)
+	{
+		const LLInventoryObject* obj = gInventory.getObject(*it);
+		LLUUID parent_id = obj ? obj->getParentUUID() : LLUUID::null;
+		while (parent_id.notNull() && folders.insert(parent_id).second)
+		{
+			const LLViewerInventoryCategory* parent = gInventory.getCategory(parent_id);
+			parent_id = parent ? parent->getParentUUID() : LLUUID::null;
+		}
+	}
+	return true;
+}
+
+void LLInventorySearchIndex::startBuild()
+{
+	LL_INFOS(LOG_INV) << "Building the inventory search index" << LL_ENDL;
+	mEntries.clear();
+	mFreeSlots.clear();
+	mSlots.clear();
+	mNameTrigrams.clear();
+	mDescriptionTrigrams.clear();
+	mCreatorSlots.clear();
+
+	mPendingIDs.clear();
+	mPendingIDs.reserve(gInventory.mItemMap.size() + gInventory.mCategoryMap.size());
+	for (LLInventoryModel::item_map_t::const_iterator it = gInventory.mItemMap.begin();
+		 it != gInventory.mItemMap.end(); ++it)
+	{
+		mPendingIDs.push_back(it->first);
+	}
+	for (LLInventoryModel::cat_map_t::const_iterator it = gInventory.mCategoryMap.begin();
+		 it != gInventory.mCategoryMap.end(); ++it)
+	{
+		mPendingIDs.push_back(it->first);
+	}
+	mEntries.reserve(mPendingIDs.size());
+	mSlots.reserve(mPendingIDs.size());
+
+	mComplete = false;
+	if (!mBuilding)
+	{
+		mBuilding = true;
+		gIdleCallbacks.addFunction(&LLInventorySearchIndex::onIdle, this);
+	}
+	++mGeneration;
+}
+
+// static
+void LLInventorySearchIndex::onIdle(void* userdata)
+{
+	((LLInventorySearchIndex*)userdata)->buildSlice();
+}
+
+void LLInventorySearchIndex::buildSlice()
+{
+	LLTimer timer;
+	S32 count = 0;
+	while (!mPendingIDs.empty())
+	{
+		const LLUUID id = mPendingIDs.back();
+		mPendingIDs.pop_back();
+		// Entries already there came from a notification since the build
+		// started.
+		if (mSlots.find(id) == mSlots.end())
+		{
+			const LLViewerInventoryItem* item = gInventory.getItem(id);
+			if (item)
+			{
+				addItem(item);
+			}
+			else
+			{
+				addCategory(gInventory.getCategory(id));
+			}
+		}
+		if (++count % 256 == 0 && timer.getElapsedTimeF32() > BUILD_TIME_PER_FRAME)
+		{
+			return;
+		}
+	}
+
+	uuid_vec_t().swap(mPendingIDs);
+	gIdleCallbacks.deleteFunction(&LLInventorySearchIndex::onIdle, this);
+	mBuilding = false;
+	mComplete = true;
+	++mGeneration;
+	LL_INFOS(LOG_INV) << "Indexed " << mSlots.size() << " items and categories using " << mNameTrigrams.size()
+					  << " name and " << mDescriptionTrigrams.size() << " description trigrams" << LL_ENDL;
+}
+
+void LLInventorySearchIndex::updateItem(const LLUUID& item_id)
+{
+	boost::unordered_map<LLUUID, U32>::iterator found = mSlots.find(item_id);
+	if (found != mSlots.end())
+	{
+		removeSlot(found->second);
+	}
+	const LLViewerInventoryItem* item = gInventory.getItem(item_id);
+	if (item)
+	{
+		addItem(item);
+	}
+	else
+	{
+		addCategory(gInventory.getCategory(item_id));
+	}
+}
+
+U32 LLInventorySearchIndex::allocateSlot()
+{
+	if (mFreeSlots.empty())
+	{
+		mEntries.push_back(Entry());
+		return (U32)mEntries.size() - 1;
+	}
+	U32 slot = mFreeSlots.back();
+	mFreeSlots.pop_back();
+	return slot;
+}
+
+void LLInventorySearchIndex::addItem(const LLViewerInventoryItem* item)
+{
+	if (!item || item->getUUID().isNull())
+	{
+		return;
+	}
+	U32 slot = allocateSlot();
+
+	// The same text the folder view searches: names and descriptions as
+	// seen through links, in upper case.
+	Entry& entry = mEntries[slot];
+	entry.mID = item->getUUID();
+	entry.mName = item->getName();
+	LLStringUtil::toUpper(entry.mName);
+	entry.mDescription = item->getDescription();
+	LLStringUtil::toUpper(entry.mDescription);
+	entry.mCreatorID = item->getCreatorUUID();
+	entry.mInventoryType = item->getInventoryType();
+
+	mSlots[entry.mID] = slot;
+	addText(mNameTrigrams, entry.mName, slot);
+	addText(mDescriptionTrigrams, entry.mDescription, slot);
+	if (entry.mCreatorID.notNull())
+	{
+		insert_sorted(mCreatorSlots[entry.mCreatorID], slot);
+	}
+}
+
+void LLInventorySearchIndex::addCategory(const LLViewerInventoryCategory* cat)
+{
+	if (!cat || cat->getUUID().isNull())
+	{
+		return;
+	}
+	U32 slot = allocateSlot();
+
+	// Folders are only searched by name.
+	Entry& entry = mEntries[slot];
+	entry.mID = cat->getUUID();
+	entry.mName = cat->getName();
+	LLStringUtil::toUpper(entry.mName);
+	entry.mInventoryType = LLInventoryType::IT_CATEGORY;
+
+	mSlots[entry.mID] = slot;
+	addText(mNameTrigrams, entry.mName, slot);
+}
+
+void LLInventorySearchIndex::removeSlot(U32 slot)
+{
+	Entry& entry = mEntries[slot];
+	removeText(mNameTrigrams, entry.mName, slot);
+	removeText(mDescriptionTrigrams, entry.mDescription, slot);
+	if (entry.mCreatorID.notNull())
+	{
+		boost::unordered_map<LLUUID, slot_list_t>::iterator creator = mCreatorSlots.find(entry.mCreatorID);
+		if (creator != mCreatorSlots.end())
+		{
+			erase_sorted(creator->second, slot);
+			if (creator->second.empty())
+			{
+				mCreatorSlots.erase(creator);
+			}
+		}
+	}
+	mSlots.erase(entry.mID);
+	entry = Entry();
+	mFreeSlots.push_back(slot);
+}
+
+// static
+void LLInventorySearchIndex::addText(trigram_map_t& trigrams, const std::string& text, U32 slot)
+{
+	std::vector<U32> text_trigrams;
+	get_trigrams(text, text_trigrams);
+	for (std::vector<U32>::const_iterator it = text_trigrams.begin(); it != text_trigrams.end(); ++it)
+	{
+		insert_sorted(trigrams[*it], slot);
+	}
+}
+
+// static
+void LLInventorySearchIndex::removeText(trigram_map_t& trigrams, const std::string& text, U32 slot)
+{
+	std::vector<U32> text_trigrams;
+	get_trigrams(text, text_trigrams);
+	for (std::vector<U32>::const_iterator it = text_trigrams.begin(); it != text_trigrams.end(); ++it)
+	{
+		trigram_map_t::iterator found = trigrams.find(*it);
+		if (found != trigrams.end())
+		{
+			erase_sorted(found->second, slot);
+			if (found->second.empty())
+			{
+				trigrams.erase(found);
+			}
+		}
+	}
+}
+
+// Slots holding every trigram of substring, which still need checking for
+// the substring itself.
+// static
+void LLInventorySearchIndex::findText(const trigram_map_t& trigrams, const std::string& substring, slot_list_t& slots)
+{
+	slots.clear();
+	std::vector<U32> query;
+	get_trigrams(substring, query);
+
+	// Intersect starting from the rarest trigram.
+	std::vector<const slot_list_t*> lists;
+	for (std::vector<U32>::const_iterator it = query.begin(); it != query.end(); ++it)
+	{
+		trigram_map_t::const_iterator found = trigrams.find(*it);
+		if (found == trigrams.end())
+		{
+			return;
+		}
+		lists.push_back(&found->second);
+	}
+	std::sort(lists.begin(), lists.end(),
+			  [](const slot_list_t* a, const slot_list_t* b) { return a->size() < b->size(); });
+
+	slots = *lists[0];
+	slot_list_t intersection;
+	for (size_t i = 1; i < lists.size() && !slots.empty(); ++i)
+	{
+		intersection.clear();
+		std::set_intersection(slots.begin(), slots.end(), lists[i]->begin(), lists[i]->end(),
+							  std::back_inserter(intersection));
+		slots.swap(intersection);
+	}
+}
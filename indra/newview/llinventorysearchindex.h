@@ -0,0 +1,131 @@
+/**
+ * @file llinventorysearchindex.h
+ * @brief Trigram index over inventory item names and descriptions
+ *
+ * $LicenseInfo:firstyear=2026&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2026, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLINVENTORYSEARCHINDEX_H
+#define LL_LLINVENTORYSEARCHINDEX_H
+
+#include "llinventoryobserver.h"
+#include "llinventorytype.h"
+#include "llsingleton.h"
+
+#include <boost/unordered_map.hpp>
+#include <boost/unordered_set.hpp>
+
+class LLViewerInventoryCategory;
+class LLViewerInventoryItem;
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Class LLInventorySearchIndex
+//
+// Index of gInventory for substring searches, so the inventory filter only
+// has to visit what may match.  Upper cased item and category names and
+// item descriptions are broken into trigrams, each mapping to the sorted
+// slots of the entries containing it; items are also grouped by creator,
+// and each slot keeps its inventory type.  The index is built a slice per
+// frame from the first search on, and then kept current from the
+// inventory observer notifications.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+class LLInventorySearchIndex : public LLInventoryObserver, public LLSingleton<LLInventorySearchIndex>
+{
+	friend class LLSingleton<LLInventorySearchIndex>;
+public:
+	typedef boost::unordered_set<LLUUID> uuid_hash_set_t;
+
+	enum ESearchType
+	{
+		SEARCH_NAME = 1,
+		SEARCH_DESCRIPTION = 2,
+		SEARCH_CREATOR = 4
+	};
+
+	// Fills candidates with every item whose name, description or creator
+	// name, as selected by search_type (the LLFolderView search type, 0
+	// meaning names), contains substring, which must be upper case, and
+	// with every category whose name does when names are searched.  Only
+	// items with an inventory type in object_types (a mask of
+	// 1 << LLInventoryType::EType) or IT_NONE are returned.  folders gets
+	// every category holding a candidate, directly or further down.
+	// Returns false when the index can not answer: inventory is not usable,
+	// the index is still being built or the substring is shorter than a
+	// trigram.
+	bool findCandidates(const std::string& substring, U32 search_type, U64 object_types,
+						uuid_hash_set_t& candidates, uuid_hash_set_t& folders);
+
+	// True if the item or category is indexed, i.e. findCandidates() would
+	// have returned it if it matched.
+	bool hasItem(const LLUUID& item_id) const	{ return mSlots.find(item_id) != mSlots.end(); }
+
+	// Changes whenever the index does; results are valid until then.
+	U32 getGeneration() const					{ return mGeneration; }
+
+	/*virtual*/ void changed(U32 mask);
+
+protected:
+	LLInventorySearchIndex();
+	virtual ~LLInventorySearchIndex();
+
+private:
+	struct Entry
+	{
+		LLUUID mID;					// null for a free slot
+		std::string mName;			// upper case
+		std::string mDescription;	// upper case
+		LLUUID mCreatorID;
+		LLInventoryType::EType mInventoryType;
+	};
+
+	typedef std::vector<U32> slot_list_t;
+	typedef boost::unordered_map<U32, slot_list_t> trigram_map_t;
+
+	void startBuild();
+	void buildSlice();
+	static void onIdle(void* userdata);
+	void updateItem(const LLUUID& item_id);
+	U32 allocateSlot();
+	void addItem(const LLViewerInventoryItem* item);
+	void addCategory(const LLViewerInventoryCategory* cat);
+	void removeSlot(U32 slot);
+
+	static void addText(trigram_map_t& trigrams, const std::string& text, U32 slot);
+	static void removeText(trigram_map_t& trigrams, const std::string& text, U32 slot);
+	static void findText(const trigram_map_t& trigrams, const std::string& substring, slot_list_t& slots);
+
+	std::vector<Entry> mEntries;
+	std::vector<U32> mFreeSlots;
+	boost::unordered_map<LLUUID, U32> mSlots;
+	trigram_map_t mNameTrigrams;
+	trigram_map_t mDescriptionTrigrams;
+	boost::unordered_map<LLUUID, slot_list_t> mCreatorSlots;
+
+	// Items and categories still to be added by the build in progress.
+	uuid_vec_t mPendingIDs;
+	bool mBuilding;
+	bool mComplete;
+
+	U32 mGeneration;
+};
+
+#endif // LL_LLINVENTORYSEARCHINDEX_H
@@ -54,6 +54,7 @@
 #include "llviewerregion.h"
 #include "llviewertexturelist.h"
 #include "llvolume.h"
+#include "llvolumefacecache.h"
 #include "llvolumemgr.h"
 #include "llvovolume.h"
 #include "llworld.h"
@@ -73,6 +74,7 @@
 #endif
 
 #include <queue>
+#include <thread>
 
 class AIHTTPTimeoutPolicy;
 extern AIHTTPTimeoutPolicy meshHeaderResponder_timeout;
@@ -87,6 +89,12 @@ LLMeshRepository gMeshRepo;
 
 const U32 MAX_MESH_REQUESTS_PER_SECOND = 100;
 
+// Blocks of a mesh asset this close together are fetched with one range request,
+// the bytes in between are downloaded and thrown away.
+const S32 MAX_MESH_BLOCK_GAP = 2048;
+// Don't grow a range request past this many bytes by adding blocks to it.
+const S32 MAX_MESH_COALESCED_BYTES = 1024 * 1024;
+
 // Maximum mesh version to support.  Three least significant digits are reserved for the minor version, 
 // with major version changes indicating a format change that is not backwards compatible and should not
 // be parsed by viewers that don't specifically support that version. For example, if the integer "1" is 
@@ -98,6 +106,8 @@ const S32 MAX_MESH_VERSION = 999;
 U32 LLMeshRepository::sBytesReceived = 0;
 U32 LLMeshRepository::sHTTPRequestCount = 0;
 U32 LLMeshRepository::sHTTPRetryCount = 0;
+U32 LLMeshRepository::sHTTPRequestsSaved = 0;
+U32 LLMeshRepository::sHTTPCoalescedRequests = 0;
 U32 LLMeshRepository::sLODProcessing = 0;
 U32 LLMeshRepository::sLODPending = 0;
 
@@ -125,6 +135,11 @@ std::string header_lod[] =
 };
 const char * const LOG_MESH = "Mesh";
 
+// Main thread cost of loading meshes
+static LLTrace::BlockTimerStatHandle FTM_MESH_LOD_RESPONSE("Mesh LOD Response");
+static LLTrace::BlockTimerStatHandle FTM_MESH_NOTIFY_LOADED("Mesh Notify Loaded");
+static LLTrace::BlockTimerStatHandle FTM_MESH_SWAP_FACES("Mesh Swap Faces");
+
 
 //get the number of bytes resident in memory for given volume
 U32 get_volume_memory_size(const LLVolume* volume)
@@ -399,6 +414,55 @@ public:
 	/*virtual*/ char const* getName(void) const { return "LLMeshPhysicsShapeResponder"; }
 };
 
+// Several blocks of one mesh asset fetched with a single range request.
+class LLMeshRangeResponder : public LLHTTPClient::ResponderWithCompleted
+{
+public:
+	LLMeshRepoThread::mesh_block_list mBlocks;
+	U32 mRequestedBytes;
+	U32 mOffset;
+	bool mHasLOD;
+	bool mProcessed;
+	void retry();
+
+	LLMeshRangeResponder(const LLMeshRepoThread::mesh_block_list& blocks, U32 offset, U32 size)
+		: mBlocks(blocks), mRequestedBytes(size), mOffset(offset), mHasLOD(false)
+	{
+		for (LLMeshRepoThread::mesh_block_list::const_iterator iter = mBlocks.begin(); iter != mBlocks.end(); ++iter)
+		{
+			mHasLOD |= iter->mType == LLMeshRepoThread::MeshBlock::LOD;
+		}
+		if (mHasLOD)
+		{
+			LLMeshRepoThread::incActiveLODRequests();
+		}
+		mProcessed = false;
+	}
+
+	~LLMeshRangeResponder()
+	{
+		if (!LLApp::isExiting())
+		{
+			if (!mProcessed)
+			{
+				LL_WARNS() << "Killed without being processed, retrying." << LL_ENDL;
+				retry();
+			}
+			if (mHasLOD)
+			{
+				LLMeshRepoThread::decActiveLODRequests();
+			}
+		}
+	}
+
+	virtual void completedRaw(LLChannelDescriptors const& channels,
+							  LLIOPipe::buffer_ptr_t const& buffer);
+
+	/*virtual*/ AICapabilityType capability_type(void) const { return cap_mesh; }
+	/*virtual*/ AIHTTPTimeoutPolicy const& getHTTPTimeoutPolicy(void) const { return meshLODResponder_timeout; }
+	/*virtual*/ char const* getName(void) const { return "LLMeshRangeResponder"; }
+};
+
 void log_upload_error(S32 status, const LLSD& content, std::string stage, std::string model_name)
 {
 	// Add notification popup.
@@ -857,15 +921,11 @@ bool LLMeshRepoThread::fetchMeshSkinInfo(const LLUUID& mesh_id)
 			return true;
 
 		//reading from VFS failed for whatever reason, fetch from sim
-		AIHTTPHeaders headers("Accept", "application/octet-stream");
-
 		std::string http_url = constructUrl(mesh_id);
 		if (!http_url.empty())
 		{				
-			if (!LLHTTPClient::getByteRange(http_url, headers, info.mOffset, info.mSize,
-				new LLMeshSkinInfoResponder(mesh_id, info.mOffset, info.mSize)))
+			if (!fetchMeshBlocks(http_url, MeshBlock(MeshBlock::SKIN, mesh_id, info.mOffset, info.mSize)))
 				return false;
-			LLMeshRepository::sHTTPRequestCount++;
 		}
 	}
 
@@ -887,15 +947,11 @@ bool LLMeshRepoThread::fetchMeshDecomposition(const LLUUID& mesh_id)
 			return true;
 
 		//reading from VFS failed for whatever reason, fetch from sim
-		AIHTTPHeaders headers("Accept", "application/octet-stream");
-
 		std::string http_url = constructUrl(mesh_id);
 		if (!http_url.empty())
 		{				
-			if (!LLHTTPClient::getByteRange(http_url, headers, info.mOffset, info.mSize,
-				new LLMeshDecompositionResponder(mesh_id, info.mOffset, info.mSize)))
+			if (!fetchMeshBlocks(http_url, MeshBlock(MeshBlock::DECOMPOSITION, mesh_id, info.mOffset, info.mSize)))
 				return false;
-			LLMeshRepository::sHTTPRequestCount++;
 		}
 	}
 
@@ -919,15 +975,11 @@ bool LLMeshRepoThread::fetchMeshPhysicsShape(const LLUUID& mesh_id)
 				return true;
 
 			//reading from VFS failed for whatever reason, fetch from sim
-			AIHTTPHeaders headers("Accept", "application/octet-stream");
-
 			std::string http_url = constructUrl(mesh_id);
 			if (!http_url.empty())
 			{
-				if (!LLHTTPClient::getByteRange(http_url, headers, info.mOffset, info.mSize,
-					new LLMeshPhysicsShapeResponder(mesh_id, info.mOffset, info.mSize)))
+				if (!fetchMeshBlocks(http_url, MeshBlock(MeshBlock::PHYSICS_SHAPE, mesh_id, info.mOffset, info.mSize)))
 					return false;
-				LLMeshRepository::sHTTPRequestCount++;
 			}
 		}
 		else
@@ -940,6 +992,245 @@ bool LLMeshRepoThread::fetchMeshPhysicsShape(const LLUUID& mesh_id)
 	return true;
 }
 
+static const char* mesh_block_name(const LLMeshRepoThread::MeshBlock& block)
+{
+	switch (block.mType)
+	{
+	case LLMeshRepoThread::MeshBlock::SKIN:
+		return "skin";
+	case LLMeshRepoThread::MeshBlock::DECOMPOSITION:
+		return "physics_convex";
+	case LLMeshRepoThread::MeshBlock::PHYSICS_SHAPE:
+		return "physics_mesh";
+	default:
+		return header_lod[block.mLOD].c_str();
+	}
+}
+
+bool LLMeshRepoThread::fetchMeshBlocks(const std::string& http_url, const MeshBlock& block)
+{ //called from the repo thread with mSignal locked
+	const LLUUID mesh_id = block.mMeshParams.getSculptID();
+
+	//everything else of this asset that is waiting to be fetched right now
+	mesh_block_list candidates;
+	{
+		LLMutexLock lock(mMutex);
+		for (auto iter = mLODReqQ.begin(); iter != mLODReqQ.end(); ++iter)
+		{
+			const LODRequest* req = dynamic_cast<const LODRequest*>(iter->first.get());
+			if (req && req->mMeshParams.getSculptID() == mesh_id &&
+				!(block.mType == MeshBlock::LOD && req->mLOD == block.mLOD) &&
+				req->mTimer.getElapsedTimeF32() >= iter->second)
+			{
+				candidates.push_back(MeshBlock(MeshBlock::LOD, req->mMeshParams, req->mLOD, 0, 0));
+			}
+		}
+	}
+	if (block.mType != MeshBlock::SKIN && mSkinRequests.count(mesh_id))
+	{
+		candidates.push_back(MeshBlock(MeshBlock::SKIN, mesh_id, 0, 0));
+	}
+	if (block.mType != MeshBlock::DECOMPOSITION && mDecompositionRequests.count(mesh_id))
+	{
+		candidates.push_back(MeshBlock(MeshBlock::DECOMPOSITION, mesh_id, 0, 0));
+	}
+	if (block.mType != MeshBlock::PHYSICS_SHAPE && mPhysicsShapeRequests.count(mesh_id))
+	{
+		candidates.push_back(MeshBlock(MeshBlock::PHYSICS_SHAPE, mesh_id, 0, 0));
+	}
+
+	mesh_block_list blocks(1, block);
+	S32 range_start = block.mOffset;
+	S32 range_end = block.mOffset + block.mSize;
+	if (!candidates.empty())
+	{
+		std::vector<bool> taken(candidates.size(), false);
+		for (U32 i = 0; i < candidates.size(); ++i)
+		{
+			MeshBlock& candidate = candidates[i];
+			MeshHeaderInfo info;
+			if (!getMeshHeaderInfo(mesh_id, mesh_block_name(candidate), info) ||
+				info.mHeaderSize == 0 || info.mVersion > MAX_MESH_VERSION || info.mOffset < 0 || info.mSize <= 0)
+			{ //leave it to its own fetch, which knows what to do with it
+				candidate.mSize = 0;
+				continue;
+			}
+			candidate.mOffset = info.mOffset;
+			candidate.mSize = info.mSize;
+			if (loadInfoFromVFS(mesh_id, info, boost::bind(&LLMeshRepoThread::blockReceived, this, candidate, _2, _3)))
+			{ //was in the cache after all, nothing to fetch but it's done
+				taken[i] = true;
+				candidate.mSize = 0;
+			}
+		}
+
+		//grow the range with the blocks that touch it until none is left
+		bool grown = true;
+		while (grown)
+		{
+			grown = false;
+			for (U32 i = 0; i < candidates.size(); ++i)
+			{
+				const MeshBlock& candidate = candidates[i];
+				if (taken[i] || candidate.mSize == 0)
+				{ //already done or not to be fetched with this
+					continue;
+				}
+				S32 start = llmin(range_start, candidate.mOffset);
+				S32 end = llmax(range_end, candidate.mOffset + candidate.mSize);
+				if (candidate.mOffset <= range_end + MAX_MESH_BLOCK_GAP &&
+					candidate.mOffset + candidate.mSize + MAX_MESH_BLOCK_GAP >= range_start &&
+					end - start <= MAX_MESH_COALESCED_BYTES)
+				{
+					taken[i] = true;
+					range_start = start;
+					range_end = end;
+					grown = true;
+				}
+			}
+		}
+
+		//take the blocks out of their queues, they are part of this request now
+		for (U32 i = 0; i < candidates.size(); ++i)
+		{
+			if (!taken[i])
+			{
+				continue;
+			}
+			const MeshBlock& candidate = candidates[i];
+			bool found = false;
+			switch (candidate.mType)
+			{
+			case MeshBlock::LOD:
+				{
+					LLMutexLock lock(mMutex);
+					for (auto iter = mLODReqQ.begin(); iter != mLODReqQ.end(); ++iter)
+					{
+						const LODRequest* req = dynamic_cast<const LODRequest*>(iter->first.get());
+						if (req && req->mMeshParams == candidate.mMeshParams && req->mLOD == candidate.mLOD)
+						{
+							mLODReqQ.erase(iter);
+							--LLMeshRepository::sLODProcessing;
+							found = true;
+							break;
+						}
+					}
+				}
+				break;
+			case MeshBlock::SKIN:
+				found = mSkinRequests.erase(mesh_id) > 0;
+				break;
+			case MeshBlock::DECOMPOSITION:
+				found = mDecompositionRequests.erase(mesh_id) > 0;
+				break;
+			case MeshBlock::PHYSICS_SHAPE:
+				found = mPhysicsShapeRequests.erase(mesh_id) > 0;
+				break;
+			}
+			if (found && candidate.mSize > 0)
+			{
+				blocks.push_back(candidate);
+			}
+		}
+
+		//the range only has to cover the blocks that are really in it
+		range_start = block.mOffset;
+		range_end = block.mOffset + block.mSize;
+		for (U32 i = 1; i < blocks.size(); ++i)
+		{
+			range_start = llmin(range_start, blocks[i].mOffset);
+			range_end = llmax(range_end, blocks[i].mOffset + blocks[i].mSize);
+		}
+	}
+
+	AIHTTPHeaders headers("Accept", "application/octet-stream");
+	if (blocks.size() == 1)
+	{
+		LLHTTPClient::ResponderPtr responder;
+		switch (block.mType)
+		{
+		case MeshBlock::LOD:
+			responder = new LLMeshLODResponder(block.mMeshParams, block.mLOD, block.mOffset, block.mSize);
+			break;
+		case MeshBlock::SKIN:
+			responder = new LLMeshSkinInfoResponder(mesh_id, block.mOffset, block.mSize);
+			break;
+		case MeshBlock::DECOMPOSITION:
+			responder = new LLMeshDecompositionResponder(mesh_id, block.mOffset, block.mSize);
+			break;
+		case MeshBlock::PHYSICS_SHAPE:
+			responder = new LLMeshPhysicsShapeResponder(mesh_id, block.mOffset, block.mSize);
+			break;
+		}
+		if (!LLHTTPClient::getByteRange(http_url, headers, block.mOffset, block.mSize, responder))
+		{
+			return false;
+		}
+		LLMeshRepository::sHTTPRequestCount++;
+		return true;
+	}
+
+	boost::intrusive_ptr<LLMeshRangeResponder> responder = new LLMeshRangeResponder(blocks, range_start, range_end - range_start);
+	if (!LLHTTPClient::getByteRange(http_url, headers, range_start, range_end - range_start, responder))
+	{ //the caller keeps block for later, put the others back where they came from
+		responder->mProcessed = true;
+		for (U32 i = 1; i < blocks.size(); ++i)
+		{
+			retryBlock(blocks[i]);
+		}
+		return false;
+	}
+	LLMeshRepository::sHTTPRequestCount++;
+	LLMeshRepository::sHTTPCoalescedRequests++;
+	LLMeshRepository::sHTTPRequestsSaved += blocks.size() - 1;
+	return true;
+}
+
+bool LLMeshRepoThread::blockReceived(const MeshBlock& block, U8* data, S32 data_size)
+{
+	switch (block.mType)
+	{
+	case MeshBlock::LOD:
+		return lodReceived(block.mMeshParams, block.mLOD, data, data_size);
+	case MeshBlock::SKIN:
+		return skinInfoReceived(block.mMeshParams.getSculptID(), data, data_size);
+	case MeshBlock::DECOMPOSITION:
+		return decompositionReceived(block.mMeshParams.getSculptID(), data, data_size);
+	case MeshBlock::PHYSICS_SHAPE:
+		return physicsShapeReceived(block.mMeshParams.getSculptID(), data, data_size);
+	}
+	return false;
+}
+
+void LLMeshRepoThread::retryBlock(const MeshBlock& block)
+{
+	switch (block.mType)
+	{
+	case MeshBlock::LOD:
+		lockAndLoadMeshLOD(block.mMeshParams, block.mLOD);
+		break;
+	case MeshBlock::SKIN:
+		loadMeshSkinInfo(block.mMeshParams.getSculptID());
+		break;
+	case MeshBlock::DECOMPOSITION:
+		loadMeshDecomposition(block.mMeshParams.getSculptID());
+		break;
+	case MeshBlock::PHYSICS_SHAPE:
+		loadMeshPhysicsShape(block.mMeshParams.getSculptID());
+		break;
+	}
+}
+
+void LLMeshRepoThread::blockFailed(const MeshBlock& block)
+{
+	if (block.mType == MeshBlock::LOD)
+	{ //tell the volume it's not coming
+		LLMutexLock lock(mMutex);
+		mUnavailableQ.push(LODRequest(block.mMeshParams, block.mLOD));
+	}
+	//skin info, decompositions and physics shapes are dropped, like their own responders do
+}
+
 //static
 void LLMeshRepoThread::incActiveLODRequests()
 {
@@ -1030,17 +1321,12 @@ bool LLMeshRepoThread::fetchMeshLOD(const LLVolumeParams& mesh_params, S32 lod,
 				return true;
 
 			//reading from VFS failed for whatever reason, fetch from sim
-			AIHTTPHeaders headers("Accept", "application/octet-stream");
-
 			std::string http_url = constructUrl(mesh_id);
 			if (!http_url.empty())
 			{		
 				count++;		
-				if (!LLHTTPClient::getByteRange(constructUrl(mesh_id), headers, info.mOffset, info.mSize,
-						new LLMeshLODResponder(mesh_params, lod, info.mOffset, info.mSize)))
+				if (!fetchMeshBlocks(http_url, MeshBlock(MeshBlock::LOD, mesh_params, lod, info.mOffset, info.mSize)))
 					return false;
-				LLMeshRepository::sHTTPRequestCount++;
-			
 			}
 			else
 			{
@@ -1056,7 +1342,7 @@ bool LLMeshRepoThread::fetchMeshLOD(const LLVolumeParams& mesh_params, S32 lod,
 	return true;
 }
 
-bool LLMeshRepoThread::headerReceived(const LLVolumeParams& mesh_params, U8* data, S32 data_size)
+bool LLMeshRepoThread::headerReceived(const LLVolumeParams& mesh_params, U8* data, S32 data_size, bool push_pending_lods)
 {
 	LLSD header;
 	
@@ -1100,24 +1386,32 @@ bool LLMeshRepoThread::headerReceived(const LLVolumeParams& mesh_params, U8* dat
 			mMeshHeader[mesh_id] = header;
 		}
 
-		LLMutexLock lock(mMutex); // make sure only one thread access mPendingLOD at the same time.
-
-		//check for pending requests
-		pending_lod_map::iterator iter = mPendingLOD.find(mesh_params);
-		if (iter != mPendingLOD.end())
+		if (push_pending_lods)
 		{
-			for (U32 i = 0; i < iter->second.size(); ++i)
-			{
-				LLMeshRepository::sLODProcessing++;
-				gMeshRepo.mThread->pushLODRequest(mesh_params, iter->second[i], 0.f);
-			}
-			mPendingLOD.erase(iter);
+			pushPendingLODs(mesh_params);
 		}
 	}
 
 	return true;
 }
 
+void LLMeshRepoThread::pushPendingLODs(const LLVolumeParams& mesh_params)
+{
+	LLMutexLock lock(mMutex); // make sure only one thread access mPendingLOD at the same time.
+
+	//check for pending requests
+	pending_lod_map::iterator iter = mPendingLOD.find(mesh_params);
+	if (iter != mPendingLOD.end())
+	{
+		for (U32 i = 0; i < iter->second.size(); ++i)
+		{
+			LLMeshRepository::sLODProcessing++;
+			gMeshRepo.mThread->pushLODRequest(mesh_params, iter->second[i], 0.f);
+		}
+		mPendingLOD.erase(iter);
+	}
+}
+
 bool LLMeshRepoThread::lodReceived(const LLVolumeParams& mesh_params, S32 lod, U8* data, S32 data_size)
 {
 	AIStateMachine::StateTimer timer("lodReceived");
@@ -1131,6 +1425,19 @@ bool LLMeshRepoThread::lodReceived(const LLVolumeParams& mesh_params, S32 lod, U
 		AIStateMachine::StateTimer timer("getNumFaces");
 		if (volume->getNumFaces() > 0)
 		{
+			//everything the main thread would otherwise do on first use of the faces
+			//(unpackVolumeFaces already cache optimized the indices); faces borrowing
+			//from an identical cached face get its octree, built here if need be
+			for (S32 i = 0; i < volume->getNumVolumeFaces(); ++i)
+			{
+				LLVolumeFace& face = volume->getVolumeFace(i);
+				if (!LLVolumeFaceCache::share(face))
+				{
+					face.createTangents();
+				}
+				face.createOctree();
+			}
+
 			AIStateMachine::StateTimer timer("LoadedMesh");
 			LoadedMesh mesh(volume, mesh_params, lod);
 			{
@@ -1145,6 +1452,120 @@ bool LLMeshRepoThread::lodReceived(const LLVolumeParams& mesh_params, S32 lod, U
 	return false;
 }
 
+void LLMeshRepoThread::queueLODDecode(const LLVolumeParams& mesh_params, S32 lod, std::vector<U8>& data, S32 cache_offset, S32 cache_size)
+{ //called from the main thread
+	{
+		LLMutexLock lock(mMutex);
+		mLODDecodeQ.push_back(LODDecodeRequest(mesh_params, lod, cache_offset, cache_size));
+		mLODDecodeQ.back().mData.swap(data);
+	}
+
+	if (mDecodeWorkers.empty())
+	{ //no decode threads, do it right here
+		decodeNextLOD();
+		return;
+	}
+
+	for (std::vector<DecodeWorker*>::iterator iter = mDecodeWorkers.begin(); iter != mDecodeWorkers.end(); ++iter)
+	{
+		(*iter)->wake();
+	}
+}
+
+bool LLMeshRepoThread::decodeNextLOD()
+{
+	mMutex->lock();
+	if (mLODDecodeQ.empty())
+	{
+		mMutex->unlock();
+		return false;
+	}
+	LODDecodeRequest req(std::move(mLODDecodeQ.front()));
+	mLODDecodeQ.pop_front();
+	mMutex->unlock();
+
+	U8* data = req.mData.empty() ? NULL : &req.mData[0];
+	if (lodReceived(req.mMeshParams, req.mLOD, data, (S32)req.mData.size()) && req.mCacheSize > 0)
+	{
+		LLVFile file(gVFS, req.mMeshParams.getSculptID(), LLAssetType::AT_MESH, LLVFile::WRITE);
+		if (file.getSize() >= req.mCacheOffset + req.mCacheSize)
+		{
+			file.seek(req.mCacheOffset);
+			file.write(data, req.mCacheSize);
+			LLMeshRepository::sCacheBytesWritten += req.mCacheSize;
+		}
+	}
+	return true;
+}
+
+void LLMeshRepoThread::startDecodeWorkers(S32 num_threads)
+{
+	for (S32 i = 0; i < num_threads; ++i)
+	{
+		mDecodeWorkers.push_back(new DecodeWorker(this, i));
+	}
+	LL_INFOS(LOG_MESH) << "Mesh decode threads: " << num_threads << LL_ENDL;
+}
+
+void LLMeshRepoThread::shutdownDecodeWorkers()
+{
+	{
+		// Nothing left to pick up, so a worker exits as soon as its current LOD is decoded.
+		LLMutexLock lock(mMutex);
+		mLODDecodeQ.clear();
+	}
+	for (std::vector<DecodeWorker*>::iterator iter = mDecodeWorkers.begin(); iter != mDecodeWorkers.end(); ++iter)
+	{
+		// Wakes the worker if it is sleeping in checkPause().
+		(*iter)->setQuitting();
+	}
+	for (std::vector<DecodeWorker*>::iterator iter = mDecodeWorkers.begin(); iter != mDecodeWorkers.end(); ++iter)
+	{
+		DecodeWorker* worker = *iter;
+		// The threads are detached; wait for run() to return before deleting.
+		while (!worker->isStopped())
+		{
+			ms_sleep(1);
+		}
+		delete worker;
+	}
+	mDecodeWorkers.clear();
+}
+
+LLMeshRepoThread::DecodeWorker::DecodeWorker(LLMeshRepoThread* repo, S32 index)
+	: LLThread(llformat("meshdecode%d", index)),
+	  mRepo(repo)
+{
+	start();
+}
+
+// virtual
+// mRunCondition is locked here
+bool LLMeshRepoThread::DecodeWorker::runCondition()
+{
+	LLMutexLock lock(mRepo->mMutex);
+	return !mRepo->mLODDecodeQ.empty();
+}
+
+// virtual
+void LLMeshRepoThread::DecodeWorker::run()
+{
+	while (1)
+	{
+		// Sleeps until queueLODDecode() wakes us up with new LODs in the queue.
+		checkPause();
+
+		if (isQuitting())
+		{
+			break;
+		}
+
+		while (!isQuitting() && mRepo->decodeNextLOD())
+		{
+		}
+	}
+}
+
 bool LLMeshRepoThread::skinInfoReceived(const LLUUID& mesh_id, U8* data, S32 data_size)
 {
 	LLSD skin;
@@ -1959,6 +2380,7 @@ void LLMeshLODResponder::retry()
 void LLMeshLODResponder::completedRaw(LLChannelDescriptors const& channels,
 							          LLIOPipe::buffer_ptr_t const& buffer)
 {
+	LL_RECORD_BLOCK_TIME(FTM_MESH_LOD_RESPONSE);
 	mProcessed = true;
 	
 	// thread could have already be destroyed during logout
@@ -1991,34 +2413,17 @@ void LLMeshLODResponder::completedRaw(LLChannelDescriptors const& channels,
 
 	LLMeshRepository::sBytesReceived += mRequestedBytes;
 
-	U8* data = NULL;
+	std::vector<U8> data;
 
 	if (data_size > 0)
 	{
 		AIStateMachine::StateTimer timer("readAfter");
-		data = new U8[data_size];
-		buffer->readAfter(channels.in(), NULL, data, data_size);
-	}
-
-	if (gMeshRepo.mThread->lodReceived(mMeshParams, mLOD, data, data_size))
-	{
-		AIStateMachine::StateTimer timer("FileOpen");
-		//good fetch from sim, write to VFS for caching
-		LLVFile file(gVFS, mMeshParams.getSculptID(), LLAssetType::AT_MESH, LLVFile::WRITE);
-
-		S32 offset = mOffset;
-		S32 size = mRequestedBytes;
-
-		if (file.getSize() >= offset+size)
-		{
-			AIStateMachine::StateTimer timer("WriteData");
-			file.seek(offset);
-			file.write(data, size);
-			LLMeshRepository::sCacheBytesWritten += size;
-		}
+		data.resize(data_size);
+		buffer->readAfter(channels.in(), NULL, &data[0], data_size);
 	}
 
-	delete [] data;
+	//good fetch from sim, the decode threads write it to VFS for caching once it decoded
+	gMeshRepo.mThread->queueLODDecode(mMeshParams, mLOD, data, mOffset, mRequestedBytes);
 }
 
 void LLMeshSkinInfoResponder::retry()
@@ -2223,6 +2628,86 @@ void LLMeshPhysicsShapeResponder::completedRaw(LLChannelDescriptors const& chann
 	delete [] data;
 }
 
+void LLMeshRangeResponder::retry()
+{
+	LLMeshRepository::sHTTPRetryCount++;
+	for (LLMeshRepoThread::mesh_block_list::const_iterator iter = mBlocks.begin(); iter != mBlocks.end(); ++iter)
+	{
+		gMeshRepo.mThread->retryBlock(*iter);
+	}
+}
+
+void LLMeshRangeResponder::completedRaw(LLChannelDescriptors const& channels,
+										LLIOPipe::buffer_ptr_t const& buffer)
+{
+	LL_RECORD_BLOCK_TIME(FTM_MESH_LOD_RESPONSE);
+	mProcessed = true;
+
+	// thread could have already be destroyed during logout
+	if( !gMeshRepo.mThread )
+	{
+		return;
+	}
+
+	S32 data_size = buffer->countAfter(channels.in(), NULL);
+
+	if (mStatus < 200 || mStatus >= 400)
+	{
+		LL_WARNS() << mStatus << ": " << mReason << LL_ENDL;
+	}
+
+	//a 206 carries the requested range, a server that ignores the range sends the whole asset with a 200
+	U32 body_offset = mOffset;
+	if (mStatus != HTTP_PARTIAL_CONTENT)
+	{
+		body_offset = 0;
+	}
+
+	if (mStatus < 200 || mStatus >= 300 || data_size < (S32)(mOffset - body_offset + mRequestedBytes))
+	{
+		if (is_internal_http_error_that_warrants_a_retry(mStatus) || mStatus == HTTP_SERVICE_UNAVAILABLE)
+		{	//timeout or service unavailable, try again
+			LL_WARNS() << "Timeout or service unavailable, retrying." << LL_ENDL;
+			retry();
+		}
+		else
+		{
+			LL_WARNS() << "Unhandled status " << mStatus << " for " << mBlocks.size() << " blocks, failing each of them." << LL_ENDL;
+			for (LLMeshRepoThread::mesh_block_list::const_iterator iter = mBlocks.begin(); iter != mBlocks.end(); ++iter)
+			{
+				gMeshRepo.mThread->blockFailed(*iter);
+			}
+		}
+		return;
+	}
+
+	LLMeshRepository::sBytesReceived += mRequestedBytes;
+
+	U8* data = new U8[data_size];
+	buffer->readAfter(channels.in(), NULL, data, data_size);
+
+	//split the range back into its blocks, each cached on its own like a single fetch would
+	LLVFile file(gVFS, mBlocks.front().mMeshParams.getSculptID(), LLAssetType::AT_MESH, LLVFile::WRITE);
+	for (LLMeshRepoThread::mesh_block_list::const_iterator iter = mBlocks.begin(); iter != mBlocks.end(); ++iter)
+	{
+		U8* block_data = data + (iter->mOffset - body_offset);
+		if (iter->mType == LLMeshRepoThread::MeshBlock::LOD)
+		{ //decoded and cached by the decode threads
+			std::vector<U8> lod_data(block_data, block_data + iter->mSize);
+			gMeshRepo.mThread->queueLODDecode(iter->mMeshParams, iter->mLOD, lod_data, iter->mOffset, iter->mSize);
+		}
+		else if (gMeshRepo.mThread->blockReceived(*iter, block_data, iter->mSize) &&
+			file.getSize() >= iter->mOffset + iter->mSize)
+		{
+			file.seek(iter->mOffset);
+			file.write(block_data, iter->mSize);
+			LLMeshRepository::sCacheBytesWritten += iter->mSize;
+		}
+	}
+
+	delete [] data;
+}
+
 void LLMeshHeaderResponder::retry()
 {
 	AIStateMachine::StateTimer timer("Retry");
@@ -2288,7 +2773,9 @@ void LLMeshHeaderResponder::completedRaw(LLChannelDescriptors const& channels,
 	LLMeshRepository::sBytesReceived += llmin(data_size, 4096);
 
 	AIStateMachine::StateTimer timer("headerReceived");
-	bool success = gMeshRepo.mThread->headerReceived(mMeshParams, &data[0], data_size);
+	// The LODs wait until the response is in the cache: small meshes come along with
+	// the header and are then loaded from there instead of being requested again.
+	bool success = gMeshRepo.mThread->headerReceived(mMeshParams, &data[0], data_size, false);
 	
 	llassert(success);
 
@@ -2352,6 +2839,11 @@ void LLMeshHeaderResponder::completedRaw(LLChannelDescriptors const& channels,
 		}
 	}
 
+	if (success)
+	{
+		gMeshRepo.mThread->pushPendingLODs(mMeshParams);
+	}
+
 	if (data.size() > BUFF_MAX_STATIC_SIZE)
 	{
 		std::vector<U8>().swap(data);
@@ -2387,12 +2879,21 @@ void LLMeshRepository::init()
 	
 	mThread = new LLMeshRepoThread();
 	mThread->start();
+
+	S32 decode_threads = gSavedSettings.getS32("MeshDecodeThreads");
+	if (decode_threads <= 0)
+	{
+		decode_threads = (S32)std::thread::hardware_concurrency() / 4;
+	}
+	mThread->startDecodeWorkers(llclamp(decode_threads, 1, 8));
 }
 
 void LLMeshRepository::shutdown()
 {
 	LL_INFOS(LOG_MESH) << "Shutting down mesh repository." << LL_ENDL;
 
+	mThread->shutdownDecodeWorkers();
+
 	mThread->mSignal->signal();
 	
 	while (!mThread->isStopped())
@@ -2511,6 +3012,8 @@ S32 LLMeshRepository::loadMesh(LLVOVolume* vobj, const LLVolumeParams& mesh_para
 
 void LLMeshRepository::notifyLoadedMeshes()
 { //called from main thread
+	LL_RECORD_BLOCK_TIME(FTM_MESH_NOTIFY_LOADED);
+
 	static const LLCachedControl<U32> max_concurrent_requests("MeshMaxConcurrentRequests");
 	LLMeshRepoThread::sMaxConcurrentRequests = max_concurrent_requests;
 
@@ -2739,7 +3242,9 @@ void LLMeshRepository::notifyMeshLoaded(const LLVolumeParams& mesh_params, LLVol
 			LLVolume* sys_volume = LLPrimitive::getVolumeManager()->refVolume(mesh_params, detail);
 			if (sys_volume)
 			{
-				sys_volume->copyVolumeFaces(volume);
+				LL_RECORD_BLOCK_TIME(FTM_MESH_SWAP_FACES);
+				//volume was built for this and is thrown away after, no need to copy
+				sys_volume->swapVolumeFaces(volume);
 				sys_volume->setMeshAssetLoaded(TRUE);
 				LLPrimitive::getVolumeManager()->unrefVolume(sys_volume);
 			}
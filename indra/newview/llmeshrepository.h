@@ -260,6 +260,55 @@ public:
 		S32 mSize;
 	};
 
+	//one block of a mesh asset; blocks of the same asset that are queued at
+	//the same time and lie next to each other are fetched with one range request
+	struct MeshBlock
+	{
+		enum EType { LOD, SKIN, DECOMPOSITION, PHYSICS_SHAPE };
+
+		MeshBlock(EType type, const LLVolumeParams& mesh_params, S32 lod, S32 offset, S32 size)
+			: mType(type), mMeshParams(mesh_params), mLOD(lod), mOffset(offset), mSize(size) {}
+		MeshBlock(EType type, const LLUUID& mesh_id, S32 offset, S32 size)
+			: mType(type), mLOD(0), mOffset(offset), mSize(size)
+		{
+			mMeshParams.setSculptID(mesh_id, LL_SCULPT_TYPE_MESH);
+		}
+
+		EType mType;
+		LLVolumeParams mMeshParams;
+		S32 mLOD;		//only for LOD blocks
+		S32 mOffset;
+		S32 mSize;
+	};
+	typedef std::vector<MeshBlock> mesh_block_list;
+
+	//a LOD received on the main thread, waiting for a decode thread
+	struct LODDecodeRequest
+	{
+		LODDecodeRequest(const LLVolumeParams& mesh_params, S32 lod, S32 cache_offset, S32 cache_size)
+			: mMeshParams(mesh_params), mLOD(lod), mCacheOffset(cache_offset), mCacheSize(cache_size) {}
+
+		LLVolumeParams mMeshParams;
+		S32 mLOD;
+		S32 mCacheOffset;	//where the data goes in the VFS once it decoded
+		S32 mCacheSize;		//bytes of the data to write there, 0 to not cache it
+		std::vector<U8> mData;
+	};
+
+	//builds render-ready volumes out of the LODs received on the main thread
+	class DecodeWorker : public LLThread
+	{
+	public:
+		DecodeWorker(LLMeshRepoThread* repo, S32 index);
+
+	protected:
+		/*virtual*/ void run();
+		/*virtual*/ bool runCondition();
+
+	private:
+		LLMeshRepoThread* mRepo;
+	};
+
 	//set of requested skin info
 	uuid_set_t mSkinRequests;
 	
@@ -287,6 +336,11 @@ public:
 	//queue of successfully loaded meshes
 	std::queue<LoadedMesh> mLoadedQ;
 
+	//queue of received LODs waiting for a decode thread, protected by mMutex
+	std::deque<LODDecodeRequest> mLODDecodeQ;
+
+	std::vector<DecodeWorker*> mDecodeWorkers;
+
 	//map of pending header requests and currently desired LODs
 	typedef std::map<LLVolumeParams, std::vector<S32> > pending_lod_map;
 	pending_lod_map mPendingLOD;
@@ -316,8 +370,17 @@ public:
 	void loadMeshLOD(const LLVolumeParams& mesh_params, S32 lod);
 	bool fetchMeshHeader(const LLVolumeParams& mesh_params, U32& count);
 	bool fetchMeshLOD(const LLVolumeParams& mesh_params, S32 lod, U32& count);
-	bool headerReceived(const LLVolumeParams& mesh_params, U8* data, S32 data_size);
+	bool headerReceived(const LLVolumeParams& mesh_params, U8* data, S32 data_size, bool push_pending_lods = true);
+	//queue the LOD requests that were waiting for the header of mesh_params
+	void pushPendingLODs(const LLVolumeParams& mesh_params);
 	bool lodReceived(const LLVolumeParams& mesh_params, S32 lod, U8* data, S32 data_size);
+	//hand received LOD data (swapped out of data) to the decode threads, which write
+	//cache_size bytes of it to the VFS at cache_offset if it decodes
+	void queueLODDecode(const LLVolumeParams& mesh_params, S32 lod, std::vector<U8>& data, S32 cache_offset, S32 cache_size);
+	//decode the next queued LOD, returns false if there was none
+	bool decodeNextLOD();
+	void startDecodeWorkers(S32 num_threads);
+	void shutdownDecodeWorkers();
 	bool skinInfoReceived(const LLUUID& mesh_id, U8* data, S32 data_size);
 	bool decompositionReceived(const LLUUID& mesh_id, U8* data, S32 data_size);
 	bool physicsShapeReceived(const LLUUID& mesh_id, U8* data, S32 data_size);
@@ -345,6 +408,16 @@ public:
 	//  (should hold onto mesh_id and try again later if header info does not exist)
 	bool fetchMeshPhysicsShape(const LLUUID& mesh_id);
 
+	//send one range request for block and the queued blocks of the same mesh adjacent to it,
+	//returns false if the request could not be sent (block should be retried later)
+	bool fetchMeshBlocks(const std::string& http_url, const MeshBlock& block);
+	//hand a received block to its lodReceived/skinInfoReceived/... callback
+	bool blockReceived(const MeshBlock& block, U8* data, S32 data_size);
+	//request block again through its own queue
+	void retryBlock(const MeshBlock& block);
+	//give up on block the way a failed fetch of it alone would
+	void blockFailed(const MeshBlock& block);
+
 	static void incActiveLODRequests();
 	static void decActiveLODRequests();
 	static void incActiveHeaderRequests();
@@ -509,6 +582,8 @@ public:
 	static U32 sBytesReceived;
 	static U32 sHTTPRequestCount;
 	static U32 sHTTPRetryCount;
+	static U32 sHTTPRequestsSaved;		// block fetches that did not need a request of their own
+	static U32 sHTTPCoalescedRequests;	// range requests that carried more than one block
 	static U32 sLODPending;
 	static U32 sLODProcessing;
 	static U32 sCacheBytesRead;
@@ -815,6 +815,7 @@ LLSpatialPartition::LLSpatialPartition(U32 data_mask, BOOL render_by_group, U32
 	mDepthMask = FALSE;
 	mSlopRatio = 0.25f;
 	mInfiniteFarClip = FALSE;
+	mCullPass = 0;
 
 	new LLSpatialGroup(mOctree, this);
 }
@@ -948,6 +949,14 @@ public:
 		
 		return false;
 	}
+
+	virtual bool expectEarlyFail(LLViewerOctreeGroup* base_group) const
+	{
+		LLSpatialGroup* group = (LLSpatialGroup*)base_group;
+		return group->getOctreeNode()->getParent() &&
+			LLPipeline::sUseOcclusion &&
+			group->isOcclusionState(LLSpatialGroup::OCCLUDED);
+	}
 	
 	virtual S32 frustumCheck(const LLViewerOctreeGroup* group)
 	{
@@ -959,6 +968,20 @@ public:
 		return res;
 	}
 
+	virtual bool frustumCheckChildren(const OctreeNode* n, S32* results)
+	{
+		AABBInFrustumNoFarClipChildBounds(n, results);
+		for (U32 i = 0; i < n->getChildCount(); i++)
+		{
+			if (results[i] != 0)
+			{
+				const LLViewerOctreeGroup* group = (const LLViewerOctreeGroup*) n->getChild(i)->getListener(0);
+				results[i] = llmin(results[i], AABBSphereIntersectGroupExtents(group));
+			}
+		}
+		return true;
+	}
+
 	virtual S32 frustumCheckObjects(const LLViewerOctreeGroup* group)
 	{
 		S32 res = AABBInFrustumNoFarClipObjectBounds(group);
@@ -992,6 +1015,12 @@ public:
 		return AABBInFrustumNoFarClipGroupBounds(group);
 	}
 
+	virtual bool frustumCheckChildren(const OctreeNode* n, S32* results)
+	{
+		AABBInFrustumNoFarClipChildBounds(n, results);
+		return true;
+	}
+
 	virtual S32 frustumCheckObjects(const LLViewerOctreeGroup* group)
 	{
 		S32 res = AABBInFrustumNoFarClipObjectBounds(group);
@@ -1010,6 +1039,12 @@ public:
 		return AABBInFrustumGroupBounds(group);
 	}
 
+	virtual bool frustumCheckChildren(const OctreeNode* n, S32* results)
+	{
+		AABBInFrustumChildBounds(n, results);
+		return true;
+	}
+
 	virtual S32 frustumCheckObjects(const LLViewerOctreeGroup* group)
 	{
 		return AABBInFrustumObjectBounds(group);
@@ -1355,6 +1390,38 @@ S32 LLSpatialPartition::cull(LLCamera &camera, std::vector<LLDrawable *>* result
 	return 0;
 }
 S32 LLSpatialPartition::cull(LLCamera &camera, bool do_occlusion)
+{
+	prepareCull();
+
+	const U32 pass = mCullPass;
+	mCullPass = 0;
+
+	if (LLPipeline::sShadowRender)
+	{
+		LL_RECORD_BLOCK_TIME(FTM_FRUSTUM_CULL);
+		LLOctreeCullShadow culler(&camera);
+		culler.setFrustumPass(pass);
+		culler.traverse(mOctree);
+	}
+	else if (mInfiniteFarClip || !LLPipeline::sUseFarClip)
+	{
+		LL_RECORD_BLOCK_TIME(FTM_FRUSTUM_CULL);		
+		LLOctreeCullNoFarClip culler(&camera);
+		culler.setFrustumPass(pass);
+		culler.traverse(mOctree);
+	}
+	else
+	{
+		LL_RECORD_BLOCK_TIME(FTM_FRUSTUM_CULL);		
+		LLOctreeCull culler(&camera);
+		culler.setFrustumPass(pass);
+		culler.traverse(mOctree);
+	}
+	
+	return 0;
+}
+
+void LLSpatialPartition::prepareCull()
 {
 #if LL_OCTREE_PARANOIA_CHECK
 	((LLSpatialGroup*)mOctree->getListener(0))->checkStates();
@@ -1368,27 +1435,27 @@ S32 LLSpatialPartition::cull(LLCamera &camera, bool do_occlusion)
 #if LL_OCTREE_PARANOIA_CHECK
 	((LLSpatialGroup*)mOctree->getListener(0))->validate();
 #endif
+}
 
+// Must not log or record timers: this runs on worker threads.
+void LLSpatialPartition::precomputeCull(LLCamera &camera, U32 pass)
+{
 	if (LLPipeline::sShadowRender)
 	{
-		LL_RECORD_BLOCK_TIME(FTM_FRUSTUM_CULL);
 		LLOctreeCullShadow culler(&camera);
-		culler.traverse(mOctree);
+		culler.precomputeFrustumChecks(mOctree, pass);
 	}
 	else if (mInfiniteFarClip || !LLPipeline::sUseFarClip)
 	{
-		LL_RECORD_BLOCK_TIME(FTM_FRUSTUM_CULL);		
 		LLOctreeCullNoFarClip culler(&camera);
-		culler.traverse(mOctree);
+		culler.precomputeFrustumChecks(mOctree, pass);
 	}
 	else
 	{
-		LL_RECORD_BLOCK_TIME(FTM_FRUSTUM_CULL);		
 		LLOctreeCull culler(&camera);
-		culler.traverse(mOctree);
+		culler.precomputeFrustumChecks(mOctree, pass);
 	}
-	
-	return 0;
+	mCullPass = pass;
 }
 
 void pushVerts(LLDrawInfo* params, U32 mask)
@@ -414,6 +414,12 @@ public:
 	BOOL visibleObjectsInFrustum(LLCamera& camera);
 	/*virtual*/ S32 cull(LLCamera &camera, bool do_occlusion=false); // Cull on arbitrary frustum
 	S32 cull(LLCamera &camera, std::vector<LLDrawable *>* results); // Cull on arbitrary frustum
+
+	// LLPipeline::updateCull() splits cull() up: prepareCull() on the main
+	// thread, then precomputeCull() on any thread, alongside other partitions,
+	// and the next cull() on the same camera reuses the frustum checks.
+	void prepareCull();
+	void precomputeCull(LLCamera &camera, U32 pass);
 	
 	BOOL isVisible(const LLVector3& v);
 	bool isHUDPartition() ;
@@ -441,6 +447,9 @@ public:
 	BOOL mDepthMask; //if TRUE, objects in this partition will be written to depth during alpha rendering
 
 	static BOOL sTeleportRequested; //started to issue a teleport request
+
+private:
+	U32 mCullPass; //frustum checks precomputed for the next cull(), 0 for none
 };
 
 // class for creating bridges between spatial partitions
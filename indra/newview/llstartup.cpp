@@ -92,6 +92,8 @@
 #include "llxorcipher.h"	// saved password, MAC address
 #include "imageids.h"
 #include "message.h"
+#include "lltemplatemessagereader.h"
+#include "llmessagelog.h"
 #include "v3math.h"
 
 #include "llagent.h"
@@ -759,6 +761,7 @@ bool idle_startup()
 
 			F32 dropPercent = gSavedSettings.getF32("PacketDropPercentage");
 			msg->mPacketRing->setDropPercentage(dropPercent);
+			msg->mPacketRing->setUseBatchedIO(gSavedSettings.getBOOL("NetworkBatchedIO"));
 
             F32 inBandwidth = gSavedSettings.getF32("InBandwidth"); 
             F32 outBandwidth = gSavedSettings.getF32("OutBandwidth"); 
@@ -990,6 +993,10 @@ bool idle_startup()
 			return FALSE;
 		}
 
+		// Started once the proxy is settled, a SOCKS proxy keeps reading on
+		// the main thread.
+		gMessageSystem->setUseReceiveThread(gSavedSettings.getBOOL("NetworkReceiveThread"));
+
 		//reset the values that could have come in from a slurl
 		if (!gLoginHandler.getWebLoginKey().isNull())
 		{
@@ -1833,6 +1840,12 @@ bool idle_startup()
 
 		// Debugging info parameters
 		gMessageSystem->setMaxMessageTime( 0.5f );			// Spam if decoding all msgs takes more than 500 ms
+		LLTemplateMessageReader::setZeroCopyDecode(gSavedSettings.getBOOL("MessageZeroCopyDecode"));
+		std::string capture_file = gSavedSettings.getString("MessageCaptureFile");
+		if (!capture_file.empty())
+		{
+			LLMessageLog::startCapture(gDirUtilp->getExpandedFilename(LL_PATH_LOGS, capture_file));
+		}
 		display_startup();
 
 		#ifndef	LL_RELEASE_FOR_DOWNLOAD
@@ -39,11 +39,11 @@
 #include "llmemory.h"
 
 // Cache organization:
-// cache/texture.entries
-//  Unordered array of Entry structs
-// cache/texture.cache
-//  First TEXTURE_CACHE_ENTRY_SIZE bytes of each texture in texture.entries in same order
-// cache/textures/[0-F]/UUID.texture
+// cache/texturecache/texture.entries.[0-F]
+//  Unordered array of Entry structs, one file per header shard (first hex digit of the UUID)
+// cache/texturecache/texture.cache.[0-F]
+//  First TEXTURE_CACHE_ENTRY_SIZE bytes of each texture in the shard's entries file in same order
+// cache/texturecache/[0-F]/UUID.texture
 //  Actual texture body files
 
 //note: there is no good to define 1024 for TEXTURE_CACHE_ENTRY_SIZE while FIRST_PACKET_SIZE is 600 on sim side.
@@ -51,8 +51,6 @@ const S32 TEXTURE_CACHE_ENTRY_SIZE = FIRST_PACKET_SIZE;//1024;
 const F32 TEXTURE_CACHE_PURGE_AMOUNT = .20f; // % amount to reduce the cache by when it exceeds its limit
 const F32 TEXTURE_CACHE_LRU_SIZE = .10f; // % amount for LRU list (low overhead to regenerate)
 
-static std::queue<LLUUID> sgDelayedPurgeQueue;
-
 class LLTextureCacheWorker : public LLWorkerClass
 {
 	friend class LLTextureCache;
@@ -432,7 +430,7 @@ bool LLTextureCacheRemoteWorker::doRead()
 		size = llmin(size, mDataSize);
 		// Allocate the read buffer
 		mReadData = (U8*)ALLOCATE_MEM(LLImageBase::getPrivatePool(), size);
-		S32 bytes_read = LLAPRFile::readEx(mCache->mHeaderDataFileName, mReadData, offset, size);
+		S32 bytes_read = LLAPRFile::readEx(mCache->getHeaderDataFileName(mID), mReadData, offset, size);
 		if (bytes_read != size)
 		{
 			LL_WARNS() << "LLTextureCacheWorker: "  << mID
@@ -601,13 +599,13 @@ bool LLTextureCacheRemoteWorker::doWrite()
 			U8* padBuffer = (U8*)ALLOCATE_MEM(LLImageBase::getPrivatePool(), TEXTURE_CACHE_ENTRY_SIZE);
 			memset(padBuffer, 0, TEXTURE_CACHE_ENTRY_SIZE);		// Init with zeros
 			memcpy(padBuffer, mWriteData, mDataSize);			// Copy the write buffer
-			bytes_written = LLAPRFile::writeEx(mCache->mHeaderDataFileName, padBuffer, offset, size);
+			bytes_written = LLAPRFile::writeEx(mCache->getHeaderDataFileName(mID), padBuffer, offset, size);
 			FREE_MEM(LLImageBase::getPrivatePool(), padBuffer);
 		}
 		else
 		{
 			// Write the header record (== first TEXTURE_CACHE_ENTRY_SIZE bytes of the raw file) in the header file
-			bytes_written = LLAPRFile::writeEx(mCache->mHeaderDataFileName, mWriteData, offset, size);
+			bytes_written = LLAPRFile::writeEx(mCache->getHeaderDataFileName(mID), mWriteData, offset, size);
 		}
 
 		if (bytes_written <= 0)
@@ -739,10 +737,14 @@ void LLTextureCacheWorker::endWork(S32 param, bool aborted)
 
 LLTextureCache::LLTextureCache(bool threaded)
 	: LLWorkerThread("TextureCache", threaded),
-	  mHeaderAPRFile(NULL),
 	  mReadOnly(TRUE), //do not allow to change the texture cache until setReadOnly() is called.
-	  mTexturesSizeTotal(0),
-	  mDoPurge(FALSE)
+	  mNextFlushShard(0),
+	  mNextPurgeShard(0),
+	  mDoPurge(FALSE),
+	  mDecodedSizeTotal(0),
+	  mDecodedMaxSize(0),
+	  mDecodedHits(0),
+	  mDecodedMisses(0)
 {
 }
 
@@ -758,7 +760,7 @@ LLTextureCache::~LLTextureCache()
 S32 LLTextureCache::update(F32 max_time_ms)
 {
 	static LLFrameTimer timer;
-	static const F32 MAX_TIME_INTERVAL = 300.f; //seconds.
+	static const F32 FLUSH_TIME_INTERVAL = 1.f; //seconds, one shard is written back per interval.
 
 	S32 res;
 	res = LLWorkerThread::update(max_time_ms);
@@ -794,11 +796,16 @@ S32 LLTextureCache::update(F32 max_time_ms)
 		bool success = iter1->second;
 		responder->completed(success);
 	}
+
+	if (mDoPurge)
+	{
+		purgeTexturesIncremental();
+	}
 	
-	if(!res && timer.getElapsedTimeF32() > MAX_TIME_INTERVAL)
+	if(timer.getElapsedTimeF32() > FLUSH_TIME_INTERVAL)
 	{
 		timer.reset();
-		writeUpdatedEntries();
+		writeUpdatedEntriesIncremental();
 	}
 
 	return res;
@@ -826,10 +833,11 @@ std::string LLTextureCache::getTextureFileName(const LLUUID& id)
 //debug
 BOOL LLTextureCache::isInCache(const LLUUID& id) 
 {
-	LLMutexLock lock(&mHeaderMutex);
-	id_map_t::const_iterator iter = mHeaderIDMap.find(id);
+	HeaderShard& shard = getHeaderShard(id);
+	LLMutexLock lock(&shard.mMutex);
+	HeaderShard::id_map_t::const_iterator iter = shard.mIDMap.find(id);
 	
-	return (iter != mHeaderIDMap.end()) ;
+	return (iter != shard.mIDMap.end()) ;
 }
 
 //debug
@@ -871,11 +879,33 @@ BOOL LLTextureCache::isInLocal(const LLUUID& id)
 
 	return FALSE;
 }
+
+//debug
+U32 LLTextureCache::getEntries()
+{
+	U32 entries = 0;
+	for (S32 i = 0; i < HEADER_SHARD_COUNT; ++i)
+	{
+		entries += mHeaderShards[i].mInfo.mEntries;
+	}
+	return entries;
+}
+
+S64 LLTextureCache::getTexturesSizeTotal()
+{
+	S64 size = 0;
+	for (S32 i = 0; i < HEADER_SHARD_COUNT; ++i)
+	{
+		size += mHeaderShards[i].mBodySizeTotal;
+	}
+	return size;
+}
+
 //////////////////////////////////////////////////////////////////////////////
 
 //static
 const S32 MAX_REASONABLE_FILE_SIZE = 512*1024*1024; // 512 MB
-F32 LLTextureCache::sHeaderCacheVersion = 1.8f;
+F32 LLTextureCache::sHeaderCacheVersion = 1.9f;
 U32 LLTextureCache::sCacheMaxEntries = MAX_REASONABLE_FILE_SIZE / TEXTURE_CACHE_ENTRY_SIZE;
 S64 LLTextureCache::sCacheMaxTexturesSize = 0; // no limit
 const char* entries_filename = "texture.entries";
@@ -883,24 +913,27 @@ const char* cache_filename = "texture.cache";
 const char* old_textures_dirname = "textures";
 //change the location of the texture cache to prevent from being deleted by old version viewers.
 const char* textures_dirname = "texturecache";
+const char* subdirs = "0123456789abcdef";
+const char* decoded_dirname = "decoded";
 
 void LLTextureCache::setDirNames(ELLPath location)
 {
 	std::string delem = gDirUtilp->getDirDelimiter();
 
-	mHeaderEntriesFileName = gDirUtilp->getExpandedFilename(location, textures_dirname, entries_filename);
-	mHeaderDataFileName = gDirUtilp->getExpandedFilename(location, textures_dirname, cache_filename);
+	for (S32 i = 0; i < HEADER_SHARD_COUNT; ++i)
+	{
+		HeaderShard& shard = mHeaderShards[i];
+		shard.mEntriesFileName = gDirUtilp->getExpandedFilename(location, textures_dirname, llformat("%s.%c", entries_filename, subdirs[i]));
+		shard.mDataFileName = gDirUtilp->getExpandedFilename(location, textures_dirname, llformat("%s.%c", cache_filename, subdirs[i]));
+	}
 	mTexturesDirName = gDirUtilp->getExpandedFilename(location, textures_dirname);
 }
 
 void LLTextureCache::purgeCache(ELLPath location)
 {
-	LLMutexLock lock(&mHeaderMutex);
-
 	if (!mReadOnly)
 	{
 		setDirNames(location);
-		llassert_always(mHeaderAPRFile == NULL);
 
 		//remove the legacy cache if exists
 		std::string texture_dir = mTexturesDirName;
@@ -938,6 +971,8 @@ U64 LLTextureCache::initCache(ELLPath location, U64 max_size, BOOL texture_cache
 	U64 header_size = (max_size * 2) / 10;
 	U32 max_entries = header_size / TEXTURE_CACHE_ENTRY_SIZE;
 	sCacheMaxEntries = (llmin(sCacheMaxEntries, max_entries));
+	// Every header shard gets the same share of the entries.
+	sCacheMaxEntries -= sCacheMaxEntries % HEADER_SHARD_COUNT;
 	header_size = sCacheMaxEntries * TEXTURE_CACHE_ENTRY_SIZE;
 	max_size -= header_size;
 	if (sCacheMaxTexturesSize > 0)
@@ -967,7 +1002,6 @@ U64 LLTextureCache::initCache(ELLPath location, U64 max_size, BOOL texture_cache
 	{
 		LLFile::mkdir(mTexturesDirName);
 		
-		const char* subdirs = "0123456789abcdef";
 		for (S32 i=0; i<16; i++)
 		{
 			std::string dirname = mTexturesDirName + gDirUtilp->getDirDelimiter() + subdirs[i];
@@ -975,7 +1009,7 @@ U64 LLTextureCache::initCache(ELLPath location, U64 max_size, BOOL texture_cache
 		}
 	}
 	readHeaderCache();
-	purgeTextures(true); // calc mTexturesSize and make some room in the texture cache if we need it
+	purgeTextures(true); // make some room in the texture cache if we need it
 
 	llassert_always(getPending() == 0); //should not start accessing the texture cache before initialized.
 
@@ -983,65 +1017,167 @@ U64 LLTextureCache::initCache(ELLPath location, U64 max_size, BOOL texture_cache
 }
 
 //----------------------------------------------------------------------------
-// mHeaderMutex must be locked for the following functions!
+// The shard's mMutex must be locked for the following functions!
 
-LLAPRFile* LLTextureCache::openHeaderEntriesFile(bool readonly, S32 offset)
+void LLTextureCache::writeShardInfo(HeaderShard& shard)
 {
-	llassert_always(mHeaderAPRFile == NULL);
-	apr_int32_t flags = readonly ? APR_READ|APR_BINARY : APR_READ|APR_WRITE|APR_BINARY;
-	// All code calling openHeaderEntriesFile, immediately calls closeHeaderEntriesFile,
-	// so this file is very short-lived.
-	mHeaderAPRFile = new LLAPRFile(mHeaderEntriesFileName, flags);
-	if(offset > 0)
+	if (!mReadOnly)
 	{
-	mHeaderAPRFile->seek(APR_SET, offset);
+		LLAPRFile::writeEx(shard.mEntriesFileName, (U8*)&shard.mInfo, 0, sizeof(EntriesInfo));
 	}
-	return mHeaderAPRFile;
 }
 
-void LLTextureCache::closeHeaderEntriesFile()
+// Reads the whole entries file of the shard into memory with a single read.
+void LLTextureCache::readShard(HeaderShard& shard)
 {
-	if(!mHeaderAPRFile)
+	shard.mEntries.clear();
+	shard.mIDMap.clear();
+	shard.mFreeList.clear();
+	shard.mLRU.clear();
+	shard.mDirty.clear();
+	shard.mFlushedEntries = 0;
+	shard.mBodySizeTotal = 0;
+
+	// mInfo initializes to default values so safe not to read it
+	shard.mInfo = EntriesInfo();
+	if (LLAPRFile::isExist(shard.mEntriesFileName))
+	{
+		LLAPRFile::readEx(shard.mEntriesFileName, (U8*)&shard.mInfo, 0, sizeof(EntriesInfo));
+	}
+	if (shard.mInfo.mVersion != sHeaderCacheVersion)
 	{
+		// Missing or written by another version: start over with an empty shard.
+		clearShard(shard);
 		return;
 	}
 
-	delete mHeaderAPRFile;
-	mHeaderAPRFile = NULL;
+	U32 num_entries = shard.mInfo.mEntries;
+	if (num_entries)
+	{
+		shard.mEntries.resize(num_entries);
+		S32 bytes = num_entries * sizeof(Entry);
+		S32 bytes_read = LLAPRFile::readEx(shard.mEntriesFileName, (U8*)&shard.mEntries[0], sizeof(EntriesInfo), bytes);
+		if (bytes_read != bytes)
+		{
+			LL_WARNS() << "Corrupted header entries, read " << bytes_read << " / " << bytes << " bytes from " << shard.mEntriesFileName << LL_ENDL;
+			clearCorruptedShard(shard);
+			return;
+		}
+	}
+	shard.mFlushedEntries = num_entries;
+
+	const U32 max_entries = sCacheMaxEntries / HEADER_SHARD_COUNT;
+	for (U32 idx = 0; idx < num_entries; ++idx)
+	{
+		Entry& entry = shard.mEntries[idx];
+		if (entry.mImageSize > entry.mBodySize && idx < max_entries && shard.mIDMap.find(entry.mID) == shard.mIDMap.end())
+		{
+			shard.mIDMap[entry.mID] = idx;
+			shard.mBodySizeTotal += entry.mBodySize;
+			continue;
+		}
+		// Deleted, bad or (when the cache size was reduced) out of range entry.
+		if (entry.mBodySize > 0 && shard.mIDMap.find(entry.mID) == shard.mIDMap.end())
+		{
+			if (entry.mBodySize > entry.mImageSize)
+			{
+				// Shouldn't happen, failsafe only
+				LL_WARNS() << "Bad entry: " << idx << ": " << entry.mID << ": BodySize: " << entry.mBodySize << LL_ENDL;
+			}
+			LLAPRFile::remove(getTextureFileName(entry.mID));
+		}
+		entry.mImageSize = -1;
+		entry.mBodySize = 0;
+		if (idx < max_entries)
+		{
+			shard.mFreeList.insert(idx);
+		}
+	}
+
+	if (num_entries > max_entries)
+	{
+		// Special case: cache size was reduced, drop the entries that don't fit anymore.
+		LL_INFOS() << "Texture Cache Entries: " << num_entries << " Max: " << max_entries << " in " << shard.mEntriesFileName << LL_ENDL;
+		shard.mEntries.resize(max_entries);
+		shard.mInfo.mEntries = max_entries;
+		shard.mFlushedEntries = max_entries;
+		writeShardInfo(shard);
+	}
 }
 
-void LLTextureCache::readEntriesHeader()
+// Empties the shard, deleting its header files and the bodies of its textures.
+void LLTextureCache::clearShard(HeaderShard& shard)
 {
-	// mHeaderEntriesInfo initializes to default values so safe not to read it
-		llassert_always(mHeaderAPRFile == NULL);
-	if (LLAPRFile::isExist(mHeaderEntriesFileName))
+	shard.mEntries.clear();
+	shard.mIDMap.clear();
+	shard.mFreeList.clear();
+	shard.mLRU.clear();
+	shard.mDirty.clear();
+	shard.mFlushedEntries = 0;
+	shard.mBodySizeTotal = 0;
+
+	// Info with 0 entries
+	shard.mInfo.mVersion = sHeaderCacheVersion;
+	shard.mInfo.mEntries = 0;
+
+	if (!mReadOnly)
 	{
-		LLAPRFile::readEx(mHeaderEntriesFileName, (U8*)&mHeaderEntriesInfo, 0, sizeof(EntriesInfo));
+		// The bodies of the shard live in the sub-directory with the same hex digit.
+		std::string dirname = mTexturesDirName + gDirUtilp->getDirDelimiter() + subdirs[&shard - mHeaderShards];
+		gDirUtilp->deleteFilesInDir(dirname, "*");
+
+		if (LLAPRFile::isExist(shard.mDataFileName))
+		{
+			LLAPRFile::remove(shard.mDataFileName);
+		}
+		if (LLAPRFile::isExist(shard.mEntriesFileName))
+		{
+			LLAPRFile::remove(shard.mEntriesFileName);
+		}
+		writeShardInfo(shard);
 	}
-	else //create an empty entries header.
+}
+
+void LLTextureCache::clearCorruptedShard(HeaderShard& shard)
+{
+	LL_WARNS() << "the texture cache shard " << shard.mEntriesFileName << " is corrupted, need to be cleared." << LL_ENDL;
+
+	if (!mReadOnly) //regenerate the directory tree if not exists.
 	{
-		mHeaderEntriesInfo.mVersion = sHeaderCacheVersion;
-		mHeaderEntriesInfo.mEntries = 0;
-		writeEntriesHeader();
+		LLFile::mkdir(mTexturesDirName);
+		LLFile::mkdir(mTexturesDirName + gDirUtilp->getDirDelimiter() + subdirs[&shard - mHeaderShards]);
 	}
+	clearShard(shard);
 }
 
-void LLTextureCache::writeEntriesHeader()
+// Collects the oldest entries of the shard, they are reused first once the shard is full.
+void LLTextureCache::rebuildLRU(HeaderShard& shard)
 {
-	llassert_always(mHeaderAPRFile == NULL);
-	if (!mReadOnly)
+	shard.mLRU.clear();
+
+	typedef std::pair<U32, S32> lru_data_t;
+	std::vector<lru_data_t> lru;
+	lru.reserve(shard.mIDMap.size());
+	for (HeaderShard::id_map_t::iterator iter = shard.mIDMap.begin(); iter != shard.mIDMap.end(); ++iter)
+	{
+		lru.push_back(std::make_pair(shard.mEntries[iter->second].mTime, iter->second));
+	}
+
+	size_t lru_entries = llmax(1, (S32)((F32)(sCacheMaxEntries / HEADER_SHARD_COUNT) * TEXTURE_CACHE_LRU_SIZE));
+	lru_entries = llmin(lru_entries, lru.size());
+	std::partial_sort(lru.begin(), lru.begin() + lru_entries, lru.end());
+	for (size_t i = 0; i < lru_entries; ++i)
 	{
-		LLAPRFile::writeEx(mHeaderEntriesFileName, (U8*)&mHeaderEntriesInfo, 0, sizeof(EntriesInfo));
+		shard.mLRU.insert(shard.mEntries[lru[i].second].mID);
 	}
 }
 
-//mHeaderMutex is locked before calling this.
-S32 LLTextureCache::openAndReadEntry(const LLUUID& id, Entry& entry, bool create)
+S32 LLTextureCache::openAndReadEntry(HeaderShard& shard, const LLUUID& id, Entry& entry, bool create)
 {
 	S32 idx = -1;
 	
-	id_map_t::iterator iter1 = mHeaderIDMap.find(id);
-	if (iter1 != mHeaderIDMap.end())
+	HeaderShard::id_map_t::iterator iter1 = shard.mIDMap.find(id);
+	if (iter1 != shard.mIDMap.end())
 	{
 		idx = iter1->second;
 	}
@@ -1050,38 +1186,39 @@ S32 LLTextureCache::openAndReadEntry(const LLUUID& id, Entry& entry, bool create
 	{
 		if (create && !mReadOnly)
 		{
-			if (mHeaderEntriesInfo.mEntries < sCacheMaxEntries)
+			if (shard.mInfo.mEntries < sCacheMaxEntries / HEADER_SHARD_COUNT)
 			{
-				// Add an entry to the end of the list
-				idx = mHeaderEntriesInfo.mEntries++;
-
+				// Add an entry to the end of the list, it reaches the disk with the next flush.
+				idx = shard.mInfo.mEntries++;
+				shard.mEntries.push_back(Entry());
 			}
-			else if (!mFreeList.empty())
+			else if (!shard.mFreeList.empty())
 			{
-				idx = *(mFreeList.begin());
-				mFreeList.erase(mFreeList.begin());
+				idx = *(shard.mFreeList.begin());
+				shard.mFreeList.erase(shard.mFreeList.begin());
 			}
 			else
 			{
+				if (shard.mLRU.empty())
+				{
+					rebuildLRU(shard);
+				}
 				// Look for a still valid entry in the LRU
-				for (auto iter2 = mLRU.begin(); iter2 != mLRU.end();)
+				for (auto iter2 = shard.mLRU.begin(); iter2 != shard.mLRU.end();)
 				{
 					auto curiter2 = iter2++;
 					LLUUID oldid = *curiter2;
 					// Erase entry from LRU regardless
-					mLRU.erase(curiter2);
+					shard.mLRU.erase(curiter2);
 					// Look up entry and use it if it is valid
-					id_map_t::iterator iter3 = mHeaderIDMap.find(oldid);
-					if (iter3 != mHeaderIDMap.end() && iter3->second >= 0)
+					HeaderShard::id_map_t::iterator iter3 = shard.mIDMap.find(oldid);
+					if (iter3 != shard.mIDMap.end() && iter3->second >= 0)
 					{
 						idx = iter3->second;
-						removeCachedTexture(oldid);//remove the existing cached texture to release the entry index.
+						removeCachedTexture(shard, oldid);//remove the existing cached texture to release the entry index.
 						break;
 					}
 				}
-				// if (idx < 0) at this point, we will rebuild the LRU 
-				//  and retry if called from setHeaderCacheEntry(),
-				//  otherwise this shouldn't happen and will trigger an error
 			}
 			if (idx >= 0)
 			{
@@ -1094,420 +1231,203 @@ S32 LLTextureCache::openAndReadEntry(const LLUUID& id, Entry& entry, bool create
 	else
 	{
 		// Remove this entry from the LRU if it exists
-		mLRU.erase(id);
+		shard.mLRU.erase(id);
 		// Read the entry
-		idx_entry_map_t::iterator iter = mUpdatedEntryMap.find(idx);
-		if(iter != mUpdatedEntryMap.end())
-		{
-			entry = iter->second;
-		}
-		else
-		{
-			readEntryFromHeaderImmediately(idx, entry);
-		}
+		entry = shard.mEntries[idx];
 		if(entry.mImageSize <= entry.mBodySize)//it happens on 64-bit systems, do not know why
 		{
 			LL_WARNS() << "corrupted entry: " << id << " entry image size: " << entry.mImageSize << " entry body size: " << entry.mBodySize << LL_ENDL;
 
 			//erase this entry and the cached texture from the cache.
 			std::string tex_filename = getTextureFileName(id);
-			removeEntry(idx, entry, tex_filename);
-			mUpdatedEntryMap.erase(idx);
+			removeEntry(shard, idx, entry, tex_filename);
 			idx = -1;
 		}
 	}
 	return idx;
 }
 
-//mHeaderMutex is locked before calling this.
-void LLTextureCache::writeEntryToHeaderImmediately(S32& idx, Entry& entry, bool write_header)
-{	
-	LLAPRFile* aprfile;
-	S32 bytes_written;
-	S32 offset = sizeof(EntriesInfo) + idx * sizeof(Entry);
-	if(write_header)
-	{
-		aprfile = openHeaderEntriesFile(false, 0);		
-		bytes_written = aprfile->write((U8*)&mHeaderEntriesInfo, sizeof(EntriesInfo));
-		if(bytes_written != sizeof(EntriesInfo))
-		{
-			clearCorruptedCache(); //clear the cache.
-			idx = -1; //mark the idx invalid.
-			return;
-		}
-
-		mHeaderAPRFile->seek(APR_SET, offset);
-	}
-	else
+// Used when a deleted entry is reused: the header data of the slot is about to be
+// overwritten, so the entries file must not keep pointing at the previous texture.
+void LLTextureCache::writeEntryToHeaderImmediately(HeaderShard& shard, S32& idx, Entry& entry)
+{
+	if (mReadOnly)
 	{
-		aprfile = openHeaderEntriesFile(false, offset);
+		return;
 	}
-	bytes_written = aprfile->write((void*)&entry, (S32)sizeof(Entry));
+
+	S32 offset = sizeof(EntriesInfo) + idx * sizeof(Entry);
+	S32 bytes_written = LLAPRFile::writeEx(shard.mEntriesFileName, (U8*)&entry, offset, sizeof(Entry));
 	if(bytes_written != sizeof(Entry))
 	{
-		clearCorruptedCache(); //clear the cache.
+		clearCorruptedShard(shard); //clear the shard.
 		idx = -1; //mark the idx invalid.
-
 		return;
 	}
-
-	closeHeaderEntriesFile();
-	mUpdatedEntryMap.erase(idx);
-}
-
-//mHeaderMutex is locked before calling this.
-void LLTextureCache::readEntryFromHeaderImmediately(S32& idx, Entry& entry)
-{
-		S32 offset = sizeof(EntriesInfo) + idx * sizeof(Entry);
-		LLAPRFile* aprfile = openHeaderEntriesFile(true, offset);
-		S32 bytes_read = aprfile->read((void*)&entry, (S32)sizeof(Entry));
-		closeHeaderEntriesFile();
-
-	if(bytes_read != sizeof(Entry))
-	{
-		clearCorruptedCache(); //clear the cache.
-		idx = -1;//mark the idx invalid.
-	}
+	shard.mDirty.erase(idx);
 }
 
-//mHeaderMutex is locked before calling this.
 //update an existing entry time stamp, delay writing.
-void LLTextureCache::updateEntryTimeStamp(S32 idx, Entry& entry)
+void LLTextureCache::updateEntryTimeStamp(HeaderShard& shard, S32 idx, Entry& entry)
 {
-	static const U32 MAX_ENTRIES_WITHOUT_TIME_STAMP = (U32)(LLTextureCache::sCacheMaxEntries * 0.75f);
-
-	if(mHeaderEntriesInfo.mEntries < MAX_ENTRIES_WITHOUT_TIME_STAMP)
+	if (idx >= 0 && !mReadOnly)
 	{
-		return; //there are enough empty entry index space, no need to stamp time.
-	}
+		entry.mTime = time(NULL);
+		shard.mEntries[idx].mTime = entry.mTime;
 
-	if (idx >= 0)
-	{
-		if (!mReadOnly)
+		// Only worth a write when the shard is getting full and the LRU order matters.
+		const U32 max_entries_without_time_stamp = (U32)((sCacheMaxEntries / HEADER_SHARD_COUNT) * 0.75f);
+		if (shard.mInfo.mEntries >= max_entries_without_time_stamp)
 		{
-			entry.mTime = time(NULL);
-			mUpdatedEntryMap[idx] = entry;
+			shard.mDirty.insert(idx);
 		}
 	}
 }
 
-//update an existing entry, write to header file immediately.
-bool LLTextureCache::updateEntry(S32& idx, Entry& entry, S32 new_image_size, S32 new_data_size)
+bool LLTextureCache::updateEntryLocked(HeaderShard& shard, S32& idx, Entry& entry, S32 new_image_size, S32 new_data_size)
 {
 	S32 new_body_size = llmax(0, new_data_size - TEXTURE_CACHE_ENTRY_SIZE);
 	
 	if(new_image_size == entry.mImageSize && new_body_size == entry.mBodySize)
-			{
-		return true; //nothing changed.
-			}
-	else 
 	{
-		bool purge = false;
-			
-		lockHeaders();
-
-		bool update_header = false;
-		if(entry.mImageSize < 0) //is a brand-new entry
-			{
-			mHeaderIDMap[entry.mID] = idx;
-			mTexturesSizeMap[entry.mID] = new_body_size;
-			mTexturesSizeTotal += new_body_size;
-			
-			// Update Header
-			update_header = true;
-			}
-		else if (entry.mBodySize != new_body_size)
-		{
-			//already in mHeaderIDMap.
-			mTexturesSizeMap[entry.mID] = new_body_size;
-			mTexturesSizeTotal -= entry.mBodySize;
-			mTexturesSizeTotal += new_body_size;
-		}
-		entry.mTime = time(NULL);
-		entry.mImageSize = new_image_size; 
-		entry.mBodySize = new_body_size;
-		
-		writeEntryToHeaderImmediately(idx, entry, update_header);
-	
-		if (mTexturesSizeTotal > sCacheMaxTexturesSize)
-		{
-			purge = true;
-		}
-		
-		unlockHeaders();
-
-		if (purge)
-		{
-			mDoPurge = TRUE;
-		}
+		return true; //nothing changed.
 	}
 
-	return false;
-}
-
-U32 LLTextureCache::openAndReadEntries(std::vector<Entry>& entries)
-{
-	U32 num_entries = mHeaderEntriesInfo.mEntries;
-
-	mHeaderIDMap.clear();
-	mTexturesSizeMap.clear();
-	mFreeList.clear();
-	mTexturesSizeTotal = 0;
-
-	LLAPRFile* aprfile = NULL; 
-	if(mUpdatedEntryMap.empty())
+	bool brand_new = entry.mImageSize < 0;
+	if (brand_new)
 	{
-		aprfile = openHeaderEntriesFile(true, (S32)sizeof(EntriesInfo));
+		shard.mIDMap[entry.mID] = idx;
+		shard.mBodySizeTotal += new_body_size;
 	}
-	else //update the header file first.
+	else
 	{
-		aprfile = openHeaderEntriesFile(false, 0);
-		updatedHeaderEntriesFile();
-		if(!aprfile)
+		HeaderShard::id_map_t::iterator iter = shard.mIDMap.find(entry.mID);
+		if (iter == shard.mIDMap.end() || iter->second != idx)
 		{
-			return 0;
+			// The entry was removed or reused since the caller read it.
+			idx = -1;
+			return false;
 		}
-		aprfile->seek(APR_SET, (S32)sizeof(EntriesInfo));
+		shard.mBodySizeTotal += new_body_size - shard.mEntries[idx].mBodySize;
 	}
-	for (U32 idx=0; idx<num_entries; idx++)
+	entry.mTime = time(NULL);
+	entry.mImageSize = new_image_size; 
+	entry.mBodySize = new_body_size;
+	shard.mEntries[idx] = entry;
+
+	if (brand_new && (U32)idx < shard.mFlushedEntries)
 	{
-		Entry entry;
-		S32 bytes_read = aprfile->read((void*)(&entry), (S32)sizeof(Entry));
-		if (bytes_read < sizeof(Entry))
-		{
-			LL_WARNS() << "Corrupted header entries, failed at " << idx << " / " << num_entries << LL_ENDL;
-			closeHeaderEntriesFile();
-			purgeAllTextures(false);
-			return 0;
-		}
-		entries.push_back(entry);
-// 		LL_INFOS() << "ENTRY: " << entry.mTime << " TEX: " << entry.mID << " IDX: " << idx << " Size: " << entry.mImageSize << LL_ENDL;
-		if(entry.mImageSize > entry.mBodySize)
-		{
-			mHeaderIDMap[entry.mID] = idx;
-				mTexturesSizeMap[entry.mID] = entry.mBodySize;
-				mTexturesSizeTotal += entry.mBodySize;
-			}
-		else
-		{
-			mFreeList.insert(idx);
-		}
+		writeEntryToHeaderImmediately(shard, idx, entry);
+	}
+	else
+	{
+		shard.mDirty.insert(idx);
 	}
-	closeHeaderEntriesFile();
-	return num_entries;
-}
 
-void LLTextureCache::writeEntriesAndClose(const std::vector<Entry>& entries)
-{
-	S32 num_entries = entries.size();
-	llassert_always(num_entries == mHeaderEntriesInfo.mEntries);
-	
-	if (!mReadOnly)
+	if (shard.mBodySizeTotal > sCacheMaxTexturesSize / HEADER_SHARD_COUNT)
 	{
-		LLAPRFile* aprfile = openHeaderEntriesFile(false, (S32)sizeof(EntriesInfo));
-		U64 write_size = U64(sizeof(Entry)) * num_entries;
-		U64 bytes_written = aprfile->write((void*)(entries.data()), write_size);
-		if (bytes_written != write_size)
-		{
-			clearCorruptedCache(); //clear the cache.
-			return;
-		}
-		closeHeaderEntriesFile();
+		mDoPurge = TRUE;
 	}
+
+	return false;
 }
 
-void LLTextureCache::writeUpdatedEntries()
+// Writes the dirty entries of the shard, then its info, through a single file handle.
+void LLTextureCache::flushDirtyEntries(HeaderShard& shard)
 {
-	lockHeaders();
-	if (!mReadOnly && !mUpdatedEntryMap.empty())
+	if (mReadOnly || (shard.mDirty.empty() && shard.mFlushedEntries == shard.mInfo.mEntries))
 	{
-		openHeaderEntriesFile(false, 0);
-		updatedHeaderEntriesFile();
-		closeHeaderEntriesFile();
+		return;
 	}
-	unlockHeaders();
-}
 
-//mHeaderMutex is locked and mHeaderAPRFile is created before calling this.
-void LLTextureCache::updatedHeaderEntriesFile()
-{
-	if (!mReadOnly && !mUpdatedEntryMap.empty() && mHeaderAPRFile)
+	bool corrupted = false;
 	{
-		//entriesInfo
-		mHeaderAPRFile->seek(APR_SET, 0);
-		S32 bytes_written = mHeaderAPRFile->write((U8*)&mHeaderEntriesInfo, sizeof(EntriesInfo));
-		if(bytes_written != sizeof(EntriesInfo))
+		LLAPRFile aprfile(shard.mEntriesFileName, APR_READ|APR_WRITE|APR_BINARY);
+		if (!aprfile.getFileHandle())
 		{
-			clearCorruptedCache(); //clear the cache.
-			return;
+			corrupted = true;
 		}
-		
-		//write each updated entry
-		S32 entry_size = (S32)sizeof(Entry);
-		S32 prev_idx = -1;
-		S32 delta_idx;
-		for (idx_entry_map_t::iterator iter = mUpdatedEntryMap.begin(); iter != mUpdatedEntryMap.end(); ++iter)
-		{
-			delta_idx = iter->first - prev_idx - 1;
-			prev_idx = iter->first;
-			if(delta_idx)
+
+		const S32 entry_size = (S32)sizeof(Entry);
+		S32 next_idx = -1;
+		for (std::set<S32>::iterator iter = shard.mDirty.begin(); !corrupted && iter != shard.mDirty.end(); ++iter)
+		{
+			S32 idx = *iter;
+			if (idx != next_idx)
 			{
-				mHeaderAPRFile->seek(APR_CUR, delta_idx * entry_size);
+				aprfile.seek(APR_SET, sizeof(EntriesInfo) + idx * entry_size);
 			}
-			
-			bytes_written = mHeaderAPRFile->write((void*)(&iter->second), entry_size);
-			if(bytes_written != entry_size)
+			if (aprfile.write((void*)&shard.mEntries[idx], entry_size) != entry_size)
 			{
-				clearCorruptedCache(); //clear the cache.
-				return;
+				corrupted = true;
 			}
+			next_idx = idx + 1;
 		}
-		mUpdatedEntryMap.clear();
-	}
-}
-//----------------------------------------------------------------------------
 
-// Called from either the main thread or the worker thread
-void LLTextureCache::readHeaderCache()
-{
-	mHeaderMutex.lock();
-
-	mLRU.clear(); // always clear the LRU
-
-	readEntriesHeader();
-	
-	if (mHeaderEntriesInfo.mVersion != sHeaderCacheVersion)
-	{
-		if (!mReadOnly)
+		// Appended entries only become visible once they are all on disk.
+		if (!corrupted)
 		{
-			purgeAllTextures(false);
+			aprfile.seek(APR_SET, 0);
+			corrupted = aprfile.write((void*)&shard.mInfo, sizeof(EntriesInfo)) != sizeof(EntriesInfo);
 		}
 	}
-	else
+
+	if (corrupted)
 	{
-		std::vector<Entry> entries;
-		U32 num_entries = openAndReadEntries(entries);
-		if (num_entries)
-		{
-			U32 empty_entries = 0;
-			typedef std::pair<U32, S32> lru_data_t;
-			std::set<lru_data_t> lru;
-			std::set<U32> purge_list;
-			for (U32 i=0; i<num_entries; i++)
-			{
-				Entry& entry = entries[i];
-				if (entry.mImageSize <= 0)
-				{
-					// This will be in the Free List, don't put it in the LRU
-					++empty_entries;
-				}
-				else
-				{
-					lru.insert(std::make_pair(entry.mTime, i));
-					if (entry.mBodySize > 0)
-					{
-						if (entry.mBodySize > entry.mImageSize)
-						{
-							// Shouldn't happen, failsafe only
-							LL_WARNS() << "Bad entry: " << i << ": " << entry.mID << ": BodySize: " << entry.mBodySize << LL_ENDL;
-							purge_list.insert(i);
-						}
-					}
-				}
-			}
-			if (num_entries - empty_entries > sCacheMaxEntries)
-			{
-				// Special case: cache size was reduced, need to remove entries
-				// Note: After we prune entries, we will call this again and create the LRU
-				U32 entries_to_purge = (num_entries - empty_entries) - sCacheMaxEntries;
-				LL_INFOS() << "Texture Cache Entries: " << num_entries << " Max: " << sCacheMaxEntries << " Empty: " << empty_entries << " Purging: " << entries_to_purge << LL_ENDL;
-				// We can exit the following loop with the given condition, since if we'd reach the end of the lru set we'd have:
-				// purge_list.size() = lru.size() = num_entries - empty_entries = entries_to_purge + sCacheMaxEntries >= entries_to_purge
-				// So, it's certain that iter will never reach lru.end() first.
-				std::set<lru_data_t>::iterator iter = lru.begin();
-				while (purge_list.size() < entries_to_purge)
-				{
-					purge_list.insert(iter->second);
-					++iter;
-				}
-			}
-			else
-			{
-				S32 lru_entries = (S32)((F32)sCacheMaxEntries * TEXTURE_CACHE_LRU_SIZE);
-				for (std::set<lru_data_t>::iterator iter = lru.begin(); iter != lru.end(); ++iter)
-				{
-					mLRU.insert(entries[iter->second].mID);
-// 					LL_INFOS() << "LRU: " << iter->first << " : " << iter->second << LL_ENDL;
-					if (--lru_entries <= 0)
-						break;
-				}
-			}
-			
-			if (purge_list.size() > 0)
-			{
-				for (std::set<U32>::iterator iter = purge_list.begin(); iter != purge_list.end(); ++iter)
-				{
-					std::string tex_filename = getTextureFileName(entries[*iter].mID);
-					removeEntry((S32)*iter, entries[*iter], tex_filename);
-				}
-				// If we removed any entries, we need to rebuild the entries list,
-				// write the header, and call this again
-				std::vector<Entry> new_entries;
-				for (U32 i=0; i<num_entries; i++)
-				{
-					const Entry& entry = entries[i];
-					if (entry.mImageSize > 0)
-					{
-						new_entries.push_back(entry);
-					}
-				}
-				llassert_always(new_entries.size() <= sCacheMaxEntries);
-				mHeaderEntriesInfo.mEntries = new_entries.size();
-				writeEntriesHeader();
-				writeEntriesAndClose(new_entries);
-				mHeaderMutex.unlock(); // unlock the mutex before calling again
-				readHeaderCache(); // repeat with new entries file
-				mHeaderMutex.lock();
-			}
-			else
-			{
-				//entries are not changed, nothing here.
-			}
-		}
+		clearCorruptedShard(shard); //clear the shard.
+		return;
 	}
-	mHeaderMutex.unlock();
+	shard.mDirty.clear();
+	shard.mFlushedEntries = shard.mInfo.mEntries;
 }
 
-//////////////////////////////////////////////////////////////////////////////
+//----------------------------------------------------------------------------
 
-//the header mutex is locked before calling this.
-void LLTextureCache::clearCorruptedCache()
+//update an existing entry, the change is written back later.
+bool LLTextureCache::updateEntry(S32& idx, Entry& entry, S32 new_image_size, S32 new_data_size)
 {
-	LL_WARNS() << "the texture cache is corrupted, need to be cleared." << LL_ENDL;
+	HeaderShard& shard = getHeaderShard(entry.mID);
+	LLMutexLock lock(&shard.mMutex);
+	return updateEntryLocked(shard, idx, entry, new_image_size, new_data_size);
+}
 
-	closeHeaderEntriesFile();//close possible file handler
-	purgeAllTextures(false); //clear the cache.
-	
-	if (!mReadOnly) //regenerate the directory tree if not exists.
+void LLTextureCache::writeUpdatedEntries()
+{
+	for (S32 i = 0; i < HEADER_SHARD_COUNT; ++i)
 	{
-		LLFile::mkdir(mTexturesDirName);
-		
-		const char* subdirs = "0123456789abcdef";
-		for (S32 i=0; i<16; i++)
-		{
-			std::string dirname = mTexturesDirName + gDirUtilp->getDirDelimiter() + subdirs[i];
-			LLFile::mkdir(dirname);
-		}
+		HeaderShard& shard = mHeaderShards[i];
+		LLMutexLock lock(&shard.mMutex);
+		flushDirtyEntries(shard);
 	}
+}
+
+// Called from the main thread, writes back one shard per call.
+void LLTextureCache::writeUpdatedEntriesIncremental()
+{
+	HeaderShard& shard = mHeaderShards[mNextFlushShard];
+	mNextFlushShard = (mNextFlushShard + 1) % HEADER_SHARD_COUNT;
 
-	return;
+	LLMutexLock lock(&shard.mMutex);
+	flushDirtyEntries(shard);
 }
 
+// Called from the main thread at startup
+void LLTextureCache::readHeaderCache()
+{
+	for (S32 i = 0; i < HEADER_SHARD_COUNT; ++i)
+	{
+		HeaderShard& shard = mHeaderShards[i];
+		LLMutexLock lock(&shard.mMutex);
+		readShard(shard);
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
 void LLTextureCache::purgeAllTextures(bool purge_directories)
 {
 	if (!mReadOnly)
 	{
-		const char* subdirs = "0123456789abcdef";
 		std::string delem = gDirUtilp->getDirDelimiter();
 		std::string mask = "*";
 		for (S32 i=0; i<16; i++)
@@ -1520,41 +1440,107 @@ void LLTextureCache::purgeAllTextures(bool purge_directories)
 				LLFile::rmdir(dirname);
 			}
 		}
+
+		std::string decoded_dir = mTexturesDirName + delem + decoded_dirname;
+		gDirUtilp->deleteFilesInDir(decoded_dir, mask);
 		if (purge_directories)
 		{
+			LLFile::rmdir(decoded_dir);
 			gDirUtilp->deleteFilesInDir(mTexturesDirName, mask);
 			LLFile::rmdir(mTexturesDirName);
 		}
 	}
-	mHeaderIDMap.clear();
-	mTexturesSizeMap.clear();
-	mTexturesSizeTotal = 0;
-	mFreeList.clear();
-	mTexturesSizeTotal = 0;
-	mUpdatedEntryMap.clear();
 
-	// Info with 0 entries
-	mHeaderEntriesInfo.mVersion = sHeaderCacheVersion;
-	mHeaderEntriesInfo.mEntries = 0;
-	writeEntriesHeader();
+	{
+		LLMutexLock lock(&mDecodedMutex);
+		mDecodedMap.clear();
+		mDecodedLRU.clear();
+		mDecodedSizeTotal = 0;
+	}
+
+	for (S32 i = 0; i < HEADER_SHARD_COUNT; ++i)
+	{
+		HeaderShard& shard = mHeaderShards[i];
+		LLMutexLock lock(&shard.mMutex);
+		shard.mEntries.clear();
+		shard.mIDMap.clear();
+		shard.mFreeList.clear();
+		shard.mLRU.clear();
+		shard.mDirty.clear();
+		shard.mFlushedEntries = 0;
+		shard.mBodySizeTotal = 0;
+
+		// Info with 0 entries
+		shard.mInfo.mVersion = sHeaderCacheVersion;
+		shard.mInfo.mEntries = 0;
+		if (!purge_directories && !mReadOnly)
+		{
+			LLAPRFile::remove(shard.mEntriesFileName);
+			writeShardInfo(shard);
+		}
+	}
 
 	LL_INFOS() << "The entire texture cache is cleared." << LL_ENDL;
 }
 
-void LLTextureCache::performDelayedPurge()
+// Called from the main thread while the cache is over budget. Each call looks
+// at the next PURGE_SCAN_PER_CALL entries of one shard, from where the last
+// call on that shard stopped, and removes the oldest bodies among them. That
+// approximates LRU order without ever scanning a whole shard at once.
+void LLTextureCache::purgeTexturesIncremental()
 {
-	LLMutexLock lock(&mHeaderMutex);
-	while(!sgDelayedPurgeQueue.empty())
+	static const U32 PURGE_SCAN_PER_CALL = 512;
+	static const S32 MAX_PURGE_PER_CALL = 64;
+
+	HeaderShard& shard = mHeaderShards[mNextPurgeShard];
+	mNextPurgeShard = (mNextPurgeShard + 1) % HEADER_SHARD_COUNT;
+
+	LLMutexLock lock(&shard.mMutex);
+
+	S64 purged_shard_size = (sCacheMaxTexturesSize * (S64)((1.f-TEXTURE_CACHE_PURGE_AMOUNT)*100)) / (100 * HEADER_SHARD_COUNT);
+	U32 num_entries = (U32)shard.mEntries.size();
+	if (shard.mBodySizeTotal > purged_shard_size && num_entries)
 	{
-		removeFromCache(sgDelayedPurgeQueue.front());
-		sgDelayedPurgeQueue.pop();
-		if (mTexturesSizeTotal < sCacheMaxTexturesSize)
+		typedef std::pair<U32, S32> time_idx_t;
+		std::vector<time_idx_t> time_idx_set;
+		U32 scan = llmin(PURGE_SCAN_PER_CALL, num_entries);
+		time_idx_set.reserve(scan);
+		U32 entry_idx = shard.mPurgeCursor % num_entries;
+		for (U32 i = 0; i < scan; ++i)
+		{
+			// Removed entries have no body
+			if (shard.mEntries[entry_idx].mBodySize > 0)
+			{
+				time_idx_set.push_back(std::make_pair(shard.mEntries[entry_idx].mTime, (S32)entry_idx));
+			}
+			if (++entry_idx == num_entries)
+			{
+				entry_idx = 0;
+			}
+		}
+		shard.mPurgeCursor = entry_idx;
+		size_t sorted = llmin((size_t)MAX_PURGE_PER_CALL, time_idx_set.size());
+		std::partial_sort(time_idx_set.begin(), time_idx_set.begin() + sorted, time_idx_set.end());
+
+		for (size_t i = 0; i < sorted && shard.mBodySizeTotal > purged_shard_size; ++i)
 		{
-			break;
+			S32 idx = time_idx_set[i].second;
+			std::string filename = getTextureFileName(shard.mEntries[idx].mID);
+	 		LL_DEBUGS("TextureCache") << "PURGING: " << filename << LL_ENDL;
+			removeEntry(shard, idx, shard.mEntries[idx], filename);
 		}
 	}
+
+	// Keep going until every shard is back under its share.
+	bool purge = false;
+	for (S32 i = 0; i < HEADER_SHARD_COUNT && !purge; ++i)
+	{
+		purge = mHeaderShards[i].mBodySizeTotal > sCacheMaxTexturesSize / HEADER_SHARD_COUNT;
+	}
+	mDoPurge = purge;
 }
 
+// Called from the main thread at startup, before any worker touches the cache.
 void LLTextureCache::purgeTextures(bool validate)
 {
 	if (mReadOnly)
@@ -1567,46 +1553,9 @@ void LLTextureCache::purgeTextures(bool validate)
 		// *FIX:Mani - watchdog off.
 		LLAppViewer::instance()->pauseMainloopTimeout();
 	}
-	
-	LLMutexLock lock(&mHeaderMutex);
 
 	LL_INFOS() << "TEXTURE CACHE: Purging." << LL_ENDL;
 
-	std::queue<LLUUID> empty;
-	std::swap(sgDelayedPurgeQueue, empty);
-
-	// Read the entries list
-	std::vector<Entry> entries;
-	U32 num_entries = openAndReadEntries(entries);
-	if (!num_entries)
-	{
-		return; // nothing to purge
-	}
-	
-	// Use mTexturesSizeMap to collect UUIDs of textures with bodies
-	typedef std::vector<std::pair<U32,S32> > time_idx_set_t;
-	time_idx_set_t time_idx_set;
-	for (size_map_t::iterator iter1 = mTexturesSizeMap.begin();
-		 iter1 != mTexturesSizeMap.end(); ++iter1)
-	{
-		if (iter1->second > 0)
-		{
-			id_map_t::iterator iter2 = mHeaderIDMap.find(iter1->first);
-			if (iter2 != mHeaderIDMap.end())
-			{
-				S32 idx = iter2->second;
-				time_idx_set.push_back(std::make_pair(entries[idx].mTime, idx));
-// 				LL_INFOS() << "TIME: " << entries[idx].mTime << " TEX: " << entries[idx].mID << " IDX: " << idx << " Size: " << entries[idx].mImageSize << LL_ENDL;
-			}
-			else
-			{
-				LL_ERRS() << "mTexturesSizeMap / mHeaderIDMap corrupted." << LL_ENDL ;
-			}
-		}
-	}
-
-	std::sort(time_idx_set.begin(), time_idx_set.end());
-	
 	// Validate 1/256th of the files on startup
 	U32 validate_idx = 0;
 	if (validate)
@@ -1617,59 +1566,70 @@ void LLTextureCache::purgeTextures(bool validate)
 		LL_DEBUGS("TextureCache") << "TEXTURE CACHE: Validating: " << validate_idx << LL_ENDL;
 	}
 
-	S64 cache_size = mTexturesSizeTotal;
-	S64 purged_cache_size = (sCacheMaxTexturesSize * (S64)((1.f-TEXTURE_CACHE_PURGE_AMOUNT)*100)) / 100;
+	S64 purged_shard_size = (sCacheMaxTexturesSize * (S64)((1.f-TEXTURE_CACHE_PURGE_AMOUNT)*100)) / (100 * HEADER_SHARD_COUNT);
 	S32 purge_count = 0;
-	for (time_idx_set_t::iterator iter = time_idx_set.begin();
-		 iter != time_idx_set.end(); ++iter)
+	U32 num_entries = 0;
+	for (S32 i = 0; i < HEADER_SHARD_COUNT; ++i)
 	{
-		S32 idx = iter->second;
-		bool purge_entry = false;
-		std::string filename = getTextureFileName(entries[idx].mID);
-		if (cache_size >= purged_cache_size)
+		HeaderShard& shard = mHeaderShards[i];
+		LLMutexLock lock(&shard.mMutex);
+		num_entries += shard.mInfo.mEntries;
+
+		// Collect the entries with bodies, oldest first
+		typedef std::vector<std::pair<U32,S32> > time_idx_set_t;
+		time_idx_set_t time_idx_set;
+		for (HeaderShard::id_map_t::iterator iter = shard.mIDMap.begin(); iter != shard.mIDMap.end(); ++iter)
 		{
-			purge_entry = true;
+			if (shard.mEntries[iter->second].mBodySize > 0)
+			{
+				time_idx_set.push_back(std::make_pair(shard.mEntries[iter->second].mTime, iter->second));
+			}
 		}
-		else if (validate)
+		std::sort(time_idx_set.begin(), time_idx_set.end());
+
+		for (time_idx_set_t::iterator iter = time_idx_set.begin();
+			 iter != time_idx_set.end(); ++iter)
 		{
-			// make sure file exists and is the correct size
-			U32 uuididx = entries[idx].mID.mData[0];
-			if (uuididx == validate_idx)
+			S32 idx = iter->second;
+			Entry& entry = shard.mEntries[idx];
+			bool purge_entry = false;
+			std::string filename = getTextureFileName(entry.mID);
+			if (shard.mBodySizeTotal >= purged_shard_size)
 			{
- 				LL_DEBUGS("TextureCache") << "Validating: " << filename << "Size: " << entries[idx].mBodySize << LL_ENDL;
-				S32 bodysize = LLAPRFile::size(filename);
-				if (bodysize != entries[idx].mBodySize)
+				purge_entry = true;
+			}
+			else if (validate)
+			{
+				// make sure file exists and is the correct size
+				U32 uuididx = entry.mID.mData[0];
+				if (uuididx == validate_idx)
 				{
-					LL_WARNS("TextureCache") << "TEXTURE CACHE BODY HAS BAD SIZE: " << bodysize << " != " << entries[idx].mBodySize
-							<< filename << LL_ENDL;
-					purge_entry = true;
+	 				LL_DEBUGS("TextureCache") << "Validating: " << filename << "Size: " << entry.mBodySize << LL_ENDL;
+					S32 bodysize = LLAPRFile::size(filename);
+					if (bodysize != entry.mBodySize)
+					{
+						LL_WARNS("TextureCache") << "TEXTURE CACHE BODY HAS BAD SIZE: " << bodysize << " != " << entry.mBodySize
+								<< filename << LL_ENDL;
+						purge_entry = true;
+					}
 				}
 			}
-		}
-		else
-		{
-			break;
-		}
-		
-		if (purge_entry)
-		{
-			purge_count++;
-	 		LL_DEBUGS("TextureCache") << "PURGING: " << filename << LL_ENDL;
-			cache_size -= entries[idx].mBodySize;
-			if(validate)
+			else
 			{
-				removeEntry(idx, entries[idx], filename);
+				break;
 			}
-			else
+			
+			if (purge_entry)
 			{
-				sgDelayedPurgeQueue.push(entries[idx].mID);
+				purge_count++;
+		 		LL_DEBUGS("TextureCache") << "PURGING: " << filename << LL_ENDL;
+				removeEntry(shard, idx, entry, filename);
 			}
 		}
-	}
 
-	LL_DEBUGS("TextureCache") << "TEXTURE CACHE: Writing Entries: " << num_entries << LL_ENDL;
-
-	writeEntriesAndClose(entries);
+		flushDirtyEntries(shard);
+	}
+	mDoPurge = FALSE;
 	
 	// *FIX:Mani - watchdog back on.
 	LLAppViewer::instance()->resumeMainloopTimeout();
@@ -1677,7 +1637,7 @@ void LLTextureCache::purgeTextures(bool validate)
 	LL_INFOS("TextureCache") << "TEXTURE CACHE:"
 			<< " PURGED: " << purge_count
 			<< " ENTRIES: " << num_entries
-			<< " CACHE SIZE: " << mTexturesSizeTotal / (1024 * 1024) << " MB"
+			<< " CACHE SIZE: " << getTexturesSizeTotal() / (1024 * 1024) << " MB"
 			<< LL_ENDL;
 }
 
@@ -1712,11 +1672,12 @@ LLTextureCacheWorker* LLTextureCache::getWriter(handle_t handle)
 // Reads imagesize from the header, updates timestamp
 S32 LLTextureCache::getHeaderCacheEntry(const LLUUID& id, Entry& entry)
 {
-	LLMutexLock lock(&mHeaderMutex);
-	S32 idx = openAndReadEntry(id, entry, false);
+	HeaderShard& shard = getHeaderShard(id);
+	LLMutexLock lock(&shard.mMutex);
+	S32 idx = openAndReadEntry(shard, id, entry, false);
 	if (idx >= 0)
 	{
-		updateEntryTimeStamp(idx, entry); // updates time
+		updateEntryTimeStamp(shard, idx, entry); // updates time
 	}
 	return idx;
 }
@@ -1724,24 +1685,12 @@ S32 LLTextureCache::getHeaderCacheEntry(const LLUUID& id, Entry& entry)
 // Writes imagesize to the header, updates timestamp
 S32 LLTextureCache::setHeaderCacheEntry(const LLUUID& id, Entry& entry, S32 imagesize, S32 datasize)
 {
-	mHeaderMutex.lock();
-	S32 idx = openAndReadEntry(id, entry, true);
-	mHeaderMutex.unlock();
-
+	HeaderShard& shard = getHeaderShard(id);
+	LLMutexLock lock(&shard.mMutex);
+	S32 idx = openAndReadEntry(shard, id, entry, true);
 	if (idx >= 0)
 	{
-		updateEntry(idx, entry, imagesize, datasize);				
-	}
-
-	if(idx < 0) // retry
-	{
-		readHeaderCache(); // We couldn't write an entry, so refresh the LRU
-	
-		mHeaderMutex.lock();
-		llassert_always(!mLRU.empty() || mHeaderEntriesInfo.mEntries < sCacheMaxEntries);
-		mHeaderMutex.unlock();
-
-		idx = setHeaderCacheEntry(id, entry, imagesize, datasize); // assert above ensures no inf. recursion
+		updateEntryLocked(shard, idx, entry, imagesize, datasize);
 	}
 	return idx;
 }
@@ -1817,15 +1766,6 @@ LLTextureCache::handle_t LLTextureCache::writeToCache(const LLUUID& id, U32 prio
 		delete responder;
 		return LLWorkerThread::nullHandle();
 	}
-	if (sgDelayedPurgeQueue.empty() && mDoPurge)
-	{
-		// NOTE: This may cause an occasional hiccup,
-		//  but it really needs to be done on the control thread
-		//  (i.e. here)		
-		purgeTextures(false);
-		mDoPurge = FALSE;
-	}
-	performDelayedPurge();
 	LLMutexLock lock(&mWorkersMutex);
 	LLTextureCacheWorker* worker = new LLTextureCacheRemoteWorker(this, priority, id,
 																  data, datasize, 0,
@@ -1871,20 +1811,20 @@ void LLTextureCache::addCompleted(Responder* responder, bool success)
 
 //////////////////////////////////////////////////////////////////////////////
 
-//called after mHeaderMutex is locked.
-void LLTextureCache::removeCachedTexture(const LLUUID& id)
+//called after the shard's mMutex is locked.
+void LLTextureCache::removeCachedTexture(HeaderShard& shard, const LLUUID& id)
 {
-	if (mTexturesSizeMap.find(id) != mTexturesSizeMap.end())
+	HeaderShard::id_map_t::iterator iter = shard.mIDMap.find(id);
+	if (iter != shard.mIDMap.end())
 	{
-		mTexturesSizeTotal -= mTexturesSizeMap[id];
-		mTexturesSizeMap.erase(id);
+		shard.mBodySizeTotal -= shard.mEntries[iter->second].mBodySize;
+		shard.mIDMap.erase(iter);
 	}
-	mHeaderIDMap.erase(id);
 	LLAPRFile::remove(getTextureFileName(id));		
 }
 
-//called after mHeaderMutex is locked.
-void LLTextureCache::removeEntry(S32 idx, Entry& entry, std::string& filename)
+//called after the shard's mMutex is locked.
+void LLTextureCache::removeEntry(HeaderShard& shard, S32 idx, Entry& entry, std::string& filename)
 {
  	bool file_maybe_exists = true;	// Always attempt to remove when idx is invalid.
 
@@ -1901,13 +1841,15 @@ void LLTextureCache::removeEntry(S32 idx, Entry& entry, std::string& filename)
 			  file_maybe_exists = false;
 		  }
 		}
-		mTexturesSizeTotal -= entry.mBodySize;
+		shard.mBodySizeTotal -= entry.mBodySize;
 
+		shard.mIDMap.erase(entry.mID);
+		shard.mLRU.erase(entry.mID);
 		entry.mImageSize = -1;
 		entry.mBodySize = 0;
-		mHeaderIDMap.erase(entry.mID);
-		mTexturesSizeMap.erase(entry.mID);		
-		mFreeList.insert(idx);	
+		shard.mEntries[idx] = entry;
+		shard.mDirty.insert(idx);
+		shard.mFreeList.insert(idx);	
 	}
 
 	if (file_maybe_exists)
@@ -1922,21 +1864,300 @@ bool LLTextureCache::removeFromCache(const LLUUID& id)
 	bool ret = false;
 	if (!mReadOnly)
 	{
-		lockHeaders();
+		HeaderShard& shard = getHeaderShard(id);
+		LLMutexLock lock(&shard.mMutex);
 
 		Entry entry;
-		S32 idx = openAndReadEntry(id, entry, false);
+		S32 idx = openAndReadEntry(shard, id, entry, false);
 		std::string tex_filename = getTextureFileName(id);
-		removeEntry(idx, entry, tex_filename);
-		if (idx >= 0)
-		{			
-			writeEntryToHeaderImmediately(idx, entry);					
-			ret = true;
+		removeEntry(shard, idx, entry, tex_filename);
+		ret = idx >= 0;
+	}
+	removeDecodedFromCache(id);
+	return ret;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Decoded mip tier
+
+const U32 DECODED_CACHE_VERSION = 1;
+
+// Header of a decoded image file, the raw pixels follow it.
+struct DecodedHeader
+{
+	U32 mVersion;
+	S32 mDataSize;		// size of the formatted data the image was decoded from
+	U16 mWidth;
+	U16 mHeight;
+	S32 mComponents;
+};
+
+std::string LLTextureCache::getDecodedFileName(const LLUUID& id, S32 discard)
+{
+	return mDecodedDirName + gDirUtilp->getDirDelimiter() + llformat("%s.%d.raw", id.asString().c_str(), discard);
+}
+
+// Called from the main thread after initCache(). A max_size of 0 disables the tier.
+void LLTextureCache::initDecodedCache(U64 max_size)
+{
+	LLMutexLock lock(&mDecodedMutex);
+
+	std::string delem = gDirUtilp->getDirDelimiter();
+	mDecodedDirName = mTexturesDirName + delem + decoded_dirname;
+	mDecodedMap.clear();
+	mDecodedLRU.clear();
+	mDecodedSizeTotal = 0;
+	mDecodedMaxSize = mReadOnly ? 0 : (S64)max_size;
+	if (mReadOnly)
+	{
+		return;
+	}
+	if (!mDecodedMaxSize)
+	{
+		// Don't leave the files of a disabled tier behind.
+		gDirUtilp->deleteFilesInDir(mDecodedDirName, "*");
+		return;
+	}
+	LLFile::mkdir(mDecodedDirName);
+
+	// Rebuild the index from the files of the previous sessions, most recently written first.
+	// The formatted data size is only known once a file is read, see readDecodedFromCache().
+	typedef std::vector<std::pair<time_t, std::pair<decoded_key_t, S32> > > file_list_t;
+	file_list_t file_list;
+	std::vector<std::string> files = gDirUtilp->getFilesInDir(mDecodedDirName);
+	for (std::vector<std::string>::iterator iter = files.begin(); iter != files.end(); ++iter)
+	{
+		const std::string& name = *iter;
+		std::string filename = mDecodedDirName + delem + name;
+		S32 discard = -1;
+		LLUUID id;
+		llstat stat_data;
+		if (name.size() > UUID_STR_LENGTH && LLUUID::validate(name.substr(0, UUID_STR_LENGTH - 1))
+			&& sscanf(name.c_str() + UUID_STR_LENGTH - 1, ".%d.raw", &discard) == 1 && discard >= 0
+			&& name.compare(name.size() - 4, 4, ".raw") == 0
+			&& LLFile::stat(filename, &stat_data) == 0)
+		{
+			id.set(name.substr(0, UUID_STR_LENGTH - 1));
+			file_list.push_back(std::make_pair(stat_data.st_mtime, std::make_pair(decoded_key_t(id, discard), (S32)stat_data.st_size)));
+		}
+		else
+		{
+			// Left over from an interrupted write
+			LLFile::remove(filename);
 		}
+	}
+	std::sort(file_list.begin(), file_list.end());
+	for (file_list_t::reverse_iterator iter = file_list.rbegin(); iter != file_list.rend(); ++iter)
+	{
+		mDecodedLRU.push_back(iter->second.first);
+		DecodedEntry& entry = mDecodedMap[iter->second.first];
+		entry.mDataSize = -1;
+		entry.mFileSize = iter->second.second;
+		entry.mLRUIter = --mDecodedLRU.end();
+		mDecodedSizeTotal += entry.mFileSize;
+	}
+	purgeDecodedTextures();
+
+	LL_INFOS("TextureCache") << "Decoded mips: " << mDecodedMap.size()
+			<< " Size: " << mDecodedSizeTotal / (1024 * 1024) << "/" << mDecodedMaxSize / (1024 * 1024) << " MB" << LL_ENDL;
+}
 
-		unlockHeaders();
+// Called from the texture fetch thread. Reading a decoded mip back is much
+// cheaper than decoding it again, so this is done synchronously.
+bool LLTextureCache::readDecodedFromCache(const LLUUID& id, S32 discard, S32 data_size, LLPointer<LLImageRaw>& raw)
+{
+	if (!mDecodedMaxSize)
+	{
+		return false;
 	}
-	return ret;
+
+	decoded_key_t key(id, discard);
+	{
+		LLMutexLock lock(&mDecodedMutex);
+		decoded_map_t::iterator iter = mDecodedMap.find(key);
+		if (iter == mDecodedMap.end() || (iter->second.mDataSize >= 0 && iter->second.mDataSize < data_size))
+		{
+			mDecodedMisses++;
+			return false;
+		}
+	}
+
+	// Read without holding the mutex, a concurrent write replaces the file atomically.
+	DecodedHeader header;
+	bool valid_header = false;
+	bool success = false;
+	{
+		LLAPRFile infile(getDecodedFileName(id, discard), APR_READ|APR_BINARY);
+		if (infile.getFileHandle() && infile.read(&header, sizeof(DecodedHeader)) == sizeof(DecodedHeader))
+		{
+			valid_header = header.mVersion == DECODED_CACHE_VERSION && header.mWidth && header.mHeight
+				&& header.mComponents > 0 && header.mComponents <= 4;
+		}
+		if (valid_header && header.mDataSize >= data_size)
+		{
+			LLPointer<LLImageRaw> image = new LLImageRaw(header.mWidth, header.mHeight, header.mComponents);
+			S32 size = image->getDataSize();
+			if (image->getData() && infile.read(image->getData(), size) == size)
+			{
+				raw = image;
+				success = true;
+			}
+		}
+	}
+
+	LLMutexLock lock(&mDecodedMutex);
+	decoded_map_t::iterator iter = mDecodedMap.find(key);
+	if (success)
+	{
+		mDecodedHits++;
+	}
+	else
+	{
+		mDecodedMisses++;
+	}
+	if (iter != mDecodedMap.end())
+	{
+		if (valid_header)
+		{
+			iter->second.mDataSize = header.mDataSize;
+			mDecodedLRU.splice(mDecodedLRU.begin(), mDecodedLRU, iter->second.mLRUIter);
+		}
+		else
+		{
+			LL_WARNS("TextureCache") << "Removing corrupted decoded texture " << id << " discard " << discard << LL_ENDL;
+			removeDecodedEntry(iter);
+		}
+	}
+	return success;
+}
+
+// May be called from any thread, the file is written by the cache thread.
+void LLTextureCache::writeDecodedToCache(const LLUUID& id, S32 discard, S32 data_size, LLImageRaw* raw)
+{
+	if (!mDecodedMaxSize || mReadOnly || !raw || !raw->getData())
+	{
+		return;
+	}
+	S32 file_size = sizeof(DecodedHeader) + raw->getDataSize();
+	if (file_size > mDecodedMaxSize / 16)
+	{
+		return; // one image should not flush a large part of the tier.
+	}
+	{
+		LLMutexLock lock(&mDecodedMutex);
+		decoded_map_t::iterator iter = mDecodedMap.find(decoded_key_t(id, discard));
+		if (iter != mDecodedMap.end() && iter->second.mDataSize >= data_size)
+		{
+			return; // already cached from at least as much data.
+		}
+	}
+
+	// The decoded image is handed to the viewer texture, which may modify it: write a copy.
+	LLImageRaw* copy = new LLImageRaw(raw->getData(), raw->getWidth(), raw->getHeight(), raw->getComponents());
+	DecodedWriteRequest* req = new DecodedWriteRequest(generateHandle(), this, id, discard, data_size, copy);
+	if (!addRequest(req))
+	{
+		req->deleteRequest();
+	}
+}
+
+void LLTextureCache::removeDecodedFromCache(const LLUUID& id)
+{
+	LLMutexLock lock(&mDecodedMutex);
+	decoded_map_t::iterator iter = mDecodedMap.lower_bound(decoded_key_t(id, 0));
+	while (iter != mDecodedMap.end() && iter->first.first == id)
+	{
+		removeDecodedEntry(iter++);
+	}
+}
+
+void LLTextureCache::addDecodedEntry(const decoded_key_t& key, S32 data_size, S32 file_size)
+{
+	LLMutexLock lock(&mDecodedMutex);
+	decoded_map_t::iterator iter = mDecodedMap.find(key);
+	if (iter != mDecodedMap.end())
+	{
+		mDecodedSizeTotal -= iter->second.mFileSize;
+		mDecodedLRU.erase(iter->second.mLRUIter);
+		mDecodedMap.erase(iter);
+	}
+	mDecodedLRU.push_front(key);
+	DecodedEntry& entry = mDecodedMap[key];
+	entry.mDataSize = data_size;
+	entry.mFileSize = file_size;
+	entry.mLRUIter = mDecodedLRU.begin();
+	mDecodedSizeTotal += file_size;
+
+	purgeDecodedTextures();
+}
+
+//mDecodedMutex is locked before calling this.
+void LLTextureCache::removeDecodedEntry(decoded_map_t::iterator iter)
+{
+	LLFile::remove(getDecodedFileName(iter->first.first, iter->first.second));
+	mDecodedSizeTotal -= iter->second.mFileSize;
+	mDecodedLRU.erase(iter->second.mLRUIter);
+	mDecodedMap.erase(iter);
+}
+
+//mDecodedMutex is locked before calling this.
+void LLTextureCache::purgeDecodedTextures()
+{
+	while (mDecodedSizeTotal > mDecodedMaxSize && !mDecodedLRU.empty())
+	{
+		removeDecodedEntry(mDecodedMap.find(mDecodedLRU.back()));
+	}
+}
+
+LLTextureCache::DecodedWriteRequest::DecodedWriteRequest(handle_t handle, LLTextureCache* cache, const LLUUID& id,
+														 S32 discard, S32 data_size, LLImageRaw* raw)
+	: LLQueuedThread::QueuedRequest(handle, LLWorkerThread::PRIORITY_LOW, FLAG_AUTO_COMPLETE),
+	  mCache(cache),
+	  mID(id),
+	  mDiscard(discard),
+	  mDataSize(data_size),
+	  mRawImage(raw)
+{
+}
+
+LLTextureCache::DecodedWriteRequest::~DecodedWriteRequest()
+{
+	mRawImage = NULL;
+}
+
+// Called from the cache thread. The file is written under a temporary name and
+// renamed, so readDecodedFromCache() never sees it half written.
+bool LLTextureCache::DecodedWriteRequest::processRequest()
+{
+	std::string filename = mCache->getDecodedFileName(mID, mDiscard);
+	std::string tmp_filename = filename + ".tmp";
+
+	DecodedHeader header;
+	header.mVersion = DECODED_CACHE_VERSION;
+	header.mDataSize = mDataSize;
+	header.mWidth = mRawImage->getWidth();
+	header.mHeight = mRawImage->getHeight();
+	header.mComponents = mRawImage->getComponents();
+	S32 size = mRawImage->getDataSize();
+
+	bool success = false;
+	{
+		LLAPRFile outfile(tmp_filename, APR_WRITE|APR_CREATE|APR_TRUNCATE|APR_BINARY);
+		success = outfile.getFileHandle()
+			&& outfile.write(&header, sizeof(DecodedHeader)) == sizeof(DecodedHeader)
+			&& outfile.write(mRawImage->getData(), size) == size;
+	}
+	if (success && LLAPRFile::rename(tmp_filename, filename))
+	{
+		mCache->addDecodedEntry(decoded_key_t(mID, mDiscard), mDataSize, sizeof(DecodedHeader) + size);
+	}
+	else
+	{
+		LL_WARNS("TextureCache") << "Unable to write decoded texture " << filename << LL_ENDL;
+		LLAPRFile::remove(tmp_filename);
+	}
+	mRawImage = NULL;
+	return true;
 }
 
 //////////////////////////////////////////////////////////////////////////////
@@ -1964,3 +2185,4 @@ void LLTextureCache::ReadResponder::setData(U8* data, S32 datasize, S32 imagesiz
 }
 
 //////////////////////////////////////////////////////////////////////////////
+
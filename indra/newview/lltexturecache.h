@@ -34,7 +34,11 @@
 
 #include "llworkerthread.h"
 
+#include <boost/unordered_map.hpp>
+#include <list>
+
 class LLImageFormatted;
+class LLImageRaw;
 class LLTextureCacheWorker;
 
 class LLTextureCache : public LLWorkerThread
@@ -69,6 +73,31 @@ private:
 		U32 mTime; // seconds since 1/1/1970
 	};
 
+	// The header cache is split into shards by the first hex digit of the
+	// texture UUID (the same digit that picks the body sub-directory). Each
+	// shard has its own entries and header data files, keeps all its entries
+	// in memory and has its own mutex, so cache hits don't touch the disk and
+	// workers looking up different textures rarely wait on each other.
+	// Changed entries are written back in batches by flushDirtyEntries().
+	enum { HEADER_SHARD_COUNT = 16 };
+	struct HeaderShard
+	{
+		HeaderShard() : mFlushedEntries(0), mBodySizeTotal(0), mPurgeCursor(0) {}
+
+		LLMutex mMutex;
+		std::string mEntriesFileName;
+		std::string mDataFileName;
+		EntriesInfo mInfo;
+		std::vector<Entry> mEntries;	// in-memory copy of the entries file
+		U32 mFlushedEntries;			// number of entries the entries file on disk knows about
+		typedef boost::unordered_map<LLUUID, S32> id_map_t;
+		id_map_t mIDMap;
+		std::set<S32> mFreeList;		// deleted entries
+		uuid_set_t mLRU;				// oldest entries, reused when the shard is full
+		std::set<S32> mDirty;			// entries that still have to be written to disk
+		S64 mBodySizeTotal;
+		U32 mPurgeCursor;				// next entry purgeTexturesIncremental() looks at
+	};
 	
 public:
 
@@ -120,6 +149,13 @@ public:
 
 	bool removeFromCache(const LLUUID& id);
 
+	// Decoded mip tier: raw images keyed by UUID and discard level, so that
+	// textures seen before don't have to be decoded again.
+	void initDecodedCache(U64 max_size);
+	bool readDecodedFromCache(const LLUUID& id, S32 discard, S32 data_size, LLPointer<LLImageRaw>& raw);
+	void writeDecodedToCache(const LLUUID& id, S32 discard, S32 data_size, LLImageRaw* raw);
+	void removeDecodedFromCache(const LLUUID& id);
+
 	// For LLTextureCacheWorker::Responder
 	LLTextureCacheWorker* getReader(handle_t handle);
 	LLTextureCacheWorker* getWriter(handle_t handle);
@@ -129,10 +165,14 @@ public:
 	// debug
 	S32 getNumReads() { return mReaders.size(); }
 	S32 getNumWrites() { return mWriters.size(); }
-	S64Bytes getUsage() { return S64Bytes(mTexturesSizeTotal); }
+	S64Bytes getUsage() { return S64Bytes(getTexturesSizeTotal()); }
 	S64Bytes getMaxUsage() { return S64Bytes(sCacheMaxTexturesSize); }
-	U32 getEntries() { return mHeaderEntriesInfo.mEntries; }
+	U32 getEntries();
 	U32 getMaxEntries() { return sCacheMaxEntries; };
+	S64Bytes getDecodedUsage() { return S64Bytes(mDecodedSizeTotal); }
+	S64Bytes getDecodedMaxUsage() { return S64Bytes(mDecodedMaxSize); }
+	U32 getDecodedHits() { return mDecodedHits; }
+	U32 getDecodedMisses() { return mDecodedMisses; }
 	BOOL isInCache(const LLUUID& id) ;
 	BOOL isInLocal(const LLUUID& id) ;
 
@@ -140,41 +180,77 @@ protected:
 	// Accessed by LLTextureCacheWorker
 	std::string getLocalFileName(const LLUUID& id);
 	std::string getTextureFileName(const LLUUID& id);
+	const std::string& getHeaderDataFileName(const LLUUID& id) { return getHeaderShard(id).mDataFileName; }
 	void addCompleted(Responder* responder, bool success);
 	
 private:
+	HeaderShard& getHeaderShard(const LLUUID& id) { return mHeaderShards[id.mData[0] >> 4]; }
 	void setDirNames(ELLPath location);
 	void readHeaderCache();
-	void clearCorruptedCache();
-	void performDelayedPurge();
 	void purgeAllTextures(bool purge_directories);
 	void purgeTextures(bool validate);
-	LLAPRFile* openHeaderEntriesFile(bool readonly, S32 offset);
-	void closeHeaderEntriesFile();
-	void readEntriesHeader();
-	void writeEntriesHeader();
-	S32 openAndReadEntry(const LLUUID& id, Entry& entry, bool create);
-	bool updateEntry(S32& idx, Entry& entry, S32 new_image_size, S32 new_body_size);
-	void updateEntryTimeStamp(S32 idx, Entry& entry) ;
-	U32 openAndReadEntries(std::vector<Entry>& entries);
-	void writeEntriesAndClose(const std::vector<Entry>& entries);
-	void readEntryFromHeaderImmediately(S32& idx, Entry& entry) ;
-	void writeEntryToHeaderImmediately(S32& idx, Entry& entry, bool write_header = false) ;
-	void removeEntry(S32 idx, Entry& entry, std::string& filename);
-	void removeCachedTexture(const LLUUID& id) ;
+	void purgeTexturesIncremental();
+	S64 getTexturesSizeTotal();
+
+	// The shard's mMutex must be locked for the following functions.
+	void readShard(HeaderShard& shard);
+	void clearShard(HeaderShard& shard);
+	void clearCorruptedShard(HeaderShard& shard);
+	void rebuildLRU(HeaderShard& shard);
+	void writeShardInfo(HeaderShard& shard);
+	S32 openAndReadEntry(HeaderShard& shard, const LLUUID& id, Entry& entry, bool create);
+	bool updateEntryLocked(HeaderShard& shard, S32& idx, Entry& entry, S32 new_image_size, S32 new_data_size);
+	void updateEntryTimeStamp(HeaderShard& shard, S32 idx, Entry& entry);
+	void writeEntryToHeaderImmediately(HeaderShard& shard, S32& idx, Entry& entry);
+	void flushDirtyEntries(HeaderShard& shard);
+	void removeEntry(HeaderShard& shard, S32 idx, Entry& entry, std::string& filename);
+	void removeCachedTexture(HeaderShard& shard, const LLUUID& id);
+
+	bool updateEntry(S32& idx, Entry& entry, S32 new_image_size, S32 new_data_size);
 	S32 getHeaderCacheEntry(const LLUUID& id, Entry& entry);
 	S32 setHeaderCacheEntry(const LLUUID& id, Entry& entry, S32 imagesize, S32 datasize);
-	void writeUpdatedEntries() ;
-	void updatedHeaderEntriesFile() ;
-	void lockHeaders() { mHeaderMutex.lock(); }
-	void unlockHeaders() { mHeaderMutex.unlock(); }
+	void writeUpdatedEntries();
+	void writeUpdatedEntriesIncremental();
+
+	// Decoded mip tier
+	typedef std::pair<LLUUID, S32> decoded_key_t;
+	typedef std::list<decoded_key_t> decoded_lru_t;
+	struct DecodedEntry
+	{
+		S32 mDataSize;		// size of the formatted data the raw image was decoded from
+		S32 mFileSize;
+		decoded_lru_t::iterator mLRUIter;
+	};
+	typedef std::map<decoded_key_t, DecodedEntry> decoded_map_t;
+
+	// Writes a decoded image on the cache thread.
+	class DecodedWriteRequest : public LLQueuedThread::QueuedRequest
+	{
+	protected:
+		virtual ~DecodedWriteRequest(); // use deleteRequest()
+
+	public:
+		DecodedWriteRequest(handle_t handle, LLTextureCache* cache, const LLUUID& id, S32 discard, S32 data_size, LLImageRaw* raw);
+
+		/*virtual*/ bool processRequest();
+
+	private:
+		LLTextureCache* mCache;
+		LLUUID mID;
+		S32 mDiscard;
+		S32 mDataSize;
+		LLPointer<LLImageRaw> mRawImage;
+	};
+
+	std::string getDecodedFileName(const LLUUID& id, S32 discard);
+	void addDecodedEntry(const decoded_key_t& key, S32 data_size, S32 file_size);
+	void removeDecodedEntry(decoded_map_t::iterator iter);
+	void purgeDecodedTextures();
 	
 private:
 	// Internal
 	LLMutex mWorkersMutex;
-	LLMutex mHeaderMutex;
 	LLMutex mListMutex;
-	LLAPRFile* mHeaderAPRFile;
 	
 	typedef std::map<handle_t, LLTextureCacheWorker*> handle_map_t;
 	handle_map_t mReaders;
@@ -189,23 +265,23 @@ private:
 	BOOL mReadOnly;
 	
 	// HEADERS (Include first mip)
-	std::string mHeaderEntriesFileName;
-	std::string mHeaderDataFileName;
-	EntriesInfo mHeaderEntriesInfo;
-	std::set<S32> mFreeList; // deleted entries
-	uuid_set_t mLRU;
-	typedef std::map<LLUUID,S32> id_map_t;
-	id_map_t mHeaderIDMap;
+	HeaderShard mHeaderShards[HEADER_SHARD_COUNT];
+	S32 mNextFlushShard;		// MAIN THREAD, round robin write-behind
+	S32 mNextPurgeShard;		// MAIN THREAD, round robin incremental purge
 
 	// BODIES (TEXTURES minus headers)
 	std::string mTexturesDirName;
-	typedef std::map<LLUUID,S32> size_map_t;
-	size_map_t mTexturesSizeMap;
-	S64 mTexturesSizeTotal;
 	LLAtomic32<bool> mDoPurge;
 
-	typedef std::map<S32, Entry> idx_entry_map_t;
-	idx_entry_map_t mUpdatedEntryMap;
+	// DECODED MIPS
+	LLMutex mDecodedMutex;
+	std::string mDecodedDirName;
+	decoded_map_t mDecodedMap;
+	decoded_lru_t mDecodedLRU;	// most recently used first
+	S64 mDecodedSizeTotal;
+	S64 mDecodedMaxSize;		// 0 when the tier is disabled
+	LLAtomicU32 mDecodedHits;
+	LLAtomicU32 mDecodedMisses;
 
 	// Statics
 	static F32 sHeaderCacheVersion;
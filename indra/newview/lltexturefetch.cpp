@@ -78,6 +78,11 @@ LLStat LLTextureFetch::sCacheReadLatency("texture_cache_read_latency", 128);
 // Log scope
 static const char * const LOG_TXT = "Texture";
 
+// Progressive decoding: decodes wider than this at the target level get a preview
+// PROGRESSIVE_DECODE_STEP levels coarser queued ahead of them.
+static const S32 PROGRESSIVE_DECODE_MIN_SIZE = 512;
+static const S32 PROGRESSIVE_DECODE_STEP = 2;
+
 class LLTextureFetchWorker : public LLWorkerClass
 {
 	friend class LLTextureFetch;
@@ -146,6 +151,26 @@ private:
 		LLTextureFetchWorker* mWorker; // debug only (may get deleted from under us, use mFetcher/mID)
 	};
 
+	class ProgressiveDecodeResponder : public LLImageDecodeThread::Responder
+	{
+	public:
+		ProgressiveDecodeResponder(LLTextureFetch* fetcher, const LLUUID& id)
+			: mFetcher(fetcher), mID(id)
+		{
+		}
+		virtual void completed(bool success, LLImageRaw* raw, LLImageRaw* aux)
+		{
+			LLTextureFetchWorker* worker = mFetcher->getWorker(mID);
+			if (worker)
+			{
+				worker->callbackProgressiveDecoded(success, raw);
+			}
+		}
+	private:
+		LLTextureFetch* mFetcher;
+		LLUUID mID;
+	};
+
 	struct Compare
 	{
 		// lhs < rhs
@@ -179,6 +204,8 @@ public:
 						   S32 imagesize, BOOL islocal);
 	void callbackCacheWrite(bool success);
 	void callbackDecoded(bool success, LLImageRaw* raw, LLImageRaw* aux);
+	void callbackProgressiveDecoded(bool success, LLImageRaw* raw);
+	void startProgressiveDecode(S32 discard);
 	
 	void setGetStatus(U32 status, const std::string& reason)
 	{
@@ -276,7 +303,9 @@ private:
 								mSimRequestedDiscard,
 								mRequestedDiscard,
 								mLoadedDiscard,
-								mDecodedDiscard;
+								mDecodedDiscard,
+								mProgressiveDiscard,	// Discard level of the preview being decoded or waiting to be picked up
+								mBestDecodedDiscard;	// Best level decoded so far by this worker, survives INIT
 	LLFrameTimer                mRequestedTimer,
 								mFetchTimer;
 	LLTimer			mCacheReadTimer;
@@ -291,6 +320,8 @@ private:
 								mCachedSize;
 	e_request_state mSentRequest;
 	handle_t mDecodeHandle;
+	handle_t mProgressiveHandle;
+	LLPointer<LLImageRaw> mProgressiveRaw;
 	BOOL mLoaded;
 	BOOL mDecoded;
 	BOOL mWritten;
@@ -841,6 +872,8 @@ LLTextureFetchWorker::LLTextureFetchWorker(LLTextureFetch* fetcher,
 	  mRequestedDiscard(-1),
 	  mLoadedDiscard(-1),
 	  mDecodedDiscard(-1),
+	  mProgressiveDiscard(-1),
+	  mBestDecodedDiscard(-1),
 	  mCacheReadTime(0.f),
 	  mCacheReadHandle(LLTextureCache::nullHandle()),
 	  mCacheWriteHandle(LLTextureCache::nullHandle()),
@@ -852,6 +885,7 @@ LLTextureFetchWorker::LLTextureFetchWorker(LLTextureFetch* fetcher,
 	  mLoaded(FALSE),
 	  mSentRequest(UNSENT),
 	  mDecodeHandle(0),
+	  mProgressiveHandle(0),
 	  mDecoded(FALSE),
 	  mWritten(FALSE),
 	  mNeedsAux(FALSE),
@@ -1225,6 +1259,12 @@ bool LLTextureFetchWorker::doWork(S32 param)
 			else
 			{
 				LL_DEBUGS(LOG_TXT) << mID << ": Not in Cache" << LL_ENDL;
+				if (mCachedSize > 0)
+				{
+					// Show what the cache has while the rest comes in from the network,
+					// at the best level the cached bytes allow
+					startProgressiveDecode(0);
+				}
 				setState(LOAD_FROM_NETWORK);
 			}
 			
@@ -1822,10 +1862,28 @@ bool LLTextureFetchWorker::doWork(S32 param)
 		U32 image_priority = LLWorkerThread::PRIORITY_NORMAL | mWorkPriority;
 		mDecoded  = FALSE;
 		setState(DECODE_IMAGE_UPDATE);
-		LL_DEBUGS(LOG_TXT) << mID << ": Decoding. Bytes: " << mFormattedImage->getDataSize() << " Discard: " << discard
-				<< " All Data: " << mHaveAllData << LL_ENDL;
-		mDecodeHandle = mFetcher->mImageDecodeThread->decodeImage(mFormattedImage, image_priority, discard, mNeedsAux,
-																  new DecodeResponder(mFetcher, mID, this));
+		if (!mNeedsAux && mFetcher->mTextureCache->readDecodedFromCache(mID, discard, mFormattedImage->getDataSize(), mRawImage))
+		{
+			// Decoded before from at least as much data, skip the decoder
+			mFormattedImage->setDiscardLevel(discard);
+			mDecodedDiscard = discard;
+			mBestDecodedDiscard = discard;
+			mDecoded = TRUE;
+			LL_DEBUGS(LOG_TXT) << mID << ": Decoded mip cache hit. Discard: " << discard << LL_ENDL;
+		}
+		else
+		{
+			LL_DEBUGS(LOG_TXT) << mID << ": Decoding. Bytes: " << mFormattedImage->getDataSize() << " Discard: " << discard
+					<< " All Data: " << mHaveAllData << LL_ENDL;
+			if (!mNeedsAux && (mFormattedImage->getWidth() || mFormattedImage->updateData()) &&
+				mFormattedImage->getWidth() >> discard >= PROGRESSIVE_DECODE_MIN_SIZE)
+			{
+				// Large decode ahead, get a coarse level on screen first
+				startProgressiveDecode(llmin(discard + PROGRESSIVE_DECODE_STEP, (S32)MAX_DISCARD_LEVEL));
+			}
+			mDecodeHandle = mFetcher->mImageDecodeThread->decodeImage(mFormattedImage, image_priority, discard, mNeedsAux,
+																	  new DecodeResponder(mFetcher, mID, this));
+		}
 		// fall though
 	}
 	
@@ -1953,6 +2011,11 @@ void LLTextureFetchWorker::endWork(S32 param, bool aborted)
 		mFetcher->mImageDecodeThread->abortRequest(mDecodeHandle, false);
 		mDecodeHandle = 0;
 	}
+	if (mProgressiveHandle != 0)
+	{
+		mFetcher->mImageDecodeThread->abortRequest(mProgressiveHandle, false);
+		mProgressiveHandle = 0;
+	}
 	mFormattedImage = NULL;
 }
 
@@ -2246,8 +2309,21 @@ void LLTextureFetchWorker::callbackDecoded(bool success, LLImageRaw* raw, LLImag
 		mRawImage = raw;
 		mAuxImage = aux;
 		mDecodedDiscard = mFormattedImage->getDiscardLevel();
+		if (mBestDecodedDiscard < 0 || mDecodedDiscard < mBestDecodedDiscard)
+		{
+			mBestDecodedDiscard = mDecodedDiscard;
+		}
+		if (mProgressiveRaw.notNull() && mProgressiveDiscard >= mDecodedDiscard)
+		{
+			mProgressiveRaw = NULL; // superseded
+		}
  		LL_DEBUGS(LOG_TXT) << mID << ": Decode Finished. Discard: " << mDecodedDiscard
 							 << " Raw Image: " << llformat("%dx%d",mRawImage->getWidth(),mRawImage->getHeight()) << LL_ENDL;
+		if (!aux)
+		{
+			// Keep the result, the next fetch of this mip can then skip the decode
+			mFetcher->mTextureCache->writeDecodedToCache(mID, mDecodedDiscard, mFormattedImage->getDataSize(), raw);
+		}
 	}
 	else
 	{
@@ -2268,6 +2344,70 @@ void LLTextureFetchWorker::callbackDecoded(bool success, LLImageRaw* raw, LLImag
 	mCacheReadTime = mCacheReadTimer.getElapsedTimeF32();
 }
 
+// Decodes a coarse level from the data loaded so far, so the texture gets on
+// screen while the rest is downloaded or decoded. OpenJPEG keeps no state between
+// decodes, so the preview decodes a truncated copy of the codestream; that is
+// cheap because the work shrinks by 4x per discard level.
+// Called from doWork() with mWorkMutex locked.
+void LLTextureFetchWorker::startProgressiveDecode(S32 discard)
+{
+	static LLCachedControl<bool> progressive_decode(gSavedSettings, "TextureProgressiveDecode");
+	if (!progressive_decode || mNeedsAux || mProgressiveHandle != 0 || mFormattedImage.isNull())
+	{
+		return;
+	}
+	LLImageJ2C* j2c = dynamic_cast<LLImageJ2C*>(mFormattedImage.get());
+	if (!j2c || (!j2c->getWidth() && !j2c->updateData()))
+	{
+		return;
+	}
+	// Never ask for more than the loaded data holds
+	discard = llmax(discard, j2c->calcDiscardLevelBytes(j2c->getDataSize()));
+	if (mBestDecodedDiscard >= 0 && discard >= mBestDecodedDiscard)
+	{
+		return; // nothing to gain
+	}
+	if (mProgressiveRaw.notNull() && discard >= mProgressiveDiscard)
+	{
+		return; // already have this one waiting
+	}
+	LLPointer<LLImageFormatted> preview = j2c->createProgressiveImage(discard);
+	if (preview.isNull())
+	{
+		return;
+	}
+	LL_DEBUGS(LOG_TXT) << mID << ": Progressive decode. Bytes: " << preview->getDataSize() << " Discard: " << discard << LL_ENDL;
+	mProgressiveDiscard = discard;
+	// Ahead of the full decode, which is queued at normal priority
+	U32 preview_priority = LLWorkerThread::PRIORITY_HIGH | mWorkPriority;
+	mProgressiveHandle = mFetcher->mImageDecodeThread->decodeImage(preview, preview_priority, discard, FALSE,
+																	new ProgressiveDecodeResponder(mFetcher, mID));
+}
+
+void LLTextureFetchWorker::callbackProgressiveDecoded(bool success, LLImageRaw* raw)
+{
+	LLMutexLock lock(&mWorkMutex);
+	if (mProgressiveHandle == 0)
+	{
+		return; // aborted, ignore
+	}
+	mProgressiveHandle = 0;
+	if (!success || !raw)
+	{
+		// Not fatal, the full decode reports real errors
+		LL_DEBUGS(LOG_TXT) << mID << ": Progressive decode failed. Discard: " << mProgressiveDiscard << LL_ENDL;
+		return;
+	}
+	if (mBestDecodedDiscard >= 0 && mProgressiveDiscard >= mBestDecodedDiscard)
+	{
+		return; // the full decode won the race
+	}
+	mProgressiveRaw = raw;
+	mBestDecodedDiscard = mProgressiveDiscard;
+	LL_DEBUGS(LOG_TXT) << mID << ": Progressive decode finished. Discard: " << mProgressiveDiscard
+					   << " Raw Image: " << llformat("%dx%d", raw->getWidth(), raw->getHeight()) << LL_ENDL;
+}
+
 //////////////////////////////////////////////////////////////////////////////
 
 bool LLTextureFetchWorker::writeToCacheComplete()
@@ -2651,6 +2791,15 @@ bool LLTextureFetch::getRequestFinished(const LLUUID& id, S32& discard_level,
 				raw = worker->mRawImage;
 				aux = worker->mAuxImage;
 			}
+			else if (worker->mProgressiveRaw.notNull() &&
+					 (worker->mProgressiveDiscard < discard_level || discard_level < 0))
+			{
+				// Not finished, but a coarser level is ready
+				discard_level = worker->mProgressiveDiscard;
+				raw = worker->mProgressiveRaw;
+				aux = NULL;
+				worker->mProgressiveRaw = NULL; // handed over
+			}
 			worker->unlockWorkMutex();
 		}
 	}
@@ -571,6 +571,10 @@ void LLGLTexMemBar::draw()
 	F32 discard_bias = LLViewerTexture::sDesiredDiscardBias;
 	F32 cache_usage = LLAppViewer::getTextureCache()->getUsage().valueInUnits<LLUnits::Megabytes>();
 	F32 cache_max_usage = LLAppViewer::getTextureCache()->getMaxUsage().valueInUnits<LLUnits::Megabytes>();
+	F32 decoded_usage = LLAppViewer::getTextureCache()->getDecodedUsage().valueInUnits<LLUnits::Megabytes>();
+	F32 decoded_max_usage = LLAppViewer::getTextureCache()->getDecodedMaxUsage().valueInUnits<LLUnits::Megabytes>();
+	U32 decoded_hits = LLAppViewer::getTextureCache()->getDecodedHits();
+	U32 decoded_misses = LLAppViewer::getTextureCache()->getDecodedMisses();
 	S32 line_height = LLFontGL::getFontMonospace()->getLineHeight();
 	S32 v_offset = 0;//(S32)((texture_bar_height + 2.2f) * mTextureView->mNumTextureBars + 2.0f);
 	F32Bytes total_texture_downloaded = gTotalTextureData;
@@ -587,14 +591,15 @@ void LLGLTexMemBar::draw()
 	{
 		global_raw_memory = *AIAccess<S64>(LLImageRaw::sGlobalRawMemory);
 	}
-	text = llformat("GL Tot: %d/%d MB Bound: %d/%d MB FBO: %d MB Raw Tot: %lld MB Bias: %.2f Cache: %.1f/%.1f MB Net Tot Tex: %.1f MB Tot Obj: %.1f MB Tot Htp: %d",
+	text = llformat("GL Tot: %d/%d MB Bound: %d/%d MB FBO: %d MB Raw Tot: %lld MB Bias: %.2f Cache: %.1f/%.1f MB Dec: %.1f/%.1f MB H/M: %u/%u Net Tot Tex: %.1f MB Tot Obj: %.1f MB Tot Htp: %d",
 					total_mem.value(),
 					max_total_mem.value(),
 					bound_mem.value(),
 					max_bound_mem.value(),
 					LLRenderTarget::sBytesAllocated/(1024*1024),
 					global_raw_memory >> 20,	discard_bias,
-					cache_usage, cache_max_usage, total_texture_downloaded.valueInUnits<LLUnits::Megabytes>(), total_object_downloaded.valueInUnits<LLUnits::Megabytes>(), total_http_requests);
+					cache_usage, cache_max_usage, decoded_usage, decoded_max_usage, decoded_hits, decoded_misses,
+					total_texture_downloaded.valueInUnits<LLUnits::Megabytes>(), total_object_downloaded.valueInUnits<LLUnits::Megabytes>(), total_http_requests);
 	//, cache_entries, cache_max_entries
 
 	LLFontGL::getFontMonospace()->renderUTF8(text, 0, 0, v_offset + line_height*3,
@@ -456,7 +456,9 @@ LLViewerOctreeGroup::~LLViewerOctreeGroup()
 LLViewerOctreeGroup::LLViewerOctreeGroup(OctreeNode* node) :
 	mOctreeNode(node),
 	mAnyVisible(0),
-	mState(CLEAN)
+	mState(CLEAN),
+	mFrustumRes(0),
+	mFrustumPass(0)
 {
 	LLVector4a tmp;
 	tmp.splat(0.f);
@@ -1344,6 +1346,12 @@ bool LLViewerOctreeCull::earlyFail(LLViewerOctreeGroup* group)
 void LLViewerOctreeCull::traverse(const OctreeNode* n)
 {
 	LLViewerOctreeGroup* group = (LLViewerOctreeGroup*) n->getListener(0);
+	S32 known_res = mNextRes;
+	mNextRes = -1;
+	if (known_res < 0 && mPass && group->mFrustumPass == mPass)
+	{
+		known_res = group->mFrustumRes;
+	}
 
 	if (earlyFail(group))
 	{
@@ -1357,16 +1365,74 @@ void LLViewerOctreeCull::traverse(const OctreeNode* n)
 	}
 	else
 	{
-		mRes = frustumCheck(group);
+		mRes = known_res >= 0 ? known_res : frustumCheck(group);
 				
-		if (mRes)
-		{ //at least partially in, run on down
+		if (mRes == 1)
+		{ //partially in, run on down checking the children together
+			traverseChildren(n);
+		}
+		else if (mRes)
+		{ //fully in, run on down
 			OctreeTraveler::traverse(n);
 		}
 
 		mRes = 0;
 	}
 }
+
+// Same as OctreeTraveler::traverse(), but with the frustum checks of the
+// children done in one batch up front.
+void LLViewerOctreeCull::traverseChildren(const OctreeNode* n)
+{
+	n->accept(this);
+
+	S32 results[LLAABBBatch::MAX_BOXES];
+	const U32 count = n->getChildCount();
+	const bool batched = count > 1 && !mPass && frustumCheckChildren(n, results);
+	for (U32 i = 0; i < count; i++)
+	{
+		mNextRes = batched ? results[i] : -1;
+		traverse(n->getChild(i));
+	}
+	mNextRes = -1;
+}
+
+void LLViewerOctreeCull::precomputeFrustumChecks(const OctreeNode* n, U32 pass)
+{
+	LLViewerOctreeGroup* group = (LLViewerOctreeGroup*) n->getListener(0);
+	group->mFrustumRes = frustumCheck(group);
+	group->mFrustumPass = pass;
+	if (group->mFrustumRes == 1)
+	{
+		precomputeChildren(n, pass);
+	}
+}
+
+// Checks every child of a node that is partially in, and goes on down the
+// same way traverse() would. Groups flagged SKIP_FRUSTUM_CHECK may be walked
+// through unchecked, so their children are covered whatever their own result.
+// Anything missed here is simply checked again during the traversal.
+void LLViewerOctreeCull::precomputeChildren(const OctreeNode* n, U32 pass)
+{
+	S32 results[LLAABBBatch::MAX_BOXES];
+	const U32 count = n->getChildCount();
+	const bool batched = count > 1 && frustumCheckChildren(n, results);
+	for (U32 i = 0; i < count; i++)
+	{
+		const OctreeNode* child = n->getChild(i);
+		LLViewerOctreeGroup* group = (LLViewerOctreeGroup*) child->getListener(0);
+		if (expectEarlyFail(group))
+		{
+			continue;
+		}
+		group->mFrustumRes = batched ? results[i] : frustumCheck(group);
+		group->mFrustumPass = pass;
+		if (group->mFrustumRes == 1 || group->hasState(LLViewerOctreeGroup::SKIP_FRUSTUM_CHECK))
+		{
+			precomputeChildren(child, pass);
+		}
+	}
+}
 	
 //------------------------------------------
 //agent space group culling
@@ -1386,6 +1452,29 @@ S32 LLViewerOctreeCull::AABBInFrustumGroupBounds(const LLViewerOctreeGroup* grou
 }
 //------------------------------------------
 
+void LLViewerOctreeCull::AABBInFrustumNoFarClipChildBounds(const OctreeNode* n, S32* results)
+{
+	LLAABBBatch boxes;
+	for (U32 i = 0; i < n->getChildCount(); i++)
+	{
+		const LLViewerOctreeGroup* group = (const LLViewerOctreeGroup*) n->getChild(i)->getListener(0);
+		boxes.add(group->mBounds[0], group->mBounds[1]);
+	}
+	mCamera->AABBsInFrustumNoFarClip(boxes, results);
+}
+
+void LLViewerOctreeCull::AABBInFrustumChildBounds(const OctreeNode* n, S32* results)
+{
+	LLAABBBatch boxes;
+	for (U32 i = 0; i < n->getChildCount(); i++)
+	{
+		const LLViewerOctreeGroup* group = (const LLViewerOctreeGroup*) n->getChild(i)->getListener(0);
+		boxes.add(group->mBounds[0], group->mBounds[1]);
+	}
+	mCamera->AABBsInFrustum(boxes, results);
+}
+//------------------------------------------
+
 //------------------------------------------
 //agent space object set culling
 S32 LLViewerOctreeCull::AABBInFrustumNoFarClipObjectBounds(const LLViewerOctreeGroup* group)
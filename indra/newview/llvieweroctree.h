@@ -261,6 +261,8 @@ protected:
 	S32 mAnyVisible; //latest visible to any camera
 	S32 mVisible[LLViewerCamera::NUM_CAMERAS];
 
+	S32 mFrustumRes;  //frustum check result computed ahead of the cull traversal
+	U32 mFrustumPass; //cull pass mFrustumRes belongs to
 };
 //octree group which has capability to support occlusion culling
 //LL_ALIGN_PREFIX(16)
@@ -361,12 +363,36 @@ class LLViewerOctreeCull : public OctreeTraveler
 {
 public:
 	LLViewerOctreeCull(LLCamera* camera)
-		: mCamera(camera), mRes(0) { }
+		: mCamera(camera), mRes(0), mNextRes(-1), mPass(0) { }
 	
 	virtual void traverse(const OctreeNode* n);
 
+	// Runs the frustum checks a traverse() of n is going to need and stores
+	// the results in the groups, tagged with pass. Nothing else is touched,
+	// so independent octrees can be checked on several threads at once.
+	void precomputeFrustumChecks(const OctreeNode* n, U32 pass);
+
+	// Makes traverse() use the results stored by precomputeFrustumChecks()
+	// for pass instead of checking again.
+	void setFrustumPass(U32 pass) { mPass = pass; }
+
 protected:
 	virtual bool earlyFail(LLViewerOctreeGroup* group);	
+	// What earlyFail() would say from the state the group is in now, without
+	// touching it, so that precomputeFrustumChecks() can leave out the
+	// subtrees the traversal is going to skip.
+	virtual bool expectEarlyFail(LLViewerOctreeGroup* group) const { return false; }
+
+	// Fills results with frustumCheck() of every child of n at once, or
+	// returns false to have each child checked on its own. Subclasses that
+	// override frustumCheck() must override this too.
+	virtual bool frustumCheckChildren(const OctreeNode* n, S32* results) { return false; }
+	void traverseChildren(const OctreeNode* n);
+	void precomputeChildren(const OctreeNode* n, U32 pass);
+
+	//agent space group cull of all children of a node, batched
+	void AABBInFrustumNoFarClipChildBounds(const OctreeNode* n, S32* results);
+	void AABBInFrustumChildBounds(const OctreeNode* n, S32* results);
 	
 	//agent space group cull
 	S32 AABBInFrustumNoFarClipGroupBounds(const LLViewerOctreeGroup* group);	
@@ -400,6 +426,8 @@ protected:
 protected:
 	LLCamera *mCamera;
 	S32 mRes;
+	S32 mNextRes;	// frustumCheck() of the next node traversed, when already known
+	U32 mPass;		// precomputed frustum checks to use, 0 for none
 };
 
 #endif
\ No newline at end of file
@@ -232,6 +232,9 @@ LLViewerStats::LLViewerStats() :
 	mTexturePacketsStat("texturepacketsstat"),
 	mActualInKBitStat("actualinkbitstat"),
 	mActualOutKBitStat("actualoutkbitstat"),
+	mNetReceiveCallsStat("netreceivecallsstat"),
+	mNetSendCallsStat("netsendcallsstat"),
+	mNetQueueDelayStat("netqueuedelaystat"),
 	mTrianglesDrawnStat("trianglesdrawnstat"),
 	mSimTimeDilation("simtimedilation"),
 	mSimFPS("simfps"),
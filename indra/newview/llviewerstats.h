@@ -59,6 +59,9 @@ public:
 			mTexturePacketsStat,
 			mActualInKBitStat,	// From the packet ring (when faking a bad connection)
 			mActualOutKBitStat,	// From the packet ring (when faking a bad connection)
+			mNetReceiveCallsStat,	// UDP receive system calls per frame
+			mNetSendCallsStat,		// UDP send system calls per frame
+			mNetQueueDelayStat,		// longest wait in the packet receive thread's queue
 			mTrianglesDrawnStat,
 			mMallocStat;
 
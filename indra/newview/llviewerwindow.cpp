@@ -42,6 +42,7 @@
 #include "llagent.h"
 #include "llagentcamera.h"
 #include "llmeshrepository.h"
+#include "llvolumefacecache.h"
 #include "llpanellogin.h"
 #include "llviewerkeyboard.h"
 
@@ -686,6 +687,10 @@ public:
 					LLMeshRepository::sHTTPRetryCount));
 				ypos += y_inc;
 
+				addText(xpos, ypos, llformat("%d/%d Mesh HTTP Requests Saved/Coalesced", LLMeshRepository::sHTTPRequestsSaved,
+					LLMeshRepository::sHTTPCoalescedRequests));
+				ypos += y_inc;
+
 				addText(xpos, ypos, llformat("%d/%d Mesh LOD Pending/Processing", LLMeshRepository::sLODPending, (U32)LLMeshRepository::sLODProcessing));
 				ypos += y_inc;
 
@@ -694,6 +699,13 @@ public:
 				ypos += y_inc;
 			}
 
+			S32 shared_faces;
+			U64 shared_bytes_saved;
+			LLVolumeFaceCache::getStats(shared_faces, shared_bytes_saved);
+			addText(xpos, ypos, llformat("%d Shared Volume Faces, %.3f MB Saved", shared_faces, shared_bytes_saved/(1024.f*1024.f)));
+
+			ypos += y_inc;
+
 			addText(xpos, ypos, llformat("%d/%d bytes allocted to messages", sMsgDataAllocSize, sMsgdataAllocCount));
 
 			LLVertexBuffer::sBindCount = LLImageGL::sBindCount = 
@@ -46,6 +46,7 @@
 #include "llmaterialtable.h"
 #include "llprimitive.h"
 #include "llvolume.h"
+#include "llvolumefacecache.h"
 #include "llvolumeoctree.h"
 #include "llvolumemgr.h"
 #include "llvolumemessage.h"
@@ -1235,6 +1236,17 @@ void LLVOVolume::sculpt()
 		}
 		getVolume()->sculpt(sculpt_width, sculpt_height, sculpt_components, sculpt_data, discard_level, mSculptTexture->isMissingAsset());
 
+		//sculpts with other prim parameters but the same map end up with the same faces;
+		//only share the final ones, every better discard level replaces them
+		if (!getVolume()->isUnique() &&
+			(mSculptTexture->isCachedRawImageReady() || mSculptTexture->isMissingAsset()))
+		{
+			for (S32 i = 0; i < getVolume()->getNumVolumeFaces(); ++i)
+			{
+				LLVolumeFaceCache::share(getVolume()->getVolumeFace(i));
+			}
+		}
+
 		//notify rebuild any other VOVolumes that reference this sculpty volume
 		for (S32 i = 0; i < mSculptTexture->getNumVolumes(LLRender::SCULPT_TEX); ++i)
 		{
@@ -1720,6 +1732,27 @@ static LLTrace::BlockTimerStatHandle FTM_GEN_FLEX("Generate Flexies");
 static LLTrace::BlockTimerStatHandle FTM_UPDATE_PRIMITIVES("Update Primitives");
 static LLTrace::BlockTimerStatHandle FTM_UPDATE_RIGGED_VOLUME("Update Rigged");
 
+bool LLVOVolume::getPendingVolume(LLVolumeParams& params, S32& detail) const
+{
+	// flexies, sculpties and meshes are built their own way
+	if (mVolumeImpl || isSculpted() || !(mVolumeChanged || mLODChanged))
+	{
+		return false;
+	}
+
+	const LLVolume* volume = getVolume();
+	if (!volume || volume->isUnique() ||
+		mLOD < 0 || mLOD >= LLVolumeLODGroup::NUM_LODS ||
+		LLVolumeLODGroup::getVolumeScaleFromDetail(mLOD) == volume->getDetail())
+	{
+		return false;
+	}
+
+	params = volume->getParams();
+	detail = mLOD;
+	return true;
+}
+
 bool LLVOVolume::lodOrSculptChanged(LLDrawable *drawable, BOOL &compiled)
 {
 	bool regen_faces = false;
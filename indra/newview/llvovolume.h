@@ -176,6 +176,10 @@ public:
 
 				
 				BOOL	getVolumeChanged() const				{ return mVolumeChanged; }
+
+				// The shared volume the next updateGeometry() will switch to,
+				// if it is a plain prim volume that may still need building.
+				bool	getPendingVolume(LLVolumeParams& params, S32& detail) const;
 				
 	/*virtual*/ F32  	getRadius() const						{ return mVObjRadius; };
 				const LLMatrix4a& getWorldMatrix(LLXformMatrix* xform) const;
@@ -59,6 +59,7 @@
 #include "llvocache.h"
 #include "llvowater.h"
 #include "message.h"
+#include "net.h"
 #include "pipeline.h"
 #include "llappviewer.h"		// for do_disconnect()
 #include "llpacketring.h"
@@ -890,6 +891,14 @@ void LLWorld::updateNetStats()
 	S32 actual_out_bits = gMessageSystem->mPacketRing->getAndResetActualOutBits();
 	LLViewerStats::getInstance()->mActualInKBitStat.addValue(actual_in_bits/1024.f);
 	LLViewerStats::getInstance()->mActualOutKBitStat.addValue(actual_out_bits/1024.f);
+	U32 receive_calls, send_calls;
+	get_and_reset_net_syscall_counts(receive_calls, send_calls);
+	LLViewerStats::getInstance()->mNetReceiveCallsStat.addValue(receive_calls);
+	LLViewerStats::getInstance()->mNetSendCallsStat.addValue(send_calls);
+	if (gMessageSystem->mPacketRing->hasReceiveThread())
+	{
+		LLViewerStats::getInstance()->mNetQueueDelayStat.addValue(gMessageSystem->mPacketRing->getAndResetMaxQueueDelay() * 1000.f);
+	}
 	LLViewerStats::getInstance()->mKBitStat.addValue(bits/1024.f);
 	LLViewerStats::getInstance()->mPacketsInStat.addValue(packets_in);
 	LLViewerStats::getInstance()->mPacketsOutStat.addValue(packets_out);
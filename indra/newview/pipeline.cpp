@@ -43,9 +43,11 @@
 #include "llfontgl.h"
 #include "llmemory.h"
 #include "llnamevalue.h"
+#include "llparallelfor.h"
 #include "llpointer.h"
 #include "llprimitive.h"
 #include "llvolume.h"
+#include "llvolumemgr.h"
 #include "material_codes.h"
 #include "timing.h"
 #include "v3color.h"
@@ -2261,6 +2263,81 @@ BOOL LLPipeline::getVisibleExtents(LLCamera& camera, LLVector3& min, LLVector3&
 }
 
 static LLTrace::BlockTimerStatHandle FTM_CULL("Object Culling");
+static LLTrace::BlockTimerStatHandle FTM_CULL_PRECOMPUTE("Precompute Frustum Checks");
+
+// Runs the frustum checks of every partition updateCull() is about to cull
+// on worker threads. The partitions are independent octrees and the checks
+// are pure math, so the results are the same as the serial traversal would
+// get; occlusion, visibility marking and the cull result itself stay on the
+// main thread, in the usual order. Groups already known to be occluded are
+// left out along with everything below them, as the traversal skips them.
+//
+// The main thread waits for the checks, so they only pay off when spreading
+// them over several cores saves more than waking the workers costs. A frustum
+// check takes about 25 ns, waking a worker on another core typically takes
+// 10-20 us, and a cull checks between a twentieth and a fifth of all groups
+// depending on occlusion, so scenes with fewer groups than this are culled
+// the usual way.
+static const U32 CULL_PRECOMPUTE_MIN_GROUPS = 16384;
+
+static void precompute_cull(LLCamera& camera, S32 water_clip)
+{
+	if (ll_parallel_for_threads() <= 1 || LLSpatialGroup::sNodeCount < CULL_PRECOMPUTE_MIN_GROUPS)
+	{
+		return;
+	}
+
+	LL_RECORD_BLOCK_TIME(FTM_CULL_PRECOMPUTE);
+
+	struct CullJob
+	{
+		LLSpatialPartition* mPartition;
+		F32 mWaterHeight;
+	};
+
+	std::vector<CullJob> jobs;
+	for (LLWorld::region_list_t::const_iterator iter = LLWorld::getInstance()->getRegionList().begin(); 
+			iter != LLWorld::getInstance()->getRegionList().end(); ++iter)
+	{
+		LLViewerRegion* region = *iter;
+		for (U32 i = 0; i < LLViewerRegion::NUM_PARTITIONS; i++)
+		{
+			LLSpatialPartition* part = region->getSpatialPartition(i);
+			if (part && gPipeline.hasRenderType(part->mDrawableType))
+			{
+				part->prepareCull();
+				CullJob job = { part, region->getWaterHeight() };
+				jobs.push_back(job);
+			}
+		}
+	}
+
+	static U32 sPass = 0;
+	if (++sPass == 0)
+	{
+		sPass = 1;
+	}
+	const U32 pass = sPass;
+
+	ll_parallel_for(jobs.size(), 1, [&](size_t begin, size_t end)
+	{
+		LLCamera region_camera(camera);
+		for (size_t i = begin; i < end; ++i)
+		{
+			//same clip plane as updateCull() sets for the region
+			if (water_clip != 0)
+			{
+				LLPlane plane(LLVector3(0,0, (F32) -water_clip), (F32) water_clip*jobs[i].mWaterHeight);
+				region_camera.setUserClipPlane(plane);
+			}
+			else
+			{
+				region_camera.disableUserClipPlane();
+			}
+			jobs[i].mPartition->precomputeCull(region_camera, pass);
+		}
+	});
+}
 
 void LLPipeline::updateCull(LLCamera& camera, LLCullResult& result, S32 water_clip, LLPlane* planep)
 {
@@ -2349,6 +2426,8 @@ void LLPipeline::updateCull(LLCamera& camera, LLCullResult& result, S32 water_cl
 		}
 		mCubeVB->setBuffer(LLVertexBuffer::MAP_VERTEX);
 	}
+
+	precompute_cull(camera, water_clip);
 	
 	for (LLWorld::region_list_t::const_iterator iter = LLWorld::getInstance()->getRegionList().begin(); 
 			iter != LLWorld::getInstance()->getRegionList().end(); ++iter)
@@ -2810,6 +2889,42 @@ void LLPipeline::rebuildGroups()
 	updateMovedList(mMovedBridge);
 }
 
+static LLTrace::BlockTimerStatHandle FTM_PREBUILD_VOLUMES("Prebuild Volumes");
+
+// Builds the shared volumes that up to count drawables from begin on are
+// about to switch to, on worker threads, so that their updateGeometry()
+// finds them ready in the volume manager. The references taken are added
+// to refs, to be released once the drawables hold their own. Returns the
+// number of drawables looked at.
+static S32 prebuild_volumes(LLDrawable::drawable_list_t::const_iterator begin,
+							LLDrawable::drawable_list_t::const_iterator end,
+							S32 count, std::vector<LLVolume*>& refs)
+{
+	LL_RECORD_BLOCK_TIME(FTM_PREBUILD_VOLUMES);
+
+	std::vector<LLVolumeMgr::volume_request_t> requests;
+	S32 visited = 0;
+	for (LLDrawable::drawable_list_t::const_iterator iter = begin; iter != end && visited < count; ++iter, ++visited)
+	{
+		LLDrawable* drawablep = *iter;
+		LLVOVolume* volobjp = drawablep && !drawablep->isDead() ? drawablep->getVOVolume() : NULL;
+		LLVolumeMgr::volume_request_t request;
+		if (volobjp && volobjp->getPendingVolume(request.first, request.second))
+		{
+			requests.push_back(request);
+		}
+	}
+
+	//a lone volume is just as quick to build where it is needed
+	if (requests.size() > 1)
+	{
+		std::vector<LLVolume*> volumes;
+		LLPrimitive::getVolumeManager()->refVolumes(requests, volumes);
+		refs.insert(refs.end(), volumes.begin(), volumes.end());
+	}
+	return visited;
+}
+
 void LLPipeline::updateGeom(F32 max_dtime, LLCamera& camera)
 {
 	LLTimer update_timer;
@@ -2832,6 +2947,9 @@ void LLPipeline::updateGeom(F32 max_dtime, LLCamera& camera)
 	// for now, only LLVOVolume does this to throttle LOD changes
 	LLVOVolume::preUpdateGeom();
 
+	std::vector<LLVolume*> prebuilt_volumes;
+	prebuild_volumes(mBuildQ1.begin(), mBuildQ1.end(), (S32) mBuildQ1.size(), prebuilt_volumes);
+
 	// Iterate through all drawables on the priority build queue,
 	for (LLDrawable::drawable_list_t::iterator iter = mBuildQ1.begin();
 		 iter != mBuildQ1.end();)
@@ -2881,6 +2999,10 @@ void LLPipeline::updateGeom(F32 max_dtime, LLCamera& camera)
 	LLSpatialGroup* last_group = NULL;
 	LLSpatialBridge* last_bridge = NULL;
 
+	//volumes are prebuilt a batch at a time, as far as the time budget goes
+	const S32 prebuild_batch = (S32) ll_parallel_for_threads() * 4;
+	S32 prebuilt_left = 0;
+
 	for (LLDrawable::drawable_list_t::iterator iter = mBuildQ2.begin();
 		 iter != mBuildQ2.end(); )
 	{
@@ -2902,6 +3024,12 @@ void LLPipeline::updateGeom(F32 max_dtime, LLCamera& camera)
 		last_group = drawablep->getSpatialGroup();
 		last_bridge = bridge;
 
+		if (!prebuilt_left)
+		{
+			prebuilt_left = prebuild_volumes(curiter, mBuildQ2.end(), prebuild_batch, prebuilt_volumes);
+		}
+		prebuilt_left--;
+
 		BOOL update_complete = TRUE;
 		if (!drawablep->isDead())
 		{
@@ -2915,6 +3043,11 @@ void LLPipeline::updateGeom(F32 max_dtime, LLCamera& camera)
 		}
 	}	
 
+	for (std::vector<LLVolume*>::iterator iter = prebuilt_volumes.begin(); iter != prebuilt_volumes.end(); ++iter)
+	{
+		LLPrimitive::getVolumeManager()->unrefVolume(*iter);
+	}
+
 	updateMovedList(mMovedBridge);
 	calcNearbyLights(camera);
 	mLightMode = LIGHT_MODE_NORMAL;
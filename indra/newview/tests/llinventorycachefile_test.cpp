@@ -0,0 +1,360 @@
+/**
+ * @file llinventorycachefile_test.cpp
+ * @brief Tests for the binary inventory cache
+ *
+ * $LicenseInfo:firstyear=2026&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2026, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+// Precompiled header: almost always required for newview cpp files
+#include "../llviewerprecompiledheaders.h"
+// Class to test
+#include "../llinventorycachefile.h"
+// Dependencies
+#include "../llviewerinventory.h"
+
+// Tut header
+#include "../test/lltut.h"
+
+// -------------------------------------------------------------------------------------------
+// Stubbing: Declarations required to link and run the class being tested
+// Notes:
+// * Add here stubbed implementation of the few classes and methods used in the class to be tested
+// * Add as little as possible (let the link errors guide you)
+// * Do not make any assumption as to how those classes or methods work (i.e. don't copy/paste code)
+// * A simulator for a class can be implemented here. Please comment and document thoroughly.
+
+// The cache only constructs viewer inventory objects and reads them back
+// through the LLInventoryItem and LLInventoryCategory accessors.
+LLViewerInventoryItem::LLViewerInventoryItem(const LLUUID& uuid, const LLUUID& parent_uuid,
+											 const LLPermissions& perm, const LLUUID& asset_uuid,
+											 LLAssetType::EType type, LLInventoryType::EType inv_type,
+											 const std::string& name, const std::string& desc,
+											 const LLSaleInfo& sale_info, U32 flags,
+											 time_t creation_date_utc)
+:	LLInventoryItem(uuid, parent_uuid, perm, asset_uuid, type, inv_type,
+					name, desc, sale_info, flags, creation_date_utc),
+	mIsComplete(TRUE)
+{
+}
+LLViewerInventoryItem::~LLViewerInventoryItem() {}
+LLAssetType::EType LLViewerInventoryItem::getType() const { return LLInventoryItem::getType(); }
+const LLUUID& LLViewerInventoryItem::getAssetUUID() const { return LLInventoryItem::getAssetUUID(); }
+const LLUUID& LLViewerInventoryItem::getProtectedAssetUUID() const { return LLInventoryItem::getAssetUUID(); }
+const std::string& LLViewerInventoryItem::getName() const { return LLInventoryItem::getName(); }
+S32 LLViewerInventoryItem::getSortField() const { return 0; }
+void LLViewerInventoryItem::getSLURL() {}
+const LLPermissions& LLViewerInventoryItem::getPermissions() const { return LLInventoryItem::getPermissions(); }
+const bool LLViewerInventoryItem::getIsFullPerm() const { return false; }
+const LLUUID& LLViewerInventoryItem::getCreatorUUID() const { return LLInventoryItem::getCreatorUUID(); }
+const std::string& LLViewerInventoryItem::getDescription() const { return LLInventoryItem::getDescription(); }
+const LLSaleInfo& LLViewerInventoryItem::getSaleInfo() const { return LLInventoryItem::getSaleInfo(); }
+LLInventoryType::EType LLViewerInventoryItem::getInventoryType() const { return LLInventoryItem::getInventoryType(); }
+bool LLViewerInventoryItem::isWearableType() const { return false; }
+LLWearableType::EType LLViewerInventoryItem::getWearableType() const { return LLWearableType::WT_INVALID; }
+U32 LLViewerInventoryItem::getFlags() const { return LLInventoryItem::getFlags(); }
+time_t LLViewerInventoryItem::getCreationDate() const { return LLInventoryItem::getCreationDate(); }
+U32 LLViewerInventoryItem::getCRC32() const { return LLInventoryItem::getCRC32(); }
+void LLViewerInventoryItem::copyItem(const LLInventoryItem* other) { LLInventoryItem::copyItem(other); }
+void LLViewerInventoryItem::updateParentOnServer(BOOL restamp) const {}
+void LLViewerInventoryItem::updateServer(BOOL is_new) const {}
+void LLViewerInventoryItem::packMessage(LLMessageSystem* msg) const {}
+BOOL LLViewerInventoryItem::unpackMessage(LLMessageSystem* msg, const char* block, S32 block_num) { return FALSE; }
+BOOL LLViewerInventoryItem::unpackMessage(const LLSD& item) { return FALSE; }
+BOOL LLViewerInventoryItem::importFile(LLFILE* fp) { return FALSE; }
+BOOL LLViewerInventoryItem::importLegacyStream(std::istream& input_stream) { return FALSE; }
+void LLViewerInventoryItem::setTransactionID(const LLTransactionID& transaction_id) {}
+
+LLViewerInventoryCategory::LLViewerInventoryCategory(const LLUUID& uuid, const LLUUID& parent_uuid,
+													 LLFolderType::EType pref, const std::string& name,
+													 const LLUUID& owner_id)
+:	LLInventoryCategory(uuid, parent_uuid, pref, name),
+	mOwnerID(owner_id),
+	mVersion(VERSION_UNKNOWN),
+	mDescendentCount(DESCENDENT_COUNT_UNKNOWN)
+{
+}
+LLViewerInventoryCategory::~LLViewerInventoryCategory() {}
+S32 LLViewerInventoryCategory::getVersion() const { return mVersion; }
+void LLViewerInventoryCategory::setVersion(S32 version) { mVersion = version; }
+void LLViewerInventoryCategory::updateParentOnServer(BOOL restamp_children) const {}
+void LLViewerInventoryCategory::updateServer(BOOL is_new) const {}
+void LLViewerInventoryCategory::packMessage(LLMessageSystem* msg) const {}
+void LLViewerInventoryCategory::unpackMessage(LLMessageSystem* msg, const char* block, S32 block_num) {}
+BOOL LLViewerInventoryCategory::unpackMessage(const LLSD& category) { return FALSE; }
+
+// End Stubbing
+// -------------------------------------------------------------------------------------------
+
+// -------------------------------------------------------------------------------------------
+// TUT
+// -------------------------------------------------------------------------------------------
+
+namespace
+{
+	const S32 CONTENT_VERSION = 3;
+	const S32 ITEM_COUNT = 64;
+
+	std::string read_file(const std::string& filename)
+	{
+		std::string contents;
+		LLFILE* fp = LLFile::fopen(filename, "rb");
+		if (fp)
+		{
+			char buffer[4096];
+			size_t got;
+			while ((got = fread(buffer, 1, sizeof(buffer), fp)) > 0)
+			{
+				contents.append(buffer, got);
+			}
+			fclose(fp);
+		}
+		return contents;
+	}
+
+	void write_file(const std::string& filename, const std::string& contents)
+	{
+		LLFILE* fp = LLFile::fopen(filename, "wb");
+		fwrite(contents.data(), 1, contents.size(), fp);
+		fclose(fp);
+	}
+}
+
+namespace tut
+{
+	// Test wrapper declarations
+	struct inventorycachefile_test
+	{
+		std::string mFilename;
+		LLUUID mOwnerID;
+		LLInventoryModel::cat_array_t mCategories;
+		LLInventoryModel::item_array_t mItems;
+
+		inventorycachefile_test()
+		:	mFilename("inventorycachefile_test.invbin")
+		{
+			mOwnerID.generate();
+
+			LLPointer<LLViewerInventoryCategory> root = addCategory(LLUUID::null, LLFolderType::FT_ROOT_INVENTORY, "My Inventory");
+			LLPointer<LLViewerInventoryCategory> objects = addCategory(root->getUUID(), LLFolderType::FT_OBJECT, "Objects");
+			for (S32 i = 0; i < ITEM_COUNT; ++i)
+			{
+				addItem(objects->getUUID(), llformat("Object %d", i));
+			}
+		}
+		~inventorycachefile_test()
+		{
+			LLFile::remove(mFilename);
+		}
+
+		LLPointer<LLViewerInventoryCategory> addCategory(const LLUUID& parent_id, LLFolderType::EType type, const std::string& name)
+		{
+			LLUUID id;
+			id.generate();
+			LLPointer<LLViewerInventoryCategory> cat = new LLViewerInventoryCategory(id, parent_id, type, name, mOwnerID);
+			cat->setVersion(LLViewerInventoryCategory::VERSION_INITIAL);
+			mCategories.push_back(cat);
+			return cat;
+		}
+
+		LLPointer<LLViewerInventoryItem> addItem(const LLUUID& parent_id, const std::string& name)
+		{
+			LLUUID id, asset_id, creator_id;
+			id.generate();
+			asset_id.generate();
+			creator_id.generate();
+			LLPermissions perm;
+			perm.init(creator_id, mOwnerID, creator_id, LLUUID::null);
+			perm.initMasks(PERM_ALL, PERM_ALL, PERM_NONE, PERM_NONE, PERM_MOVE | PERM_TRANSFER);
+			LLPointer<LLViewerInventoryItem> item = new LLViewerInventoryItem(
+				id, parent_id, perm, asset_id, LLAssetType::AT_OBJECT, LLInventoryType::IT_OBJECT,
+				name, "Description of " + name, LLSaleInfo(LLSaleInfo::FS_COPY, 10), 0x1234, 1234567890);
+			mItems.push_back(item);
+			return item;
+		}
+
+		void save()
+		{
+			ensure("saved", LLInventoryCacheFile::save(mFilename, CONTENT_VERSION, mCategories, mItems));
+		}
+
+		// Loads the cache and checks that it holds what is in mCategories
+		// and mItems.
+		void ensureLoads()
+		{
+			LLInventoryModel::cat_array_t categories;
+			LLInventoryModel::item_array_t items;
+			ensure("loaded", LLInventoryCacheFile::load(mFilename, CONTENT_VERSION, categories, items));
+			ensure_equals("category count", categories.size(), mCategories.size());
+			ensure_equals("item count", items.size(), mItems.size());
+
+			std::map<LLUUID, LLViewerInventoryCategory*> loaded_categories;
+			for (size_t i = 0; i < categories.size(); ++i)
+			{
+				loaded_categories[categories[i]->getUUID()] = categories[i];
+			}
+			for (size_t i = 0; i < mCategories.size(); ++i)
+			{
+				const LLViewerInventoryCategory* expected = mCategories[i];
+				const LLViewerInventoryCategory* cat = loaded_categories[expected->getUUID()];
+				ensure("category loaded", cat != NULL);
+				ensure_equals("category parent", cat->getParentUUID(), expected->getParentUUID());
+				ensure_equals("category owner", cat->getOwnerID(), expected->getOwnerID());
+				ensure_equals("category version", cat->getVersion(), expected->getVersion());
+				ensure_equals("category type", cat->getPreferredType(), expected->getPreferredType());
+				ensure_equals("category name", cat->getName(), expected->getName());
+			}
+
+			std::map<LLUUID, LLViewerInventoryItem*> loaded_items;
+			for (size_t i = 0; i < items.size(); ++i)
+			{
+				loaded_items[items[i]->getUUID()] = items[i];
+			}
+			for (size_t i = 0; i < mItems.size(); ++i)
+			{
+				const LLViewerInventoryItem* expected = mItems[i];
+				const LLViewerInventoryItem* item = loaded_items[expected->getUUID()];
+				ensure("item loaded", item != NULL);
+				ensure_equals("item parent", item->getParentUUID(), expected->getParentUUID());
+				ensure_equals("item asset", item->getAssetUUID(), expected->getAssetUUID());
+				ensure("item permissions", item->getPermissions() == expected->getPermissions());
+				ensure_equals("item sale type", item->getSaleInfo().getSaleType(), expected->getSaleInfo().getSaleType());
+				ensure_equals("item sale price", item->getSaleInfo().getSalePrice(), expected->getSaleInfo().getSalePrice());
+				ensure_equals("item type", item->getType(), expected->getType());
+				ensure_equals("item inventory type", item->getInventoryType(), expected->getInventoryType());
+				ensure_equals("item flags", item->getFlags(), expected->getFlags());
+				ensure_equals("item creation date", item->getCreationDate(), expected->getCreationDate());
+				ensure_equals("item name", item->getName(), expected->getName());
+				ensure_equals("item description", item->getDescription(), expected->getDescription());
+				ensure("item fetched before use", !item->isComplete());
+			}
+		}
+
+		void ensureLoadFails(S32 content_version)
+		{
+			LLInventoryModel::cat_array_t categories(mCategories);
+			LLInventoryModel::item_array_t items(mItems);
+			ensure("not loaded", !LLInventoryCacheFile::load(mFilename, content_version, categories, items));
+			ensure("no categories", categories.empty());
+			ensure("no items", items.empty());
+		}
+	};
+
+	// Tut templating thingamagic: test group, object and test instance
+	typedef test_group<inventorycachefile_test> inventorycachefile_t;
+	typedef inventorycachefile_t::object inventorycachefile_object_t;
+	tut::inventorycachefile_t tut_inventorycachefile("inventorycachefile");
+
+	// Round trip through a fresh snapshot.
+	template<> template<>
+	void inventorycachefile_object_t::test<1>()
+	{
+		LLPointer<LLViewerInventoryCategory> unknown = addCategory(mCategories[0]->getUUID(), LLFolderType::FT_NONE, "Never fetched");
+		unknown->setVersion(LLViewerInventoryCategory::VERSION_UNKNOWN);
+		save();
+		// Categories with an unknown version are not cached.
+		mCategories.pop_back();
+		ensureLoads();
+	}
+
+	// Small changes are appended and replayed over the snapshot.
+	template<> template<>
+	void inventorycachefile_object_t::test<2>()
+	{
+		save();
+		std::string snapshot = read_file(mFilename);
+
+		mItems[0]->rename("Renamed object");
+		mItems.erase(mItems.begin() + 1);
+		addItem(mCategories[1]->getUUID(), "New object");
+		mCategories[1]->setVersion(LLViewerInventoryCategory::VERSION_INITIAL + 1);
+		save();
+		std::string contents = read_file(mFilename);
+		ensure("appended", contents.size() > snapshot.size());
+		ensure("snapshot kept", contents.compare(0, snapshot.size(), snapshot) == 0);
+		ensureLoads();
+
+		// Nothing changed: nothing to append.
+		save();
+		ensure_equals("up to date", read_file(mFilename).size(), contents.size());
+		ensureLoads();
+	}
+
+	// A save interrupted while appending loses only the damaged record.
+	template<> template<>
+	void inventorycachefile_object_t::test<3>()
+	{
+		save();
+		mItems[0]->rename("First change");
+		save();
+		size_t first_size = read_file(mFilename).size();
+		std::string first_name = mItems[1]->getName();
+		mItems[1]->rename("Second change");
+		save();
+		std::string contents = read_file(mFilename);
+		ensure("appended", contents.size() > first_size);
+
+		write_file(mFilename, contents.substr(0, contents.size() - 3));
+		mItems[1]->rename(first_name);
+		ensureLoads();
+
+		// The next save cannot append after the damaged record, so it
+		// writes a fresh snapshot.
+		mItems[2]->rename("Third change");
+		save();
+		ensureLoads();
+	}
+
+	// A column that fails its checksum makes the whole cache unusable.
+	template<> template<>
+	void inventorycachefile_object_t::test<4>()
+	{
+		mItems[ITEM_COUNT / 2]->rename("Corrupt me");
+		save();
+		std::string contents = read_file(mFilename);
+		size_t name_pos = contents.find("Corrupt me");
+		ensure("name stored", name_pos != std::string::npos);
+		contents[name_pos] = 'X';
+		write_file(mFilename, contents);
+		ensureLoadFails(CONTENT_VERSION);
+
+		// Saving again replaces the damaged file.
+		save();
+		ensureLoads();
+	}
+
+	// No usable cache: the caller falls back to the text cache.
+	template<> template<>
+	void inventorycachefile_object_t::test<5>()
+	{
+		ensureLoadFails(CONTENT_VERSION);
+
+		write_file(mFilename, "<llsd><map /></llsd>");
+		ensureLoadFails(CONTENT_VERSION);
+
+		save();
+		ensureLoadFails(CONTENT_VERSION + 1);
+
+		std::string contents = read_file(mFilename);
+		write_file(mFilename, contents.substr(0, contents.size() / 2));
+		ensureLoadFails(CONTENT_VERSION);
+	}
+}
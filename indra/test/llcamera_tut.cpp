@@ -0,0 +1,154 @@
+/**
+ * @file llcamera_tut.cpp
+ * @brief Checks the batched LLCamera frustum tests against the box by box ones
+ *
+ * $LicenseInfo:firstyear=2026&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2026, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include <tut/tut.hpp>
+#include "linden_common.h"
+#include "lltut.h"
+#include "llcamera.h"
+#include "lltimer.h"
+
+namespace tut
+{
+	struct llcamera_data
+	{
+		// 100k boxes, about the drawables of a busy region, gathered in
+		// batches of eight the way LLViewerOctreeCull batches the children
+		// of a node.
+		enum { NUM_BOXES = 100000, NUM_BATCHES = NUM_BOXES / LLAABBBatch::MAX_BOXES };
+
+		LLCamera mCamera;
+		std::vector<LLVector4a> mCenters;
+		std::vector<LLVector4a> mRadii;
+
+		llcamera_data()
+			: mCamera(1.f, 1.6f, 1000, 0.1f, 128.f),
+			  mCenters(NUM_BOXES),
+			  mRadii(NUM_BOXES)
+		{
+			LLVector3 origin(128.f, 40.f, 30.f);
+			mCamera.lookAt(origin, LLVector3(128.f, 200.f, 30.f));
+			LLVector3 frust[8];
+			const F32 h = tanf(mCamera.getView() * 0.5f);
+			const F32 w = h * mCamera.getAspect();
+			for (S32 k = 0; k < 2; ++k)
+			{
+				const F32 d = k ? mCamera.getFar() : mCamera.getNear();
+				const LLVector3 at = origin + mCamera.getAtAxis() * d;
+				const LLVector3 left = mCamera.getLeftAxis() * (w * d);
+				const LLVector3 up = mCamera.getUpAxis() * (h * d);
+				frust[k * 4 + 0] = at + left - up;
+				frust[k * 4 + 1] = at - left - up;
+				frust[k * 4 + 2] = at - left + up;
+				frust[k * 4 + 3] = at + left + up;
+			}
+			mCamera.calcAgentFrustumPlanes(frust);
+
+			// a region of boxes, some of them straddling the frustum planes
+			srand(1);
+			for (S32 i = 0; i < NUM_BOXES; ++i)
+			{
+				mCenters[i].set(random_f32(256.f), random_f32(256.f), 20.f + random_f32(20.f));
+				const F32 r = 0.2f + random_f32(8.f);
+				mRadii[i].set(r, r, r);
+			}
+		}
+
+		static F32 random_f32(F32 max)
+		{
+			return max * (F32)rand() / (F32)RAND_MAX;
+		}
+
+		// Runs the box by box and the batched test over all boxes, checks
+		// that they agree and logs how long each took.
+		void compare(bool far_clip)
+		{
+			const S32 passes = 20;
+			std::vector<S32> single(NUM_BOXES), batched(NUM_BOXES);
+
+			LLTimer timer;
+			for (S32 pass = 0; pass < passes; ++pass)
+			{
+				for (S32 i = 0; i < NUM_BOXES; ++i)
+				{
+					single[i] = far_clip ? mCamera.AABBInFrustum(mCenters[i], mRadii[i]) :
+										   mCamera.AABBInFrustumNoFarClip(mCenters[i], mRadii[i]);
+				}
+			}
+			const F64 single_seconds = timer.getElapsedTimeF64();
+
+			timer.reset();
+			for (S32 pass = 0; pass < passes; ++pass)
+			{
+				for (S32 b = 0; b < NUM_BATCHES; ++b)
+				{
+					// gathering the batch is part of what the cull pays
+					LLAABBBatch batch;
+					const S32 first = b * LLAABBBatch::MAX_BOXES;
+					for (S32 i = first; i < first + LLAABBBatch::MAX_BOXES; ++i)
+					{
+						batch.add(mCenters[i], mRadii[i]);
+					}
+					if (far_clip)
+					{
+						mCamera.AABBsInFrustum(batch, &batched[first]);
+					}
+					else
+					{
+						mCamera.AABBsInFrustumNoFarClip(batch, &batched[first]);
+					}
+				}
+			}
+			const F64 batched_seconds = timer.getElapsedTimeF64();
+
+			S32 in = 0;
+			for (S32 i = 0; i < NUM_BOXES; ++i)
+			{
+				ensure_equals("Ensure batched result matches box by box ", batched[i], single[i]);
+				in += single[i] != 0;
+			}
+			LL_INFOS() << (far_clip ? "AABBInFrustum" : "AABBInFrustumNoFarClip") << ": " << NUM_BOXES << " boxes, "
+					   << in << " in: box by box " << single_seconds * 1.e9 / (passes * NUM_BOXES) << " ns/box, batched "
+					   << batched_seconds * 1.e9 / (passes * NUM_BOXES) << " ns/box" << LL_ENDL;
+		}
+	};
+	typedef test_group<llcamera_data> llcamera_test;
+	typedef llcamera_test::object llcamera_object;
+	tut::llcamera_test llcamera_testcase("llcamera");
+
+	template<> template<>
+	void llcamera_object::test<1>()
+		// AABBsInFrustum() matches AABBInFrustum()
+	{
+		compare(true);
+	}
+
+	template<> template<>
+	void llcamera_object::test<2>()
+		// AABBsInFrustumNoFarClip() matches AABBInFrustumNoFarClip()
+	{
+		compare(false);
+	}
+}
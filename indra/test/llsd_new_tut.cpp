@@ -733,27 +733,27 @@ namespace tut
 		}
 		
 		{
-			SDAllocationCheck check("assign integer value", 1);
+			SDAllocationCheck check("assign integer value", 0);
 			LLSD v = 45;
 			v = 33;
 			v = 0;
 		}
 
 		{
-			SDAllocationCheck check("copy construct integer", 1);
+			SDAllocationCheck check("copy construct integer", 0);
 			LLSD v = 45;
 			LLSD w = v;
 		}
 
 		{
-			SDAllocationCheck check("assign integer", 1);
+			SDAllocationCheck check("assign integer", 0);
 			LLSD v = 45;
 			LLSD w;
 			w = v;
 		}
 		
 		{
-			SDAllocationCheck check("avoids extra clone", 2);
+			SDAllocationCheck check("avoids extra clone", 1);
 			LLSD v = 45;
 			LLSD w = v;
 			w = "nice day";
@@ -769,6 +769,34 @@ namespace tut
 		ensure("type is a string", v.isString());
 	}
 
+	template<> template<>
+	void SDTestObject::test<15>()
+		// inline scalars keep their own value and type through copies
+	{
+		SDCleanupCheck check;
+
+		LLSD r = 2.5;
+		LLSD i = 7;
+		LLSD b = true;
+		LLSD v = r;
+		ensureTypeAndValue("copied real", v, 2.5);
+		v = i;
+		ensureTypeAndValue("real replaced by integer", v, 7);
+		v = b;
+		ensureTypeAndValue("integer replaced by boolean", v, true);
+		v = r;
+		ensureTypeAndValue("boolean replaced by real", v, 2.5);
+		v = "text";
+		ensureTypeAndValue("real replaced by string", v, "text");
+		v = i;
+		ensureTypeAndValue("string replaced by integer", v, 7);
+		ensure("integer has no map members", !v.has("x"));
+		ensure_equals("integer has no size", v.size(), 0);
+		v.clear();
+		ensure("cleared", v.isUndefined());
+		ensureTypeAndValue("source real unaltered", r, 2.5);
+	}
+
 	/* TO DO:
 		conversion of undefined to UUID, Date, URI and Binary
 		conversion of undefined to map and array
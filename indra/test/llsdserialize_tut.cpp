@@ -40,6 +40,7 @@
 #include "linden_common.h"
 #include "llsd.h"
 #include "llsdserialize.h"
+#include "llsdxmlscanner.h"
 #include "lltut.h"
 #include "llformat.h"
 
@@ -648,6 +649,47 @@ namespace tut
 			v.size() + 1);
 	}
 
+	template<> template<> 
+	void TestLLSDXMLParsingObject::test<4>()
+	{
+		// documents the scanner handles and documents it leaves to expat
+		// must parse the same either way
+		const char* documents[] = {
+			"<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<llsd><map>"
+				"<key>a&lt;b</key><string>x&amp;y&#65;&#x263A;\xc3\xa9</string>"
+				"<key>bin</key><binary encoding=\"base64\">aGVs\r\nbG8=</binary>"
+				"<key>list</key><array><integer>1</integer><undef/><real>1.5</real></array>"
+			"</map></llsd>\n",
+			"<llsd>\r\n<string>line\r\nbreaks\rhere</string>\r\n</llsd>",
+			"<llsd><map><key>k</key><llsd><integer>1</integer></llsd></map></llsd>",
+			"<llsd><string>ha ha</string>",
+			"<!-- comment --><llsd><string>a</string></llsd>",
+			"<llsd><string><![CDATA[<tag>]]></string></llsd>",
+			"<llsd><string>a]]>b</string></llsd>",
+			"<llsd><string>bad \xff byte</string></llsd>",
+			"<llsd><string>&unknown;</string></llsd>",
+			"<llsd><binary encoding=\"base64\" encoding=\"base64\">aGVsbG8=</binary></llsd>",
+			"<map><key>a</key><integer>1</integer></map>",
+			"<llsd/>"
+		};
+		for (size_t i = 0; i < sizeof(documents) / sizeof(documents[0]); ++i)
+		{
+			std::string msg = llformat("document %d", (int)i);
+			LLSD results[2];
+			S32 counts[2];
+			for (int enabled = 0; enabled < 2; ++enabled)
+			{
+				LLSDXMLScanner::setEnabled(enabled != 0);
+				std::istringstream input(documents[i]);
+				mParser->reset();
+				counts[enabled] = mParser->parse(input, results[enabled], LLSDSerialize::SIZE_UNLIMITED);
+			}
+			LLSDXMLScanner::setEnabled(true);
+			ensure_equals(msg, results[1], results[0]);
+			ensure_equals(msg + " (count)", counts[1], counts[0]);
+		}
+	}
+
 	/*
 	TODO:
 		test XML parsing
@@ -1439,6 +1481,69 @@ namespace tut
 		ensureBinaryAndNotation("map", test);
 		ensureBinaryAndXML("map", test);
 	}
+
+	class LLSDEventRecorder : public LLSDParseHandler
+	{
+	public:
+		LLSDEventRecorder(S32 stop_after = -1) : mValues(0), mStopAfter(stop_after) { }
+
+		/*virtual*/ bool beginMap()						{ mEvents << "{"; return true; }
+		/*virtual*/ bool mapKey(const std::string& key)	{ mEvents << key << ":"; return true; }
+		/*virtual*/ bool endMap()						{ mEvents << "}"; return true; }
+		/*virtual*/ bool beginArray()					{ mEvents << "["; return true; }
+		/*virtual*/ bool endArray()						{ mEvents << "]"; return true; }
+		/*virtual*/ bool value(const LLSD& value)
+		{
+			mEvents << value.asString() << ",";
+			return (mStopAfter < 0) || (++mValues < mStopAfter);
+		}
+
+		std::ostringstream mEvents;
+		S32 mValues;
+		S32 mStopAfter;
+	};
+
+	template<> template<> 
+	void TestLLSDCompatibleObject::test<9>()
+	{
+		// streaming parses see the same events in every format
+		LLSD test;
+		test["name"] = "bar";
+		test["count"] = 100;
+		test["list"].append(1.5);
+		test["list"].append(LLSD::emptyMap());
+		test["list"][2]["deep"] = true;
+
+		std::stringstream binary, notation, xml;
+		LLSDSerialize::toBinary(test, binary);
+		LLSDSerialize::toNotation(test, notation);
+		LLSDSerialize::toXML(test, xml);
+
+		LLSDEventRecorder from_binary, from_notation, from_xml;
+		LLPointer<LLSDParser> parser = new LLSDBinaryParser;
+		ensure_equals("binary stream count",
+			parser->parse(binary, from_binary, LLSDSerialize::SIZE_UNLIMITED), 8);
+		parser = new LLSDNotationParser;
+		ensure_equals("notation stream count",
+			parser->parse(notation, from_notation, LLSDSerialize::SIZE_UNLIMITED), 8);
+		parser = new LLSDXMLParser;
+		ensure_equals("xml stream count",
+			parser->parse(xml, from_xml, LLSDSerialize::SIZE_UNLIMITED), 8);
+
+		ensure_equals("binary events", from_binary.mEvents.str(),
+			std::string("{count:100,list:[1.5,{}{deep:true,}]name:bar,}"));
+		ensure_equals("notation events", from_notation.mEvents.str(), from_binary.mEvents.str());
+		ensure_equals("xml events", from_xml.mEvents.str(), from_binary.mEvents.str());
+
+		// a handler returning false ends the parse
+		LLSDEventRecorder stopper(2);
+		std::istringstream rebinary(binary.str());
+		parser = new LLSDBinaryParser;
+		ensure_equals("stopped parse",
+			parser->parse(rebinary, stopper, LLSDSerialize::SIZE_UNLIMITED),
+			(S32)LLSDParser::PARSE_FAILURE);
+		ensure_equals("stopped after", stopper.mValues, 2);
+	}
 }
 
 #endif
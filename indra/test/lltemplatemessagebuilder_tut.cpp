@@ -39,6 +39,7 @@
 #include "llquaternion.h"
 #include "lltemplatemessagebuilder.h"
 #include "lltemplatemessagereader.h"
+#include "lltimer.h"
 #include "llversionserver.h"
 #include "message_prehash.h"
 #include "u64.h"
@@ -108,8 +109,9 @@ namespace tut
 			U8 offset = 0)
 		{
 			numberMap[1] = &messageTemplate;
+			// the buffer outlives the reader
 			const U32 bufferSize = 1024;
-			U8 buffer[bufferSize];
+			static U8 buffer[bufferSize];
 			// zero out the packet ID field
 			memset(buffer, 0, LL_PACKET_ID_SIZE);
 			U32 builtSize = builder->buildMessage(buffer, bufferSize, offset);
@@ -970,5 +972,120 @@ namespace tut
 		ensure_equals("Ensure unchanged buffer ", strlen(outBuffer), 0);
 		delete reader;
 	}
-}
 
+	template<> template<>
+	void LLTemplateMessageBuilderTestObject::test<46>()
+		// reused packet buffer -> values read are unchanged
+	{
+		LLMessageTemplate messageTemplate = defaultTemplate();
+		messageTemplate.addBlock(defaultBlock(MVT_U32, 4, MBT_SINGLE));
+		U32 outValue, inValue = 0xbbbbbbbb;
+		LLTemplateMessageBuilder* builder = defaultBuilder(messageTemplate);
+		builder->addU32(_PREHASH_Test0, inValue);
+		const U32 bufferSize = 1024;
+		U8 buffer[bufferSize];
+		memset(buffer, 0, LL_PACKET_ID_SIZE);
+		U32 builtSize = builder->buildMessage(buffer, bufferSize, 0);
+		delete builder;
+
+		numberMap[1] = &messageTemplate;
+		LLTemplateMessageReader* reader = 
+			new LLTemplateMessageReader(numberMap);
+		reader->validateMessage(buffer, builtSize, LLHost());
+		reader->readMessage(buffer, LLHost());
+		memset(buffer, 0xcc, bufferSize);
+		reader->getU32(_PREHASH_Test0, _PREHASH_Test0, outValue);
+		ensure_equals("Ensure value read from reused buffer ", outValue, inValue);
+		delete reader;
+	}
+
+	template<> template<>
+	void LLTemplateMessageBuilderTestObject::test<47>()
+		// size of variable in missing block -> LL_BLOCK_NOT_IN_MESSAGE
+	{
+		LLMessageTemplate messageTemplate = defaultTemplate();
+		messageTemplate.addBlock(defaultBlock(MVT_U32, 4, MBT_SINGLE));
+		messageTemplate.addBlock(createBlock(const_cast<char*>(_PREHASH_Test1), MVT_U32, 4));
+		LLTemplateMessageBuilder* builder = defaultBuilder(messageTemplate);
+		builder->addU32(_PREHASH_Test0, 1);
+		LLTemplateMessageReader* reader = setReader(messageTemplate, builder);
+		ensure_equals("Ensure size of present variable ",
+					  reader->getSize(_PREHASH_Test0, _PREHASH_Test0), 4);
+		ensure_equals("Ensure missing block ",
+					  reader->getSize(_PREHASH_Test1, _PREHASH_Test0), LL_BLOCK_NOT_IN_MESSAGE);
+		delete reader;
+	}
+
+	template<> template<>
+	void LLTemplateMessageBuilderTestObject::test<48>()
+		// decode throughput, zero copy and copying decode read the same values
+	{
+		// shaped like an object update: a header and 20 repeated blocks
+		LLMessageTemplate messageTemplate = defaultTemplate();
+		messageTemplate.addBlock(defaultBlock(MVT_U32, 4, MBT_SINGLE));
+		LLMessageBlock* objectBlock = createBlock(const_cast<char*>(_PREHASH_Test1), MVT_LLVector3, 12);
+		objectBlock->addVariable(const_cast<char*>(_PREHASH_Test1), MVT_LLUUID, 16);
+		objectBlock->addVariable(const_cast<char*>(_PREHASH_Test2), MVT_VARIABLE, 1);
+		messageTemplate.addBlock(objectBlock);
+		const S32 numObjects = 20;
+		LLTemplateMessageBuilder* builder = defaultBuilder(messageTemplate);
+		builder->addU32(_PREHASH_Test0, 0xbbbbbbbb);
+		U8 extraParams[64];
+		for (S32 i = 0; i < (S32)sizeof(extraParams); ++i)
+		{
+			extraParams[i] = (U8)i;
+		}
+		for (S32 i = 0; i < numObjects; ++i)
+		{
+			builder->nextBlock(_PREHASH_Test1);
+			builder->addVector3(_PREHASH_Test0, LLVector3((F32)i, 2.f * i, 3.f * i));
+			builder->addUUID(_PREHASH_Test1, LLUUID::generateNewID());
+			builder->addBinaryData(_PREHASH_Test2, extraParams, i % 2 ? sizeof(extraParams) : 16);
+		}
+		const U32 bufferSize = 2048;
+		U8 buffer[bufferSize];
+		memset(buffer, 0, LL_PACKET_ID_SIZE);
+		U32 builtSize = builder->buildMessage(buffer, bufferSize, 0);
+		delete builder;
+
+		numberMap[1] = &messageTemplate;
+		LLTemplateMessageReader* reader = new LLTemplateMessageReader(numberMap);
+		const bool zeroCopy = LLTemplateMessageReader::getZeroCopyDecode();
+		const S32 numMessages = 20000;
+		F64 checksum[2];
+		for (S32 pass = 0; pass < 2; ++pass)
+		{
+			LLTemplateMessageReader::setZeroCopyDecode(pass == 0);
+			checksum[pass] = 0.0;
+			LLTimer timer;
+			for (S32 n = 0; n < numMessages; ++n)
+			{
+				reader->validateMessage(buffer, builtSize, LLHost());
+				reader->readMessage(buffer, LLHost());
+				U32 header;
+				reader->getU32(_PREHASH_Test0, _PREHASH_Test0, header);
+				S32 count = reader->getNumberOfBlocks(_PREHASH_Test1);
+				for (S32 i = 0; i < count; ++i)
+				{
+					LLVector3 pos;
+					LLUUID id;
+					U8 data[sizeof(extraParams)];
+					reader->getVector3(_PREHASH_Test1, _PREHASH_Test0, pos, i);
+					reader->getUUID(_PREHASH_Test1, _PREHASH_Test1, id, i);
+					S32 size = reader->getSize(_PREHASH_Test1, i, _PREHASH_Test2);
+					reader->getBinaryData(_PREHASH_Test1, _PREHASH_Test2, data, size, i, sizeof(data));
+					checksum[pass] += pos.mV[VY] + id.mData[0] + size + data[size - 1];
+				}
+				checksum[pass] += header;
+				reader->clearMessage();
+			}
+			F64 seconds = timer.getElapsedTimeF64();
+			LL_INFOS() << (pass == 0 ? "Zero copy" : "Copying") << " decode: " << numMessages << " messages of "
+					   << builtSize << " bytes in " << seconds << " s, "
+					   << (seconds > 0.0 ? numMessages / seconds : 0.0) << " messages/s" << LL_ENDL;
+		}
+		LLTemplateMessageReader::setZeroCopyDecode(zeroCopy);
+		ensure_equals("Ensure both decodes read the same ", checksum[0], checksum[1]);
+		delete reader;
+	}
+}
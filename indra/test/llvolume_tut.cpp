@@ -0,0 +1,422 @@
+/**
+ * @file llvolume_tut.cpp
+ * @brief Checks LLVolume face and sculpt mesh generation against reference values
+ *
+ * $LicenseInfo:firstyear=2026&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2026, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include <tut/tut.hpp>
+#include "linden_common.h"
+#include "lltut.h"
+#include "llvolume.h"
+#include "llvolumefacecache.h"
+#include "llvolumemgr.h"
+#include "lluuid.h"
+#include "lltimer.h"
+#include "llparallelfor.h"
+
+namespace tut
+{
+	struct llvolume_data
+	{
+		// The reworked kernels must reproduce the old output exactly.
+		static bool samePoint(const LLVector4a& a, const LLVector4a& b)
+		{
+			return a[0] == b[0] && a[1] == b[1] && a[2] == b[2];
+		}
+
+		// Sculpt map filled with a pattern that touches every byte value.
+		std::vector<U8> makeSculptMap(U16 width, U16 height)
+		{
+			std::vector<U8> map(width * height * 3);
+			for (size_t i = 0; i < map.size(); ++i)
+			{
+				map[i] = (U8)((i * 37 + i / 7) & 0xff);
+			}
+			return map;
+		}
+
+		// The mesh point sculpting used to compute pixel by pixel.
+		LLVector4a referenceSculptPoint(S32 s, S32 t, S32 size_s, S32 size_t,
+										U16 width, U16 height, const U8* data, U8 type)
+		{
+			U8 stitching = type & LL_SCULPT_TYPE_MASK;
+			BOOL invert = type & LL_SCULPT_FLAG_INVERT;
+			BOOL mirror = type & LL_SCULPT_FLAG_MIRROR;
+			S32 reversed_t = (invert ? !mirror : mirror) ? size_t - t - 1 : t;
+
+			U32 x = (U32) ((F32)reversed_t/(size_t-1) * (F32) width);
+			U32 y = (U32) ((F32)s/(size_s-1) * (F32) height);
+			if (y == 0 && stitching == LL_SCULPT_TYPE_SPHERE)
+			{
+				x = width / 2;
+			}
+			if (y == height)
+			{
+				y = stitching == LL_SCULPT_TYPE_TORUS ? 0 : height - 1;
+				if (stitching == LL_SCULPT_TYPE_SPHERE)
+				{
+					x = width / 2;
+				}
+			}
+			if (x == width)
+			{
+				x = stitching == LL_SCULPT_TYPE_PLANE ? width - 1 : 0;
+			}
+
+			const U8* rgb = data + (x + y * width) * 3;
+			LLVector4a value;
+			value.set(rgb[0], rgb[1], rgb[2]);
+			value.mul(1.f/255.f);
+			value.sub(LLVector4a(0.5f, 0.5f, 0.5f));
+			if (mirror)
+			{
+				value.mul(LLVector4a(-1.f, 1.f, 1.f, 1.f));
+			}
+			return value;
+		}
+
+		void ensureSculptMatches(U8 type, F32 detail)
+		{
+			const U16 width = 32;
+			const U16 height = 16;
+			std::vector<U8> map = makeSculptMap(width, height);
+
+			LLVolumeParams params;
+			params.setType(LL_PCODE_PROFILE_CIRCLE, LL_PCODE_PATH_CIRCLE);
+			params.setSculptID(LLUUID("c96f9b1e-f589-4100-9774-d98643ce0bed"), type);
+			LLPointer<LLVolume> volume = new LLVolume(params, detail);
+			volume->sculpt(width, height, 3, &map[0], 0, false);
+
+			S32 size_s = volume->getPath().mPath.size();
+			S32 size_t = volume->getProfile().mProfile.size();
+			ensure_equals("mesh size", (S32)volume->getMesh().size(), size_s * size_t);
+			for (S32 s = 0; s < size_s; ++s)
+			{
+				for (S32 t = 0; t < size_t; ++t)
+				{
+					LLVector4a expected = referenceSculptPoint(s, t, size_s, size_t, width, height, &map[0], type);
+					ensure("sculpt point", samePoint(volume->getMeshPt(s * size_t + t), expected));
+				}
+			}
+		}
+		static F32 random_f32(F32 max)
+		{
+			return max * (F32)rand() / (F32)RAND_MAX;
+		}
+
+		// Prim params spread over every profile, hole and path type, with
+		// the cuts, hollows and path tortures a builder can set.
+		static LLVolumeParams randomParams()
+		{
+			static const U8 profiles[] = { LL_PCODE_PROFILE_CIRCLE, LL_PCODE_PROFILE_SQUARE, LL_PCODE_PROFILE_ISOTRI,
+										   LL_PCODE_PROFILE_EQUALTRI, LL_PCODE_PROFILE_RIGHTTRI, LL_PCODE_PROFILE_CIRCLE_HALF };
+			static const U8 holes[] = { LL_PCODE_HOLE_SAME, LL_PCODE_HOLE_CIRCLE, LL_PCODE_HOLE_SQUARE, LL_PCODE_HOLE_TRIANGLE };
+			static const U8 paths[] = { LL_PCODE_PATH_LINE, LL_PCODE_PATH_CIRCLE, LL_PCODE_PATH_CIRCLE2, LL_PCODE_PATH_TEST };
+
+			LLVolumeParams params;
+			params.setType(profiles[rand() % LL_ARRAY_SIZE(profiles)] | holes[rand() % LL_ARRAY_SIZE(holes)],
+						   paths[rand() % LL_ARRAY_SIZE(paths)]);
+			F32 begin = random_f32(0.9f);
+			params.setBeginAndEndS(begin, begin + 0.02f + random_f32(0.98f - begin));
+			begin = random_f32(0.9f);
+			params.setBeginAndEndT(begin, begin + 0.02f + random_f32(0.98f - begin));
+			if (rand() & 1)
+			{
+				params.setHollow(random_f32(0.95f));
+			}
+			params.setRatio(random_f32(2.f), random_f32(2.f));
+			params.setShear(random_f32(1.f) - 0.5f, random_f32(1.f) - 0.5f);
+			params.setTwistBegin(random_f32(2.f) - 1.f);
+			params.setTwistEnd(random_f32(2.f) - 1.f);
+			params.setTaper(random_f32(2.f) - 1.f, random_f32(2.f) - 1.f);
+			params.setRevolutions(1.f + random_f32(3.f));
+			params.setRadiusOffset(random_f32(1.f) - 0.5f);
+			params.setSkew(random_f32(1.f) - 0.5f);
+			return params;
+		}
+
+		static bool sameVolume(const LLVolume* a, const LLVolume* b)
+		{
+			if (a->getNumVolumeFaces() != b->getNumVolumeFaces())
+			{
+				return false;
+			}
+			for (S32 f = 0; f < a->getNumVolumeFaces(); ++f)
+			{
+				const LLVolumeFace& fa = a->getVolumeFace(f);
+				const LLVolumeFace& fb = b->getVolumeFace(f);
+				if (fa.mNumVertices != fb.mNumVertices || fa.mNumIndices != fb.mNumIndices ||
+					memcmp(fa.mPositions, fb.mPositions, fa.mNumVertices * sizeof(LLVector4a)) ||
+					memcmp(fa.mNormals, fb.mNormals, fa.mNumVertices * sizeof(LLVector4a)) ||
+					memcmp(fa.mTexCoords, fb.mTexCoords, fa.mNumVertices * sizeof(LLVector2)) ||
+					memcmp(fa.mIndices, fb.mIndices, fa.mNumIndices * sizeof(U16)))
+				{
+					return false;
+				}
+			}
+			return true;
+		}
+	};
+	typedef test_group<llvolume_data> llvolume_test;
+	typedef llvolume_test::object llvolume_object;
+	tut::llvolume_test llvolume_testcase("llvolume");
+
+	template<> template<>
+	void llvolume_object::test<1>()
+	{
+		// Cap texture coordinates are the profile shifted into [0, 1],
+		// mirrored for the bottom cap, and positions are the end mesh rows.
+		LLVolumeParams params;
+		params.setType(LL_PCODE_PROFILE_CIRCLE | LL_PCODE_HOLE_CIRCLE, LL_PCODE_PATH_LINE);
+		params.setHollow(0.5f);
+		params.setBeginAndEndS(0.f, 0.75f);
+		LLPointer<LLVolume> volume = new LLVolume(params, 2.f);
+
+		const LLAlignedArray<LLVector4a,64>& profile = volume->getProfile().mProfile;
+		S32 max_s = volume->getProfile().getTotal();
+		S32 max_t = volume->getPath().mPath.size();
+		S32 caps = 0;
+		for (S32 f = 0; f < volume->getNumVolumeFaces(); ++f)
+		{
+			const LLVolumeFace& face = volume->getVolumeFace(f);
+			bool top = face.mTypeMask & LLVolumeFace::TOP_MASK;
+			if (!top && !(face.mTypeMask & LLVolumeFace::BOTTOM_MASK))
+			{
+				continue;
+			}
+			++caps;
+			ensure("cap vertex count", face.mNumVertices >= (S32)profile.size());
+
+			S32 offset = top ? (max_t - 1) * max_s : face.mBeginS;
+			LLVector2 min_uv(1.f, 1.f), max_uv(0.f, 0.f);
+			for (S32 i = 0; i < (S32)profile.size(); ++i)
+			{
+				F32 u = profile[i][0] + 0.5f;
+				F32 v = top ? profile[i][1] + 0.5f : 0.5f - profile[i][1];
+				ensure_equals("cap u", face.mTexCoords[i].mV[0], u);
+				ensure_equals("cap v", face.mTexCoords[i].mV[1], v);
+				ensure("cap position", samePoint(face.mPositions[i], volume->getMesh()[offset + i]));
+				update_min_max(min_uv, max_uv, face.mTexCoords[i]);
+			}
+			ensure("cap texture coordinates in range", min_uv.mV[0] >= 0.f && max_uv.mV[0] <= 1.f);
+		}
+		ensure_equals("caps", caps, 2);
+	}
+
+	template<> template<>
+	void llvolume_object::test<2>()
+	{
+		// Every row of a side face is a row of the mesh, with one v per row.
+		LLVolumeParams params;
+		params.setType(LL_PCODE_PROFILE_CIRCLE, LL_PCODE_PATH_CIRCLE);
+		LLPointer<LLVolume> volume = new LLVolume(params, 2.f);
+
+		S32 max_s = volume->getProfile().getTotal();
+		S32 sides = 0;
+		for (S32 f = 0; f < volume->getNumVolumeFaces(); ++f)
+		{
+			const LLVolumeFace& face = volume->getVolumeFace(f);
+			if (!(face.mTypeMask & LLVolumeFace::SIDE_MASK) || (face.mTypeMask & LLVolumeFace::FLAT_MASK))
+			{
+				continue;
+			}
+			++sides;
+			ensure_equals("side vertex count", face.mNumVertices, face.mNumS * face.mNumT);
+			for (S32 t = 0; t < face.mNumT; ++t)
+			{
+				const LLVector4a* row = &volume->getMesh()[(face.mBeginT + t) * max_s + face.mBeginS];
+				for (S32 s = 0; s < face.mNumS; ++s)
+				{
+					S32 i = t * face.mNumS + s;
+					ensure("side position", samePoint(face.mPositions[i], row[s]));
+					ensure_equals("side v", face.mTexCoords[i].mV[1], face.mTexCoords[t * face.mNumS].mV[1]);
+				}
+			}
+		}
+		ensure("side faces", sides > 0);
+	}
+
+	template<> template<>
+	void llvolume_object::test<3>()
+	{
+		// Sculpt meshes match the per pixel mapping for every stitching type.
+		ensureSculptMatches(LL_SCULPT_TYPE_SPHERE, 2.f);
+		ensureSculptMatches(LL_SCULPT_TYPE_TORUS, 1.f);
+		ensureSculptMatches(LL_SCULPT_TYPE_PLANE, 4.f);
+		ensureSculptMatches(LL_SCULPT_TYPE_CYLINDER, 2.f);
+		ensureSculptMatches(LL_SCULPT_TYPE_SPHERE | LL_SCULPT_FLAG_MIRROR, 4.f);
+		ensureSculptMatches(LL_SCULPT_TYPE_CYLINDER | LL_SCULPT_FLAG_INVERT, 1.f);
+		ensureSculptMatches(LL_SCULPT_TYPE_TORUS | LL_SCULPT_FLAG_INVERT | LL_SCULPT_FLAG_MIRROR, 2.f);
+	}
+
+	template<> template<>
+	void llvolume_object::test<4>()
+	{
+		// Identical faces of separately built volumes borrow the same buffers
+		// and, once one is needed, the same octree.  Editing one of them gives
+		// it a copy of its own.
+		LLVolumeParams params;
+		params.setType(LL_PCODE_PROFILE_SQUARE, LL_PCODE_PATH_CIRCLE);
+		params.setHollow(0.25f);
+		LLPointer<LLVolume> first = new LLVolume(params, 2.f);
+		LLPointer<LLVolume> second = new LLVolume(params, 2.f);
+
+		LLVolumeFace& a = first->getVolumeFace(0);
+		LLVolumeFace& b = second->getVolumeFace(0);
+		const LLVolumeFace original = b;
+
+		ensure("first face cached", LLVolumeFaceCache::share(a));
+		ensure("second face cached", LLVolumeFaceCache::share(b));
+		ensure("buffers shared", a.isShared() && b.isShared() &&
+			   a.mPositions == b.mPositions && a.mIndices == b.mIndices);
+		ensure("no octree until needed", !a.mOctree && !b.mOctree);
+
+		a.createOctree();
+		b.createOctree();
+		ensure("octree shared", a.mOctree != NULL && a.mOctree == b.mOctree && a.isShared() && b.isShared());
+
+		S32 faces = 0;
+		U64 bytes_saved = 0;
+		LLVolumeFaceCache::getStats(faces, bytes_saved);
+		ensure("savings reported", faces > 0 && bytes_saved > 0);
+
+		b.pushIndex(0);
+		ensure("edited face copied", !b.isShared() && b.mPositions != a.mPositions);
+		ensure("other face still shared", a.isShared() && a.mOctree != NULL);
+		ensure_equals("face id kept", b.mID, original.mID);
+		ensure_equals("vertex count", b.mNumVertices, original.mNumVertices);
+		ensure_equals("index count", b.mNumIndices, original.mNumIndices + 1);
+		ensure("positions copied", !memcmp(b.mPositions, original.mPositions, original.mNumVertices * sizeof(LLVector4a)));
+		ensure("indices copied", !memcmp(b.mIndices, original.mIndices, original.mNumIndices * sizeof(U16)));
+	}
+
+	template<> template<>
+	void llvolume_object::test<5>()
+	{
+		// A batch of dirty prims built through LLVolumeMgr::refVolumes()
+		// comes out bit for bit the same as one refVolume() at a time.
+		// 50k param sets, as many prims as a busy region streams in, each at
+		// a random LOD.
+		const S32 count = 50000;
+		srand(1);
+		std::vector<LLVolumeMgr::volume_request_t> requests;
+		requests.reserve(count);
+		for (S32 i = 0; i < count; ++i)
+		{
+			requests.push_back(LLVolumeMgr::volume_request_t(randomParams(), rand() % LLVolumeLODGroup::NUM_LODS));
+		}
+
+		LLVolumeMgr serial_mgr;
+		std::vector<LLVolume*> serial;
+		serial.reserve(count);
+		LLTimer timer;
+		for (S32 i = 0; i < count; ++i)
+		{
+			serial.push_back(serial_mgr.refVolume(requests[i].first, requests[i].second));
+		}
+		const F64 serial_seconds = timer.getElapsedTimeF64();
+
+		LLVolumeMgr batch_mgr;
+		batch_mgr.useMutex();
+		std::vector<LLVolume*> batched;
+		timer.reset();
+		batch_mgr.refVolumes(requests, batched);
+		const F64 batched_seconds = timer.getElapsedTimeF64();
+
+		ensure_equals("one volume per request", (S32)batched.size(), count);
+		for (S32 i = 0; i < count; ++i)
+		{
+			ensure("batched volume matches", sameVolume(batched[i], serial[i]));
+			serial_mgr.unrefVolume(serial[i]);
+			batch_mgr.unrefVolume(batched[i]);
+		}
+		ensure("no dangling volumes", serial_mgr.cleanup() && batch_mgr.cleanup());
+
+		LL_INFOS() << count << " prims: one at a time " << serial_seconds << " s, batched on "
+				   << ll_parallel_for_threads() << " threads " << batched_seconds << " s" << LL_ENDL;
+	}
+
+	template<> template<>
+	void llvolume_object::test<6>()
+	{
+		// Time to build each profile and path type, hollowed and cut so
+		// side and cap faces both show up, at the highest LOD.  Sculpties are
+		// timed for each stitching type on a 64x64 map.
+		static const U8 profiles[] = { LL_PCODE_PROFILE_CIRCLE, LL_PCODE_PROFILE_SQUARE, LL_PCODE_PROFILE_ISOTRI,
+									   LL_PCODE_PROFILE_EQUALTRI, LL_PCODE_PROFILE_RIGHTTRI, LL_PCODE_PROFILE_CIRCLE_HALF };
+		static const U8 paths[] = { LL_PCODE_PATH_LINE, LL_PCODE_PATH_CIRCLE, LL_PCODE_PATH_CIRCLE2, LL_PCODE_PATH_TEST };
+		static const U8 sculpts[] = { LL_SCULPT_TYPE_SPHERE, LL_SCULPT_TYPE_TORUS, LL_SCULPT_TYPE_PLANE, LL_SCULPT_TYPE_CYLINDER };
+		const S32 builds = 200;
+		const F32 detail = LLVolumeLODGroup::getVolumeScaleFromDetail(LLVolumeLODGroup::NUM_LODS - 1);
+
+		F64 total_seconds = 0.0;
+		for (U32 p = 0; p < LL_ARRAY_SIZE(profiles); ++p)
+		{
+			for (U32 t = 0; t < LL_ARRAY_SIZE(paths); ++t)
+			{
+				LLVolumeParams params;
+				params.setType(profiles[p] | LL_PCODE_HOLE_SAME, paths[t]);
+				params.setHollow(0.3f);
+				params.setBeginAndEndS(0.1f, 0.9f);
+
+				S32 vertices = 0;
+				LLTimer timer;
+				for (S32 i = 0; i < builds; ++i)
+				{
+					LLPointer<LLVolume> volume = new LLVolume(params, detail);
+					vertices = 0;
+					for (S32 f = 0; f < volume->getNumVolumeFaces(); ++f)
+					{
+						vertices += volume->getVolumeFace(f).mNumVertices;
+					}
+				}
+				const F64 seconds = timer.getElapsedTimeF64();
+				total_seconds += seconds;
+				ensure("volume has vertices", vertices > 0);
+				LL_INFOS() << "profile " << (S32)profiles[p] << " path " << (S32)paths[t] << ": " << vertices << " vertices, "
+						   << seconds * 1.e6 / builds << " us/volume" << LL_ENDL;
+			}
+		}
+
+		const U16 size = 64;
+		std::vector<U8> map = makeSculptMap(size, size);
+		LLUUID sculpt_id("c96f9b1e-f589-4100-9774-d98643ce0bed");
+		for (U32 k = 0; k < LL_ARRAY_SIZE(sculpts); ++k)
+		{
+			LLVolumeParams params;
+			params.setType(LL_PCODE_PROFILE_CIRCLE, LL_PCODE_PATH_CIRCLE);
+			params.setSculptID(sculpt_id, sculpts[k]);
+
+			LLTimer timer;
+			for (S32 i = 0; i < builds; ++i)
+			{
+				LLPointer<LLVolume> volume = new LLVolume(params, detail);
+				volume->sculpt(size, size, 3, &map[0], 0, false);
+			}
+			const F64 seconds = timer.getElapsedTimeF64();
+			total_seconds += seconds;
+			LL_INFOS() << "sculpt " << (S32)sculpts[k] << ": " << seconds * 1.e6 / builds << " us/volume" << LL_ENDL;
+		}
+		LL_INFOS() << "all types: " << total_seconds << " s" << LL_ENDL;
+	}
+}